@@ -0,0 +1,279 @@
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <optional>
+#include <algorithm>
+#include <stdexcept>
+#include "account_cache.h"
+
+static bool sameSlice(const std::optional<DataSlice> &a, const std::optional<DataSlice> &b)
+{
+  if (!a || !b)
+  {
+    return !a && !b;
+  }
+  return a->offset == b->offset && a->length == b->length;
+}
+
+AccountCache::AccountCache(Connection connection, size_t capacity, uint32_t maxAgeMs, uint32_t coalesceMs)
+    : connection(connection), capacity(capacity), maxAgeMs(maxAgeMs), coalesceMs(coalesceMs)
+{
+  if (capacity == 0)
+  {
+    throw std::invalid_argument("AccountCache capacity must be at least 1");
+  }
+}
+
+bool AccountCache::lookup(const PublicKey &account, Commitment commitment, const std::optional<DataSlice> &dataSlice, std::optional<AccountInfo> &result)
+{
+  auto it = entries.find(account);
+  if (it == entries.end())
+  {
+    return false;
+  }
+  Entry &entry = it->second;
+
+  // A read at a higher commitment is also valid at a lower one
+  if (Clock::now() - entry.readAt > std::chrono::milliseconds(maxAgeMs) ||
+      static_cast<int>(entry.commitment) < static_cast<int>(commitment))
+  {
+    return false;
+  }
+
+  // A full read can serve any slice, a sliced read only the same slice
+  if (entry.dataSlice && !sameSlice(entry.dataSlice, dataSlice))
+  {
+    return false;
+  }
+
+  result = entry.account;
+  if (result && dataSlice && !entry.dataSlice)
+  {
+    std::vector<uint8_t> &data = result->data;
+    size_t begin = std::min(dataSlice->offset, data.size());
+    size_t end = begin + std::min(dataSlice->length, data.size() - begin);
+    data = std::vector<uint8_t>(data.begin() + begin, data.begin() + end);
+  }
+
+  order.splice(order.begin(), order, entry.position);
+  return true;
+}
+
+void AccountCache::store(const PublicKey &account, const std::optional<AccountInfo> &info, Commitment commitment, const std::optional<DataSlice> &dataSlice, uint64_t slot)
+{
+  auto it = entries.find(account);
+  if (it != entries.end())
+  {
+    Entry &entry = it->second;
+    if (entry.slot > slot)
+    {
+      return;
+    }
+    entry.account = info;
+    entry.commitment = commitment;
+    entry.dataSlice = dataSlice;
+    entry.slot = slot;
+    entry.readAt = Clock::now();
+    order.splice(order.begin(), order, entry.position);
+    return;
+  }
+
+  order.push_front(account);
+  Entry entry{info, commitment, dataSlice, slot, Clock::now(), order.begin()};
+  entries.emplace(account, entry);
+
+  while (entries.size() > capacity)
+  {
+    entries.erase(order.back());
+    order.pop_back();
+  }
+}
+
+// The first miss opens a flight and waits coalesceMs for others to join
+// before sending it; later misses for the same commitment and slice add
+// their accounts and wait for the result.
+void AccountCache::fetch(const std::vector<PublicKey> &accounts, Commitment commitment, const std::optional<DataSlice> &dataSlice, std::vector<std::optional<AccountInfo>> &results)
+{
+  std::unique_lock<std::mutex> lock(mutex);
+
+  std::shared_ptr<Flight> flight;
+  for (auto &open : flights)
+  {
+    if (open->commitment == commitment && sameSlice(open->dataSlice, dataSlice))
+    {
+      flight = open;
+      break;
+    }
+  }
+  bool leader = !flight;
+  if (leader)
+  {
+    flight = std::make_shared<Flight>();
+    flight->commitment = commitment;
+    flight->dataSlice = dataSlice;
+    flights.push_back(flight);
+  }
+
+  std::vector<size_t> indices;
+  for (const auto &account : accounts)
+  {
+    auto found = std::find(flight->accounts.begin(), flight->accounts.end(), account);
+    indices.push_back(found - flight->accounts.begin());
+    if (found == flight->accounts.end())
+    {
+      flight->accounts.push_back(account);
+    }
+  }
+
+  if (leader)
+  {
+    if (coalesceMs > 0)
+    {
+      lock.unlock();
+      std::this_thread::sleep_for(std::chrono::milliseconds(coalesceMs));
+      lock.lock();
+    }
+    flights.erase(std::find(flights.begin(), flights.end(), flight));
+    std::vector<PublicKey> requested = flight->accounts;
+    lock.unlock();
+
+    std::vector<std::optional<AccountInfo>> fetched;
+    std::vector<uint64_t> slots;
+    std::string error;
+    try
+    {
+      fetched = connection.getMultipleAccounts(requested, commitment, dataSlice, slots);
+    }
+    catch (const std::exception &e)
+    {
+      error = e.what();
+      if (error.empty())
+      {
+        error = "Request failed";
+      }
+    }
+
+    lock.lock();
+    if (error.empty())
+    {
+      for (size_t i = 0; i < requested.size(); ++i)
+      {
+        store(requested[i], fetched[i], commitment, dataSlice, slots[i]);
+      }
+    }
+    flight->results = std::move(fetched);
+    flight->error = error;
+    flight->done = true;
+    landed.notify_all();
+  }
+  else
+  {
+    landed.wait(lock, [&flight]
+                { return flight->done; });
+  }
+
+  if (!flight->error.empty())
+  {
+    throw std::runtime_error(flight->error);
+  }
+  results.resize(accounts.size());
+  for (size_t i = 0; i < accounts.size(); ++i)
+  {
+    results[i] = flight->results[indices[i]];
+  }
+}
+
+std::optional<AccountInfo> AccountCache::get(const PublicKey &account, Commitment commitment, std::optional<DataSlice> dataSlice)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::optional<AccountInfo> cached;
+    if (lookup(account, commitment, dataSlice, cached))
+    {
+      return cached;
+    }
+  }
+
+  std::vector<std::optional<AccountInfo>> results;
+  fetch({account}, commitment, dataSlice, results);
+  return results[0];
+}
+
+std::vector<std::optional<AccountInfo>> AccountCache::getMultiple(const std::vector<PublicKey> &accounts, Commitment commitment, std::optional<DataSlice> dataSlice)
+{
+  std::vector<std::optional<AccountInfo>> results(accounts.size());
+  std::vector<PublicKey> misses;
+  std::vector<size_t> missIndices;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < accounts.size(); ++i)
+    {
+      if (!lookup(accounts[i], commitment, dataSlice, results[i]))
+      {
+        misses.push_back(accounts[i]);
+        missIndices.push_back(i);
+      }
+    }
+  }
+
+  if (!misses.empty())
+  {
+    std::vector<std::optional<AccountInfo>> fetched;
+    fetch(misses, commitment, dataSlice, fetched);
+    for (size_t i = 0; i < misses.size(); ++i)
+    {
+      results[missIndices[i]] = fetched[i];
+    }
+  }
+  return results;
+}
+
+std::optional<AccountInfo> AccountCache::peek(const PublicKey &account)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = entries.find(account);
+  if (it == entries.end())
+  {
+    return std::nullopt;
+  }
+  return it->second.account;
+}
+
+void AccountCache::update(const PublicKey &account, const AccountInfo &info, Commitment commitment)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (info.lamports == 0)
+  {
+    store(account, std::nullopt, commitment, std::nullopt, info.slot);
+    return;
+  }
+  store(account, info, commitment, std::nullopt, info.slot);
+}
+
+void AccountCache::invalidate(const PublicKey &account)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = entries.find(account);
+  if (it != entries.end())
+  {
+    order.erase(it->second.position);
+    entries.erase(it);
+  }
+}
+
+void AccountCache::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  entries.clear();
+  order.clear();
+}
+
+size_t AccountCache::size()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return entries.size();
+}
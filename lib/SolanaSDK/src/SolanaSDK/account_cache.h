@@ -0,0 +1,103 @@
+#ifndef ACCOUNT_CACHE_H
+#define ACCOUNT_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <map>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <optional>
+#include <mutex>
+#include <condition_variable>
+#include "connection.h"
+#include "public_key.h"
+
+constexpr size_t ACCOUNT_CACHE_DEFAULT_CAPACITY = 64;
+
+// Cached reads younger than this are served without a request
+constexpr uint32_t ACCOUNT_CACHE_DEFAULT_MAX_AGE_MS = 2000;
+
+// How long the first miss waits for other misses to join its request
+constexpr uint32_t ACCOUNT_CACHE_DEFAULT_COALESCE_MS = 5;
+
+// LRU cache of account reads keyed by address. Entries are stamped with
+// the slot and commitment they were read at; an older slot never replaces
+// a newer one. A missing or closed account is an entry too, at the slot it
+// was seen gone, so it replaces what an older slot left behind. Misses that arrive within the coalescing window, from any
+// thread, share one getMultipleAccounts call.
+class AccountCache
+{
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Entry
+  {
+    // Empty if the account did not exist
+    std::optional<AccountInfo> account;
+    Commitment commitment;
+    // Set if only this slice of the data was read
+    std::optional<DataSlice> dataSlice;
+    uint64_t slot;
+    Clock::time_point readAt;
+    std::list<PublicKey>::iterator position;
+  };
+
+  // One pending getMultipleAccounts call that later misses can join
+  struct Flight
+  {
+    Commitment commitment;
+    std::optional<DataSlice> dataSlice;
+    std::vector<PublicKey> accounts;
+    std::vector<std::optional<AccountInfo>> results;
+    bool done = false;
+    std::string error;
+  };
+
+  Connection connection;
+  size_t capacity;
+  uint32_t maxAgeMs;
+  uint32_t coalesceMs;
+  std::map<PublicKey, Entry> entries;
+  // Most recently used first
+  std::list<PublicKey> order;
+  std::vector<std::shared_ptr<Flight>> flights;
+  std::mutex mutex;
+  std::condition_variable landed;
+
+  // Cached account if a fresh enough entry covers the request
+  bool lookup(const PublicKey &account, Commitment commitment, const std::optional<DataSlice> &dataSlice, std::optional<AccountInfo> &result);
+  void store(const PublicKey &account, const std::optional<AccountInfo> &info, Commitment commitment, const std::optional<DataSlice> &dataSlice, uint64_t slot);
+  void fetch(const std::vector<PublicKey> &accounts, Commitment commitment, const std::optional<DataSlice> &dataSlice, std::vector<std::optional<AccountInfo>> &results);
+
+public:
+  AccountCache(Connection connection, size_t capacity = ACCOUNT_CACHE_DEFAULT_CAPACITY, uint32_t maxAgeMs = ACCOUNT_CACHE_DEFAULT_MAX_AGE_MS, uint32_t coalesceMs = ACCOUNT_CACHE_DEFAULT_COALESCE_MS);
+
+  AccountCache(const AccountCache &) = delete;
+  AccountCache &operator=(const AccountCache &) = delete;
+
+  // Account from the cache or the node; empty if it does not exist.
+  // Request errors are thrown.
+  std::optional<AccountInfo> get(const PublicKey &account, Commitment commitment, std::optional<DataSlice> dataSlice = std::nullopt);
+
+  // Several accounts, fetching only the ones that are not cached
+  std::vector<std::optional<AccountInfo>> getMultiple(const std::vector<PublicKey> &accounts, Commitment commitment, std::optional<DataSlice> dataSlice = std::nullopt);
+
+  // Cached account without touching the network, regardless of age
+  std::optional<AccountInfo> peek(const PublicKey &account);
+
+  // Store an account seen elsewhere, e.g. in an account notification.
+  // Ignored if the cache already holds a newer slot. An account left with
+  // no lamports was closed and is cached as missing.
+  void update(const PublicKey &account, const AccountInfo &info, Commitment commitment);
+
+  void invalidate(const PublicKey &account);
+
+  void clear();
+
+  size_t size();
+};
+
+#endif // ACCOUNT_CACHE_H
@@ -23,6 +23,16 @@ AccountMeta *AccountMeta::newReadonly(PublicKey publicKey, bool isSigner)
     return accountMeta;
 }
 
+AccountMeta AccountMeta::writable(PublicKey publicKey, bool isSigner)
+{
+    return AccountMeta{publicKey, isSigner, true};
+}
+
+AccountMeta AccountMeta::readonly(PublicKey publicKey, bool isSigner)
+{
+    return AccountMeta{publicKey, isSigner, false};
+}
+
 // Serialize the AccountMeta object to a vector of bytes
 std::vector<uint8_t> AccountMeta::serialize()
 {
@@ -21,6 +21,10 @@ public:
   // Construct metadata for a read-only account.
   static AccountMeta *newReadonly(PublicKey publicKey, bool isSigner);
 
+  // As above, returned by value instead of allocated
+  static AccountMeta writable(PublicKey publicKey, bool isSigner);
+  static AccountMeta readonly(PublicKey publicKey, bool isSigner);
+
   std::vector<uint8_t> serialize();
 
   static AccountMeta deserialize(const std::vector<uint8_t> &input);
@@ -1,7 +1,10 @@
 #include "base58.h"
+#if defined(ARDUINO)
 #include <Arduino.h>
+#endif
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
 
 const std::string Base58::ALPHABET = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
 
@@ -9,12 +12,20 @@ Base58::Base58() {}
 
 void Base58::printArray(const std::vector<unsigned char> &arr)
 {
+#if defined(ARDUINO)
     for (const auto &el : arr)
     {
         Serial.print(static_cast<int>(el));
         Serial.print(",");
     }
     Serial.println();
+#else
+    for (const auto &el : arr)
+    {
+        std::cout << static_cast<int>(el) << ",";
+    }
+    std::cout << std::endl;
+#endif
 }
 
 std::string Base58::encode(const std::vector<uint8_t> &input)
@@ -82,13 +93,19 @@ std::vector<uint8_t> Base58::decode(const std::string &addr)
 std::string Base58::trimEncode(const std::vector<uint8_t> &input)
 {
     std::string encoded = encode(input);
+    // encode() pads to a fixed width; keep one '1' per leading zero byte and
+    // every digit after them, trailing '1's included
+    size_t zeros = 0;
+    while (zeros < input.size() && input[zeros] == 0)
+    {
+        ++zeros;
+    }
     size_t first = encoded.find_first_not_of('1');
     if (std::string::npos == first)
     {
-        return "";
+        return std::string(zeros, '1');
     }
-    size_t last = encoded.find_last_not_of('1');
-    return encoded.substr(first, (last - first + 1));
+    return std::string(zeros, '1') + encoded.substr(first);
 }
 
 std::vector<uint8_t> Base58::trimDecode(const std::string &addr)
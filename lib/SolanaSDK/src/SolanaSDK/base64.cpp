@@ -0,0 +1,103 @@
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include "base64.h"
+
+const std::string Base64::ALPHABET = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+size_t Base64::encodedLength(size_t length)
+{
+  return ((length + 2) / 3) * 4;
+}
+
+// Encode bytes as standard padded base64, as used by the RPC "base64" encoding
+void Base64::encode(const uint8_t *input, size_t length, char *output)
+{
+  size_t i = 0;
+  for (; i + 2 < length; i += 3)
+  {
+    uint32_t n = (input[i] << 16) | (input[i + 1] << 8) | input[i + 2];
+    *output++ = ALPHABET[(n >> 18) & 0x3F];
+    *output++ = ALPHABET[(n >> 12) & 0x3F];
+    *output++ = ALPHABET[(n >> 6) & 0x3F];
+    *output++ = ALPHABET[n & 0x3F];
+  }
+
+  size_t remaining = length - i;
+  if (remaining > 0)
+  {
+    uint32_t n = input[i] << 16;
+    if (remaining == 2)
+    {
+      n |= input[i + 1] << 8;
+    }
+    *output++ = ALPHABET[(n >> 18) & 0x3F];
+    *output++ = ALPHABET[(n >> 12) & 0x3F];
+    *output++ = remaining == 2 ? ALPHABET[(n >> 6) & 0x3F] : '=';
+    *output++ = '=';
+  }
+}
+
+std::string Base64::encode(const std::vector<uint8_t> &input)
+{
+  std::string output(encodedLength(input.size()), '\0');
+  encode(input.data(), input.size(), &output[0]);
+  return output;
+}
+
+int Base64::decodeChar(char c)
+{
+  if (c >= 'A' && c <= 'Z')
+  {
+    return c - 'A';
+  }
+  if (c >= 'a' && c <= 'z')
+  {
+    return c - 'a' + 26;
+  }
+  if (c >= '0' && c <= '9')
+  {
+    return c - '0' + 52;
+  }
+  if (c == '+')
+  {
+    return 62;
+  }
+  if (c == '/')
+  {
+    return 63;
+  }
+  return -1;
+}
+
+// Decode standard base64, ignoring trailing padding
+std::vector<uint8_t> Base64::decode(const std::string &input)
+{
+  std::vector<uint8_t> output;
+  output.reserve((input.size() / 4) * 3);
+
+  uint32_t buffer = 0;
+  int bits = 0;
+  for (char c : input)
+  {
+    if (c == '=')
+    {
+      break;
+    }
+    int value = decodeChar(c);
+    if (value < 0)
+    {
+      throw std::invalid_argument("Invalid base64 character");
+    }
+    buffer = (buffer << 6) | static_cast<uint32_t>(value);
+    bits += 6;
+    if (bits >= 8)
+    {
+      bits -= 8;
+      output.push_back(static_cast<uint8_t>((buffer >> bits) & 0xFF));
+    }
+  }
+
+  return output;
+}
@@ -0,0 +1,24 @@
+#ifndef BASE64_H
+#define BASE64_H
+
+#include <cstdint>
+#include <vector>
+#include <string>
+
+class Base64
+{
+public:
+  static std::string encode(const std::vector<uint8_t> &input);
+  // Write the encoding of length bytes to output, which must hold
+  // encodedLength(length) characters
+  static void encode(const uint8_t *input, size_t length, char *output);
+  static size_t encodedLength(size_t length);
+  static std::vector<uint8_t> decode(const std::string &input);
+  // Value of one base64 character, -1 if it is not part of the alphabet
+  static int decodeChar(char c);
+
+private:
+  static const std::string ALPHABET;
+};
+
+#endif // BASE64_H
@@ -0,0 +1,400 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include "blake3.h"
+#include "hash.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BLAKE3_LANES_VECTOR 1
+#endif
+
+static const uint32_t BLAKE3_IV[8] = {
+    0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19};
+
+static const uint8_t MSG_SCHEDULE[7][16] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8},
+    {3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1},
+    {10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6},
+    {12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4},
+    {9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7},
+    {11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13},
+};
+
+enum Blake3Flags : uint32_t
+{
+    CHUNK_START = 1 << 0,
+    CHUNK_END = 1 << 1,
+    PARENT = 1 << 2,
+    ROOT = 1 << 3,
+};
+
+static inline uint32_t load32(const uint8_t *p)
+{
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// One round of the BLAKE3 G mixing function over any word type, scalar or
+// a vector holding the same word of several lanes
+template <typename W>
+static inline __attribute__((always_inline)) void g(W *v, size_t a, size_t b, size_t c, size_t d, W mx, W my)
+{
+    v[a] = v[a] + v[b] + mx;
+    v[d] = ((v[d] ^ v[a]) >> 16) | ((v[d] ^ v[a]) << 16);
+    v[c] = v[c] + v[d];
+    v[b] = ((v[b] ^ v[c]) >> 12) | ((v[b] ^ v[c]) << 20);
+    v[a] = v[a] + v[b] + my;
+    v[d] = ((v[d] ^ v[a]) >> 8) | ((v[d] ^ v[a]) << 24);
+    v[c] = v[c] + v[d];
+    v[b] = ((v[b] ^ v[c]) >> 7) | ((v[b] ^ v[c]) << 25);
+}
+
+template <typename W>
+static inline __attribute__((always_inline)) void rounds(W *v, const W *m)
+{
+    for (size_t r = 0; r < 7; ++r)
+    {
+        const uint8_t *s = MSG_SCHEDULE[r];
+        g(v, 0, 4, 8, 12, m[s[0]], m[s[1]]);
+        g(v, 1, 5, 9, 13, m[s[2]], m[s[3]]);
+        g(v, 2, 6, 10, 14, m[s[4]], m[s[5]]);
+        g(v, 3, 7, 11, 15, m[s[6]], m[s[7]]);
+        g(v, 0, 5, 10, 15, m[s[8]], m[s[9]]);
+        g(v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+        g(v, 2, 7, 8, 13, m[s[12]], m[s[13]]);
+        g(v, 3, 4, 9, 14, m[s[14]], m[s[15]]);
+    }
+}
+
+// Compress one block in place, leaving the new chaining value in cv
+static void compressInPlace(uint32_t cv[8], const uint8_t block[BLAKE3_BLOCK_LEN], uint8_t blockLen, uint64_t counter, uint32_t flags)
+{
+    uint32_t m[16];
+    for (size_t i = 0; i < 16; ++i)
+    {
+        m[i] = load32(block + 4 * i);
+    }
+    uint32_t v[16] = {
+        cv[0], cv[1], cv[2], cv[3], cv[4], cv[5], cv[6], cv[7],
+        BLAKE3_IV[0], BLAKE3_IV[1], BLAKE3_IV[2], BLAKE3_IV[3],
+        static_cast<uint32_t>(counter), static_cast<uint32_t>(counter >> 32), blockLen, flags};
+    rounds(v, m);
+    for (size_t i = 0; i < 8; ++i)
+    {
+        cv[i] = v[i] ^ v[i + 8];
+    }
+}
+
+// Hash whole chunks one at a time
+static void hashChunksScalar(const uint8_t *input, size_t numChunks, uint64_t counter, uint32_t (*out)[8])
+{
+    for (size_t c = 0; c < numChunks; ++c)
+    {
+        std::memcpy(out[c], BLAKE3_IV, sizeof(BLAKE3_IV));
+        for (size_t b = 0; b < BLAKE3_CHUNK_LEN / BLAKE3_BLOCK_LEN; ++b)
+        {
+            uint32_t flags = (b == 0 ? static_cast<uint32_t>(CHUNK_START) : 0u) | (b == BLAKE3_CHUNK_LEN / BLAKE3_BLOCK_LEN - 1 ? static_cast<uint32_t>(CHUNK_END) : 0u);
+            compressInPlace(out[c], input + c * BLAKE3_CHUNK_LEN + b * BLAKE3_BLOCK_LEN, BLAKE3_BLOCK_LEN, counter + c, flags);
+        }
+    }
+}
+
+#if defined(BLAKE3_LANES_VECTOR)
+template <size_t N>
+struct Blake3LaneVector
+{
+    typedef uint32_t type __attribute__((vector_size(4 * N)));
+};
+
+// Hash N whole chunks in parallel, one chunk per lane
+template <size_t N>
+static inline __attribute__((always_inline)) void hashChunksLanes(const uint8_t *input, size_t numChunks, uint64_t counter, uint32_t (*out)[8])
+{
+    typedef typename Blake3LaneVector<N>::type V;
+
+    V counterLow = V{};
+    V counterHigh = V{};
+    for (size_t lane = 0; lane < N; ++lane)
+    {
+        counterLow[lane] = static_cast<uint32_t>(counter + lane);
+        counterHigh[lane] = static_cast<uint32_t>((counter + lane) >> 32);
+    }
+
+    V cv[8];
+    for (size_t i = 0; i < 8; ++i)
+    {
+        cv[i] = V{} + BLAKE3_IV[i];
+    }
+
+    for (size_t b = 0; b < BLAKE3_CHUNK_LEN / BLAKE3_BLOCK_LEN; ++b)
+    {
+        V m[16];
+        for (size_t i = 0; i < 16; ++i)
+        {
+            for (size_t lane = 0; lane < N; ++lane)
+            {
+                // Lanes past numChunks hash a copy of chunk 0 and are dropped
+                size_t chunk = lane < numChunks ? lane : 0;
+                m[i][lane] = load32(input + chunk * BLAKE3_CHUNK_LEN + b * BLAKE3_BLOCK_LEN + 4 * i);
+            }
+        }
+
+        uint32_t flags = (b == 0 ? static_cast<uint32_t>(CHUNK_START) : 0u) | (b == BLAKE3_CHUNK_LEN / BLAKE3_BLOCK_LEN - 1 ? static_cast<uint32_t>(CHUNK_END) : 0u);
+        V v[16] = {
+            cv[0], cv[1], cv[2], cv[3], cv[4], cv[5], cv[6], cv[7],
+            V{} + BLAKE3_IV[0], V{} + BLAKE3_IV[1], V{} + BLAKE3_IV[2], V{} + BLAKE3_IV[3],
+            counterLow, counterHigh, V{} + static_cast<uint32_t>(BLAKE3_BLOCK_LEN), V{} + flags};
+        rounds(v, m);
+        for (size_t i = 0; i < 8; ++i)
+        {
+            cv[i] = v[i] ^ v[i + 8];
+        }
+    }
+
+    for (size_t lane = 0; lane < numChunks; ++lane)
+    {
+        for (size_t i = 0; i < 8; ++i)
+        {
+            out[lane][i] = cv[i][lane];
+        }
+    }
+}
+#endif
+
+#if defined(BLAKE3_LANES_VECTOR) && defined(__x86_64__)
+__attribute__((target("avx512f"))) static void hashChunksAvx512(const uint8_t *input, size_t numChunks, uint64_t counter, uint32_t (*out)[8])
+{
+    hashChunksLanes<16>(input, numChunks, counter, out);
+}
+
+__attribute__((target("avx2"))) static void hashChunksAvx2(const uint8_t *input, size_t numChunks, uint64_t counter, uint32_t (*out)[8])
+{
+    hashChunksLanes<8>(input, numChunks, counter, out);
+}
+
+__attribute__((target("sse4.1"))) static void hashChunksSse4(const uint8_t *input, size_t numChunks, uint64_t counter, uint32_t (*out)[8])
+{
+    hashChunksLanes<4>(input, numChunks, counter, out);
+}
+#elif defined(BLAKE3_LANES_VECTOR) && defined(__aarch64__)
+static void hashChunksNeon(const uint8_t *input, size_t numChunks, uint64_t counter, uint32_t (*out)[8])
+{
+    hashChunksLanes<4>(input, numChunks, counter, out);
+}
+#endif
+
+typedef void (*ChunkFunction)(const uint8_t *, size_t, uint64_t, uint32_t (*)[8]);
+
+struct ChunkImplementation
+{
+    const char *name;
+    size_t width;
+    ChunkFunction run;
+};
+
+// Check a lane implementation against the scalar path
+static bool selfTest(const ChunkImplementation &implementation)
+{
+    std::vector<uint8_t> input(implementation.width * BLAKE3_CHUNK_LEN);
+    for (size_t i = 0; i < input.size(); ++i)
+    {
+        input[i] = static_cast<uint8_t>(i % 251);
+    }
+    uint64_t counter = (1ULL << 32) - 1;
+    std::vector<uint32_t> expected(implementation.width * 8);
+    std::vector<uint32_t> actual(implementation.width * 8);
+    hashChunksScalar(input.data(), implementation.width, counter, reinterpret_cast<uint32_t(*)[8]>(expected.data()));
+    implementation.run(input.data(), implementation.width, counter, reinterpret_cast<uint32_t(*)[8]>(actual.data()));
+    return expected == actual;
+}
+
+static const ChunkImplementation &selectImplementation()
+{
+    static const ChunkImplementation selected = []
+    {
+        std::vector<ChunkImplementation> candidates;
+#if defined(BLAKE3_LANES_VECTOR) && defined(__x86_64__)
+        if (__builtin_cpu_supports("avx512f"))
+        {
+            candidates.push_back({"avx512", 16, hashChunksAvx512});
+        }
+        if (__builtin_cpu_supports("avx2"))
+        {
+            candidates.push_back({"avx2", 8, hashChunksAvx2});
+        }
+        if (__builtin_cpu_supports("sse4.1"))
+        {
+            candidates.push_back({"sse4.1", 4, hashChunksSse4});
+        }
+#elif defined(BLAKE3_LANES_VECTOR) && defined(__aarch64__)
+        candidates.push_back({"neon", 4, hashChunksNeon});
+#endif
+        for (const ChunkImplementation &candidate : candidates)
+        {
+            if (selfTest(candidate))
+            {
+                return candidate;
+            }
+        }
+        return ChunkImplementation{"portable", 1, hashChunksScalar};
+    }();
+    return selected;
+}
+
+const char *Blake3Hasher::implementation()
+{
+    return selectImplementation().name;
+}
+
+Blake3Hasher::Blake3Hasher() : cvStackLen(0)
+{
+    resetChunk(0);
+}
+
+size_t Blake3Hasher::chunkLen() const
+{
+    return BLAKE3_BLOCK_LEN * static_cast<size_t>(blocksCompressed) + blockLen;
+}
+
+void Blake3Hasher::resetChunk(uint64_t counter)
+{
+    std::memcpy(chunkCv, BLAKE3_IV, sizeof(chunkCv));
+    chunkCounter = counter;
+    blockLen = 0;
+    blocksCompressed = 0;
+}
+
+void Blake3Hasher::updateChunk(const uint8_t *input, size_t len)
+{
+    while (len > 0)
+    {
+        // Only compress a full block once more input is known to follow
+        if (blockLen == BLAKE3_BLOCK_LEN)
+        {
+            compressInPlace(chunkCv, block, BLAKE3_BLOCK_LEN, chunkCounter, blocksCompressed == 0 ? static_cast<uint32_t>(CHUNK_START) : 0u);
+            blocksCompressed++;
+            blockLen = 0;
+        }
+        size_t take = std::min(BLAKE3_BLOCK_LEN - blockLen, len);
+        std::memcpy(block + blockLen, input, take);
+        blockLen += take;
+        input += take;
+        len -= take;
+    }
+}
+
+// Merge completed subtrees, the number of trailing zero bits of totalChunks
+// tells how many are ready
+void Blake3Hasher::addChunkCv(const uint32_t cv[8], uint64_t totalChunks)
+{
+    uint32_t newCv[8];
+    std::memcpy(newCv, cv, sizeof(newCv));
+    while ((totalChunks & 1) == 0)
+    {
+        uint8_t parentBlock[BLAKE3_BLOCK_LEN];
+        cvStackLen--;
+        for (size_t i = 0; i < 8; ++i)
+        {
+            for (size_t j = 0; j < 4; ++j)
+            {
+                parentBlock[4 * i + j] = static_cast<uint8_t>(cvStack[cvStackLen][i] >> (8 * j));
+                parentBlock[32 + 4 * i + j] = static_cast<uint8_t>(newCv[i] >> (8 * j));
+            }
+        }
+        std::memcpy(newCv, BLAKE3_IV, sizeof(newCv));
+        compressInPlace(newCv, parentBlock, BLAKE3_BLOCK_LEN, 0, PARENT);
+        totalChunks >>= 1;
+    }
+    std::memcpy(cvStack[cvStackLen], newCv, sizeof(newCv));
+    cvStackLen++;
+}
+
+void Blake3Hasher::hash(const uint8_t *val, size_t len)
+{
+    const ChunkImplementation &lanes = selectImplementation();
+
+    while (len > 0)
+    {
+        if (chunkLen() == BLAKE3_CHUNK_LEN)
+        {
+            uint32_t cv[8];
+            std::memcpy(cv, chunkCv, sizeof(cv));
+            compressInPlace(cv, block, blockLen, chunkCounter, CHUNK_END | (blocksCompressed == 0 ? static_cast<uint32_t>(CHUNK_START) : 0u));
+            addChunkCv(cv, chunkCounter + 1);
+            resetChunk(chunkCounter + 1);
+        }
+
+        // Hash runs of whole chunks straight from the caller's buffer,
+        // always keeping the final chunk back for finalization
+        if (chunkLen() == 0 && len > BLAKE3_CHUNK_LEN)
+        {
+            size_t numChunks = std::min(lanes.width, (len - 1) / BLAKE3_CHUNK_LEN);
+            uint32_t cvs[16][8];
+            lanes.run(val, numChunks, chunkCounter, cvs);
+            for (size_t i = 0; i < numChunks; ++i)
+            {
+                addChunkCv(cvs[i], chunkCounter + i + 1);
+            }
+            resetChunk(chunkCounter + numChunks);
+            val += numChunks * BLAKE3_CHUNK_LEN;
+            len -= numChunks * BLAKE3_CHUNK_LEN;
+            continue;
+        }
+
+        size_t take = std::min(BLAKE3_CHUNK_LEN - chunkLen(), len);
+        updateChunk(val, take);
+        val += take;
+        len -= take;
+    }
+}
+
+void Blake3Hasher::hashv(const std::vector<ByteSpan> &vals)
+{
+    for (auto &val : vals)
+    {
+        this->hash(val.data, val.size);
+    }
+}
+
+void Blake3Hasher::result(Hash *hash)
+{
+    // Output node of the current chunk
+    uint32_t cv[8];
+    std::memcpy(cv, chunkCv, sizeof(cv));
+    uint8_t outBlock[BLAKE3_BLOCK_LEN];
+    std::memcpy(outBlock, block, blockLen);
+    std::memset(outBlock + blockLen, 0, BLAKE3_BLOCK_LEN - blockLen);
+    uint8_t outBlockLen = blockLen;
+    uint64_t outCounter = chunkCounter;
+    uint32_t outFlags = CHUNK_END | (blocksCompressed == 0 ? static_cast<uint32_t>(CHUNK_START) : 0u);
+
+    // Fold in the stacked subtrees from right to left
+    for (size_t remaining = cvStackLen; remaining > 0; --remaining)
+    {
+        compressInPlace(cv, outBlock, outBlockLen, outCounter, outFlags);
+        for (size_t i = 0; i < 8; ++i)
+        {
+            for (size_t j = 0; j < 4; ++j)
+            {
+                outBlock[4 * i + j] = static_cast<uint8_t>(cvStack[remaining - 1][i] >> (8 * j));
+                outBlock[32 + 4 * i + j] = static_cast<uint8_t>(cv[i] >> (8 * j));
+            }
+        }
+        std::memcpy(cv, BLAKE3_IV, sizeof(cv));
+        outBlockLen = BLAKE3_BLOCK_LEN;
+        outCounter = 0;
+        outFlags = PARENT;
+    }
+
+    compressInPlace(cv, outBlock, outBlockLen, outCounter, outFlags | ROOT);
+    for (size_t i = 0; i < 8; ++i)
+    {
+        for (size_t j = 0; j < 4; ++j)
+        {
+            hash->data[4 * i + j] = static_cast<uint8_t>(cv[i] >> (8 * j));
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef BLAKE3_H
+#define BLAKE3_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "hash.h"
+#include "byte_span.h"
+
+// Size of a BLAKE3 chunk in bytes
+constexpr size_t BLAKE3_CHUNK_LEN = 1024;
+// Size of a BLAKE3 block in bytes
+constexpr size_t BLAKE3_BLOCK_LEN = 64;
+// Enough chaining values for 2^54 chunks
+constexpr size_t BLAKE3_MAX_DEPTH = 54;
+
+// Streaming BLAKE3 hasher, a sibling of the SHA-256 Hasher. Whole chunks
+// are compressed several at a time in SIMD lanes when the CPU allows it.
+class Blake3Hasher
+{
+public:
+    Blake3Hasher();
+
+    void hash(const uint8_t *val, size_t len);
+    void hashv(const std::vector<ByteSpan> &vals);
+    void result(Hash *hash);
+
+    // Name of the chunk compression path picked for this CPU
+    static const char *implementation();
+
+private:
+    // State of the chunk currently being filled
+    uint32_t chunkCv[8];
+    uint64_t chunkCounter;
+    uint8_t block[BLAKE3_BLOCK_LEN];
+    uint8_t blockLen;
+    uint8_t blocksCompressed;
+
+    // Chaining values of completed subtrees
+    uint32_t cvStack[BLAKE3_MAX_DEPTH][8];
+    uint8_t cvStackLen;
+
+    size_t chunkLen() const;
+    void resetChunk(uint64_t counter);
+    void updateChunk(const uint8_t *input, size_t len);
+    void addChunkCv(const uint32_t cv[8], uint64_t totalChunks);
+};
+
+#endif // BLAKE3_H
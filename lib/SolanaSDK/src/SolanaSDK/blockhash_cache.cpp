@@ -0,0 +1,253 @@
+#include <cstdint>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <optional>
+#include <exception>
+#include <stdexcept>
+#include <condition_variable>
+#include "blockhash_cache.h"
+#include "connection.h"
+#include "rpc_batch.h"
+
+BlockhashCache::BlockhashCache(Connection connection, uint32_t refreshMs, uint64_t margin)
+    : connection(connection), refreshMs(refreshMs), margin(margin) {}
+
+BlockhashCache::~BlockhashCache()
+{
+  stop();
+}
+
+void BlockhashCache::start()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (running)
+  {
+    return;
+  }
+  running = true;
+  worker = std::thread(&BlockhashCache::run, this);
+}
+
+void BlockhashCache::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!running)
+    {
+      return;
+    }
+    running = false;
+  }
+  wake.notify_all();
+  if (worker.joinable())
+  {
+    worker.join();
+  }
+}
+
+void BlockhashCache::track(Commitment commitment)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry &entry = entries[static_cast<size_t>(commitment)];
+    if (entry.tracked)
+    {
+      return;
+    }
+    entry.tracked = true;
+    pending = true;
+  }
+  wake.notify_all();
+}
+
+// Background loop: refresh every tracked commitment that is due, stale or
+// close to expiry, then sleep until the next one is due or someone wakes us
+void BlockhashCache::run()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  while (running)
+  {
+    pending = false;
+    Clock::time_point now = Clock::now();
+    Clock::time_point next = now + std::chrono::milliseconds(refreshMs);
+
+    for (size_t i = 0; i < entries.size() && running; ++i)
+    {
+      Entry &entry = entries[i];
+      if (!entry.tracked)
+      {
+        continue;
+      }
+      Clock::time_point due = entry.refreshedAt + std::chrono::milliseconds(refreshMs);
+      if (entry.valid && !entry.stale && usable(entry) && due > now)
+      {
+        next = std::min(next, due);
+        continue;
+      }
+
+      lock.unlock();
+      bool refreshed = false;
+      try
+      {
+        refreshed = refresh(static_cast<Commitment>(i));
+      }
+      catch (const std::exception &)
+      {
+        // An exception escaping this thread would terminate the program,
+        // a refresh that threw is retried like any other failed one
+      }
+      lock.lock();
+
+      if (!refreshed)
+      {
+        // Retry failed refreshes sooner than the regular schedule
+        next = std::min(next, Clock::now() + std::chrono::milliseconds(refreshMs / 4));
+      }
+    }
+
+    wake.wait_until(lock, next, [this]
+                    { return !running || pending; });
+  }
+}
+
+// Fetch the blockhash and the current block height in one batch so the
+// height estimate starts from the same moment the blockhash was taken
+bool BlockhashCache::refresh(Commitment commitment)
+{
+  std::optional<BlockhashWithExpiryBlockHeight> blockhash;
+  std::optional<uint64_t> blockHeight;
+  uint64_t generation;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    generation = entries[static_cast<size_t>(commitment)].generation;
+  }
+
+  RpcBatch batch;
+  batch.getLatestBlockhash(commitment, [&blockhash](std::optional<BlockhashWithExpiryBlockHeight> result)
+                           { blockhash = result; });
+  batch.getBlockHeight(commitment, [&blockHeight](std::optional<uint64_t> result)
+                       { blockHeight = result; });
+
+  Clock::time_point observedAt = Clock::now();
+  if (!connection.sendBatch(batch) || !blockhash || !blockHeight)
+  {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  Entry &entry = entries[static_cast<size_t>(commitment)];
+  entry.valid = true;
+  // An invalidate() while the request was out may have been about this
+  // very blockhash
+  if (entry.generation == generation)
+  {
+    entry.stale = false;
+  }
+  entry.blockhash = *blockhash;
+  entry.observedBlockHeight = *blockHeight;
+  entry.observedAt = observedAt;
+  entry.refreshedAt = Clock::now();
+  return true;
+}
+
+uint64_t BlockhashCache::estimateBlockHeight(const Entry &entry) const
+{
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - entry.observedAt).count();
+  return entry.observedBlockHeight + static_cast<uint64_t>(elapsed) / BLOCKHASH_CACHE_SLOT_MS;
+}
+
+bool BlockhashCache::usable(const Entry &entry) const
+{
+  return entry.valid && estimateBlockHeight(entry) + margin < entry.blockhash.lastValidBlockHeight;
+}
+
+std::optional<BlockhashWithExpiryBlockHeight> BlockhashCache::get(Commitment commitment)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry &entry = entries[static_cast<size_t>(commitment)];
+    if (!entry.stale && usable(entry))
+    {
+      return entry.blockhash;
+    }
+    if (entry.tracked)
+    {
+      // Already being refreshed, don't hammer the node on every miss
+      return std::nullopt;
+    }
+    entry.tracked = true;
+    pending = true;
+  }
+  wake.notify_all();
+  return std::nullopt;
+}
+
+BlockhashWithExpiryBlockHeight BlockhashCache::getOrFetch(Commitment commitment)
+{
+  std::optional<BlockhashWithExpiryBlockHeight> cached = get(commitment);
+  if (cached)
+  {
+    return *cached;
+  }
+  if (!refreshNow(commitment))
+  {
+    throw std::runtime_error("Request failed");
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  return entries[static_cast<size_t>(commitment)].blockhash;
+}
+
+uint64_t BlockhashCache::remainingBlocks(Commitment commitment)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  const Entry &entry = entries[static_cast<size_t>(commitment)];
+  if (!entry.valid)
+  {
+    return 0;
+  }
+  uint64_t height = estimateBlockHeight(entry);
+  return height < entry.blockhash.lastValidBlockHeight ? entry.blockhash.lastValidBlockHeight - height : 0;
+}
+
+void BlockhashCache::invalidate(Commitment commitment)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry &entry = entries[static_cast<size_t>(commitment)];
+    entry.stale = true;
+    entry.generation++;
+    entry.tracked = true;
+    pending = true;
+  }
+  wake.notify_all();
+}
+
+void BlockhashCache::invalidateAll()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Entry &entry : entries)
+    {
+      entry.stale = entry.valid || entry.tracked;
+      entry.generation++;
+    }
+    pending = true;
+  }
+  wake.notify_all();
+}
+
+bool BlockhashCache::refreshNow(Commitment commitment)
+{
+  track(commitment);
+  return refresh(commitment);
+}
+
+bool BlockhashCache::isBlockhashError(const std::string &message)
+{
+  return message.find("Blockhash not found") != std::string::npos ||
+         message.find("BlockhashNotFound") != std::string::npos ||
+         message.find("block height exceeded") != std::string::npos;
+}
@@ -0,0 +1,102 @@
+#ifndef BLOCKHASH_CACHE_H
+#define BLOCKHASH_CACHE_H
+
+#include <cstdint>
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <optional>
+#include <condition_variable>
+#include "connection.h"
+
+// How often the cached blockhashes are refreshed in the background
+constexpr uint32_t BLOCKHASH_CACHE_DEFAULT_REFRESH_MS = 5000;
+
+// Average slot duration used to estimate the current block height
+constexpr uint32_t BLOCKHASH_CACHE_SLOT_MS = 400;
+
+// A cached blockhash with fewer remaining blocks than this is treated as
+// expired, leaving time for the transaction to land
+constexpr uint64_t BLOCKHASH_CACHE_DEFAULT_MARGIN = 30;
+
+// Latest blockhash per commitment, refreshed on a background thread.
+// The current block height is extrapolated locally from the last observed
+// height, so get() can tell how close a cached hash is to expiry without
+// touching the network.
+class BlockhashCache
+{
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Entry
+  {
+    bool tracked = false;
+    bool valid = false;
+    // Set by invalidate() to force the next refresh
+    bool stale = false;
+    // Bumped by invalidate(), so a refresh that was already in flight
+    // leaves stale set
+    uint64_t generation = 0;
+    BlockhashWithExpiryBlockHeight blockhash;
+    uint64_t observedBlockHeight = 0;
+    Clock::time_point observedAt;
+    Clock::time_point refreshedAt;
+  };
+
+  Connection connection;
+  std::array<Entry, 3> entries;
+  uint32_t refreshMs;
+  uint64_t margin;
+  bool running = false;
+  // Set when a caller needs the refresher to look at the entries early
+  bool pending = false;
+  std::thread worker;
+  std::mutex mutex;
+  std::condition_variable wake;
+
+  void run();
+  bool refresh(Commitment commitment);
+  uint64_t estimateBlockHeight(const Entry &entry) const;
+  bool usable(const Entry &entry) const;
+
+public:
+  BlockhashCache(Connection connection, uint32_t refreshMs = BLOCKHASH_CACHE_DEFAULT_REFRESH_MS, uint64_t margin = BLOCKHASH_CACHE_DEFAULT_MARGIN);
+
+  ~BlockhashCache();
+
+  BlockhashCache(const BlockhashCache &) = delete;
+  BlockhashCache &operator=(const BlockhashCache &) = delete;
+
+  // Start the background refresher
+  void start();
+
+  void stop();
+
+  // Keep the blockhash for this commitment fresh
+  void track(Commitment commitment);
+
+  // Cached blockhash, or empty if none is cached or it is about to expire.
+  // Never blocks on the network; a miss starts tracking the commitment.
+  std::optional<BlockhashWithExpiryBlockHeight> get(Commitment commitment);
+
+  // Cached blockhash, fetching one on the caller's thread on a miss
+  BlockhashWithExpiryBlockHeight getOrFetch(Commitment commitment);
+
+  // Estimated blocks left before the cached blockhash expires, 0 if none
+  uint64_t remainingBlocks(Commitment commitment);
+
+  // Drop the cached blockhash and wake the refresher, e.g. after a send
+  // was rejected because the blockhash was not found or had expired
+  void invalidate(Commitment commitment);
+
+  void invalidateAll();
+
+  // Refresh on the caller's thread. Returns false if the request failed.
+  bool refreshNow(Commitment commitment);
+
+  // True if an RPC error message reports a missing or expired blockhash
+  static bool isBlockhashError(const std::string &message);
+};
+
+#endif // BLOCKHASH_CACHE_H
@@ -0,0 +1,26 @@
+#ifndef BYTE_SPAN_H
+#define BYTE_SPAN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <array>
+
+// Non-owning view over a contiguous run of bytes
+struct ByteSpan
+{
+  const uint8_t *data = nullptr;
+  size_t size = 0;
+
+  ByteSpan() = default;
+  ByteSpan(const uint8_t *data, size_t size) : data(data), size(size) {}
+  ByteSpan(const std::vector<uint8_t> &bytes) : data(bytes.data()), size(bytes.size()) {}
+  template <size_t N>
+  ByteSpan(const std::array<uint8_t, N> &bytes) : data(bytes.data()), size(N) {}
+
+  const uint8_t *begin() const { return data; }
+  const uint8_t *end() const { return data + size; }
+  bool empty() const { return size == 0; }
+};
+
+#endif // BYTE_SPAN_H
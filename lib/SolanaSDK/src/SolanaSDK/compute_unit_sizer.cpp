@@ -0,0 +1,140 @@
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <map>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <mutex>
+#include "compute_unit_sizer.h"
+#include "message.h"
+#include "transaction.h"
+#include "programs/compute_budget.h"
+
+ComputeUnitSizer::ComputeUnitSizer(Connection connection, uint32_t marginPercent)
+    : connection(connection), marginPercent(marginPercent) {}
+
+static bool isComputeUnitLimit(const Instruction &instruction)
+{
+  return instruction.programId == ComputeBudgetProgram::id() && !instruction.data.empty() &&
+         instruction.data[0] == static_cast<uint8_t>(ComputeBudgetInstruction::SetComputeUnitLimit);
+}
+
+std::vector<Instruction> ComputeUnitSizer::withoutLimit(const std::vector<Instruction> &instructions)
+{
+  std::vector<Instruction> result;
+  result.reserve(instructions.size() + 1);
+  for (const auto &instruction : instructions)
+  {
+    if (!isComputeUnitLimit(instruction))
+    {
+      result.push_back(instruction);
+    }
+  }
+  return result;
+}
+
+// Everything that decides which code runs: the discriminator at the start
+// of the data selects the instruction, while the arguments after it, like
+// amounts, rarely change the cost
+std::string ComputeUnitSizer::shapeOf(const std::vector<Instruction> &instructions, const std::optional<PublicKey> &payer)
+{
+  std::string shape;
+  shape.push_back(payer ? 1 : 0);
+  if (payer)
+  {
+    shape.append(reinterpret_cast<const char *>(payer->key), PUBLIC_KEY_LEN);
+  }
+  for (const auto &instruction : instructions)
+  {
+    shape.append(reinterpret_cast<const char *>(instruction.programId.key), PUBLIC_KEY_LEN);
+    shape.push_back(static_cast<char>(instruction.accounts.size()));
+    for (const auto &account : instruction.accounts)
+    {
+      shape.append(reinterpret_cast<const char *>(account.publicKey.key), PUBLIC_KEY_LEN);
+      shape.push_back(static_cast<char>((account.isSigner ? 1 : 0) | (account.isWritable ? 2 : 0)));
+    }
+    uint32_t dataLength = static_cast<uint32_t>(instruction.data.size());
+    shape.append(reinterpret_cast<const char *>(&dataLength), sizeof(dataLength));
+    size_t discriminator = std::min(instruction.data.size(), COMPUTE_UNIT_SHAPE_DATA_BYTES);
+    shape.append(reinterpret_cast<const char *>(instruction.data.data()), discriminator);
+  }
+  return shape;
+}
+
+uint32_t ComputeUnitSizer::computeUnitLimit(const std::vector<Instruction> &instructions, std::optional<PublicKey> payer)
+{
+  std::vector<Instruction> body = withoutLimit(instructions);
+  std::string shape = shapeOf(body, payer);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = cache.find(shape);
+    if (found != cache.end() && Clock::now() - found->second.simulatedAt < std::chrono::milliseconds(COMPUTE_UNIT_CACHE_TTL_MS))
+    {
+      return found->second.units;
+    }
+  }
+
+  // Simulate under the largest limit so the usage is not cut short; the
+  // SetComputeUnitLimit it costs is counted in the result
+  body.insert(body.begin(), ComputeBudgetProgram::setComputeUnitLimit(MAX_COMPUTE_UNIT_LIMIT));
+  Transaction transaction = Transaction::newUnsigned(Message(body, payer));
+  SimulationResult simulation = connection.simulateTransaction(transaction);
+  if (simulation.err)
+  {
+    throw std::runtime_error("Simulation failed: " + *simulation.err);
+  }
+  if (!simulation.unitsConsumed)
+  {
+    throw std::runtime_error("Simulation did not report unitsConsumed");
+  }
+
+  uint64_t used = *simulation.unitsConsumed;
+  uint64_t margin = std::max<uint64_t>(used * marginPercent / 100, COMPUTE_UNIT_MIN_MARGIN);
+  uint32_t units = static_cast<uint32_t>(std::min<uint64_t>(used + margin, MAX_COMPUTE_UNIT_LIMIT));
+
+  std::lock_guard<std::mutex> lock(mutex);
+  if (cache.size() >= COMPUTE_UNIT_CACHE_CAPACITY && cache.find(shape) == cache.end())
+  {
+    // Drop the stalest limit
+    auto oldest = std::min_element(cache.begin(), cache.end(), [](const auto &a, const auto &b)
+                                   { return a.second.simulatedAt < b.second.simulatedAt; });
+    cache.erase(oldest);
+  }
+  cache[shape] = Entry{units, Clock::now()};
+  return units;
+}
+
+std::vector<Instruction> ComputeUnitSizer::withComputeUnitLimit(const std::vector<Instruction> &instructions, std::optional<PublicKey> payer)
+{
+  Instruction limit = ComputeBudgetProgram::setComputeUnitLimit(computeUnitLimit(instructions, payer));
+  std::vector<Instruction> result;
+  result.reserve(instructions.size() + 1);
+  bool replaced = false;
+  for (const auto &instruction : instructions)
+  {
+    if (isComputeUnitLimit(instruction))
+    {
+      // A transaction may only carry one; keep the first in place
+      if (!replaced)
+      {
+        result.push_back(limit);
+        replaced = true;
+      }
+      continue;
+    }
+    result.push_back(instruction);
+  }
+  if (!replaced)
+  {
+    result.insert(result.begin(), limit);
+  }
+  return result;
+}
+
+void ComputeUnitSizer::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  cache.clear();
+}
@@ -0,0 +1,76 @@
+#ifndef COMPUTE_UNIT_SIZER_H
+#define COMPUTE_UNIT_SIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <map>
+#include <vector>
+#include <chrono>
+#include <optional>
+#include <mutex>
+#include "connection.h"
+#include "instruction.h"
+#include "public_key.h"
+
+// Headroom added to the simulated usage
+constexpr uint32_t COMPUTE_UNIT_DEFAULT_MARGIN_PERCENT = 10;
+constexpr uint32_t COMPUTE_UNIT_MIN_MARGIN = 1000;
+
+// Transaction shapes whose limit is kept
+constexpr size_t COMPUTE_UNIT_CACHE_CAPACITY = 64;
+
+// Leading instruction data bytes that are part of a shape. They hold the
+// instruction discriminator: 1 byte for SPL Token, 4 for the System
+// program and 8 for Anchor programs.
+constexpr size_t COMPUTE_UNIT_SHAPE_DATA_BYTES = 8;
+
+// How long a limit is reused before the shape is simulated again, in case
+// a program was upgraded
+constexpr uint32_t COMPUTE_UNIT_CACHE_TTL_MS = 10 * 60 * 1000;
+
+// Sizes the compute unit limit of a transaction from a simulation of it.
+// A tight limit costs less at a given unit price and lets the scheduler
+// fit the transaction in sooner. Limits are cached per transaction shape
+// (payer, programs, account metas, instruction data lengths and the first
+// COMPUTE_UNIT_SHAPE_DATA_BYTES of each instruction's data), so repeats
+// that differ only in later arguments, e.g. token transfers of different
+// amounts, are not simulated again.
+class ComputeUnitSizer
+{
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Entry
+  {
+    uint32_t units;
+    Clock::time_point simulatedAt;
+  };
+
+  Connection connection;
+  uint32_t marginPercent;
+  std::map<std::string, Entry> cache;
+  std::mutex mutex;
+
+  static std::vector<Instruction> withoutLimit(const std::vector<Instruction> &instructions);
+  static std::string shapeOf(const std::vector<Instruction> &instructions, const std::optional<PublicKey> &payer);
+
+public:
+  ComputeUnitSizer(Connection connection, uint32_t marginPercent = COMPUTE_UNIT_DEFAULT_MARGIN_PERCENT);
+
+  ComputeUnitSizer(const ComputeUnitSizer &) = delete;
+  ComputeUnitSizer &operator=(const ComputeUnitSizer &) = delete;
+
+  // Compute unit limit for the transaction: simulated usage plus the
+  // margin. Any SetComputeUnitLimit in instructions is ignored. Throws if
+  // the simulated transaction fails.
+  uint32_t computeUnitLimit(const std::vector<Instruction> &instructions, std::optional<PublicKey> payer);
+
+  // instructions with their SetComputeUnitLimit replaced by, or preceded
+  // by, one for computeUnitLimit(instructions, payer)
+  std::vector<Instruction> withComputeUnitLimit(const std::vector<Instruction> &instructions, std::optional<PublicKey> payer);
+
+  void clear();
+};
+
+#endif // COMPUTE_UNIT_SIZER_H
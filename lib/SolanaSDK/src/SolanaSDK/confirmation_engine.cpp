@@ -0,0 +1,310 @@
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <future>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <optional>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <ArduinoJson.h>
+#include "confirmation_engine.h"
+#include "connection.h"
+#include "rpc_batch.h"
+#include "rpc_request_writer.h"
+
+ConfirmationEngine::ConfirmationEngine(Connection connection, ConfirmationOptions options)
+    : connection(connection), options(options) {}
+
+ConfirmationEngine::~ConfirmationEngine()
+{
+  stop();
+}
+
+void ConfirmationEngine::start()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (running)
+  {
+    return;
+  }
+  running = true;
+  worker = std::thread(&ConfirmationEngine::run, this);
+}
+
+void ConfirmationEngine::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!running)
+    {
+      return;
+    }
+    running = false;
+  }
+  wake.notify_all();
+  if (worker.joinable())
+  {
+    worker.join();
+  }
+}
+
+void ConfirmationEngine::run()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  while (running)
+  {
+    lock.unlock();
+    bool polled = false;
+    try
+    {
+      polled = tick();
+    }
+    catch (const std::exception &)
+    {
+      // A malformed reply must not end the thread, the next tick polls
+      // again
+    }
+    lock.lock();
+    if (!polled)
+    {
+      failures++;
+    }
+    wake.wait_for(lock, std::chrono::milliseconds(options.pollIntervalMs), [this]
+                  { return !running; });
+  }
+}
+
+// Statuses from nodes that predate confirmationStatus only say whether the
+// transaction is rooted
+bool ConfirmationEngine::reached(const SignatureStatus &status, Commitment commitment)
+{
+  Commitment level = status.confirmationStatus
+                         ? *status.confirmationStatus
+                         : (status.confirmations ? Commitment::processed : Commitment::finalized);
+  return static_cast<int>(level) >= static_cast<int>(commitment);
+}
+
+std::future<ConfirmationResult> ConfirmationEngine::track(const Signature &signature, std::vector<uint8_t> rawTransaction, uint64_t lastValidBlockHeight, Commitment commitment)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (entries.count(signature) > 0)
+  {
+    throw std::invalid_argument("Signature is already tracked");
+  }
+  Entry &entry = entries[signature];
+  entry.rawTransaction = std::make_shared<const std::vector<uint8_t>>(std::move(rawTransaction));
+  entry.lastValidBlockHeight = lastValidBlockHeight;
+  entry.commitment = commitment;
+  return entry.promise.get_future();
+}
+
+std::future<ConfirmationResult> ConfirmationEngine::track(const Signature &signature, std::vector<uint8_t> rawTransaction, uint64_t lastValidBlockHeight)
+{
+  return track(signature, std::move(rawTransaction), lastValidBlockHeight, options.commitment);
+}
+
+std::future<ConfirmationResult> ConfirmationEngine::send(Transaction transaction, uint64_t lastValidBlockHeight, Commitment commitment)
+{
+  if (transaction.signatures.empty())
+  {
+    throw std::invalid_argument("Transaction is not signed");
+  }
+  // Known before sending, the reply only echoes it
+  Signature signature = transaction.signatures.front();
+  std::vector<uint8_t> rawTransaction = transaction.serialize();
+
+  // The engine rebroadcasts on its own schedule, the node does not need to
+  SendOptions sendOptions;
+  sendOptions.maxRetires = 0;
+  connection.sendRawTransaction(rawTransaction, sendOptions);
+  return track(signature, std::move(rawTransaction), lastValidBlockHeight, commitment);
+}
+
+std::future<ConfirmationResult> ConfirmationEngine::send(Transaction transaction, uint64_t lastValidBlockHeight)
+{
+  return send(transaction, lastValidBlockHeight, options.commitment);
+}
+
+bool ConfirmationEngine::notify(const Signature &signature, uint64_t slot, bool failed, Commitment commitment)
+{
+  std::promise<ConfirmationResult> promise;
+  ConfirmationResult result;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(signature);
+    if (it == entries.end())
+    {
+      return false;
+    }
+    Entry &entry = it->second;
+    entry.landed = true;
+    if (static_cast<int>(commitment) < static_cast<int>(entry.commitment))
+    {
+      return false;
+    }
+    result = ConfirmationResult{signature, failed ? ConfirmationStatus::failed : ConfirmationStatus::confirmed, slot, entry.rebroadcasts};
+    promise = std::move(entry.promise);
+    entries.erase(it);
+  }
+  promise.set_value(result);
+  return true;
+}
+
+// One round trip: statuses of every tracked signature, the block height
+// for expiry and rebroadcast pacing, and the rebroadcasts that are due
+bool ConfirmationEngine::tick()
+{
+  std::vector<Signature> signatures;
+  std::vector<std::shared_ptr<const std::vector<uint8_t>>> due;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (entries.empty())
+    {
+      return true;
+    }
+    signatures.reserve(entries.size());
+    for (auto &item : entries)
+    {
+      signatures.push_back(item.first);
+      Entry &entry = item.second;
+      if (blockHeight == 0 || entry.landed || blockHeight > entry.lastValidBlockHeight)
+      {
+        continue;
+      }
+      if (entry.sentAtBlockHeight == 0)
+      {
+        // Sent by the caller just before it was tracked
+        entry.sentAtBlockHeight = blockHeight;
+      }
+      else if (blockHeight >= entry.sentAtBlockHeight + options.rebroadcastBlocks && due.size() < options.maxRebroadcastsPerTick)
+      {
+        entry.sentAtBlockHeight = blockHeight;
+        entry.rebroadcasts++;
+        due.push_back(entry.rawTransaction);
+      }
+    }
+  }
+
+  // The block height rides along with the first batch of statuses
+  RpcBatch batch;
+  std::optional<uint64_t> latestBlockHeight;
+  batch.getBlockHeight(Commitment::confirmed, [&latestBlockHeight](std::optional<uint64_t> result)
+                       { latestBlockHeight = result; });
+
+  std::vector<std::optional<SignatureStatus>> statuses(signatures.size());
+  std::vector<bool> answered(signatures.size(), false);
+  size_t calls = 0;
+  for (size_t start = 0; start < signatures.size(); start += CONFIRMATION_STATUSES_PER_CALL)
+  {
+    size_t end = std::min(start + CONFIRMATION_STATUSES_PER_CALL, signatures.size());
+    std::vector<Signature> chunk(signatures.begin() + start, signatures.begin() + end);
+    batch.getSignatureStatuses(chunk, [&statuses, &answered, start](std::vector<std::optional<SignatureStatus>> result)
+                               {
+                                 for (size_t i = 0; i < result.size(); ++i)
+                                 {
+                                   statuses[start + i] = result[i];
+                                   answered[start + i] = true;
+                                 } });
+    if (++calls % CONFIRMATION_STATUS_CALLS_PER_BATCH == 0 || end == signatures.size())
+    {
+      if (!connection.sendBatch(batch))
+      {
+        return false;
+      }
+      batch.clear();
+    }
+  }
+  if (!latestBlockHeight)
+  {
+    return false;
+  }
+
+  std::vector<std::pair<std::promise<ConfirmationResult>, ConfirmationResult>> resolved;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    blockHeight = std::max(blockHeight, *latestBlockHeight);
+    for (size_t i = 0; i < signatures.size(); ++i)
+    {
+      if (!answered[i])
+      {
+        continue;
+      }
+      auto it = entries.find(signatures[i]);
+      if (it == entries.end())
+      {
+        continue;
+      }
+      Entry &entry = it->second;
+      const std::optional<SignatureStatus> &status = statuses[i];
+      if (status)
+      {
+        entry.landed = true;
+        if (!reached(*status, entry.commitment))
+        {
+          continue;
+        }
+        ConfirmationStatus outcome = status->failed ? ConfirmationStatus::failed : ConfirmationStatus::confirmed;
+        resolved.emplace_back(std::move(entry.promise), ConfirmationResult{signatures[i], outcome, status->slot, entry.rebroadcasts});
+      }
+      else if (*latestBlockHeight > entry.lastValidBlockHeight)
+      {
+        resolved.emplace_back(std::move(entry.promise), ConfirmationResult{signatures[i], ConfirmationStatus::expired, 0, entry.rebroadcasts});
+      }
+      else
+      {
+        // Not seen yet, or dropped with a minority fork: keep sending it
+        entry.landed = false;
+        continue;
+      }
+      entries.erase(it);
+    }
+  }
+
+  for (auto &item : resolved)
+  {
+    item.first.set_value(item.second);
+  }
+
+  // Rebroadcasts skip preflight and node-side retries, their results are
+  // not needed since the status poll tells whether they landed
+  bool sent = true;
+  for (size_t i = 0; i < due.size(); ++i)
+  {
+    std::shared_ptr<const std::vector<uint8_t>> rawTransaction = due[i];
+    batch.add(
+        "sendTransaction",
+        [rawTransaction](RpcRequestWriter &params)
+        {
+          params.base64(*rawTransaction);
+          params.beginObject();
+          params.key("encoding").string("base64");
+          params.key("skipPreflight").boolean(true);
+          params.key("maxRetries").number(0);
+          params.endObject();
+        },
+        [](JsonVariantConst, JsonVariantConst) {});
+    if ((i + 1) % CONFIRMATION_SENDS_PER_BATCH == 0 || i + 1 == due.size())
+    {
+      sent = connection.sendBatch(batch) && sent;
+      batch.clear();
+    }
+  }
+  return sent;
+}
+
+size_t ConfirmationEngine::failedTicks()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return failures;
+}
+
+size_t ConfirmationEngine::inFlight()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return entries.size();
+}
@@ -0,0 +1,134 @@
+#ifndef CONFIRMATION_ENGINE_H
+#define CONFIRMATION_ENGINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <condition_variable>
+#include "connection.h"
+#include "transaction.h"
+#include "signature.h"
+
+// Signatures per getSignatureStatuses call, as many as the node accepts
+constexpr size_t CONFIRMATION_STATUSES_PER_CALL = GET_SIGNATURE_STATUSES_LIMIT;
+
+// getSignatureStatuses calls per batch request. Each signature adds about
+// 90 bytes to the request body, which is built in memory.
+constexpr size_t CONFIRMATION_STATUS_CALLS_PER_BATCH = 4;
+
+// Rebroadcasts per batch request, each up to 1644 bytes of base64
+constexpr size_t CONFIRMATION_SENDS_PER_BATCH = 16;
+
+struct ConfirmationOptions
+{
+  // Commitment the futures resolve at when track() is given none
+  Commitment commitment = Commitment::confirmed;
+  // Time between status polls, one slot by default
+  uint32_t pollIntervalMs = 400;
+  // Blocks to wait after a send before sending the same bytes again
+  uint64_t rebroadcastBlocks = 4;
+  // Upper bound on rebroadcasts per poll so a large backlog cannot blow
+  // up the size of a single batch
+  size_t maxRebroadcastsPerTick = 512;
+};
+
+enum class ConfirmationStatus
+{
+  // Reached the requested commitment and succeeded
+  confirmed,
+  // Reached the requested commitment with an error
+  failed,
+  // Never seen before the block height passed lastValidBlockHeight
+  expired
+};
+
+struct ConfirmationResult
+{
+  Signature signature;
+  ConfirmationStatus status;
+  // Slot the transaction landed in, 0 if expired
+  uint64_t slot;
+  uint32_t rebroadcasts;
+};
+
+// Confirms every in-flight transaction from one table. Each tick polls
+// getBlockHeight and getSignatureStatuses for all pending signatures (in
+// chunks of 256, a few chunks per batch request), then sends the raw bytes
+// of transactions that are due for a rebroadcast in batches of their own.
+// Futures resolve once the requested commitment is reached, or as expired
+// when the block height passes lastValidBlockHeight.
+//
+// Notifications from a PubSubConnection can be fed in through notify() to
+// resolve signatures between polls.
+class ConfirmationEngine
+{
+private:
+  struct Entry
+  {
+    std::shared_ptr<const std::vector<uint8_t>> rawTransaction;
+    uint64_t lastValidBlockHeight;
+    Commitment commitment;
+    // Block height of the last send, unknown until the first poll
+    uint64_t sentAtBlockHeight = 0;
+    uint32_t rebroadcasts = 0;
+    // Set once the node reports a status; landed transactions are not sent again
+    bool landed = false;
+    std::promise<ConfirmationResult> promise;
+  };
+
+  Connection connection;
+  ConfirmationOptions options;
+  std::unordered_map<Signature, Entry, SignatureHash> entries;
+  uint64_t blockHeight = 0;
+  // Background ticks that failed or threw
+  size_t failures = 0;
+  bool running = false;
+  std::thread worker;
+  std::mutex mutex;
+  std::condition_variable wake;
+
+  void run();
+  static bool reached(const SignatureStatus &status, Commitment commitment);
+
+public:
+  ConfirmationEngine(Connection connection, ConfirmationOptions options = ConfirmationOptions());
+
+  // Pending futures are broken if the engine is destroyed before they resolve
+  ~ConfirmationEngine();
+
+  ConfirmationEngine(const ConfirmationEngine &) = delete;
+  ConfirmationEngine &operator=(const ConfirmationEngine &) = delete;
+
+  // Start polling on a background thread
+  void start();
+
+  void stop();
+
+  // Track a transaction that has already been sent once
+  std::future<ConfirmationResult> track(const Signature &signature, std::vector<uint8_t> rawTransaction, uint64_t lastValidBlockHeight, Commitment commitment);
+  std::future<ConfirmationResult> track(const Signature &signature, std::vector<uint8_t> rawTransaction, uint64_t lastValidBlockHeight);
+
+  // Send a signed transaction and track it under its own first signature.
+  // Send errors are thrown here.
+  std::future<ConfirmationResult> send(Transaction transaction, uint64_t lastValidBlockHeight, Commitment commitment);
+  std::future<ConfirmationResult> send(Transaction transaction, uint64_t lastValidBlockHeight);
+
+  // Report a status seen elsewhere, e.g. a signature notification. Returns
+  // true if it resolved a tracked signature.
+  bool notify(const Signature &signature, uint64_t slot, bool failed, Commitment commitment);
+
+  // Poll once on the caller's thread. Returns false if the request failed.
+  bool tick();
+
+  // Ticks of the background thread that failed, including ones that threw
+  size_t failedTicks();
+
+  size_t inFlight();
+};
+
+#endif // CONFIRMATION_ENGINE_H
@@ -1,9 +1,15 @@
 #include <string>
+#include <vector>
+#include <optional>
+#include <algorithm>
 #include <ArduinoJson.h>
 #include "connection.h"
 #include "hash.h"
 #include "base58.h"
-#include "send_request.h"
+#include "base64.h"
+#include "rpc_batch.h"
+#include "rpc_request_writer.h"
+#include "program_accounts.h"
 
 std::string to_string(Commitment commitment)
 {
@@ -19,95 +25,170 @@ std::string to_string(Commitment commitment)
   return ""; // Default case, should not be reached
 }
 
-String Connection::createRequestPayload(uint16_t id, const std::string &method, JsonObject &additionalParams)
+std::optional<Commitment> commitmentFromString(const char *commitment)
 {
-  StaticJsonDocument<1024> doc;
-  doc["id"] = id;
-  doc["jsonrpc"] = "2.0";
-  doc["method"] = method.c_str();
+  if (commitment == nullptr)
+  {
+    return std::nullopt;
+  }
+  std::string value(commitment);
+  if (value == "processed")
+  {
+    return Commitment::processed;
+  }
+  if (value == "confirmed")
+  {
+    return Commitment::confirmed;
+  }
+  if (value == "finalized")
+  {
+    return Commitment::finalized;
+  }
+  return std::nullopt;
+}
 
-  // Create a JsonArray for params
-  JsonArray paramsArray = doc.createNestedArray("params");
-  paramsArray.add(additionalParams); // Add the JsonObject as an element of the array
+Connection::Connection(std::shared_ptr<Transport> transport, Commitment commitment)
+{
+  this->commitment = commitment;
+  this->transport = transport;
+  this->requestIds = std::make_shared<std::atomic<uint32_t>>(1);
+  this->executor = std::make_shared<RpcExecutor>(transport->maxConcurrency());
+}
 
-  String requestPayload;
-  serializeJson(doc, requestPayload);
-  return requestPayload;
+Connection::Connection(std::string endpoint, Commitment commitment, size_t maxConnections)
+    : Connection(Transport::forEndpoint(endpoint, maxConnections), commitment)
+{
+  this->rpcEndpoint = endpoint;
 }
 
-String Connection::createRequestPayload(uint16_t id, const std::string &method, JsonArray &additionalParams)
+Connection::Connection(std::string endpoint, Commitment commitment)
+    : Connection(endpoint, commitment, TRANSPORT_DEFAULT_MAX_CONNECTIONS) {}
+
+Connection::Connection(std::string endpoint)
+    : Connection(endpoint, Commitment::processed, TRANSPORT_DEFAULT_MAX_CONNECTIONS) {}
+
+size_t Connection::warmup()
 {
-  StaticJsonDocument<1024> doc;
-  doc["id"] = id;
-  doc["jsonrpc"] = "2.0";
-  doc["method"] = method.c_str();
+  return transport->warmup();
+}
 
-  // Create a JsonArray for params
-  doc["params"] = additionalParams;
+Connection Connection::withDeadline(uint32_t timeoutMs) const
+{
+  Connection copy = *this;
+  copy.context.deadline = Deadline::earliest(context.deadline, Deadline::after(timeoutMs));
+  return copy;
+}
 
-  String requestPayload;
-  serializeJson(doc, requestPayload);
-  return requestPayload;
+Connection Connection::withCancellation(CancellationToken token) const
+{
+  Connection copy = *this;
+  copy.context.token = token;
+  return copy;
 }
 
-Connection::Connection(std::string endpoint, Commitment commitment)
+Connection Connection::withContext(RequestContext context) const
 {
-  this->rpcEndpoint = endpoint;
-  this->commitment = commitment;
+  Connection copy = *this;
+  copy.context = context;
+  return copy;
 }
 
-Connection::Connection(std::string endpoint)
+bool Connection::sendRequest(const std::string &requestPayload, JsonDocument &responseDoc, const JsonDocument &filter)
 {
-  this->rpcEndpoint = endpoint;
-  this->commitment = Commitment::processed;
+  ByteSpan request(reinterpret_cast<const uint8_t *>(requestPayload.data()), requestPayload.size());
+  return transport->post(request, [&responseDoc, &filter](ResponseReader &body)
+                         {
+                           DeserializationError error = deserializeJson(responseDoc, body, DeserializationOption::Filter(filter));
+                           return !error; }, context);
 }
 
-BlockhashWithExpiryBlockHeight Connection::_getLatestBlockhash(Commitment commitment)
+bool Connection::sendRequest(const std::string &requestPayload, JsonDocument &responseDoc)
+{
+  ByteSpan request(reinterpret_cast<const uint8_t *>(requestPayload.data()), requestPayload.size());
+  return transport->post(request, [&responseDoc](ResponseReader &body)
+                         {
+                           DeserializationError error = deserializeJson(responseDoc, body);
+                           return !error; }, context);
+}
+
+void Connection::checkRpcError(const JsonDocument &responseDoc)
+{
+  if (!responseDoc["error"].isNull())
+  {
+    const char *message = responseDoc["error"]["message"];
+    throw RpcException(RpcErrorCode::rpc, message != nullptr ? message : "RPC error");
+  }
+}
+
+void Connection::requestFailed() const
+{
+  std::optional<RpcErrorCode> reason = context.stopReason();
+  if (reason == RpcErrorCode::timeout)
+  {
+    throw RpcException(RpcErrorCode::timeout, "Request timed out");
+  }
+  if (reason == RpcErrorCode::cancelled)
+  {
+    throw RpcException(RpcErrorCode::cancelled, "Request cancelled");
+  }
+  throw RpcException(RpcErrorCode::transport, "Request failed");
+}
+
+uint32_t Connection::nextRequestId()
 {
-  // Create a JSON document to hold the request payload
-  DynamicJsonDocument doc(256);
-  JsonObject params = doc.to<JsonObject>();
+  return (*requestIds)++;
+}
 
-  // Add the commitment parameter to the params object
-  params["commitment"] = to_string(commitment);
+BlockhashWithExpiryBlockHeight Connection::_getLatestBlockhash(Commitment commitment)
+{
+  // Write the request payload
+  std::string requestPayload;
+  RpcRequestWriter writer(requestPayload, 128);
+  writer.beginRequest(nextRequestId(), "getLatestBlockhash");
+  writer.beginObject().key("commitment").string(to_string(commitment)).endObject();
+  writer.endRequest();
 
-  // Create the request payload using createRequestPayload method
-  String requestPayload = createRequestPayload(1, "getLatestBlockhash", params);
+  // Only keep the fields we need from the response
+  JsonDocument filter;
+  filter["result"]["value"]["blockhash"] = true;
+  filter["result"]["value"]["lastValidBlockHeight"] = true;
+  filter["error"]["message"] = true;
 
-  // Send the HTTP request and get the response
-  String response;
-  if (sendHttpRequest(rpcEndpoint.c_str(), requestPayload, response))
+  // Send the HTTP request and parse the response as it arrives
+  JsonDocument responseDoc;
+  if (sendRequest(requestPayload, responseDoc, filter))
   {
-    // Parse the JSON response
-    DynamicJsonDocument responseDoc(512); // Adjust capacity as needed
-    deserializeJson(responseDoc, response);
+    checkRpcError(responseDoc);
 
     // Extract the blockhash string from the response
     const char *blockhashString = responseDoc["result"]["value"]["blockhash"];
+    if (blockhashString == nullptr)
+    {
+      throw std::runtime_error("Invalid blockhash response");
+    }
 
-    // Decode the blockhash string using Base58 decoding
-    std::vector<uint8_t> recentBlockhashBytes = Base58::trimDecode(blockhashString);
+    // Decode the blockhash string at full length, a blockhash starting
+    // with zero bytes keeps them
+    std::vector<uint8_t> recentBlockhashBytes = Base58::decode(blockhashString);
+    if (recentBlockhashBytes.size() != HASH_BYTES)
+    {
+      throw std::runtime_error("Invalid blockhash response");
+    }
 
     // Construct the Hash object from the decoded bytes
-    Hash blockhash = Hash(recentBlockhashBytes);
+    Hash blockhash = Hash::deserialize(recentBlockhashBytes);
 
     // Construct the BlockhashWithExpiryBlockHeight object
     BlockhashWithExpiryBlockHeight blockhashWithExpiryBlockHeight;
     blockhashWithExpiryBlockHeight.blockhash = blockhash;
-
-    // Check if the response contains lastValidBlockHeight
-    if (responseDoc["result"]["value"].containsKey("lastValidBlockHeight"))
-    {
-      uint64_t lastValidBlockHeight = responseDoc["result"]["value"]["lastValidBlockHeight"];
-      blockhashWithExpiryBlockHeight.lastValidBlockHeight = lastValidBlockHeight;
-    }
+    blockhashWithExpiryBlockHeight.lastValidBlockHeight = responseDoc["result"]["value"]["lastValidBlockHeight"] | 0ULL;
 
     return blockhashWithExpiryBlockHeight;
   }
   else
   {
     // Throw an exception or handle the error as needed
-    throw std::runtime_error("Request failed");
+    requestFailed();
   }
 }
 
@@ -123,42 +204,49 @@ BlockhashWithExpiryBlockHeight Connection::getLatestBlockhash()
 
 Signature Connection::_sendTransaction(Transaction transaction, SendOptions sendOptions)
 {
-  // Create a JSON document to hold the request payload
-  DynamicJsonDocument doc(512);
-
-  // Create the params array
-  JsonArray params = doc.createNestedArray("params");
-
-  // Serialize transaction and add it to the params array
-  String transactionSerialized = Base58::trimEncode(transaction.serialize()).c_str();
-  params.add(transactionSerialized);
+  return _sendRawTransaction(transaction.serialize(), sendOptions);
+}
 
-  // Create options object and add parameters
-  StaticJsonDocument<128> options;
-  options["encoding"] = "base58";
-  options["skipPreflight"] = sendOptions.skipPreflight;
-  options["preflightCommitment"] = to_string(sendOptions.preflightCommitment);
-  options["maxRetries"] = sendOptions.maxRetires;
+Signature Connection::_sendRawTransaction(const std::vector<uint8_t> &rawTransaction, SendOptions sendOptions)
+{
+  // Write the request payload, encoding the transaction straight into it
+  std::string requestPayload;
+  RpcRequestWriter writer(requestPayload, 192 + Base64::encodedLength(rawTransaction.size()));
+  writer.beginRequest(nextRequestId(), "sendTransaction");
+  writer.base64(rawTransaction);
 
-  // Add options object to the params array
-  params.add(options);
+  // Add the options object to the params array
+  writer.beginObject();
+  writer.key("encoding").string("base64");
+  writer.key("skipPreflight").boolean(sendOptions.skipPreflight);
+  writer.key("preflightCommitment").string(to_string(sendOptions.preflightCommitment));
+  writer.key("maxRetries").number(sendOptions.maxRetires);
+  writer.endObject();
+  writer.endRequest();
 
-  // Create the request payload using createRequestPayload method
-  String requestPayload = createRequestPayload(1, "sendTransaction", params);
+  JsonDocument filter;
+  filter["result"] = true;
+  filter["error"]["message"] = true;
 
-  // Send the HTTP request and get the response
-  String response;
-  if (sendHttpRequest(rpcEndpoint.c_str(), requestPayload, response))
+  // Send the HTTP request and parse the response as it arrives
+  JsonDocument responseDoc;
+  if (sendRequest(requestPayload, responseDoc, filter))
   {
-    // Parse the JSON response
-    DynamicJsonDocument responseDoc(128); // Adjust capacity as needed
-    deserializeJson(responseDoc, response);
+    checkRpcError(responseDoc);
 
     // Extract the signature string from the response
-    String signatureString = responseDoc["result"];
+    const char *signatureString = responseDoc["result"];
+    if (signatureString == nullptr)
+    {
+      throw std::runtime_error("Invalid sendTransaction response");
+    }
 
-    // Decode the signature string using Base58 decoding
-    std::vector<uint8_t> signatureBytes = Base58::trimDecode(signatureString.c_str());
+    // Decode the signature string at full length, like the blockhash
+    std::vector<uint8_t> signatureBytes = Base58::decode(signatureString);
+    if (signatureBytes.size() != SIGNATURE_BYTES)
+    {
+      throw std::runtime_error("Invalid sendTransaction response");
+    }
 
     // Deserialize the signature
     Signature signature = Signature::deserialize(signatureBytes);
@@ -168,7 +256,7 @@ Signature Connection::_sendTransaction(Transaction transaction, SendOptions send
   else
   {
     // Throw an exception or handle the error as needed
-    throw std::runtime_error("Request failed");
+    requestFailed();
   }
 }
 
@@ -181,4 +269,807 @@ Signature Connection::sendTransaction(Transaction transaction)
 {
   SendOptions defaultSendOptions;
   return _sendTransaction(transaction, defaultSendOptions);
-}
\ No newline at end of file
+}
+
+Signature Connection::sendRawTransaction(const std::vector<uint8_t> &rawTransaction, SendOptions sendOptions)
+{
+  return _sendRawTransaction(rawTransaction, sendOptions);
+}
+
+Signature Connection::sendRawTransaction(const std::vector<uint8_t> &rawTransaction)
+{
+  SendOptions defaultSendOptions;
+  return _sendRawTransaction(rawTransaction, defaultSendOptions);
+}
+
+uint64_t Connection::_getBlockHeight(Commitment commitment)
+{
+  // Write the request payload
+  std::string requestPayload;
+  RpcRequestWriter writer(requestPayload, 128);
+  writer.beginRequest(nextRequestId(), "getBlockHeight");
+  writer.beginObject().key("commitment").string(to_string(commitment)).endObject();
+  writer.endRequest();
+
+  JsonDocument filter;
+  filter["result"] = true;
+  filter["error"]["message"] = true;
+
+  // Send the HTTP request and parse the response as it arrives
+  JsonDocument responseDoc;
+  if (sendRequest(requestPayload, responseDoc, filter))
+  {
+    checkRpcError(responseDoc);
+
+    if (!responseDoc["result"].is<uint64_t>())
+    {
+      throw std::runtime_error("Invalid block height response");
+    }
+    return responseDoc["result"].as<uint64_t>();
+  }
+  else
+  {
+    // Throw an exception or handle the error as needed
+    requestFailed();
+  }
+}
+
+uint64_t Connection::getBlockHeight(Commitment commitment)
+{
+  return _getBlockHeight(commitment);
+}
+
+uint64_t Connection::getBlockHeight()
+{
+  return _getBlockHeight(commitment);
+}
+
+// Options object shared by the account reads
+static void writeAccountConfig(RpcRequestWriter &writer, Commitment commitment, const std::optional<DataSlice> &dataSlice)
+{
+  writer.beginObject();
+  writer.key("commitment").string(to_string(commitment));
+  writer.key("encoding").string("base64");
+  if (dataSlice)
+  {
+    writer.key("dataSlice").beginObject();
+    writer.key("offset").number(dataSlice->offset);
+    writer.key("length").number(dataSlice->length);
+    writer.endObject();
+  }
+  writer.endObject();
+}
+
+// Keep only the account fields, with data as [data, encoding]
+static void filterAccount(JsonObject filter)
+{
+  filter["lamports"] = true;
+  filter["owner"] = true;
+  filter["data"][0] = true;
+  filter["executable"] = true;
+  filter["rentEpoch"] = true;
+}
+
+static std::optional<AccountInfo> parseAccountInfo(JsonVariantConst value, uint64_t slot)
+{
+  if (value.isNull())
+  {
+    return std::nullopt;
+  }
+  const char *owner = value["owner"];
+  const char *data = value["data"][0];
+  if (owner == nullptr || data == nullptr)
+  {
+    throw std::runtime_error("Invalid account response");
+  }
+  std::optional<PublicKey> ownerKey = PublicKey::fromString(owner);
+  if (!ownerKey)
+  {
+    throw std::runtime_error("Invalid account owner");
+  }
+  AccountInfo account;
+  account.lamports = value["lamports"] | 0ULL;
+  account.owner = *ownerKey;
+  account.data = Base64::decode(data);
+  account.executable = value["executable"] | false;
+  account.rentEpoch = value["rentEpoch"] | 0ULL;
+  account.slot = slot;
+  return account;
+}
+
+std::optional<AccountInfo> Connection::_getAccountInfo(PublicKey account, Commitment commitment, std::optional<DataSlice> dataSlice)
+{
+  // Write the request payload
+  std::string requestPayload;
+  RpcRequestWriter writer(requestPayload, 256);
+  writer.beginRequest(nextRequestId(), "getAccountInfo");
+  writer.string(account.toBase58());
+  writeAccountConfig(writer, commitment, dataSlice);
+  writer.endRequest();
+
+  JsonDocument filter;
+  filter["result"]["context"]["slot"] = true;
+  filterAccount(filter["result"]["value"].to<JsonObject>());
+  filter["error"]["message"] = true;
+
+  // Send the HTTP request and parse the response as it arrives
+  JsonDocument responseDoc;
+  if (sendRequest(requestPayload, responseDoc, filter))
+  {
+    checkRpcError(responseDoc);
+
+    if (responseDoc["result"].isNull())
+    {
+      throw std::runtime_error("Invalid account response");
+    }
+    uint64_t slot = responseDoc["result"]["context"]["slot"] | 0ULL;
+    return parseAccountInfo(responseDoc["result"]["value"], slot);
+  }
+  else
+  {
+    // Throw an exception or handle the error as needed
+    requestFailed();
+  }
+}
+
+std::vector<std::optional<AccountInfo>> Connection::_getMultipleAccounts(const std::vector<PublicKey> &accounts, Commitment commitment, std::optional<DataSlice> dataSlice, std::vector<uint64_t> *slots)
+{
+  std::vector<std::optional<AccountInfo>> result;
+  result.reserve(accounts.size());
+  if (slots != nullptr)
+  {
+    slots->clear();
+    slots->reserve(accounts.size());
+  }
+
+  JsonDocument filter;
+  filter["result"]["context"]["slot"] = true;
+  filterAccount(filter["result"]["value"][0].to<JsonObject>());
+  filter["error"]["message"] = true;
+
+  for (size_t start = 0; start < accounts.size(); start += GET_MULTIPLE_ACCOUNTS_LIMIT)
+  {
+    size_t end = std::min(start + GET_MULTIPLE_ACCOUNTS_LIMIT, accounts.size());
+
+    std::string requestPayload;
+    RpcRequestWriter writer(requestPayload, 192 + 48 * (end - start));
+    writer.beginRequest(nextRequestId(), "getMultipleAccounts");
+    writer.beginArray();
+    for (size_t i = start; i < end; ++i)
+    {
+      PublicKey account = accounts[i];
+      writer.string(account.toBase58());
+    }
+    writer.endArray();
+    writeAccountConfig(writer, commitment, dataSlice);
+    writer.endRequest();
+
+    JsonDocument responseDoc;
+    if (!sendRequest(requestPayload, responseDoc, filter))
+    {
+      requestFailed();
+    }
+    checkRpcError(responseDoc);
+
+    JsonArrayConst values = responseDoc["result"]["value"];
+    if (values.isNull() || values.size() != end - start)
+    {
+      throw std::runtime_error("Invalid getMultipleAccounts response");
+    }
+    uint64_t slot = responseDoc["result"]["context"]["slot"] | 0ULL;
+    for (JsonVariantConst value : values)
+    {
+      result.push_back(parseAccountInfo(value, slot));
+      if (slots != nullptr)
+      {
+        slots->push_back(slot);
+      }
+    }
+  }
+  return result;
+}
+
+std::optional<AccountInfo> Connection::getAccountInfo(PublicKey account, Commitment commitment, std::optional<DataSlice> dataSlice)
+{
+  return _getAccountInfo(account, commitment, dataSlice);
+}
+
+std::optional<AccountInfo> Connection::getAccountInfo(PublicKey account)
+{
+  return _getAccountInfo(account, commitment, std::nullopt);
+}
+
+std::vector<std::optional<AccountInfo>> Connection::getMultipleAccounts(const std::vector<PublicKey> &accounts, Commitment commitment, std::optional<DataSlice> dataSlice)
+{
+  return _getMultipleAccounts(accounts, commitment, dataSlice);
+}
+
+std::vector<std::optional<AccountInfo>> Connection::getMultipleAccounts(const std::vector<PublicKey> &accounts)
+{
+  return _getMultipleAccounts(accounts, commitment, std::nullopt);
+}
+
+std::vector<std::optional<AccountInfo>> Connection::getMultipleAccounts(const std::vector<PublicKey> &accounts, Commitment commitment, std::optional<DataSlice> dataSlice, std::vector<uint64_t> &slots)
+{
+  return _getMultipleAccounts(accounts, commitment, dataSlice, &slots);
+}
+
+std::vector<ConfirmedSignatureInfo> Connection::_getSignaturesForAddress(PublicKey address, SignaturesForAddressOptions options, Commitment commitment)
+{
+  // Write the request payload
+  std::string requestPayload;
+  RpcRequestWriter writer(requestPayload, 384);
+  writer.beginRequest(nextRequestId(), "getSignaturesForAddress");
+  writer.string(address.toBase58());
+  writer.beginObject();
+  writer.key("commitment").string(to_string(commitment));
+  writer.key("limit").number(std::min(options.limit, GET_SIGNATURES_FOR_ADDRESS_LIMIT));
+  if (options.before)
+  {
+    writer.key("before").string(options.before->toString());
+  }
+  if (options.until)
+  {
+    writer.key("until").string(options.until->toString());
+  }
+  writer.endObject();
+  writer.endRequest();
+
+  // Memos are dropped, everything else of each entry is kept
+  JsonDocument filter;
+  filter["result"][0]["signature"] = true;
+  filter["result"][0]["slot"] = true;
+  filter["result"][0]["err"] = true;
+  filter["result"][0]["blockTime"] = true;
+  filter["result"][0]["confirmationStatus"] = true;
+  filter["error"]["message"] = true;
+
+  // Send the HTTP request and parse the response as it arrives
+  JsonDocument responseDoc;
+  if (sendRequest(requestPayload, responseDoc, filter))
+  {
+    checkRpcError(responseDoc);
+
+    JsonArrayConst entries = responseDoc["result"];
+    if (entries.isNull())
+    {
+      throw std::runtime_error("Invalid getSignaturesForAddress response");
+    }
+
+    std::vector<ConfirmedSignatureInfo> result;
+    result.reserve(entries.size());
+    for (JsonVariantConst entry : entries)
+    {
+      const char *signatureString = entry["signature"];
+      if (signatureString == nullptr)
+      {
+        throw std::runtime_error("Invalid getSignaturesForAddress response");
+      }
+      ConfirmedSignatureInfo info;
+      info.signature = Signature::deserialize(Base58::decode(signatureString));
+      info.slot = entry["slot"] | 0ULL;
+      info.failed = !entry["err"].isNull();
+      if (entry["blockTime"].is<int64_t>())
+      {
+        info.blockTime = entry["blockTime"].as<int64_t>();
+      }
+      info.confirmationStatus = commitmentFromString(entry["confirmationStatus"]);
+      result.push_back(info);
+    }
+    return result;
+  }
+  else
+  {
+    // Throw an exception or handle the error as needed
+    requestFailed();
+  }
+}
+
+SimulationResult Connection::_simulateTransaction(Transaction transaction, SimulateOptions options, Commitment commitment)
+{
+  // Write the request payload, encoding the transaction straight into it
+  std::vector<uint8_t> rawTransaction = transaction.serialize();
+  std::string requestPayload;
+  RpcRequestWriter writer(requestPayload, 192 + Base64::encodedLength(rawTransaction.size()));
+  writer.beginRequest(nextRequestId(), "simulateTransaction");
+  writer.base64(rawTransaction);
+  writer.beginObject();
+  writer.key("encoding").string("base64");
+  writer.key("commitment").string(to_string(commitment));
+  writer.key("sigVerify").boolean(options.sigVerify);
+  // The node rejects both flags set at once
+  writer.key("replaceRecentBlockhash").boolean(options.replaceRecentBlockhash && !options.sigVerify);
+  writer.endObject();
+  writer.endRequest();
+
+  // Account and return data are not requested, so only these are read
+  JsonDocument filter;
+  filter["result"]["context"]["slot"] = true;
+  filter["result"]["value"]["err"] = true;
+  filter["result"]["value"]["logs"] = true;
+  filter["result"]["value"]["unitsConsumed"] = true;
+  filter["error"]["message"] = true;
+
+  // Send the HTTP request and parse the response as it arrives
+  JsonDocument responseDoc;
+  if (sendRequest(requestPayload, responseDoc, filter))
+  {
+    checkRpcError(responseDoc);
+
+    JsonObjectConst value = responseDoc["result"]["value"];
+    if (value.isNull())
+    {
+      throw std::runtime_error("Invalid simulateTransaction response");
+    }
+
+    SimulationResult result;
+    result.slot = responseDoc["result"]["context"]["slot"] | 0ULL;
+    if (!value["err"].isNull())
+    {
+      std::string err;
+      serializeJson(value["err"], err);
+      result.err = err;
+    }
+    for (JsonVariantConst line : value["logs"].as<JsonArrayConst>())
+    {
+      const char *text = line;
+      result.logs.push_back(text != nullptr ? text : "");
+    }
+    if (value["unitsConsumed"].is<uint64_t>())
+    {
+      result.unitsConsumed = value["unitsConsumed"].as<uint64_t>();
+    }
+    return result;
+  }
+  else
+  {
+    // Throw an exception or handle the error as needed
+    requestFailed();
+  }
+}
+
+SimulationResult Connection::simulateTransaction(Transaction transaction, SimulateOptions options, Commitment commitment)
+{
+  return _simulateTransaction(transaction, options, commitment);
+}
+
+SimulationResult Connection::simulateTransaction(Transaction transaction, SimulateOptions options)
+{
+  return _simulateTransaction(transaction, options, commitment);
+}
+
+SimulationResult Connection::simulateTransaction(Transaction transaction)
+{
+  return _simulateTransaction(transaction, SimulateOptions(), commitment);
+}
+
+std::vector<PrioritizationFee> Connection::getRecentPrioritizationFees(const std::vector<PublicKey> &accounts)
+{
+  // Write the request payload
+  size_t count = std::min(accounts.size(), GET_RECENT_PRIORITIZATION_FEES_LIMIT);
+  std::string requestPayload;
+  RpcRequestWriter writer(requestPayload, 64 + count * (PUBLIC_KEY_MAX_BASE58_LEN + 3));
+  writer.beginRequest(nextRequestId(), "getRecentPrioritizationFees");
+  writer.beginArray();
+  for (size_t i = 0; i < count; ++i)
+  {
+    PublicKey account = accounts[i];
+    writer.string(account.toBase58());
+  }
+  writer.endArray();
+  writer.endRequest();
+
+  JsonDocument filter;
+  filter["result"][0]["slot"] = true;
+  filter["result"][0]["prioritizationFee"] = true;
+  filter["error"]["message"] = true;
+
+  // Send the HTTP request and parse the response as it arrives
+  JsonDocument responseDoc;
+  if (sendRequest(requestPayload, responseDoc, filter))
+  {
+    checkRpcError(responseDoc);
+
+    JsonArrayConst entries = responseDoc["result"];
+    if (entries.isNull())
+    {
+      throw std::runtime_error("Invalid getRecentPrioritizationFees response");
+    }
+
+    std::vector<PrioritizationFee> result;
+    result.reserve(entries.size());
+    for (JsonVariantConst entry : entries)
+    {
+      PrioritizationFee fee;
+      fee.slot = entry["slot"] | 0ULL;
+      fee.prioritizationFee = entry["prioritizationFee"] | 0ULL;
+      result.push_back(fee);
+    }
+    return result;
+  }
+  else
+  {
+    // Throw an exception or handle the error as needed
+    requestFailed();
+  }
+}
+
+std::vector<ConfirmedSignatureInfo> Connection::getSignaturesForAddress(PublicKey address, SignaturesForAddressOptions options, Commitment commitment)
+{
+  return _getSignaturesForAddress(address, options, commitment);
+}
+
+std::vector<ConfirmedSignatureInfo> Connection::getSignaturesForAddress(PublicKey address, SignaturesForAddressOptions options)
+{
+  return _getSignaturesForAddress(address, options, commitment);
+}
+
+std::vector<ConfirmedSignatureInfo> Connection::getSignaturesForAddress(PublicKey address)
+{
+  return _getSignaturesForAddress(address, SignaturesForAddressOptions(), commitment);
+}
+
+size_t Connection::getProgramAccounts(PublicKey programId, const ProgramAccountsConfig &config, Commitment commitment, const ProgramAccountHandler &handler)
+{
+  // Write the request payload
+  std::string requestPayload;
+  RpcRequestWriter writer(requestPayload, 256);
+  writer.beginRequest(nextRequestId(), "getProgramAccounts");
+  writer.string(programId.toBase58());
+  writer.beginObject();
+  writer.key("commitment").string(to_string(commitment));
+  writer.key("encoding").string("base64");
+  if (config.dataSlice)
+  {
+    writer.key("dataSlice").beginObject();
+    writer.key("offset").number(config.dataSlice->offset);
+    writer.key("length").number(config.dataSlice->length);
+    writer.endObject();
+  }
+  if (!config.memcmp.empty() || config.dataSize)
+  {
+    writer.key("filters").beginArray();
+    if (config.dataSize)
+    {
+      writer.beginObject().key("dataSize").number(*config.dataSize).endObject();
+    }
+    for (const auto &filter : config.memcmp)
+    {
+      writer.beginObject().key("memcmp").beginObject();
+      writer.key("offset").number(filter.offset);
+      writer.key("bytes").base64(filter.bytes);
+      writer.key("encoding").string("base64");
+      writer.endObject().endObject();
+    }
+    writer.endArray();
+  }
+  writer.endObject();
+  writer.endRequest();
+
+  // Parse the accounts straight from the body as they arrive
+  std::optional<std::string> error;
+  std::optional<std::string> invalid;
+  size_t count = 0;
+  ByteSpan request(reinterpret_cast<const uint8_t *>(requestPayload.data()), requestPayload.size());
+  bool ok = transport->post(request, [&handler, &error, &invalid, &count](ResponseReader &body)
+                            {
+                              ProgramAccountsParser parser(body);
+                              bool parsed = parser.parse(handler);
+                              error = parser.error;
+                              invalid = parser.invalid;
+                              count = parser.count;
+                              return parsed; }, context);
+  if (error)
+  {
+    throw RpcException(RpcErrorCode::rpc, *error);
+  }
+  if (invalid)
+  {
+    throw RpcException(RpcErrorCode::invalidResponse, *invalid);
+  }
+  if (!ok)
+  {
+    requestFailed();
+  }
+  return count;
+}
+
+size_t Connection::getProgramAccounts(PublicKey programId, const ProgramAccountsConfig &config, const ProgramAccountHandler &handler)
+{
+  return getProgramAccounts(programId, config, commitment, handler);
+}
+
+NonceAccount Connection::_getNonceAccount(PublicKey nonceAccount, Commitment commitment)
+{
+  std::optional<AccountInfo> account = _getAccountInfo(nonceAccount, commitment, std::nullopt);
+  if (!account)
+  {
+    throw std::runtime_error("Nonce account not found");
+  }
+  return NonceAccount::deserialize(account->data);
+}
+
+NonceAccount Connection::getNonceAccount(PublicKey nonceAccount, Commitment commitment)
+{
+  return _getNonceAccount(nonceAccount, commitment);
+}
+
+NonceAccount Connection::getNonceAccount(PublicKey nonceAccount)
+{
+  return _getNonceAccount(nonceAccount, commitment);
+}
+
+bool Connection::sendBatch(RpcBatch &batch)
+{
+  if (batch.calls.empty())
+  {
+    return true;
+  }
+
+  // Write the JSON-RPC array, one request object per queued call
+  std::string requestPayload;
+  RpcRequestWriter writer(requestPayload, 128 * batch.calls.size());
+  writer.beginArray();
+  for (auto &call : batch.calls)
+  {
+    call.id = nextRequestId();
+    writer.beginRequest(call.id, call.method.c_str());
+    if (call.params)
+    {
+      call.params(writer);
+    }
+    writer.endRequest();
+  }
+  writer.endArray();
+
+  JsonDocument responseDoc;
+  if (!sendRequest(requestPayload, responseDoc))
+  {
+    batch.fail();
+    return false;
+  }
+
+  batch.dispatch(responseDoc.as<JsonArrayConst>());
+  return true;
+}
+
+RpcResult<BlockhashWithExpiryBlockHeight> Connection::tryGetLatestBlockhash(Commitment commitment)
+{
+  return tryCall([commitment](Connection &connection)
+                 { return connection._getLatestBlockhash(commitment); });
+}
+
+RpcResult<BlockhashWithExpiryBlockHeight> Connection::tryGetLatestBlockhash()
+{
+  return tryGetLatestBlockhash(commitment);
+}
+
+RpcResult<Signature> Connection::trySendTransaction(Transaction transaction, SendOptions sendOptions)
+{
+  return tryCall([&transaction, &sendOptions](Connection &connection)
+                 { return connection._sendTransaction(transaction, sendOptions); });
+}
+
+RpcResult<Signature> Connection::trySendTransaction(Transaction transaction)
+{
+  SendOptions defaultSendOptions;
+  return trySendTransaction(transaction, defaultSendOptions);
+}
+
+RpcResult<Signature> Connection::trySendRawTransaction(const std::vector<uint8_t> &rawTransaction, SendOptions sendOptions)
+{
+  return tryCall([&rawTransaction, &sendOptions](Connection &connection)
+                 { return connection._sendRawTransaction(rawTransaction, sendOptions); });
+}
+
+RpcResult<Signature> Connection::trySendRawTransaction(const std::vector<uint8_t> &rawTransaction)
+{
+  SendOptions defaultSendOptions;
+  return trySendRawTransaction(rawTransaction, defaultSendOptions);
+}
+
+RpcResult<uint64_t> Connection::tryGetBlockHeight(Commitment commitment)
+{
+  return tryCall([commitment](Connection &connection)
+                 { return connection._getBlockHeight(commitment); });
+}
+
+RpcResult<uint64_t> Connection::tryGetBlockHeight()
+{
+  return tryGetBlockHeight(commitment);
+}
+
+RpcResult<NonceAccount> Connection::tryGetNonceAccount(PublicKey nonceAccount, Commitment commitment)
+{
+  return tryCall([&nonceAccount, commitment](Connection &connection)
+                 { return connection._getNonceAccount(nonceAccount, commitment); });
+}
+
+RpcResult<NonceAccount> Connection::tryGetNonceAccount(PublicKey nonceAccount)
+{
+  return tryGetNonceAccount(nonceAccount, commitment);
+}
+
+RpcResult<std::optional<AccountInfo>> Connection::tryGetAccountInfo(PublicKey account, Commitment commitment, std::optional<DataSlice> dataSlice)
+{
+  return tryCall([&account, commitment, &dataSlice](Connection &connection)
+                 { return connection._getAccountInfo(account, commitment, dataSlice); });
+}
+
+RpcResult<std::optional<AccountInfo>> Connection::tryGetAccountInfo(PublicKey account)
+{
+  return tryGetAccountInfo(account, commitment, std::nullopt);
+}
+
+RpcResult<std::vector<std::optional<AccountInfo>>> Connection::tryGetMultipleAccounts(const std::vector<PublicKey> &accounts, Commitment commitment, std::optional<DataSlice> dataSlice)
+{
+  return tryCall([&accounts, commitment, &dataSlice](Connection &connection)
+                 { return connection._getMultipleAccounts(accounts, commitment, dataSlice); });
+}
+
+RpcResult<std::vector<std::optional<AccountInfo>>> Connection::tryGetMultipleAccounts(const std::vector<PublicKey> &accounts)
+{
+  return tryGetMultipleAccounts(accounts, commitment, std::nullopt);
+}
+
+RpcResult<std::vector<ConfirmedSignatureInfo>> Connection::tryGetSignaturesForAddress(PublicKey address, SignaturesForAddressOptions options, Commitment commitment)
+{
+  return tryCall([&address, &options, commitment](Connection &connection)
+                 { return connection._getSignaturesForAddress(address, options, commitment); });
+}
+
+RpcResult<std::vector<ConfirmedSignatureInfo>> Connection::tryGetSignaturesForAddress(PublicKey address, SignaturesForAddressOptions options)
+{
+  return tryGetSignaturesForAddress(address, options, commitment);
+}
+
+RpcResult<std::vector<ConfirmedSignatureInfo>> Connection::tryGetSignaturesForAddress(PublicKey address)
+{
+  return tryGetSignaturesForAddress(address, SignaturesForAddressOptions(), commitment);
+}
+
+RpcResult<std::vector<PrioritizationFee>> Connection::tryGetRecentPrioritizationFees(const std::vector<PublicKey> &accounts)
+{
+  return tryCall([&accounts](Connection &connection)
+                 { return connection.getRecentPrioritizationFees(accounts); });
+}
+
+RpcResult<SimulationResult> Connection::trySimulateTransaction(Transaction transaction, SimulateOptions options, Commitment commitment)
+{
+  return tryCall([&transaction, &options, commitment](Connection &connection)
+                 { return connection._simulateTransaction(transaction, options, commitment); });
+}
+
+RpcResult<SimulationResult> Connection::trySimulateTransaction(Transaction transaction, SimulateOptions options)
+{
+  return trySimulateTransaction(transaction, options, commitment);
+}
+
+RpcResult<SimulationResult> Connection::trySimulateTransaction(Transaction transaction)
+{
+  return trySimulateTransaction(transaction, SimulateOptions(), commitment);
+}
+
+RpcResult<size_t> Connection::tryGetProgramAccounts(PublicKey programId, const ProgramAccountsConfig &config, Commitment commitment, const ProgramAccountHandler &handler)
+{
+  return tryCall([&programId, &config, commitment, &handler](Connection &connection)
+                 { return connection.getProgramAccounts(programId, config, commitment, handler); });
+}
+
+RpcResult<size_t> Connection::tryGetProgramAccounts(PublicKey programId, const ProgramAccountsConfig &config, const ProgramAccountHandler &handler)
+{
+  return tryGetProgramAccounts(programId, config, commitment, handler);
+}
+
+std::future<BlockhashWithExpiryBlockHeight> Connection::getLatestBlockhashAsync(Commitment commitment)
+{
+  return async([commitment](Connection &connection)
+               { return connection._getLatestBlockhash(commitment); });
+}
+
+std::future<BlockhashWithExpiryBlockHeight> Connection::getLatestBlockhashAsync()
+{
+  return getLatestBlockhashAsync(commitment);
+}
+
+std::future<Signature> Connection::sendTransactionAsync(Transaction transaction, SendOptions sendOptions)
+{
+  return async([transaction, sendOptions](Connection &connection)
+               { return connection._sendTransaction(transaction, sendOptions); });
+}
+
+std::future<Signature> Connection::sendTransactionAsync(Transaction transaction)
+{
+  SendOptions defaultSendOptions;
+  return sendTransactionAsync(transaction, defaultSendOptions);
+}
+
+std::future<Signature> Connection::sendRawTransactionAsync(std::vector<uint8_t> rawTransaction, SendOptions sendOptions)
+{
+  return async([rawTransaction, sendOptions](Connection &connection)
+               { return connection._sendRawTransaction(rawTransaction, sendOptions); });
+}
+
+std::future<Signature> Connection::sendRawTransactionAsync(std::vector<uint8_t> rawTransaction)
+{
+  SendOptions defaultSendOptions;
+  return sendRawTransactionAsync(rawTransaction, defaultSendOptions);
+}
+
+std::future<uint64_t> Connection::getBlockHeightAsync(Commitment commitment)
+{
+  return async([commitment](Connection &connection)
+               { return connection._getBlockHeight(commitment); });
+}
+
+std::future<uint64_t> Connection::getBlockHeightAsync()
+{
+  return getBlockHeightAsync(commitment);
+}
+
+std::future<NonceAccount> Connection::getNonceAccountAsync(PublicKey nonceAccount, Commitment commitment)
+{
+  return async([nonceAccount, commitment](Connection &connection)
+               { return connection._getNonceAccount(nonceAccount, commitment); });
+}
+
+std::future<NonceAccount> Connection::getNonceAccountAsync(PublicKey nonceAccount)
+{
+  return getNonceAccountAsync(nonceAccount, commitment);
+}
+
+std::future<std::optional<AccountInfo>> Connection::getAccountInfoAsync(PublicKey account, Commitment commitment, std::optional<DataSlice> dataSlice)
+{
+  return async([account, commitment, dataSlice](Connection &connection)
+               { return connection._getAccountInfo(account, commitment, dataSlice); });
+}
+
+std::future<std::optional<AccountInfo>> Connection::getAccountInfoAsync(PublicKey account)
+{
+  return getAccountInfoAsync(account, commitment, std::nullopt);
+}
+
+std::future<std::vector<std::optional<AccountInfo>>> Connection::getMultipleAccountsAsync(std::vector<PublicKey> accounts, Commitment commitment, std::optional<DataSlice> dataSlice)
+{
+  return async([accounts, commitment, dataSlice](Connection &connection)
+               { return connection._getMultipleAccounts(accounts, commitment, dataSlice); });
+}
+
+std::future<std::vector<std::optional<AccountInfo>>> Connection::getMultipleAccountsAsync(std::vector<PublicKey> accounts)
+{
+  return getMultipleAccountsAsync(accounts, commitment, std::nullopt);
+}
+
+std::future<std::vector<ConfirmedSignatureInfo>> Connection::getSignaturesForAddressAsync(PublicKey address, SignaturesForAddressOptions options, Commitment commitment)
+{
+  return async([address, options, commitment](Connection &connection)
+               { return connection._getSignaturesForAddress(address, options, commitment); });
+}
+
+std::future<std::vector<ConfirmedSignatureInfo>> Connection::getSignaturesForAddressAsync(PublicKey address, SignaturesForAddressOptions options)
+{
+  return getSignaturesForAddressAsync(address, options, commitment);
+}
+
+std::future<std::vector<PrioritizationFee>> Connection::getRecentPrioritizationFeesAsync(std::vector<PublicKey> accounts)
+{
+  return async([accounts](Connection &connection)
+               { return connection.getRecentPrioritizationFees(accounts); });
+}
+
+std::future<SimulationResult> Connection::simulateTransactionAsync(Transaction transaction, SimulateOptions options, Commitment commitment)
+{
+  return async([transaction, options, commitment](Connection &connection)
+               { return connection._simulateTransaction(transaction, options, commitment); });
+}
+
+std::future<SimulationResult> Connection::simulateTransactionAsync(Transaction transaction, SimulateOptions options)
+{
+  return simulateTransactionAsync(transaction, options, commitment);
+}
+
+std::future<bool> Connection::sendBatchAsync(RpcBatch batch)
+{
+  return async([batch](Connection &connection) mutable
+               { return connection.sendBatch(batch); });
+}
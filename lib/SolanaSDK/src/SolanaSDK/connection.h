@@ -2,10 +2,20 @@
 #define CONNECTION_H
 
 #include <string>
+#include <memory>
+#include <future>
+#include <atomic>
+#include <optional>
+#include <functional>
 #include <ArduinoJson.h>
 #include "hash.h"
 #include "signature.h"
 #include "transaction.h"
+#include "nonce_account.h"
+#include "public_key.h"
+#include "transport.h"
+#include "request_context.h"
+#include "rpc_executor.h"
 
 enum class Commitment
 {
@@ -17,6 +27,9 @@ enum class Commitment
 // Overload the std::string conversion operator for Commitment enum class
 std::string to_string(Commitment commitment);
 
+// Parse a commitment level as reported by the RPC node
+std::optional<Commitment> commitmentFromString(const char *commitment);
+
 struct SendOptions
 {
   bool skipPreflight = false;
@@ -30,6 +43,97 @@ struct BlockhashWithExpiryBlockHeight
   uint64_t lastValidBlockHeight;
 };
 
+struct SignatureStatus
+{
+  uint64_t slot;
+  // Number of blocks since confirmation, empty once rooted
+  std::optional<uint64_t> confirmations;
+  // True if the transaction failed
+  bool failed;
+  std::optional<Commitment> confirmationStatus;
+};
+
+// Part of the account data to return instead of all of it
+struct DataSlice
+{
+  size_t offset;
+  size_t length;
+};
+
+struct AccountInfo
+{
+  uint64_t lamports;
+  PublicKey owner;
+  // All of the account data, or only the requested slice
+  std::vector<uint8_t> data;
+  bool executable;
+  uint64_t rentEpoch;
+  // Slot the node had reached when it read the account
+  uint64_t slot;
+};
+
+// Most accounts the node returns from one getMultipleAccounts call
+constexpr size_t GET_MULTIPLE_ACCOUNTS_LIMIT = 100;
+
+// Most signatures the node returns from one getSignaturesForAddress call
+constexpr size_t GET_SIGNATURES_FOR_ADDRESS_LIMIT = 1000;
+
+struct ConfirmedSignatureInfo
+{
+  Signature signature;
+  uint64_t slot;
+  // True if the transaction failed
+  bool failed;
+  std::optional<int64_t> blockTime;
+  std::optional<Commitment> confirmationStatus;
+};
+
+struct SignaturesForAddressOptions
+{
+  size_t limit = GET_SIGNATURES_FOR_ADDRESS_LIMIT;
+  // Start searching backwards from before this signature
+  std::optional<Signature> before;
+  // Stop when this signature is reached, it is not returned
+  std::optional<Signature> until;
+};
+
+// Most signatures the node accepts in one getSignatureStatuses call
+constexpr size_t GET_SIGNATURE_STATUSES_LIMIT = 256;
+
+// Most accounts getRecentPrioritizationFees accepts
+constexpr size_t GET_RECENT_PRIORITIZATION_FEES_LIMIT = 128;
+
+struct PrioritizationFee
+{
+  uint64_t slot;
+  // Lowest fee paid by a transaction landed in slot, micro-lamports per
+  // compute unit
+  uint64_t prioritizationFee;
+};
+
+struct SimulateOptions
+{
+  bool sigVerify = false;
+  // Simulate against the node's latest blockhash, so an unsigned
+  // transaction with any blockhash can be simulated. Ignored with
+  // sigVerify set.
+  bool replaceRecentBlockhash = true;
+};
+
+struct SimulationResult
+{
+  // Transaction error as JSON, empty if the transaction succeeded
+  std::optional<std::string> err;
+  std::vector<std::string> logs;
+  // Empty if the node did not report it
+  std::optional<uint64_t> unitsConsumed;
+  uint64_t slot;
+};
+
+class RpcBatch;
+struct ProgramAccountsConfig;
+struct ProgramAccount;
+
 // Partial implementation of Connection
 // reference from web3.js
 class Connection
@@ -37,20 +141,181 @@ class Connection
 private:
   Commitment commitment;
   std::string rpcEndpoint;
-  String createRequestPayload(uint16_t id, const std::string &method, JsonObject &additionalParams);
-  String createRequestPayload(uint16_t id, const std::string &method, JsonArray &additionalParams);
+  std::shared_ptr<Transport> transport;
+  std::shared_ptr<std::atomic<uint32_t>> requestIds;
+  std::shared_ptr<RpcExecutor> executor;
+  // Deadline and cancellation every call of this connection runs under
+  RequestContext context;
+  uint32_t nextRequestId();
+  // Stream the response into responseDoc, keeping only what filter selects
+  bool sendRequest(const std::string &requestPayload, JsonDocument &responseDoc, const JsonDocument &filter);
+  bool sendRequest(const std::string &requestPayload, JsonDocument &responseDoc);
+  // Throw the RPC error message if the response carries one
+  static void checkRpcError(const JsonDocument &responseDoc);
+  // Throw for a request that got no usable response, with the reason the
+  // context stopped if it did
+  [[noreturn]] void requestFailed() const;
   // TODO: Add proper commitment or config args
   BlockhashWithExpiryBlockHeight _getLatestBlockhash(Commitment commitment);
   // TODO: Add proper signer arg and
   Signature _sendTransaction(Transaction transaction, SendOptions sendOptions);
+  Signature _sendRawTransaction(const std::vector<uint8_t> &rawTransaction, SendOptions sendOptions);
+  uint64_t _getBlockHeight(Commitment commitment);
+  NonceAccount _getNonceAccount(PublicKey nonceAccount, Commitment commitment);
+  std::optional<AccountInfo> _getAccountInfo(PublicKey account, Commitment commitment, std::optional<DataSlice> dataSlice);
+  SimulationResult _simulateTransaction(Transaction transaction, SimulateOptions options, Commitment commitment);
+  std::vector<ConfirmedSignatureInfo> _getSignaturesForAddress(PublicKey address, SignaturesForAddressOptions options, Commitment commitment);
+  std::vector<std::optional<AccountInfo>> _getMultipleAccounts(const std::vector<PublicKey> &accounts, Commitment commitment, std::optional<DataSlice> dataSlice, std::vector<uint64_t> *slots = nullptr);
+
+  // Run task on the executor with a copy of this connection. The copy
+  // shares the sockets but not the executor, so a queued task never keeps
+  // the executor alive.
+  template <typename F>
+  auto async(F task) -> std::future<decltype(task(std::declval<Connection &>()))>
+  {
+    Connection self = *this;
+    self.executor.reset();
+    return executor->submit([self, task]() mutable
+                            { return task(self); });
+  }
 
 public:
   Connection(std::string endpoint, Commitment commitment);
   Connection(std::string endpoint);
+  Connection(std::string endpoint, Commitment commitment, size_t maxConnections);
+  // Send requests over a caller-supplied transport, e.g. LoopbackTransport
+  Connection(std::shared_ptr<Transport> transport, Commitment commitment);
+  // Open the keep-alive sockets ahead of the first request
+  size_t warmup();
+  // Copies of this connection whose calls give up after timeoutMs from now,
+  // once token is cancelled, or under context. They share the sockets and
+  // executor, so they are cheap to make per call:
+  //   connection.withDeadline(500).getBalance(key)
+  // A stopped call throws RpcException with code timeout or cancelled.
+  Connection withDeadline(uint32_t timeoutMs) const;
+  Connection withCancellation(CancellationToken token) const;
+  Connection withContext(RequestContext context) const;
+
+  // Run call on this connection and return its value or error instead of
+  // throwing:
+  //   auto result = connection.withDeadline(500).tryCall([](Connection &c)
+  //                                                      { return c.getBlockHeight(); });
+  template <typename F>
+  auto tryCall(F call) -> RpcResult<decltype(call(std::declval<Connection &>()))>
+  {
+    RpcResult<decltype(call(std::declval<Connection &>()))> result;
+    try
+    {
+      result.value = call(*this);
+    }
+    catch (const RpcException &e)
+    {
+      result.error = RpcError{e.code, e.what()};
+    }
+    catch (const std::exception &e)
+    {
+      result.error = RpcError{context.stopReason().value_or(RpcErrorCode::invalidResponse), e.what()};
+    }
+    return result;
+  }
   BlockhashWithExpiryBlockHeight getLatestBlockhash(Commitment commitment);
   BlockhashWithExpiryBlockHeight getLatestBlockhash();
   Signature sendTransaction(Transaction transaction, SendOptions sendOptions);
   Signature sendTransaction(Transaction transaction);
+  Signature sendRawTransaction(const std::vector<uint8_t> &rawTransaction, SendOptions sendOptions);
+  Signature sendRawTransaction(const std::vector<uint8_t> &rawTransaction);
+  uint64_t getBlockHeight(Commitment commitment);
+  uint64_t getBlockHeight();
+  NonceAccount getNonceAccount(PublicKey nonceAccount, Commitment commitment);
+  NonceAccount getNonceAccount(PublicKey nonceAccount);
+  // Empty if the account does not exist. With dataSlice set only that
+  // range of the account data is returned.
+  std::optional<AccountInfo> getAccountInfo(PublicKey account, Commitment commitment, std::optional<DataSlice> dataSlice = std::nullopt);
+  std::optional<AccountInfo> getAccountInfo(PublicKey account);
+  // Results in the same order as accounts, empty for accounts that do not
+  // exist. More than GET_MULTIPLE_ACCOUNTS_LIMIT accounts take several calls.
+  std::vector<std::optional<AccountInfo>> getMultipleAccounts(const std::vector<PublicKey> &accounts, Commitment commitment, std::optional<DataSlice> dataSlice = std::nullopt);
+  std::vector<std::optional<AccountInfo>> getMultipleAccounts(const std::vector<PublicKey> &accounts);
+  // Also fills slots with the slot each account was read at, which is the
+  // only record of when a missing account was seen missing
+  std::vector<std::optional<AccountInfo>> getMultipleAccounts(const std::vector<PublicKey> &accounts, Commitment commitment, std::optional<DataSlice> dataSlice, std::vector<uint64_t> &slots);
+  // Signatures of transactions mentioning address, newest first. Page
+  // through older history by passing the last signature as before.
+  std::vector<ConfirmedSignatureInfo> getSignaturesForAddress(PublicKey address, SignaturesForAddressOptions options, Commitment commitment);
+  std::vector<ConfirmedSignatureInfo> getSignaturesForAddress(PublicKey address, SignaturesForAddressOptions options);
+  std::vector<ConfirmedSignatureInfo> getSignaturesForAddress(PublicKey address);
+  // Fees paid in recent slots by transactions that write-locked accounts,
+  // or by any transaction if accounts is empty. Only the first
+  // GET_RECENT_PRIORITIZATION_FEES_LIMIT accounts are sent.
+  std::vector<PrioritizationFee> getRecentPrioritizationFees(const std::vector<PublicKey> &accounts);
+  // Run transaction on the node without submitting it. A failed
+  // transaction is reported in err, not thrown.
+  SimulationResult simulateTransaction(Transaction transaction, SimulateOptions options, Commitment commitment);
+  SimulationResult simulateTransaction(Transaction transaction, SimulateOptions options);
+  SimulationResult simulateTransaction(Transaction transaction);
+  // Stream the accounts owned by programId to handler as they are read
+  // from the socket, without holding the response in memory. handler
+  // returns false to stop. Returns the number of accounts handled.
+  size_t getProgramAccounts(PublicKey programId, const ProgramAccountsConfig &config, Commitment commitment, const std::function<bool(const ProgramAccount &)> &handler);
+  size_t getProgramAccounts(PublicKey programId, const ProgramAccountsConfig &config, const std::function<bool(const ProgramAccount &)> &handler);
+  // Send every queued call of the batch in one HTTP request and dispatch
+  // the results to their callbacks. Returns false if the request failed.
+  // A callback that throws does not keep the others from being called, the
+  // first exception is rethrown after all of them ran.
+  bool sendBatch(RpcBatch &batch);
+
+  // Variants returning the value or the error that ended the call instead
+  // of throwing. A call past its deadline comes back with
+  // RpcErrorCode::timeout, one whose token was cancelled with cancelled:
+  //   auto height = connection.withDeadline(500).tryGetBlockHeight();
+  //   if (!height) { ... height.error->code ... }
+  RpcResult<BlockhashWithExpiryBlockHeight> tryGetLatestBlockhash(Commitment commitment);
+  RpcResult<BlockhashWithExpiryBlockHeight> tryGetLatestBlockhash();
+  RpcResult<Signature> trySendTransaction(Transaction transaction, SendOptions sendOptions);
+  RpcResult<Signature> trySendTransaction(Transaction transaction);
+  RpcResult<Signature> trySendRawTransaction(const std::vector<uint8_t> &rawTransaction, SendOptions sendOptions);
+  RpcResult<Signature> trySendRawTransaction(const std::vector<uint8_t> &rawTransaction);
+  RpcResult<uint64_t> tryGetBlockHeight(Commitment commitment);
+  RpcResult<uint64_t> tryGetBlockHeight();
+  RpcResult<NonceAccount> tryGetNonceAccount(PublicKey nonceAccount, Commitment commitment);
+  RpcResult<NonceAccount> tryGetNonceAccount(PublicKey nonceAccount);
+  RpcResult<std::optional<AccountInfo>> tryGetAccountInfo(PublicKey account, Commitment commitment, std::optional<DataSlice> dataSlice = std::nullopt);
+  RpcResult<std::optional<AccountInfo>> tryGetAccountInfo(PublicKey account);
+  RpcResult<std::vector<std::optional<AccountInfo>>> tryGetMultipleAccounts(const std::vector<PublicKey> &accounts, Commitment commitment, std::optional<DataSlice> dataSlice = std::nullopt);
+  RpcResult<std::vector<std::optional<AccountInfo>>> tryGetMultipleAccounts(const std::vector<PublicKey> &accounts);
+  RpcResult<std::vector<ConfirmedSignatureInfo>> tryGetSignaturesForAddress(PublicKey address, SignaturesForAddressOptions options, Commitment commitment);
+  RpcResult<std::vector<ConfirmedSignatureInfo>> tryGetSignaturesForAddress(PublicKey address, SignaturesForAddressOptions options);
+  RpcResult<std::vector<ConfirmedSignatureInfo>> tryGetSignaturesForAddress(PublicKey address);
+  RpcResult<std::vector<PrioritizationFee>> tryGetRecentPrioritizationFees(const std::vector<PublicKey> &accounts);
+  RpcResult<SimulationResult> trySimulateTransaction(Transaction transaction, SimulateOptions options, Commitment commitment);
+  RpcResult<SimulationResult> trySimulateTransaction(Transaction transaction, SimulateOptions options);
+  RpcResult<SimulationResult> trySimulateTransaction(Transaction transaction);
+  RpcResult<size_t> tryGetProgramAccounts(PublicKey programId, const ProgramAccountsConfig &config, Commitment commitment, const std::function<bool(const ProgramAccount &)> &handler);
+  RpcResult<size_t> tryGetProgramAccounts(PublicKey programId, const ProgramAccountsConfig &config, const std::function<bool(const ProgramAccount &)> &handler);
+
+  // Non-blocking variants, run on a pool of maxConnections workers so that
+  // many requests can be in flight at once. Errors are rethrown by get().
+  std::future<BlockhashWithExpiryBlockHeight> getLatestBlockhashAsync(Commitment commitment);
+  std::future<BlockhashWithExpiryBlockHeight> getLatestBlockhashAsync();
+  std::future<Signature> sendTransactionAsync(Transaction transaction, SendOptions sendOptions);
+  std::future<Signature> sendTransactionAsync(Transaction transaction);
+  std::future<Signature> sendRawTransactionAsync(std::vector<uint8_t> rawTransaction, SendOptions sendOptions);
+  std::future<Signature> sendRawTransactionAsync(std::vector<uint8_t> rawTransaction);
+  std::future<uint64_t> getBlockHeightAsync(Commitment commitment);
+  std::future<uint64_t> getBlockHeightAsync();
+  std::future<NonceAccount> getNonceAccountAsync(PublicKey nonceAccount, Commitment commitment);
+  std::future<NonceAccount> getNonceAccountAsync(PublicKey nonceAccount);
+  std::future<std::optional<AccountInfo>> getAccountInfoAsync(PublicKey account, Commitment commitment, std::optional<DataSlice> dataSlice = std::nullopt);
+  std::future<std::optional<AccountInfo>> getAccountInfoAsync(PublicKey account);
+  std::future<std::vector<std::optional<AccountInfo>>> getMultipleAccountsAsync(std::vector<PublicKey> accounts, Commitment commitment, std::optional<DataSlice> dataSlice = std::nullopt);
+  std::future<std::vector<std::optional<AccountInfo>>> getMultipleAccountsAsync(std::vector<PublicKey> accounts);
+  std::future<std::vector<ConfirmedSignatureInfo>> getSignaturesForAddressAsync(PublicKey address, SignaturesForAddressOptions options, Commitment commitment);
+  std::future<std::vector<ConfirmedSignatureInfo>> getSignaturesForAddressAsync(PublicKey address, SignaturesForAddressOptions options);
+  std::future<std::vector<PrioritizationFee>> getRecentPrioritizationFeesAsync(std::vector<PublicKey> accounts);
+  std::future<SimulationResult> simulateTransactionAsync(Transaction transaction, SimulateOptions options, Commitment commitment);
+  std::future<SimulationResult> simulateTransactionAsync(Transaction transaction, SimulateOptions options);
+  // Batch callbacks run on a worker thread
+  std::future<bool> sendBatchAsync(RpcBatch batch);
 };
 
 #endif // CONNECTION_H
\ No newline at end of file
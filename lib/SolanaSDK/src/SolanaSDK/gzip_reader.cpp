@@ -0,0 +1,535 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include "gzip_reader.h"
+
+// Most bytes of a stored block copied per step
+constexpr uint32_t GZIP_STORED_STEP = 1024;
+
+// Base values and extra bits of the length and distance symbols, RFC 1951
+static const uint16_t LENGTH_BASE[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t LENGTH_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t DISTANCE_BASE[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t DISTANCE_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+// Order the code length code lengths are sent in
+static const uint8_t CODE_LENGTH_ORDER[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+// CRC-32 a nibble at a time, keeps the table small
+static const uint32_t CRC_TABLE[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+    0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c};
+
+GzipResponseReader::GzipResponseReader(ResponseReader &body, std::vector<uint8_t> &window) : body(body), window(window)
+{
+  if (window.size() < GZIP_WINDOW_SIZE)
+  {
+    window.resize(GZIP_WINDOW_SIZE);
+  }
+}
+
+// Returns false if the lengths do not describe a valid code. An incomplete
+// code is allowed, decode() fails on the missing codes.
+bool GzipResponseReader::build(Huffman &code, const uint8_t *lengths, int count)
+{
+  std::memset(code.count, 0, sizeof(code.count));
+  for (int i = 0; i < count; ++i)
+  {
+    code.count[lengths[i]]++;
+  }
+  if (code.count[0] == count)
+  {
+    return true;
+  }
+  int left = 1;
+  for (int length = 1; length < 16; ++length)
+  {
+    left <<= 1;
+    left -= code.count[length];
+    if (left < 0)
+    {
+      return false;
+    }
+  }
+  uint16_t offsets[16];
+  offsets[1] = 0;
+  for (int length = 1; length < 15; ++length)
+  {
+    offsets[length + 1] = offsets[length] + code.count[length];
+  }
+  for (int i = 0; i < count; ++i)
+  {
+    if (lengths[i] != 0)
+    {
+      code.symbol[offsets[lengths[i]]++] = static_cast<uint16_t>(i);
+    }
+  }
+  return true;
+}
+
+const GzipResponseReader::Huffman &GzipResponseReader::fixedLengths()
+{
+  static const Huffman code = []
+  {
+    uint8_t lengths[288];
+    std::fill(lengths, lengths + 144, 8);
+    std::fill(lengths + 144, lengths + 256, 9);
+    std::fill(lengths + 256, lengths + 280, 7);
+    std::fill(lengths + 280, lengths + 288, 8);
+    Huffman built;
+    build(built, lengths, 288);
+    return built;
+  }();
+  return code;
+}
+
+const GzipResponseReader::Huffman &GzipResponseReader::fixedDistances()
+{
+  static const Huffman code = []
+  {
+    uint8_t lengths[30];
+    std::fill(lengths, lengths + 30, 5);
+    Huffman built;
+    build(built, lengths, 30);
+    return built;
+  }();
+  return code;
+}
+
+int GzipResponseReader::byte()
+{
+  return body.read();
+}
+
+// Next count bits, least significant first; -1 at the end of the body
+int GzipResponseReader::bits(int count)
+{
+  while (bitCount < count)
+  {
+    int c = byte();
+    if (c < 0)
+    {
+      return -1;
+    }
+    bitBuffer |= static_cast<uint32_t>(c) << bitCount;
+    bitCount += 8;
+  }
+  int value = static_cast<int>(bitBuffer & ((1u << count) - 1));
+  bitBuffer >>= count;
+  bitCount -= count;
+  return value;
+}
+
+// Read a symbol a bit at a time, -1 on a bad code or the end of the body
+int GzipResponseReader::decode(const Huffman &code)
+{
+  int value = 0;
+  int first = 0;
+  int index = 0;
+  for (int length = 1; length < 16; ++length)
+  {
+    int bit = bits(1);
+    if (bit < 0)
+    {
+      return -1;
+    }
+    value |= bit;
+    int count = code.count[length];
+    if (value - count < first)
+    {
+      return code.symbol[index + (value - first)];
+    }
+    index += count;
+    first += count;
+    first <<= 1;
+    value <<= 1;
+  }
+  return -1;
+}
+
+void GzipResponseReader::put(uint8_t value)
+{
+  window[written % GZIP_WINDOW_SIZE] = value;
+  written++;
+  crc = (crc >> 4) ^ CRC_TABLE[(crc ^ value) & 0x0F];
+  crc = (crc >> 4) ^ CRC_TABLE[(crc ^ (value >> 4)) & 0x0F];
+}
+
+// RFC 1952 member header; the optional fields are skipped
+bool GzipResponseReader::readHeader()
+{
+  uint8_t fixed[10];
+  for (uint8_t &b : fixed)
+  {
+    int c = byte();
+    if (c < 0)
+    {
+      return false;
+    }
+    b = static_cast<uint8_t>(c);
+  }
+  if (fixed[0] != 0x1f || fixed[1] != 0x8b || fixed[2] != 8)
+  {
+    return false;
+  }
+  uint8_t flags = fixed[3];
+  if (flags & 0x04)
+  {
+    int low = byte();
+    int high = byte();
+    if (low < 0 || high < 0)
+    {
+      return false;
+    }
+    for (int extra = low | (high << 8); extra > 0; --extra)
+    {
+      if (byte() < 0)
+      {
+        return false;
+      }
+    }
+  }
+  // File name, then comment, each zero-terminated
+  for (uint8_t field : {0x08, 0x10})
+  {
+    if (flags & field)
+    {
+      int c;
+      while ((c = byte()) > 0)
+      {
+      }
+      if (c < 0)
+      {
+        return false;
+      }
+    }
+  }
+  if (flags & 0x02)
+  {
+    if (byte() < 0 || byte() < 0)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool GzipResponseReader::readBlockHeader()
+{
+  int last = bits(1);
+  int type = bits(2);
+  if (last < 0 || type < 0)
+  {
+    return false;
+  }
+  lastBlock = last == 1;
+  switch (type)
+  {
+  case 0:
+  {
+    // Stored blocks start on a byte boundary
+    bitBuffer = 0;
+    bitCount = 0;
+    uint8_t header[4];
+    for (uint8_t &b : header)
+    {
+      int c = byte();
+      if (c < 0)
+      {
+        return false;
+      }
+      b = static_cast<uint8_t>(c);
+    }
+    uint16_t length = header[0] | (header[1] << 8);
+    uint16_t complement = header[2] | (header[3] << 8);
+    if (length != static_cast<uint16_t>(~complement))
+    {
+      return false;
+    }
+    storedLeft = length;
+    state = State::stored;
+    return true;
+  }
+  case 1:
+    lengthCode = &fixedLengths();
+    distanceCode = &fixedDistances();
+    state = State::compressed;
+    return true;
+  case 2:
+    if (!readDynamicCodes())
+    {
+      return false;
+    }
+    lengthCode = &dynamicLengths;
+    distanceCode = &dynamicDistances;
+    state = State::compressed;
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool GzipResponseReader::readDynamicCodes()
+{
+  int lengthCount = bits(5);
+  int distanceCount = bits(5);
+  int codeLengthCount = bits(4);
+  if (lengthCount < 0 || distanceCount < 0 || codeLengthCount < 0)
+  {
+    return false;
+  }
+  lengthCount += 257;
+  distanceCount += 1;
+  codeLengthCount += 4;
+  if (lengthCount > 286 || distanceCount > 30)
+  {
+    return false;
+  }
+
+  uint8_t lengths[286 + 30] = {};
+  for (int i = 0; i < codeLengthCount; ++i)
+  {
+    int length = bits(3);
+    if (length < 0)
+    {
+      return false;
+    }
+    lengths[CODE_LENGTH_ORDER[i]] = static_cast<uint8_t>(length);
+  }
+  Huffman codeLengths;
+  if (!build(codeLengths, lengths, 19))
+  {
+    return false;
+  }
+
+  // Literal/length and distance code lengths, run-length coded together
+  int total = lengthCount + distanceCount;
+  int index = 0;
+  while (index < total)
+  {
+    int symbol = decode(codeLengths);
+    if (symbol < 0)
+    {
+      return false;
+    }
+    if (symbol < 16)
+    {
+      lengths[index++] = static_cast<uint8_t>(symbol);
+      continue;
+    }
+    uint8_t repeated = 0;
+    int repeat;
+    if (symbol == 16)
+    {
+      if (index == 0)
+      {
+        return false;
+      }
+      repeated = lengths[index - 1];
+      repeat = bits(2);
+      repeat = repeat < 0 ? -1 : 3 + repeat;
+    }
+    else if (symbol == 17)
+    {
+      repeat = bits(3);
+      repeat = repeat < 0 ? -1 : 3 + repeat;
+    }
+    else
+    {
+      repeat = bits(7);
+      repeat = repeat < 0 ? -1 : 11 + repeat;
+    }
+    if (repeat < 0 || index + repeat > total)
+    {
+      return false;
+    }
+    std::fill(lengths + index, lengths + index + repeat, repeated);
+    index += repeat;
+  }
+  if (lengths[256] == 0)
+  {
+    // No end-of-block code
+    return false;
+  }
+  return build(dynamicLengths, lengths, lengthCount) &&
+         build(dynamicDistances, lengths + lengthCount, distanceCount);
+}
+
+bool GzipResponseReader::readTrailer()
+{
+  bitBuffer = 0;
+  bitCount = 0;
+  uint32_t fields[2] = {0, 0};
+  for (uint32_t &field : fields)
+  {
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+      int c = byte();
+      if (c < 0)
+      {
+        return false;
+      }
+      field |= static_cast<uint32_t>(c) << shift;
+    }
+  }
+  return fields[0] == (crc ^ 0xFFFFFFFF) && fields[1] == static_cast<uint32_t>(written);
+}
+
+bool GzipResponseReader::step()
+{
+  switch (state)
+  {
+  case State::header:
+    if (!readHeader())
+    {
+      return false;
+    }
+    state = State::blockHeader;
+    return true;
+  case State::blockHeader:
+    return readBlockHeader();
+  case State::stored:
+  {
+    uint32_t take = std::min(storedLeft, GZIP_STORED_STEP);
+    for (uint32_t i = 0; i < take; ++i)
+    {
+      int c = byte();
+      if (c < 0)
+      {
+        return false;
+      }
+      put(static_cast<uint8_t>(c));
+    }
+    storedLeft -= take;
+    if (storedLeft == 0)
+    {
+      state = lastBlock ? State::trailer : State::blockHeader;
+    }
+    return true;
+  }
+  case State::compressed:
+  {
+    int symbol = decode(*lengthCode);
+    if (symbol < 0)
+    {
+      return false;
+    }
+    if (symbol < 256)
+    {
+      put(static_cast<uint8_t>(symbol));
+      return true;
+    }
+    if (symbol == 256)
+    {
+      state = lastBlock ? State::trailer : State::blockHeader;
+      return true;
+    }
+    symbol -= 257;
+    if (symbol >= 29)
+    {
+      return false;
+    }
+    int extra = bits(LENGTH_EXTRA[symbol]);
+    int distanceSymbol = extra < 0 ? -1 : decode(*distanceCode);
+    if (distanceSymbol < 0 || distanceSymbol >= 30)
+    {
+      return false;
+    }
+    int length = LENGTH_BASE[symbol] + extra;
+    int distanceExtra = bits(DISTANCE_EXTRA[distanceSymbol]);
+    if (distanceExtra < 0)
+    {
+      return false;
+    }
+    uint32_t distance = DISTANCE_BASE[distanceSymbol] + distanceExtra;
+    if (distance > written)
+    {
+      return false;
+    }
+    for (int i = 0; i < length; ++i)
+    {
+      put(window[(written - distance) % GZIP_WINDOW_SIZE]);
+    }
+    return true;
+  }
+  case State::trailer:
+    if (!readTrailer())
+    {
+      return false;
+    }
+    state = State::done;
+    return true;
+  default:
+    return false;
+  }
+}
+
+int GzipResponseReader::read()
+{
+  char c;
+  return readBytes(&c, 1) == 1 ? static_cast<uint8_t>(c) : -1;
+}
+
+// Hands out what the last step inflated before taking another, so output
+// not yet read is never overwritten in the window
+size_t GzipResponseReader::readBytes(char *buffer, size_t length)
+{
+  size_t count = 0;
+  while (count < length)
+  {
+    if (delivered == written)
+    {
+      if (state == State::done || state == State::failed)
+      {
+        break;
+      }
+      if (!step())
+      {
+        state = State::failed;
+        break;
+      }
+      continue;
+    }
+    size_t start = static_cast<size_t>(delivered % GZIP_WINDOW_SIZE);
+    size_t take = std::min<uint64_t>(written - delivered, length - count);
+    take = std::min(take, GZIP_WINDOW_SIZE - start);
+    std::memcpy(buffer + count, window.data() + start, take);
+    delivered += take;
+    count += take;
+  }
+  return count;
+}
+
+int GzipResponseReader::status() const
+{
+  return body.status();
+}
+
+uint32_t GzipResponseReader::retryAfterMs() const
+{
+  return body.retryAfterMs();
+}
+
+bool GzipResponseReader::ok() const
+{
+  return state != State::failed;
+}
+
+bool GzipResponseReader::finish()
+{
+  char scratch[256];
+  while (readBytes(scratch, sizeof(scratch)) > 0)
+  {
+  }
+  return ok();
+}
@@ -0,0 +1,86 @@
+#ifndef GZIP_READER_H
+#define GZIP_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "transport.h"
+
+// Largest back-reference deflate allows, and so the whole history an
+// inflater needs to keep
+constexpr size_t GZIP_WINDOW_SIZE = 32768;
+
+// Inflates a gzip response body as it is read, so a JSON parser can
+// consume a compressed body without it being buffered. Memory use is the
+// 32 KiB window, which the caller passes in so it can be reused across
+// responses. The CRC and length in the gzip trailer are checked once the
+// body has been read to the end.
+class GzipResponseReader : public ResponseReader
+{
+private:
+  // Canonical Huffman code: codes per bit length and symbols in code order
+  struct Huffman
+  {
+    uint16_t count[16];
+    uint16_t symbol[288];
+  };
+
+  enum class State
+  {
+    header,
+    blockHeader,
+    stored,
+    compressed,
+    trailer,
+    done,
+    failed
+  };
+
+  ResponseReader &body;
+  std::vector<uint8_t> &window;
+  // Bytes inflated and bytes handed to the reader so far
+  uint64_t written = 0;
+  uint64_t delivered = 0;
+  uint32_t bitBuffer = 0;
+  int bitCount = 0;
+  State state = State::header;
+  bool lastBlock = false;
+  uint32_t storedLeft = 0;
+  const Huffman *lengthCode = nullptr;
+  const Huffman *distanceCode = nullptr;
+  Huffman dynamicLengths;
+  Huffman dynamicDistances;
+  uint32_t crc = 0xFFFFFFFF;
+
+  static bool build(Huffman &code, const uint8_t *lengths, int count);
+  static const Huffman &fixedLengths();
+  static const Huffman &fixedDistances();
+
+  int byte();
+  int bits(int count);
+  int decode(const Huffman &code);
+  void put(uint8_t value);
+  bool readHeader();
+  bool readBlockHeader();
+  bool readDynamicCodes();
+  bool readTrailer();
+  // Inflate at least one byte or move to the next state
+  bool step();
+
+public:
+  GzipResponseReader(ResponseReader &body, std::vector<uint8_t> &window);
+
+  int read() override;
+  size_t readBytes(char *buffer, size_t length) override;
+  int status() const override;
+  uint32_t retryAfterMs() const override;
+
+  // False once the body turned out to be corrupt or truncated
+  bool ok() const;
+
+  // Inflate whatever the reader left, so the trailer is checked even when
+  // the parser stopped at the end of the JSON. Returns ok().
+  bool finish();
+};
+
+#endif // GZIP_READER_H
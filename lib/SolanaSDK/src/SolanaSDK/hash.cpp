@@ -1,8 +1,10 @@
 #include <atomic>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 #include "hash.h"
 #include "base58.h"
+#include "sha256_lanes.h"
 
 Hash::Hash()
 {
@@ -135,20 +137,46 @@ std::string Hash::toStr()
     return base58Encoded;
 }
 
+Hasher::Hasher() : Hasher(Sha256Backend::best()) {}
+
+Hasher::Hasher(const Sha256Backend &backend) : backend(&backend)
+{
+    this->backend->init(this->state);
+}
+
+Hasher::~Hasher()
+{
+    this->backend->release(this->state);
+}
+
 void Hasher::hash(const uint8_t *val, size_t len)
 {
-    this->hasher.doUpdate(val, len);
+    this->backend->update(this->state, val, len);
 }
 
-void Hasher::hashv(const std::vector<uint8_t *> &vals)
+void Hasher::hashv(const std::vector<ByteSpan> &vals)
 {
     for (auto &val : vals)
     {
-        this->hash(val, std::strlen(reinterpret_cast<const char *>(val)));
+        this->hash(val.data, val.size);
     }
 }
 
 void Hasher::result(Hash *hash)
 {
-    this->hasher.doFinal(reinterpret_cast<byte *>(hash->data.data()));
+    this->backend->finish(this->state, hash->data.data());
+    // Leave the hasher ready for the next message
+    this->backend->init(this->state);
+}
+
+std::vector<Hash> Hasher::hashMany(const std::vector<std::vector<ByteSpan>> &messages)
+{
+    std::vector<Hash> hashes(messages.size());
+    std::vector<uint8_t> digests(messages.size() * HASH_BYTES);
+    Sha256Lanes::hashMany(messages, reinterpret_cast<uint8_t(*)[SHA256_DIGEST_BYTES]>(digests.data()));
+    for (size_t i = 0; i < messages.size(); ++i)
+    {
+        std::copy(digests.begin() + i * HASH_BYTES, digests.begin() + (i + 1) * HASH_BYTES, hashes[i].data.begin());
+    }
+    return hashes;
 }
@@ -2,9 +2,11 @@
 #define HASH_H
 
 #include <cstring>
+#include <string>
 #include <array>
 #include <vector>
-#include <Crypto.h>
+#include "sha256.h"
+#include "byte_span.h"
 
 // Size of hash in bytes
 constexpr size_t HASH_BYTES = 32;
@@ -53,14 +55,26 @@ public:
     }
 };
 
+// Streaming SHA-256 over the fastest backend available, see Sha256Backend
 class Hasher
 {
 public:
-    SHA256 hasher;
+    Hasher();
+    explicit Hasher(const Sha256Backend &backend);
+    Hasher(const Hasher &) = delete;
+    Hasher &operator=(const Hasher &) = delete;
+    ~Hasher();
 
     void hash(const uint8_t *val, size_t len);
-    void hashv(const std::vector<uint8_t *> &vals);
+    void hashv(const std::vector<ByteSpan> &vals);
     void result(Hash *hash);
+
+    // Hash independent messages side by side, see Sha256Lanes
+    static std::vector<Hash> hashMany(const std::vector<std::vector<ByteSpan>> &messages);
+
+private:
+    const Sha256Backend *backend;
+    Sha256State state;
 };
 
 #endif // HASH_H
\ No newline at end of file
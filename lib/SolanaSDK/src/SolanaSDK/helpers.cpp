@@ -2,6 +2,7 @@
 #include <string>
 #include <algorithm>
 #include "helpers.h"
+#include "programs/system_program.h"
 
 Helpers::Helpers() {};
 
@@ -13,22 +14,8 @@ std::vector<uint8_t> Helpers::buffer_to_hex_uint8_vector(std::vector<uint8_t> bu
     return result;
 }
 
+// Transfer instruction data for the given lamports
 std::vector<uint8_t> Helpers::uint64_to_hex_uint8_vector(uint64_t number) {
-    std::vector<uint8_t> amount_hex;
-    std::vector<uint8_t> transferData = {
-        0x02, 0x00, 0x00, 0x00};
-    
-    // Extract individual bytes
-    amount_hex.push_back((number >> 56) & 0xFF);
-    amount_hex.push_back((number >> 48) & 0xFF);
-    amount_hex.push_back((number >> 40) & 0xFF);
-    amount_hex.push_back((number >> 32) & 0xFF);
-    amount_hex.push_back((number >> 24) & 0xFF);
-    amount_hex.push_back((number >> 16) & 0xFF);
-    amount_hex.push_back((number >> 8) & 0xFF);
-    amount_hex.push_back(number & 0xFF);
-    std::reverse(amount_hex.begin(), amount_hex.end());
-    transferData.insert(transferData.end(), amount_hex.begin(), amount_hex.end());
-
-    return transferData;
-}
\ No newline at end of file
+    auto data = SystemProgram::transferData(number);
+    return std::vector<uint8_t>(data.begin(), data.end());
+}
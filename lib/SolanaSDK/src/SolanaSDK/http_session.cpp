@@ -0,0 +1,608 @@
+#if defined(ARDUINO)
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <HTTPClient.h>
+#include "http_session.h"
+#include "gzip_reader.h"
+#include "tls_session_client.h"
+
+HttpSession::HttpSession(const std::string &url, const char *caCert, std::shared_ptr<TlsSessionCache> tlsSessions) : url(url), caCert(caCert)
+{
+  parseUrl();
+#if defined(CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS)
+  if (secure)
+  {
+    if (!tlsSessions)
+    {
+      tlsSessions = std::make_shared<TlsSessionCache>();
+    }
+    client.reset(new TlsSessionClient(caCert, tlsSessions));
+  }
+#else
+  (void)tlsSessions;
+  if (secure)
+  {
+    WiFiClientSecure *secureClient = new WiFiClientSecure();
+    if (caCert != nullptr)
+    {
+      secureClient->setCACert(caCert);
+    }
+    else
+    {
+      // Matches HTTPClient::begin(url), which does not verify the server
+      secureClient->setInsecure();
+    }
+    client.reset(secureClient);
+  }
+#endif
+  else
+  {
+    client.reset(new WiFiClient());
+  }
+  http.setReuse(true);
+  setTimeout(HTTP_SESSION_DEFAULT_TIMEOUT_MS);
+}
+
+HttpSession::~HttpSession()
+{
+  close();
+}
+
+// Split scheme://host[:port]/path into the parts needed to pre-connect
+void HttpSession::parseUrl()
+{
+  secure = url.rfind("https://", 0) == 0;
+  size_t hostStart = url.find("://");
+  hostStart = hostStart == std::string::npos ? 0 : hostStart + 3;
+  size_t hostEnd = url.find('/', hostStart);
+  std::string authority = url.substr(hostStart, hostEnd == std::string::npos ? std::string::npos : hostEnd - hostStart);
+
+  size_t colon = authority.find(':');
+  if (colon != std::string::npos)
+  {
+    host = authority.substr(0, colon);
+    port = static_cast<uint16_t>(std::stoi(authority.substr(colon + 1)));
+  }
+  else
+  {
+    host = authority;
+    port = secure ? 443 : 80;
+  }
+}
+
+bool HttpSession::warmup()
+{
+  if (WiFi.status() != WL_CONNECTED)
+  {
+    return false;
+  }
+  if (client->connected())
+  {
+    return true;
+  }
+  return client->connect(host.c_str(), port) == 1;
+}
+
+bool HttpSession::connected()
+{
+  return client->connected();
+}
+
+void HttpSession::setTimeout(uint32_t timeoutMs)
+{
+  // HTTPClient keeps the read timeout in 16 bits
+  http.setTimeout(static_cast<uint16_t>(std::min<uint32_t>(timeoutMs, UINT16_MAX)));
+  http.setConnectTimeout(static_cast<int32_t>(timeoutMs));
+}
+
+void HttpSession::setAcceptGzip(bool accept)
+{
+  acceptGzip = accept;
+}
+
+void HttpSession::close()
+{
+  http.end();
+  client->stop();
+}
+
+bool HttpSession::postOnce(const uint8_t *requestData, size_t length, const HttpResponseReader &reader, int &httpResponseCode, bool &parsed)
+{
+  // begin() only records the URL, the socket in client is kept across calls
+  if (!http.begin(*client, url.c_str()))
+  {
+    httpResponseCode = -1;
+    return false;
+  }
+  http.addHeader("Content-Type", "application/json");
+  if (acceptGzip)
+  {
+    http.addHeader("Accept-Encoding", "gzip");
+  }
+  static const char *headerKeys[] = {"Transfer-Encoding", "Retry-After", "Content-Encoding"};
+  http.collectHeaders(headerKeys, 3);
+
+  httpResponseCode = http.POST(const_cast<uint8_t *>(requestData), length);
+  if (httpResponseCode > 0)
+  {
+    bool chunked = http.header("Transfer-Encoding").indexOf("chunked") >= 0;
+    HttpBodyStream body(http.getStream(), chunked, http.getSize());
+    body.status = httpResponseCode;
+    body.retryAfterMs = parseRetryAfter(http.header("Retry-After").c_str());
+    if (http.header("Content-Encoding").indexOf("gzip") >= 0)
+    {
+      body.inflateWindow = &window;
+    }
+    parsed = reader(body);
+    bool reusable = body.drain();
+    http.end();
+    if (!reusable)
+    {
+      client->stop();
+    }
+    return true;
+  }
+
+  http.end();
+  return false;
+}
+
+// Presents a response body stream as a transport response body
+class StreamResponseReader : public ResponseReader
+{
+private:
+  HttpBodyStream &stream;
+
+public:
+  StreamResponseReader(HttpBodyStream &stream) : stream(stream) {}
+
+  int read() override
+  {
+    uint8_t c;
+    return stream.readBytes(&c, 1) == 1 ? c : -1;
+  }
+
+  size_t readBytes(char *buffer, size_t length) override
+  {
+    return stream.readBytes(buffer, length);
+  }
+
+  int status() const override
+  {
+    return stream.status;
+  }
+
+  uint32_t retryAfterMs() const override
+  {
+    return stream.retryAfterMs;
+  }
+};
+
+// Hand the body to handler, inflating it on the way if it is compressed
+static bool readBody(HttpBodyStream &body, ResponseReader &reader, const ResponseHandler &handler)
+{
+  if (body.inflateWindow == nullptr)
+  {
+    return handler(reader);
+  }
+  GzipResponseReader inflated(reader, *body.inflateWindow);
+  bool parsed = handler(inflated);
+  return inflated.finish() && parsed;
+}
+
+bool HttpSession::post(const String &requestData, String &response)
+{
+  // The body is inflated first when acceptGzip had the server compress it
+  return post(requestData, [&response](HttpBodyStream &body)
+              {
+                response = "";
+                StreamResponseReader reader(body);
+                return readBody(body, reader, [&response](ResponseReader &text)
+                                {
+                                  int c;
+                                  while ((c = text.read()) >= 0)
+                                  {
+                                    response += static_cast<char>(c);
+                                  }
+                                  return true; }); });
+}
+
+bool HttpSession::post(const String &requestData, const HttpResponseReader &reader)
+{
+  return post(reinterpret_cast<const uint8_t *>(requestData.c_str()), requestData.length(), reader);
+}
+
+bool HttpSession::post(const std::string &requestData, const HttpResponseReader &reader)
+{
+  return post(reinterpret_cast<const uint8_t *>(requestData.data()), requestData.size(), reader);
+}
+
+bool HttpSession::post(const uint8_t *requestData, size_t length, const HttpResponseReader &reader)
+{
+  if (WiFi.status() != WL_CONNECTED)
+  {
+    Serial.println("WiFi not connected");
+    return false;
+  }
+
+  int httpResponseCode;
+  bool parsed = false;
+  if (postOnce(requestData, length, reader, httpResponseCode, parsed))
+  {
+    return parsed;
+  }
+
+  // The server may have closed an idle keep-alive socket, retry on a new one
+  client->stop();
+  if (postOnce(requestData, length, reader, httpResponseCode, parsed))
+  {
+    return parsed;
+  }
+
+  Serial.print("HTTP error code: ");
+  Serial.println(httpResponseCode);
+  client->stop();
+  return false;
+}
+
+HttpBodyStream::HttpBodyStream(Stream &source, bool chunked, int contentLength)
+    : source(source), chunked(chunked), remaining(chunked ? 0 : contentLength)
+{
+  if (chunked)
+  {
+    done = !nextChunk();
+  }
+  else if (contentLength == 0)
+  {
+    done = true;
+  }
+}
+
+// One byte from the socket, waiting up to the stream timeout
+int HttpBodyStream::rawRead()
+{
+  uint8_t c;
+  return source.readBytes(&c, 1) == 1 ? c : -1;
+}
+
+// Parse a "<hex size>[;ext]\r\n" chunk header, false on the last chunk
+bool HttpBodyStream::nextChunk()
+{
+  int64_t size = 0;
+  bool digits = false;
+  int c;
+  while ((c = rawRead()) >= 0 && c != '\n')
+  {
+    if (c == ';')
+    {
+      // Skip chunk extensions up to the end of the line
+      while ((c = rawRead()) >= 0 && c != '\n')
+      {
+      }
+      break;
+    }
+    int value = -1;
+    if (c >= '0' && c <= '9')
+    {
+      value = c - '0';
+    }
+    else if (c >= 'a' && c <= 'f')
+    {
+      value = c - 'a' + 10;
+    }
+    else if (c >= 'A' && c <= 'F')
+    {
+      value = c - 'A' + 10;
+    }
+    if (value >= 0)
+    {
+      size = (size << 4) | value;
+      digits = true;
+    }
+  }
+  if (!digits || size == 0)
+  {
+    return false;
+  }
+  remaining = size;
+  return true;
+}
+
+int HttpBodyStream::nextByte()
+{
+  if (done)
+  {
+    return -1;
+  }
+  if (chunked && remaining == 0)
+  {
+    // Every chunk's data is followed by CRLF
+    rawRead();
+    rawRead();
+    if (!nextChunk())
+    {
+      done = true;
+      return -1;
+    }
+  }
+  int c = rawRead();
+  if (c < 0)
+  {
+    done = true;
+    return -1;
+  }
+  if (remaining > 0 && --remaining == 0 && !chunked)
+  {
+    done = true;
+  }
+  return c;
+}
+
+int HttpBodyStream::available()
+{
+  if (peeked >= 0)
+  {
+    return 1;
+  }
+  if (done)
+  {
+    return 0;
+  }
+  int buffered = source.available();
+  if (remaining > 0 && buffered > remaining)
+  {
+    buffered = static_cast<int>(remaining);
+  }
+  return buffered;
+}
+
+int HttpBodyStream::read()
+{
+  if (peeked >= 0)
+  {
+    int c = peeked;
+    peeked = -1;
+    return c;
+  }
+  return nextByte();
+}
+
+int HttpBodyStream::peek()
+{
+  if (peeked < 0)
+  {
+    peeked = nextByte();
+  }
+  return peeked;
+}
+
+size_t HttpBodyStream::write(uint8_t)
+{
+  return 0;
+}
+
+bool HttpBodyStream::drain()
+{
+  peeked = -1;
+  if (!done && (remaining < 0 || (!chunked && remaining > static_cast<int64_t>(TRANSPORT_DRAIN_LIMIT))))
+  {
+    return false;
+  }
+  for (size_t budget = TRANSPORT_DRAIN_LIMIT; !done && budget > 0; --budget)
+  {
+    nextByte();
+  }
+  if (!done || (!chunked && remaining > 0))
+  {
+    return false;
+  }
+  if (chunked)
+  {
+    // Trailer section ends with an empty line
+    int c;
+    while ((c = rawRead()) >= 0)
+    {
+      if (c == '\n')
+      {
+        break;
+      }
+    }
+  }
+  return true;
+}
+
+HttpSessionPool::HttpSessionPool(const std::string &url, size_t size, const char *caCert)
+{
+  size = std::max<size_t>(size, 1);
+  std::shared_ptr<TlsSessionCache> tlsSessions;
+#if defined(CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS)
+  tlsSessions = std::make_shared<TlsSessionCache>();
+#endif
+  for (size_t i = 0; i < size; ++i)
+  {
+    sessions.emplace_back(new HttpSession(url, caCert, tlsSessions));
+  }
+  busy.assign(size, false);
+}
+
+size_t HttpSessionPool::acquire(const RequestContext &context)
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true)
+  {
+    if (context.stopped())
+    {
+      return sessions.size();
+    }
+    // Prefer a session whose socket is already open
+    size_t idle = sessions.size();
+    for (size_t i = 0; i < sessions.size(); ++i)
+    {
+      if (!busy[i])
+      {
+        if (sessions[i]->connected())
+        {
+          idle = i;
+          break;
+        }
+        if (idle == sessions.size())
+        {
+          idle = i;
+        }
+      }
+    }
+    if (idle < sessions.size())
+    {
+      busy[idle] = true;
+      return idle;
+    }
+    if (context.deadline.bounded() || context.token)
+    {
+      released.wait_for(lock, std::chrono::milliseconds(context.deadline.remainingMs(REQUEST_CONTEXT_POLL_MS)));
+    }
+    else
+    {
+      released.wait(lock);
+    }
+  }
+}
+
+void HttpSessionPool::release(size_t index)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    busy[index] = false;
+  }
+  released.notify_one();
+}
+
+size_t HttpSessionPool::warmup()
+{
+  // Every session stays held until the loop ends, acquire() would otherwise
+  // hand back the first warm one each time
+  std::vector<size_t> held;
+  size_t ready = 0;
+  for (size_t i = 0; i < sessions.size(); ++i)
+  {
+    size_t index = acquire();
+    held.push_back(index);
+    if (sessions[index]->warmup())
+    {
+      ready++;
+    }
+  }
+  for (size_t index : held)
+  {
+    release(index);
+  }
+  return ready;
+}
+
+bool HttpSessionPool::post(const String &requestData, String &response)
+{
+  size_t index = acquire();
+  bool ok = sessions[index]->post(requestData, response);
+  release(index);
+  return ok;
+}
+
+bool HttpSessionPool::post(const String &requestData, const HttpResponseReader &reader)
+{
+  size_t index = acquire();
+  bool ok = sessions[index]->post(requestData, reader);
+  release(index);
+  return ok;
+}
+
+bool HttpSessionPool::post(const std::string &requestData, const HttpResponseReader &reader)
+{
+  size_t index = acquire();
+  bool ok = sessions[index]->post(requestData, reader);
+  release(index);
+  return ok;
+}
+
+bool HttpSessionPool::post(const uint8_t *requestData, size_t length, const HttpResponseReader &reader)
+{
+  size_t index = acquire();
+  bool ok = sessions[index]->post(requestData, length, reader);
+  release(index);
+  return ok;
+}
+
+bool HttpSessionPool::post(const uint8_t *requestData, size_t length, const HttpResponseReader &reader, const RequestContext &context)
+{
+  size_t index = acquire(context);
+  if (index == sessions.size())
+  {
+    return false;
+  }
+  // Measured after the wait for a session, which used up part of the budget
+  uint32_t timeoutMs = std::max<uint32_t>(context.deadline.remainingMs(HTTP_SESSION_DEFAULT_TIMEOUT_MS), 1);
+  sessions[index]->setTimeout(timeoutMs);
+  bool ok = sessions[index]->post(requestData, length, reader);
+  sessions[index]->setTimeout(HTTP_SESSION_DEFAULT_TIMEOUT_MS);
+  release(index);
+  return ok;
+}
+
+void HttpSessionPool::setAcceptGzip(bool accept)
+{
+  for (auto &session : sessions)
+  {
+    session->setAcceptGzip(accept);
+  }
+}
+
+size_t HttpSessionPool::size() const
+{
+  return sessions.size();
+}
+
+HttpTransport::HttpTransport(const std::string &url, size_t maxConnections, const char *caCert)
+    : sessions(url, maxConnections, caCert)
+{
+  sessions.setAcceptGzip(true);
+}
+
+bool HttpTransport::post(ByteSpan request, const ResponseHandler &handler)
+{
+  return sessions.post(request.data, request.size, [&handler](HttpBodyStream &body)
+                       {
+                         StreamResponseReader reader(body);
+                         return readBody(body, reader, handler); });
+}
+
+bool HttpTransport::post(ByteSpan request, const ResponseHandler &handler, const RequestContext &context)
+{
+  if (context.stopped())
+  {
+    return false;
+  }
+  return sessions.post(request.data, request.size, [&handler, &context](HttpBodyStream &body)
+                       {
+                         StreamResponseReader stream(body);
+                         ContextResponseReader reader(stream, context);
+                         return readBody(body, reader, handler) && !context.stopped(); }, context) &&
+         !context.stopped();
+}
+
+size_t HttpTransport::warmup()
+{
+  return sessions.warmup();
+}
+
+size_t HttpTransport::maxConcurrency() const
+{
+  return sessions.size();
+}
+
+#endif // ARDUINO
@@ -0,0 +1,176 @@
+#ifndef HTTP_SESSION_H
+#define HTTP_SESSION_H
+
+#if defined(ARDUINO)
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <WiFi.h>
+#include <HTTPClient.h>
+#include "transport.h"
+
+// Default number of keep-alive sockets a Connection keeps per endpoint
+constexpr size_t HTTP_SESSION_DEFAULT_POOL_SIZE = 1;
+
+// Connect and read timeout of a session when the call has no deadline
+constexpr uint32_t HTTP_SESSION_DEFAULT_TIMEOUT_MS = 5000;
+
+// Response body of a single request, read straight from the socket. Handles
+// both Content-Length and chunked bodies so a JSON parser can consume it
+// without the whole body being buffered first.
+class HttpBodyStream : public Stream
+{
+private:
+  Stream &source;
+  bool chunked;
+  // Bytes left in the body (or current chunk), -1 reads until close
+  int64_t remaining;
+  bool done = false;
+  int peeked = -1;
+
+  int rawRead();
+  bool nextChunk();
+  int nextByte();
+
+public:
+  HttpBodyStream(Stream &source, bool chunked, int contentLength);
+
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t) override;
+
+  // Consume what the reader left so the socket can be reused. Returns false
+  // if the socket has to be closed instead: the body only ends with it, or
+  // more than TRANSPORT_DRAIN_LIMIT bytes are left.
+  bool drain();
+
+  // HTTP status of the response
+  int status = 0;
+  // Delay asked for with Retry-After, 0 if none
+  uint32_t retryAfterMs = 0;
+  // The session's inflate window when the body is gzip-compressed, null
+  // otherwise
+  std::vector<uint8_t> *inflateWindow = nullptr;
+};
+
+// Called with the response body once the server answered. Returns false if
+// the body could not be parsed.
+using HttpResponseReader = std::function<bool(HttpBodyStream &body)>;
+
+// Declared in tls_session_client.h when esp-tls session tickets are enabled
+class TlsSessionCache;
+
+// A keep-alive HTTP(S) connection to a single RPC endpoint. The socket is
+// opened on first use (or by warmup) and reused across requests; if the
+// server dropped it the request is retried once on a fresh socket. With
+// CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS, https goes through esp-tls and
+// new sockets resume the session kept in tlsSessions.
+class HttpSession
+{
+private:
+  std::string url;
+  std::string host;
+  uint16_t port;
+  bool secure;
+  const char *caCert;
+  std::unique_ptr<WiFiClient> client;
+  HTTPClient http;
+  bool acceptGzip = false;
+  std::vector<uint8_t> window;
+
+  void parseUrl();
+  bool postOnce(const uint8_t *requestData, size_t length, const HttpResponseReader &reader, int &httpResponseCode, bool &parsed);
+
+public:
+  HttpSession(const std::string &url, const char *caCert = nullptr, std::shared_ptr<TlsSessionCache> tlsSessions = nullptr);
+  ~HttpSession();
+
+  // Open the socket and finish the TLS handshake ahead of the first request
+  bool warmup();
+
+  bool post(const String &requestData, String &response);
+
+  // Stream the response body into reader instead of buffering it
+  bool post(const uint8_t *requestData, size_t length, const HttpResponseReader &reader);
+  bool post(const String &requestData, const HttpResponseReader &reader);
+  bool post(const std::string &requestData, const HttpResponseReader &reader);
+
+  bool connected();
+
+  // Bounds connecting and each wait for response bytes
+  void setTimeout(uint32_t timeoutMs);
+
+  // Ask for gzip-compressed responses. A reader given the body stream has
+  // to inflate it when inflateWindow is set; post(String, String &) does.
+  void setAcceptGzip(bool accept);
+
+  void close();
+};
+
+// Fixed set of sessions to one endpoint, shared by concurrent callers. The
+// sessions share one TLS session cache, so after the first handshake the
+// others resume it.
+class HttpSessionPool
+{
+private:
+  std::vector<std::unique_ptr<HttpSession>> sessions;
+  std::vector<bool> busy;
+  std::mutex mutex;
+  std::condition_variable released;
+
+  // Index of a free session, or size() once context stopped first
+  size_t acquire(const RequestContext &context = RequestContext());
+  void release(size_t index);
+
+public:
+  HttpSessionPool(const std::string &url, size_t size = HTTP_SESSION_DEFAULT_POOL_SIZE, const char *caCert = nullptr);
+
+  // Pre-connect every session in the pool, returns how many succeeded
+  size_t warmup();
+
+  void setAcceptGzip(bool accept);
+
+  bool post(const String &requestData, String &response);
+
+  bool post(const String &requestData, const HttpResponseReader &reader);
+
+  bool post(const std::string &requestData, const HttpResponseReader &reader);
+
+  bool post(const uint8_t *requestData, size_t length, const HttpResponseReader &reader);
+
+  // As above, giving up if context stops while waiting for a free session.
+  // The session's timeout is lowered to the time left for this call.
+  bool post(const uint8_t *requestData, size_t length, const HttpResponseReader &reader, const RequestContext &context);
+
+  size_t size() const;
+};
+
+// Transport over the ESP32 HTTPClient, backed by a session pool. Responses
+// may come back gzip-compressed and are inflated as they are read.
+class HttpTransport : public Transport
+{
+private:
+  HttpSessionPool sessions;
+
+public:
+  HttpTransport(const std::string &url, size_t maxConnections = HTTP_SESSION_DEFAULT_POOL_SIZE, const char *caCert = nullptr);
+
+  bool post(ByteSpan request, const ResponseHandler &handler) override;
+
+  // The wait for a free session and the HTTPClient timeouts are bounded by
+  // the time left before the deadline
+  bool post(ByteSpan request, const ResponseHandler &handler, const RequestContext &context) override;
+
+  size_t warmup() override;
+
+  size_t maxConcurrency() const override;
+};
+
+#endif // ARDUINO
+
+#endif // HTTP_SESSION_H
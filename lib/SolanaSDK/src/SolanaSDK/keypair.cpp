@@ -2,11 +2,17 @@
 #include <sodium/crypto_sign_ed25519.h>
 #include <string>
 #include <vector>
+#include <stdexcept>
 #include <algorithm>
 #include <cassert>
+#if defined(ESP_PLATFORM)
 #include <esp_random.h>
+#endif
+#if defined(ARDUINO)
 #include <Arduino.h>
+#endif
 #include "keypair.h"
+#include "keypair_pool.h"
 #include "base58.h"
 #include "public_key.h"
 
@@ -16,17 +22,35 @@ Keypair::Keypair()
     std::fill(secretKey, secretKey + SECRET_KEY_LEN, 0);
 }
 
+// Seed bytes of a vector, checked before the delegated constructor reads them
+static const unsigned char *checkedSeed(const std::vector<unsigned char> &seed)
+{
+    if (seed.size() != SECRET_KEY_LEN)
+    {
+        throw std::invalid_argument("Invalid seed size");
+    }
+    return seed.data();
+}
+
 // Generate keypair from a secure seed
-Keypair::Keypair(const std::vector<unsigned char> &seed)
+Keypair::Keypair(const std::vector<unsigned char> &seed) : Keypair(checkedSeed(seed)) {}
+
+// Generate keypair from a secure seed (convenience for C arrays)
+Keypair::Keypair(const unsigned char seed[SECRET_KEY_LEN])
 {
-    assert(seed.size() == SECRET_KEY_LEN); // Enforce valid seed size
     unsigned char publicKey[PUBLIC_KEY_LEN];
-    crypto_sign_ed25519_seed_keypair(publicKey, this->secretKey, seed.data());
+    crypto_sign_ed25519_seed_keypair(publicKey, this->secretKey, seed);
     this->publicKey = PublicKey(publicKey);
 }
 
-// Generate keypair from a secure seed (convenience for C arrays)
-Keypair::Keypair(const unsigned char seed[SECRET_KEY_LEN]) : Keypair(std::vector<unsigned char>(seed, seed + SECRET_KEY_LEN)) {}
+// Rebuild a keypair from a libsodium secret key (seed followed by public key)
+Keypair Keypair::fromSecretKey(const unsigned char secretKey[SECRET_KEY_LEN])
+{
+    Keypair keypair;
+    std::copy(secretKey, secretKey + SECRET_KEY_LEN, keypair.secretKey);
+    keypair.publicKey = PublicKey(secretKey + SECRET_KEY_LEN - PUBLIC_KEY_LEN);
+    return keypair;
+}
 
 // Access secret key with authorization
 const unsigned char *Keypair::getSecretKey()
@@ -37,23 +61,24 @@ const unsigned char *Keypair::getSecretKey()
 // Destructor to securely clear secret key
 Keypair::~Keypair()
 {
-    std::fill(secretKey, secretKey + SECRET_KEY_LEN, 0);
+    sodium_memzero(secretKey, SECRET_KEY_LEN);
 }
 
-// Generate a new Keypair with a random seed
 // Generate a new Keypair with a random seed
 Keypair Keypair::generate()
 {
-    std::vector<unsigned char> seed(SECRET_KEY_LEN);
+    unsigned char seed[SECRET_KEY_LEN];
 
-    // Fill the seed vector with random bytes one character at a time
-    for (size_t i = 0; i < seed.size(); ++i)
-    {
-        seed[i] = static_cast<unsigned char>(randombytes_random() % 256);
-    }
+    // Fill the whole seed with a single call to the entropy source
+    randombytes_buf(seed, SECRET_KEY_LEN);
 
-    // Ensure that the size of the seed vector matches SECRET_KEY_LEN
-    assert(seed.size() == SECRET_KEY_LEN);
+    Keypair keypair(seed);
+    sodium_memzero(seed, SECRET_KEY_LEN);
+    return keypair;
+}
 
-    return Keypair(seed);
+// Take a pre-generated keypair from the shared background pool
+Keypair Keypair::take()
+{
+    return KeypairPool::shared().take();
 }
@@ -34,8 +34,14 @@ public:
     // Destructor to securely clear secret key
     ~Keypair();
 
+    // Rebuild a keypair from a 64 byte secret key
+    static Keypair fromSecretKey(const unsigned char secretKey[SECRET_KEY_LEN]);
+
     // Generate a new Keypair with a random seed
     static Keypair generate();
+
+    // Take a ready keypair from the shared pool, see KeypairPool
+    static Keypair take();
 };
 
 #endif // KEYPAIR_H
\ No newline at end of file
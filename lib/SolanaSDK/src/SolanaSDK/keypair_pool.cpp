@@ -0,0 +1,137 @@
+#include <sodium.h>
+#include <sodium/crypto_sign_ed25519.h>
+#include <cstddef>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "keypair_pool.h"
+#include "keypair.h"
+
+KeypairPool::KeypairPool(size_t depth) : depth(depth), slots(depth * SECRET_KEY_LEN, 0) {}
+
+KeypairPool::~KeypairPool()
+{
+    stop();
+    drain();
+}
+
+void KeypairPool::start()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running)
+    {
+        return;
+    }
+    running = true;
+    worker = std::thread(&KeypairPool::run, this);
+}
+
+void KeypairPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running)
+        {
+            return;
+        }
+        running = false;
+    }
+    refill.notify_all();
+    if (worker.joinable())
+    {
+        worker.join();
+    }
+}
+
+void KeypairPool::setDepth(size_t depth)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    sodium_memzero(slots.data(), slots.size());
+    this->depth = depth;
+    slots.assign(depth * SECRET_KEY_LEN, 0);
+    head = 0;
+    count = 0;
+    refill.notify_all();
+}
+
+// Background loop: top the pool up to depth, one entropy draw per batch
+void KeypairPool::run()
+{
+    unsigned char seeds[KEYPAIR_POOL_BATCH * crypto_sign_ed25519_SEEDBYTES];
+    unsigned char secretKey[SECRET_KEY_LEN];
+    unsigned char publicKey[PUBLIC_KEY_LEN];
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        refill.wait(lock, [this]
+                    { return !running || count < depth; });
+        if (!running)
+        {
+            break;
+        }
+
+        size_t batch = std::min(KEYPAIR_POOL_BATCH, depth - count);
+        lock.unlock();
+
+        randombytes_buf(seeds, batch * crypto_sign_ed25519_SEEDBYTES);
+        std::vector<unsigned char> generated(batch * SECRET_KEY_LEN);
+        for (size_t i = 0; i < batch; ++i)
+        {
+            crypto_sign_ed25519_seed_keypair(publicKey, secretKey, seeds + i * crypto_sign_ed25519_SEEDBYTES);
+            std::copy(secretKey, secretKey + SECRET_KEY_LEN, generated.begin() + i * SECRET_KEY_LEN);
+        }
+        sodium_memzero(seeds, sizeof(seeds));
+        sodium_memzero(secretKey, sizeof(secretKey));
+
+        lock.lock();
+        for (size_t i = 0; i < batch && count < depth; ++i)
+        {
+            size_t tail = (head + count) % depth;
+            std::copy(generated.begin() + i * SECRET_KEY_LEN, generated.begin() + (i + 1) * SECRET_KEY_LEN, slots.begin() + tail * SECRET_KEY_LEN);
+            count++;
+        }
+        sodium_memzero(generated.data(), generated.size());
+    }
+}
+
+Keypair KeypairPool::take()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (count > 0)
+        {
+            unsigned char *slot = slots.data() + head * SECRET_KEY_LEN;
+            Keypair keypair = Keypair::fromSecretKey(slot);
+            sodium_memzero(slot, SECRET_KEY_LEN);
+            head = (head + 1) % depth;
+            count--;
+            refill.notify_one();
+            return keypair;
+        }
+    }
+    return Keypair::generate();
+}
+
+size_t KeypairPool::available()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return count;
+}
+
+void KeypairPool::drain()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    sodium_memzero(slots.data(), slots.size());
+    head = 0;
+    count = 0;
+    refill.notify_all();
+}
+
+KeypairPool &KeypairPool::shared()
+{
+    static KeypairPool pool;
+    pool.start();
+    return pool;
+}
@@ -0,0 +1,62 @@
+#ifndef KEYPAIR_POOL_H
+#define KEYPAIR_POOL_H
+
+#include <cstddef>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "keypair.h"
+
+// Default number of keypairs kept ready by the shared pool
+constexpr size_t KEYPAIR_POOL_DEFAULT_DEPTH = 8;
+
+// Keypairs generated per entropy draw when refilling the pool
+constexpr size_t KEYPAIR_POOL_BATCH = 4;
+
+// Pool of keypairs generated ahead of time on a background thread, so
+// throwaway signers can be handed out without paying for key generation
+// on the caller's thread.
+class KeypairPool
+{
+private:
+    size_t depth;
+    // Ring buffer of libsodium secret keys, SECRET_KEY_LEN bytes per slot
+    std::vector<unsigned char> slots;
+    size_t head = 0;
+    size_t count = 0;
+    bool running = false;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable refill;
+
+    void run();
+
+public:
+    KeypairPool(size_t depth = KEYPAIR_POOL_DEFAULT_DEPTH);
+
+    // Stops the worker and wipes any remaining keys
+    ~KeypairPool();
+
+    // Start the background generator
+    void start();
+
+    // Stop the background generator, keeping pooled keys
+    void stop();
+
+    // Change the number of keypairs kept ready, wiping the current pool
+    void setDepth(size_t depth);
+
+    // Pop a ready keypair, generating one inline if the pool is empty
+    Keypair take();
+
+    size_t available();
+
+    // Securely wipe all pooled keys
+    void drain();
+
+    // Pool used by Keypair::take(), started on first use
+    static KeypairPool &shared();
+};
+
+#endif // KEYPAIR_POOL_H
@@ -0,0 +1,29 @@
+#include <cstddef>
+#include <string>
+#include <mutex>
+#include "loopback_transport.h"
+
+LoopbackTransport::LoopbackTransport(Handler handler, size_t concurrency)
+    : handler(handler), concurrency(concurrency) {}
+
+bool LoopbackTransport::post(ByteSpan request, const ResponseHandler &responseHandler)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    requests++;
+  }
+  std::string response = handler(std::string(reinterpret_cast<const char *>(request.data), request.size));
+  StringResponseReader body(response);
+  return responseHandler(body);
+}
+
+size_t LoopbackTransport::maxConcurrency() const
+{
+  return concurrency;
+}
+
+size_t LoopbackTransport::requestCount()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return requests;
+}
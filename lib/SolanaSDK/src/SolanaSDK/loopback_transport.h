@@ -0,0 +1,35 @@
+#ifndef LOOPBACK_TRANSPORT_H
+#define LOOPBACK_TRANSPORT_H
+
+#include <cstddef>
+#include <string>
+#include <functional>
+#include <mutex>
+#include "transport.h"
+
+// In-process transport for tests: each request is handed to a function
+// standing in for the RPC node, and its return value is the response body.
+class LoopbackTransport : public Transport
+{
+public:
+  using Handler = std::function<std::string(const std::string &request)>;
+
+private:
+  Handler handler;
+  size_t concurrency;
+  size_t requests = 0;
+  std::mutex mutex;
+
+public:
+  LoopbackTransport(Handler handler, size_t concurrency = 1);
+
+  using Transport::post;
+  bool post(ByteSpan request, const ResponseHandler &responseHandler) override;
+
+  size_t maxConcurrency() const override;
+
+  // Number of requests posted so far
+  size_t requestCount();
+};
+
+#endif // LOOPBACK_TRANSPORT_H
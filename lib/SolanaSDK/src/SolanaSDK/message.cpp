@@ -9,6 +9,7 @@
 #include <sstream>
 #include "public_key.h"
 #include "hash.h"
+#include "blake3.h"
 #include "instruction.h"
 #include "compiled_keys.h"
 #include "message.h"
@@ -152,16 +153,19 @@ Message::Message(MessageHeader header, std::vector<PublicKey> accountKeys, Hash
 
 Message::Message(std::vector<Instruction> instructions, std::optional<PublicKey> payer)
 {
-  Message::newWithBlockhash(instructions, payer, Hash());
+  *this = Message::newWithBlockhash(instructions, payer, Hash());
 }
 
+// Create a message whose first instruction advances the given nonce account,
+// so it can be signed with the stored nonce instead of a recent blockhash.
 Message Message::newWithNonce(
     std::vector<Instruction> instructions,
     std::optional<PublicKey> payer,
-    PublicKey &nonceAccountPublicKey,
-    PublicKey &nonceAuthorityPublicKey)
+    const PublicKey &nonceAccountPublicKey,
+    const PublicKey &nonceAuthorityPublicKey)
 {
-  // TODO: add advance nonce account instruction
+  Instruction advanceNonceIx = SystemProgram::advanceNonceAccount(nonceAccountPublicKey, nonceAuthorityPublicKey);
+  instructions.insert(instructions.begin(), advanceNonceIx);
   return Message(instructions, payer);
 }
 
@@ -344,12 +348,22 @@ bool Message::isUpgradeableLoaderPresent()
                      { return key == BPFLoaderUpgradeable::id(); });
 }
 
-Hash Message::hashRawMessage(std::vector<uint8_t> messageBytes)
+// Compute the BLAKE3 message hash used by the network to identify a message
+Hash Message::hashRawMessage(const std::vector<uint8_t> &messageBytes)
 {
-  Hash hash = Hash();
-  std::array<uint8_t, 32> messageArr;
-  std::copy(messageBytes.data(), messageBytes.data() + 32, messageArr.begin());
-  return hash.newFromArray(messageArr);
+  Blake3Hasher hasher;
+  hasher.hash(reinterpret_cast<const uint8_t *>(MESSAGE_HASH_DOMAIN), sizeof(MESSAGE_HASH_DOMAIN) - 1);
+  hasher.hash(messageBytes.data(), messageBytes.size());
+
+  Hash hash;
+  hasher.result(&hash);
+  return hash;
+}
+
+// Compute the message hash of this message
+Hash Message::hash()
+{
+  return Message::hashRawMessage(this->serialize());
 }
 
 // Serialize method for Message
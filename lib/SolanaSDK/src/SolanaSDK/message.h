@@ -9,6 +9,9 @@
 #include "instruction.h"
 #include "address_lookup_table.h"
 
+// Domain separator prepended to serialized messages before hashing
+constexpr char MESSAGE_HASH_DOMAIN[] = "solana-tx-message-v1";
+
 struct MessageHeader
 {
   uint8_t numRequiredSignatures;
@@ -44,11 +47,11 @@ public:
 
   static Message newWithBlockhash(std::vector<Instruction> instructions, std::optional<PublicKey> payer, Hash blockhash);
 
-  Message newWithNonce(
+  static Message newWithNonce(
       std::vector<Instruction> instructions,
       std::optional<PublicKey> payer,
-      PublicKey &nonceAccountPublicKey,
-      PublicKey &nonceAuthorityPublicKey);
+      const PublicKey &nonceAccountPublicKey,
+      const PublicKey &nonceAuthorityPublicKey);
 
   static Message newWithCompiledInstructions(
       uint8_t numRequiredSignatures,
@@ -88,7 +91,9 @@ public:
 
   bool isUpgradeableLoaderPresent();
 
-  static Hash hashRawMessage(std::vector<uint8_t> messageBytes);
+  static Hash hashRawMessage(const std::vector<uint8_t> &messageBytes);
+
+  Hash hash();
 
   std::vector<uint8_t> serialize();
 
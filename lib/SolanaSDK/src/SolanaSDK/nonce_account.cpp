@@ -0,0 +1,58 @@
+#include <cstdint>
+#include <vector>
+#include <stdexcept>
+#include "nonce_account.h"
+#include "public_key.h"
+#include "hash.h"
+
+static uint32_t readU32(const std::vector<uint8_t> &data, size_t offset)
+{
+  uint32_t value = 0;
+  for (size_t i = 0; i < 4; ++i)
+  {
+    value |= static_cast<uint32_t>(data[offset + i]) << (8 * i);
+  }
+  return value;
+}
+
+static uint64_t readU64(const std::vector<uint8_t> &data, size_t offset)
+{
+  uint64_t value = 0;
+  for (size_t i = 0; i < 8; ++i)
+  {
+    value |= static_cast<uint64_t>(data[offset + i]) << (8 * i);
+  }
+  return value;
+}
+
+// Deserialize the bincode layout of nonce::state::Versions
+NonceAccount NonceAccount::deserialize(const std::vector<uint8_t> &data)
+{
+  if (data.size() < 8)
+  {
+    throw std::invalid_argument("Invalid nonce account length");
+  }
+
+  NonceAccount nonceAccount;
+  nonceAccount.version = readU32(data, 0);
+  if (nonceAccount.version > 1)
+  {
+    throw std::invalid_argument("Unknown nonce account version");
+  }
+
+  uint32_t state = readU32(data, 4);
+  if (state == 0)
+  {
+    return nonceAccount;
+  }
+  if (state != 1 || data.size() < NONCE_ACCOUNT_LEN)
+  {
+    throw std::invalid_argument("Invalid nonce account state");
+  }
+
+  nonceAccount.initialized = true;
+  nonceAccount.authority = PublicKey(std::vector<uint8_t>(data.begin() + 8, data.begin() + 8 + PUBLIC_KEY_LEN));
+  nonceAccount.durableNonce = Hash::deserialize(std::vector<uint8_t>(data.begin() + 40, data.begin() + 40 + HASH_BYTES));
+  nonceAccount.lamportsPerSignature = readU64(data, 72);
+  return nonceAccount;
+}
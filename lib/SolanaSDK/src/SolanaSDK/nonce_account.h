@@ -0,0 +1,35 @@
+#ifndef NONCE_ACCOUNT_H
+#define NONCE_ACCOUNT_H
+
+#include <cstdint>
+#include <vector>
+#include "public_key.h"
+#include "hash.h"
+
+// Size of a nonce account's data in bytes
+constexpr size_t NONCE_ACCOUNT_LEN = 80;
+
+// Decoded state of a durable nonce account
+// reference from solana_program::nonce::state
+class NonceAccount
+{
+public:
+  // 0 for legacy nonces, 1 for current nonces
+  uint32_t version = 0;
+
+  // False until the account has been initialized by the system program
+  bool initialized = false;
+
+  // Address of the account allowed to advance the nonce
+  PublicKey authority;
+
+  // Durable nonce value, used in place of a recent blockhash
+  Hash durableNonce;
+
+  // Fee calculator recorded when the nonce was last advanced
+  uint64_t lamportsPerSignature = 0;
+
+  static NonceAccount deserialize(const std::vector<uint8_t> &data);
+};
+
+#endif // NONCE_ACCOUNT_H
@@ -0,0 +1,915 @@
+#if !defined(ARDUINO)
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cctype>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <mutex>
+#include <condition_variable>
+#include <cerrno>
+#include <climits>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#if defined(POSIX_HTTP_TLS)
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/x509v3.h>
+#endif
+#include "posix_http_transport.h"
+#include "gzip_reader.h"
+
+#if !defined(MSG_NOSIGNAL)
+#define MSG_NOSIGNAL 0
+#endif
+
+// Size of the per-socket read buffer
+constexpr size_t POSIX_HTTP_BUFFER_SIZE = 4096;
+
+#if defined(POSIX_HTTP_TLS)
+// OpenSSL's socket BIO writes with write(), which raises SIGPIPE once the
+// server has gone away. This one sends with MSG_NOSIGNAL like the plain
+// path does and leaves everything else to the stock socket BIO.
+static int tlsSocketWrite(BIO *bio, const char *data, int length)
+{
+  ssize_t written = ::send(static_cast<int>(BIO_get_fd(bio, nullptr)), data, static_cast<size_t>(length), MSG_NOSIGNAL);
+  BIO_clear_retry_flags(bio);
+  if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+  {
+    BIO_set_retry_write(bio);
+  }
+  return static_cast<int>(written);
+}
+
+static BIO_METHOD *tlsSocketMethod()
+{
+  static BIO_METHOD *method = []()
+  {
+    const BIO_METHOD *stock = BIO_s_socket();
+    BIO_METHOD *socketMethod = BIO_meth_new(BIO_TYPE_SOCKET, "socket without SIGPIPE");
+    BIO_meth_set_write(socketMethod, tlsSocketWrite);
+    BIO_meth_set_read(socketMethod, BIO_meth_get_read(stock));
+    BIO_meth_set_ctrl(socketMethod, BIO_meth_get_ctrl(stock));
+    BIO_meth_set_create(socketMethod, BIO_meth_get_create(stock));
+    BIO_meth_set_destroy(socketMethod, BIO_meth_get_destroy(stock));
+    return socketMethod;
+  }();
+  return method;
+}
+
+// Events to wait for before retrying an SSL call that returned result,
+// 0 if it failed for good
+static short tlsWaitEvents(SSL *ssl, int result)
+{
+  switch (SSL_get_error(ssl, result))
+  {
+  case SSL_ERROR_WANT_READ:
+    return POLLIN;
+  case SSL_ERROR_WANT_WRITE:
+    return POLLOUT;
+  default:
+    return 0;
+  }
+}
+#endif
+
+class PosixHttpTransport::BodyReader : public ResponseReader
+{
+private:
+  Socket &socket;
+  bool chunked;
+  // Bytes left in the body (or current chunk), -1 reads until close
+  int64_t remaining;
+  bool done = false;
+  int statusCode;
+  uint32_t retryAfter;
+
+  bool nextChunk()
+  {
+    std::string line;
+    if (!readLine(socket, line))
+    {
+      return false;
+    }
+    size_t size = std::strtoull(line.c_str(), nullptr, 16);
+    if (size == 0)
+    {
+      // Skip the trailer section up to the final empty line
+      while (readLine(socket, line) && !line.empty())
+      {
+      }
+      return false;
+    }
+    remaining = static_cast<int64_t>(size);
+    return true;
+  }
+
+public:
+  BodyReader(Socket &socket, bool chunked, int64_t contentLength, int statusCode, uint32_t retryAfter)
+      : socket(socket), chunked(chunked), remaining(chunked ? 0 : contentLength), statusCode(statusCode), retryAfter(retryAfter)
+  {
+    if (chunked)
+    {
+      done = !nextChunk();
+    }
+    else if (contentLength == 0)
+    {
+      done = true;
+    }
+  }
+
+  int status() const override
+  {
+    return statusCode;
+  }
+
+  uint32_t retryAfterMs() const override
+  {
+    return retryAfter;
+  }
+
+  int read() override
+  {
+    char c;
+    return readBytes(&c, 1) == 1 ? static_cast<uint8_t>(c) : -1;
+  }
+
+  // Copies straight out of the socket buffer, refilling it as needed
+  size_t readBytes(char *buffer, size_t length) override
+  {
+    size_t count = 0;
+    while (count < length && !done)
+    {
+      if (chunked && remaining == 0)
+      {
+        std::string crlf;
+        readLine(socket, crlf);
+        if (!nextChunk())
+        {
+          done = true;
+          break;
+        }
+      }
+      if (socket.start == socket.end)
+      {
+        int c = readByte(socket);
+        if (c < 0)
+        {
+          done = true;
+          break;
+        }
+        // readByte consumed it, step back so it is copied below
+        socket.start--;
+      }
+      size_t available = socket.end - socket.start;
+      size_t take = std::min(available, length - count);
+      if (remaining >= 0)
+      {
+        take = std::min<size_t>(take, static_cast<size_t>(remaining));
+      }
+      std::memcpy(buffer + count, socket.buffer.data() + socket.start, take);
+      socket.start += take;
+      count += take;
+      if (remaining >= 0)
+      {
+        remaining -= take;
+        if (remaining == 0 && !chunked)
+        {
+          done = true;
+        }
+      }
+    }
+    return count;
+  }
+
+  // Consume what the handler left so the socket can be reused. Returns
+  // false if the socket has to be closed instead: the body only ends when
+  // the server closes it, or more than TRANSPORT_DRAIN_LIMIT bytes are left.
+  bool drain()
+  {
+    if (!chunked && (remaining < 0 || remaining > static_cast<int64_t>(TRANSPORT_DRAIN_LIMIT)))
+    {
+      return false;
+    }
+    char scratch[256];
+    for (size_t budget = TRANSPORT_DRAIN_LIMIT; !done && budget > 0;)
+    {
+      size_t count = readBytes(scratch, std::min(sizeof(scratch), budget));
+      if (count == 0)
+      {
+        break;
+      }
+      budget -= count;
+    }
+    return done && (chunked || remaining == 0);
+  }
+};
+
+PosixHttpTransport::PosixHttpTransport(const std::string &url, size_t maxConnections, uint32_t timeoutMs, const char *caCert)
+    : timeoutMs(timeoutMs)
+{
+  parseUrl(url);
+  if (secure)
+  {
+#if defined(POSIX_HTTP_TLS)
+    setupTls(caCert);
+#else
+    (void)caCert;
+    throw std::invalid_argument("PosixHttpTransport needs POSIX_HTTP_TLS for https");
+#endif
+  }
+  maxConnections = std::max<size_t>(maxConnections, 1);
+  for (size_t i = 0; i < maxConnections; ++i)
+  {
+    sockets.emplace_back(new Socket());
+    sockets.back()->buffer.resize(POSIX_HTTP_BUFFER_SIZE);
+    sockets.back()->timeoutMs = timeoutMs;
+  }
+  busy.assign(maxConnections, false);
+}
+
+PosixHttpTransport::~PosixHttpTransport()
+{
+  for (auto &socket : sockets)
+  {
+    close(*socket);
+  }
+#if defined(POSIX_HTTP_TLS)
+  if (session != nullptr)
+  {
+    SSL_SESSION_free(session);
+  }
+  if (tls != nullptr)
+  {
+    SSL_CTX_free(tls);
+  }
+#endif
+}
+
+#if defined(POSIX_HTTP_TLS)
+void PosixHttpTransport::setupTls(const char *caCert)
+{
+  tls = SSL_CTX_new(TLS_client_method());
+  if (tls == nullptr)
+  {
+    throw std::runtime_error("Failed to create TLS context");
+  }
+  SSL_CTX_set_min_proto_version(tls, TLS1_2_VERSION);
+  SSL_CTX_set_verify(tls, SSL_VERIFY_PEER, nullptr);
+  if (caCert != nullptr)
+  {
+    BIO *pem = BIO_new_mem_buf(caCert, -1);
+    X509_STORE *store = SSL_CTX_get_cert_store(tls);
+    size_t added = 0;
+    while (X509 *certificate = PEM_read_bio_X509(pem, nullptr, nullptr, nullptr))
+    {
+      added += X509_STORE_add_cert(store, certificate) == 1 ? 1 : 0;
+      X509_free(certificate);
+    }
+    BIO_free(pem);
+    ERR_clear_error();
+    if (added == 0)
+    {
+      SSL_CTX_free(tls);
+      tls = nullptr;
+      throw std::invalid_argument("caCert holds no PEM certificate");
+    }
+  }
+  else
+  {
+    SSL_CTX_set_default_verify_paths(tls);
+  }
+
+  // Sessions are kept by storeSession rather than OpenSSL's cache, which
+  // clients do not look up
+  SSL_CTX_set_app_data(tls, this);
+  SSL_CTX_set_session_cache_mode(tls, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+  SSL_CTX_sess_set_new_cb(tls, storeSession);
+}
+
+// Called by OpenSSL with each session the server hands out; under TLS 1.3
+// that is a ticket read along with the first response
+int PosixHttpTransport::storeSession(SSL *ssl, SSL_SESSION *newSession)
+{
+  PosixHttpTransport *transport = static_cast<PosixHttpTransport *>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+  std::lock_guard<std::mutex> lock(transport->tlsMutex);
+  if (transport->session != nullptr)
+  {
+    SSL_SESSION_free(transport->session);
+  }
+  transport->session = newSession;
+  // Keep the reference OpenSSL passed in
+  return 1;
+}
+
+bool PosixHttpTransport::handshake(Socket &socket)
+{
+  socket.ssl = SSL_new(tls);
+  if (socket.ssl == nullptr)
+  {
+    return false;
+  }
+  BIO *bio = BIO_new(tlsSocketMethod());
+  BIO_set_fd(bio, socket.fd, BIO_NOCLOSE);
+  SSL_set_bio(socket.ssl, bio, bio);
+
+  // An address is matched against the certificate's IP entries and gets
+  // no SNI; a name is sent as SNI and matched against its DNS entries
+  in6_addr address;
+  if (inet_pton(AF_INET, host.c_str(), &address) == 1 || inet_pton(AF_INET6, host.c_str(), &address) == 1)
+  {
+    X509_VERIFY_PARAM_set1_ip_asc(SSL_get0_param(socket.ssl), host.c_str());
+  }
+  else
+  {
+    SSL_set_tlsext_host_name(socket.ssl, host.c_str());
+    SSL_set1_host(socket.ssl, host.c_str());
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(tlsMutex);
+    if (session != nullptr)
+    {
+      SSL_set_session(socket.ssl, session);
+    }
+  }
+
+  while (true)
+  {
+    int result = SSL_connect(socket.ssl);
+    if (result == 1)
+    {
+      break;
+    }
+    short events = tlsWaitEvents(socket.ssl, result);
+    if (events == 0 || !waitFor(socket, events))
+    {
+      ERR_clear_error();
+      return false;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(tlsMutex);
+  stats.handshakes++;
+  if (SSL_session_reused(socket.ssl) == 1)
+  {
+    stats.resumed++;
+  }
+  return true;
+}
+#endif
+
+void PosixHttpTransport::parseUrl(const std::string &url)
+{
+  secure = url.rfind("https://", 0) == 0;
+  size_t hostStart = url.find("://");
+  hostStart = hostStart == std::string::npos ? 0 : hostStart + 3;
+  size_t pathStart = url.find('/', hostStart);
+  std::string authority = url.substr(hostStart, pathStart == std::string::npos ? std::string::npos : pathStart - hostStart);
+  path = pathStart == std::string::npos ? "/" : url.substr(pathStart);
+
+  size_t colon = authority.find(':');
+  if (colon != std::string::npos)
+  {
+    host = authority.substr(0, colon);
+    port = static_cast<uint16_t>(std::stoi(authority.substr(colon + 1)));
+  }
+  else
+  {
+    host = authority;
+    port = secure ? 443 : 80;
+  }
+}
+
+bool PosixHttpTransport::open(Socket &socket)
+{
+  close(socket);
+
+  addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo *addresses = nullptr;
+  if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0)
+  {
+    return false;
+  }
+
+  for (addrinfo *address = addresses; address != nullptr; address = address->ai_next)
+  {
+    int fd = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (fd < 0)
+    {
+      continue;
+    }
+
+    timeval timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_usec = (timeoutMs % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#if defined(SO_NOSIGPIPE)
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+
+    // Connect without blocking so the wait is bounded like any other
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    socket.fd = fd;
+    bool connected = ::connect(fd, address->ai_addr, address->ai_addrlen) == 0;
+    if (!connected && errno == EINPROGRESS && waitFor(socket, POLLOUT))
+    {
+      int error = 0;
+      socklen_t length = sizeof(error);
+      connected = getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0;
+    }
+    if (connected)
+    {
+      // TLS sockets stay non-blocking: OpenSSL reports what it waits for
+      // and waitFor bounds the wait
+      if (!secure)
+      {
+        fcntl(fd, F_SETFL, flags);
+      }
+      break;
+    }
+    socket.fd = -1;
+    ::close(fd);
+    if (socket.context.stopped())
+    {
+      break;
+    }
+  }
+
+  freeaddrinfo(addresses);
+#if defined(POSIX_HTTP_TLS)
+  if (socket.fd >= 0 && secure && !handshake(socket))
+  {
+    close(socket);
+  }
+#endif
+  return socket.fd >= 0;
+}
+
+void PosixHttpTransport::close(Socket &socket)
+{
+#if defined(POSIX_HTTP_TLS)
+  if (socket.ssl != nullptr)
+  {
+    // Send close_notify without waiting for the reply. OpenSSL marks the
+    // session of a connection freed without it as not resumable.
+    SSL_shutdown(socket.ssl);
+    SSL_free(socket.ssl);
+    socket.ssl = nullptr;
+    ERR_clear_error();
+  }
+#endif
+  if (socket.fd >= 0)
+  {
+    ::close(socket.fd);
+    socket.fd = -1;
+  }
+  socket.start = 0;
+  socket.end = 0;
+}
+
+bool PosixHttpTransport::waitFor(Socket &socket, short events)
+{
+  Deadline idle = Deadline::after(socket.timeoutMs);
+  while (true)
+  {
+    if (socket.context.stopped())
+    {
+      return false;
+    }
+    Deadline until = Deadline::earliest(idle, socket.context.deadline);
+    if (until.expired())
+    {
+      return false;
+    }
+    // Wake up regularly to look at the cancellation token
+    uint32_t wait = until.remainingMs(socket.context.token ? REQUEST_CONTEXT_POLL_MS : INT_MAX);
+    pollfd entry;
+    entry.fd = socket.fd;
+    entry.events = events;
+    entry.revents = 0;
+    int ready = ::poll(&entry, 1, static_cast<int>(wait));
+    if (ready > 0)
+    {
+      return true;
+    }
+    if (ready < 0 && errno != EINTR)
+    {
+      return false;
+    }
+  }
+}
+
+int PosixHttpTransport::readByte(Socket &socket)
+{
+  if (socket.start == socket.end)
+  {
+    size_t received = receive(socket, socket.buffer.data(), socket.buffer.size());
+    if (received == 0)
+    {
+      return -1;
+    }
+    socket.start = 0;
+    socket.end = received;
+  }
+  return static_cast<uint8_t>(socket.buffer[socket.start++]);
+}
+
+size_t PosixHttpTransport::receive(Socket &socket, char *buffer, size_t length)
+{
+  if (socket.fd < 0)
+  {
+    return 0;
+  }
+#if defined(POSIX_HTTP_TLS)
+  if (socket.ssl != nullptr)
+  {
+    while (true)
+    {
+      int received = SSL_read(socket.ssl, buffer, static_cast<int>(std::min<size_t>(length, INT_MAX)));
+      if (received > 0)
+      {
+        return static_cast<size_t>(received);
+      }
+      short events = tlsWaitEvents(socket.ssl, received);
+      if (events == 0 || !waitFor(socket, events))
+      {
+        ERR_clear_error();
+        return 0;
+      }
+    }
+  }
+#endif
+  if (!waitFor(socket, POLLIN))
+  {
+    return 0;
+  }
+  ssize_t received = ::recv(socket.fd, buffer, length, 0);
+  return received > 0 ? static_cast<size_t>(received) : 0;
+}
+
+bool PosixHttpTransport::writeRequest(Socket &socket, const std::string &headers, ByteSpan body)
+{
+#if defined(POSIX_HTTP_TLS)
+  if (socket.ssl != nullptr)
+  {
+    // OpenSSL writes a record per call, one for the headers and one for
+    // the body
+    const char *parts[2] = {headers.data(), reinterpret_cast<const char *>(body.data)};
+    size_t lengths[2] = {headers.size(), body.size};
+    for (size_t i = 0; i < 2; ++i)
+    {
+      size_t sent = 0;
+      while (sent < lengths[i])
+      {
+        int written = SSL_write(socket.ssl, parts[i] + sent, static_cast<int>(std::min<size_t>(lengths[i] - sent, INT_MAX)));
+        if (written > 0)
+        {
+          sent += static_cast<size_t>(written);
+          continue;
+        }
+        short events = tlsWaitEvents(socket.ssl, written);
+        if (events == 0 || !waitFor(socket, events))
+        {
+          ERR_clear_error();
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+#endif
+  // Headers and body go out together without being copied into one buffer
+  iovec parts[2];
+  parts[0].iov_base = const_cast<char *>(headers.data());
+  parts[0].iov_len = headers.size();
+  parts[1].iov_base = const_cast<uint8_t *>(body.data);
+  parts[1].iov_len = body.size;
+  size_t total = headers.size() + body.size;
+  size_t sent = 0;
+  while (sent < total)
+  {
+    msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    iovec pending[2];
+    size_t count = 0;
+    size_t skip = sent;
+    for (const iovec &part : parts)
+    {
+      if (skip >= part.iov_len)
+      {
+        skip -= part.iov_len;
+        continue;
+      }
+      pending[count].iov_base = static_cast<char *>(part.iov_base) + skip;
+      pending[count].iov_len = part.iov_len - skip;
+      skip = 0;
+      count++;
+    }
+    message.msg_iov = pending;
+    message.msg_iovlen = count;
+    if (!waitFor(socket, POLLOUT))
+    {
+      return false;
+    }
+    ssize_t written = ::sendmsg(socket.fd, &message, MSG_NOSIGNAL);
+    if (written <= 0)
+    {
+      return false;
+    }
+    sent += static_cast<size_t>(written);
+  }
+  return true;
+}
+
+bool PosixHttpTransport::readLine(Socket &socket, std::string &line)
+{
+  line.clear();
+  int c;
+  while ((c = readByte(socket)) >= 0)
+  {
+    if (c == '\n')
+    {
+      if (!line.empty() && line.back() == '\r')
+      {
+        line.pop_back();
+      }
+      return true;
+    }
+    line.push_back(static_cast<char>(c));
+  }
+  return false;
+}
+
+// Case-insensitive match of a header name at the start of line
+static bool headerIs(const std::string &line, const char *name)
+{
+  size_t length = std::strlen(name);
+  if (line.size() <= length || line[length] != ':')
+  {
+    return false;
+  }
+  for (size_t i = 0; i < length; ++i)
+  {
+    if (std::tolower(static_cast<unsigned char>(line[i])) != std::tolower(static_cast<unsigned char>(name[i])))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static std::string headerValue(const std::string &line)
+{
+  size_t start = line.find(':') + 1;
+  while (start < line.size() && line[start] == ' ')
+  {
+    start++;
+  }
+  std::string value = line.substr(start);
+  std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c)
+                 { return static_cast<char>(std::tolower(c)); });
+  return value;
+}
+
+bool PosixHttpTransport::postOnce(Socket &socket, ByteSpan request, const ResponseHandler &handler, bool &answered, bool &parsed)
+{
+  answered = false;
+  if (socket.fd < 0 && !open(socket))
+  {
+    return false;
+  }
+
+  std::string headers;
+  headers.reserve(160 + host.size() + path.size());
+  headers.append("POST ").append(path).append(" HTTP/1.1\r\n");
+  headers.append("Host: ").append(host).append("\r\n");
+  headers.append("Content-Type: application/json\r\n");
+  headers.append("Accept-Encoding: gzip\r\n");
+  headers.append("Content-Length: ").append(std::to_string(request.size)).append("\r\n");
+  headers.append("Connection: keep-alive\r\n\r\n");
+
+  if (!writeRequest(socket, headers, request))
+  {
+    close(socket);
+    return false;
+  }
+
+  // Status line, skipping any interim 1xx responses
+  std::string line;
+  int status = 0;
+  do
+  {
+    if (!readLine(socket, line) || line.rfind("HTTP/", 0) != 0)
+    {
+      close(socket);
+      return false;
+    }
+    size_t space = line.find(' ');
+    status = space == std::string::npos ? 0 : std::atoi(line.c_str() + space + 1);
+    if (status >= 100 && status < 200)
+    {
+      while (readLine(socket, line) && !line.empty())
+      {
+      }
+    }
+  } while (status >= 100 && status < 200);
+
+  int64_t contentLength = -1;
+  bool chunked = false;
+  bool keepAlive = true;
+  uint32_t retryAfter = 0;
+  bool gzip = false;
+  while (true)
+  {
+    if (!readLine(socket, line))
+    {
+      close(socket);
+      return false;
+    }
+    if (line.empty())
+    {
+      break;
+    }
+    if (headerIs(line, "Content-Length"))
+    {
+      contentLength = std::strtoll(headerValue(line).c_str(), nullptr, 10);
+    }
+    else if (headerIs(line, "Transfer-Encoding"))
+    {
+      chunked = headerValue(line).find("chunked") != std::string::npos;
+    }
+    else if (headerIs(line, "Connection"))
+    {
+      keepAlive = headerValue(line).find("close") == std::string::npos;
+    }
+    else if (headerIs(line, "Content-Encoding"))
+    {
+      gzip = headerValue(line).find("gzip") != std::string::npos;
+    }
+    else if (headerIs(line, "Retry-After"))
+    {
+      retryAfter = parseRetryAfter(headerValue(line));
+    }
+  }
+
+  answered = true;
+  BodyReader body(socket, chunked, contentLength, status, retryAfter);
+  if (gzip)
+  {
+    GzipResponseReader inflated(body, socket.window);
+    parsed = handler(inflated);
+    parsed = inflated.finish() && parsed;
+  }
+  else
+  {
+    parsed = handler(body);
+  }
+  // A call that gave up part way leaves the socket mid-response
+  if (socket.context.stopped() || !body.drain() || !keepAlive)
+  {
+    close(socket);
+  }
+  return true;
+}
+
+size_t PosixHttpTransport::acquire(const RequestContext &context)
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true)
+  {
+    if (context.stopped())
+    {
+      return sockets.size();
+    }
+    // Prefer a socket that is already open
+    size_t idle = sockets.size();
+    for (size_t i = 0; i < sockets.size(); ++i)
+    {
+      if (!busy[i])
+      {
+        if (sockets[i]->fd >= 0)
+        {
+          idle = i;
+          break;
+        }
+        if (idle == sockets.size())
+        {
+          idle = i;
+        }
+      }
+    }
+    if (idle < sockets.size())
+    {
+      busy[idle] = true;
+      return idle;
+    }
+    if (context.deadline.bounded() || context.token)
+    {
+      released.wait_for(lock, std::chrono::milliseconds(context.deadline.remainingMs(REQUEST_CONTEXT_POLL_MS)));
+    }
+    else
+    {
+      released.wait(lock);
+    }
+  }
+}
+
+void PosixHttpTransport::release(size_t index)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    busy[index] = false;
+  }
+  released.notify_one();
+}
+
+bool PosixHttpTransport::post(ByteSpan request, const ResponseHandler &handler)
+{
+  return post(request, handler, RequestContext());
+}
+
+bool PosixHttpTransport::post(ByteSpan request, const ResponseHandler &handler, const RequestContext &context)
+{
+  size_t index = acquire(context);
+  if (index == sockets.size())
+  {
+    return false;
+  }
+  Socket &socket = *sockets[index];
+  socket.context = context;
+  bool reused = socket.fd >= 0;
+  bool answered = false;
+  bool parsed = false;
+
+  bool ok = postOnce(socket, request, handler, answered, parsed);
+  if (!ok && !answered && reused && !context.stopped())
+  {
+    // The server may have closed an idle keep-alive socket, retry on a new one
+    close(socket);
+    ok = postOnce(socket, request, handler, answered, parsed);
+  }
+
+  socket.context = RequestContext();
+  release(index);
+  return ok && parsed && !context.stopped();
+}
+
+size_t PosixHttpTransport::warmup()
+{
+  // Hold every slot until the loop is done, otherwise acquire hands back
+  // the socket just opened and only one connection gets made
+  size_t ready = 0;
+  std::vector<size_t> held;
+  for (size_t i = 0; i < sockets.size(); ++i)
+  {
+    size_t index = acquire(RequestContext());
+    held.push_back(index);
+    if (sockets[index]->fd >= 0 || open(*sockets[index]))
+    {
+      ready++;
+    }
+  }
+  for (size_t index : held)
+  {
+    release(index);
+  }
+  return ready;
+}
+
+size_t PosixHttpTransport::maxConcurrency() const
+{
+  return sockets.size();
+}
+
+PosixHttpTransport::TlsStats PosixHttpTransport::tlsStats()
+{
+#if defined(POSIX_HTTP_TLS)
+  std::lock_guard<std::mutex> lock(tlsMutex);
+  return stats;
+#else
+  return TlsStats();
+#endif
+}
+
+#endif // !ARDUINO
@@ -0,0 +1,125 @@
+#ifndef POSIX_HTTP_TRANSPORT_H
+#define POSIX_HTTP_TRANSPORT_H
+
+#if !defined(ARDUINO)
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#if defined(POSIX_HTTP_TLS)
+#include <openssl/ssl.h>
+#endif
+#include "transport.h"
+
+// Socket send/receive timeout used when none is given
+constexpr uint32_t POSIX_HTTP_DEFAULT_TIMEOUT_MS = 30000;
+
+// HTTP/1.1 transport over plain POSIX sockets for Linux hosts. Keeps up to
+// maxConnections keep-alive sockets open to the endpoint; the request body
+// is written to the socket with the headers in a single writev() call.
+// timeoutMs bounds connect and each wait for the socket; a call's context
+// can bound the whole exchange. Responses may come back gzip-compressed
+// and are inflated as they are read.
+//
+// https:// needs a build with POSIX_HTTP_TLS and OpenSSL. The server is
+// verified against caCert (PEM) or the system store, and sockets opened
+// after the first handshake resume its TLS session.
+class PosixHttpTransport : public Transport
+{
+public:
+  struct TlsStats
+  {
+    size_t handshakes = 0;
+    // Handshakes that resumed a cached session
+    size_t resumed = 0;
+  };
+
+private:
+  struct Socket
+  {
+    int fd = -1;
+#if defined(POSIX_HTTP_TLS)
+    SSL *ssl = nullptr;
+#endif
+    // Bytes read from the socket but not consumed yet
+    std::vector<char> buffer;
+    size_t start = 0;
+    size_t end = 0;
+    // Longest wait for the socket to become ready
+    uint32_t timeoutMs = 0;
+    // Context of the call using the socket
+    RequestContext context;
+    // History for inflating gzip bodies, allocated on the first one
+    std::vector<uint8_t> window;
+  };
+
+  std::string host;
+  uint16_t port;
+  std::string path;
+  uint32_t timeoutMs;
+  bool secure = false;
+#if defined(POSIX_HTTP_TLS)
+  SSL_CTX *tls = nullptr;
+  // Newest session the server handed out, offered on every new socket
+  SSL_SESSION *session = nullptr;
+  std::mutex tlsMutex;
+  TlsStats stats;
+
+  void setupTls(const char *caCert);
+  bool handshake(Socket &socket);
+  static int storeSession(SSL *ssl, SSL_SESSION *session);
+#endif
+  std::vector<std::unique_ptr<Socket>> sockets;
+  std::vector<bool> busy;
+  std::mutex mutex;
+  std::condition_variable released;
+
+  // Content-Length or chunked body read straight from a socket
+  class BodyReader;
+
+  void parseUrl(const std::string &url);
+  // Wait until the socket is ready for events, false on timeout or once
+  // the call's context stops
+  static bool waitFor(Socket &socket, short events);
+  // One byte from the socket, refilling its buffer; -1 on EOF or timeout
+  static int readByte(Socket &socket);
+  // Up to length bytes once the socket is readable, 0 on EOF or timeout
+  static size_t receive(Socket &socket, char *buffer, size_t length);
+  // Request headers then body, false on error or timeout
+  static bool writeRequest(Socket &socket, const std::string &headers, ByteSpan body);
+  // A header line without its CRLF, false on EOF
+  static bool readLine(Socket &socket, std::string &line);
+  bool open(Socket &socket);
+  void close(Socket &socket);
+  bool postOnce(Socket &socket, ByteSpan request, const ResponseHandler &handler, bool &answered, bool &parsed);
+  // Index of a free socket, or sockets.size() if the context stopped first
+  size_t acquire(const RequestContext &context);
+  void release(size_t index);
+
+public:
+  PosixHttpTransport(const std::string &url, size_t maxConnections = 1, uint32_t timeoutMs = POSIX_HTTP_DEFAULT_TIMEOUT_MS, const char *caCert = nullptr);
+  ~PosixHttpTransport();
+
+  PosixHttpTransport(const PosixHttpTransport &) = delete;
+  PosixHttpTransport &operator=(const PosixHttpTransport &) = delete;
+
+  bool post(ByteSpan request, const ResponseHandler &handler) override;
+
+  // Bounds connect, write and every read by the context
+  bool post(ByteSpan request, const ResponseHandler &handler, const RequestContext &context) override;
+
+  size_t warmup() override;
+
+  size_t maxConcurrency() const override;
+
+  // TLS handshakes made so far, all zero for http://
+  TlsStats tlsStats();
+};
+
+#endif // !ARDUINO
+
+#endif // POSIX_HTTP_TRANSPORT_H
@@ -0,0 +1,102 @@
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <mutex>
+#include "priority_fee_estimator.h"
+#include "programs/compute_budget.h"
+
+PriorityFeeEstimator::PriorityFeeEstimator(Connection connection, uint32_t percentile, uint32_t ttlMs)
+    : connection(connection), percentile(std::min<uint32_t>(percentile, 100)), ttlMs(ttlMs) {}
+
+void PriorityFeeEstimator::setBounds(uint64_t minMicroLamports, uint64_t maxMicroLamports)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  this->minMicroLamports = minMicroLamports;
+  this->maxMicroLamports = std::max(minMicroLamports, maxMicroLamports);
+  cache.clear();
+}
+
+// Slots where nothing competing paid a fee count as zero, so a quiet
+// account set gets a low estimate
+uint64_t PriorityFeeEstimator::fromFees(std::vector<PrioritizationFee> fees) const
+{
+  uint64_t microLamports = 0;
+  if (!fees.empty())
+  {
+    size_t index = (fees.size() - 1) * percentile / 100;
+    std::nth_element(fees.begin(), fees.begin() + index, fees.end(), [](const PrioritizationFee &a, const PrioritizationFee &b)
+                     { return a.prioritizationFee < b.prioritizationFee; });
+    microLamports = fees[index].prioritizationFee;
+  }
+  return std::min(std::max(microLamports, minMicroLamports), maxMicroLamports);
+}
+
+uint64_t PriorityFeeEstimator::estimate(std::vector<PublicKey> accounts)
+{
+  std::sort(accounts.begin(), accounts.end());
+  accounts.erase(std::unique(accounts.begin(), accounts.end()), accounts.end());
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = cache.find(accounts);
+    if (found != cache.end() && Clock::now() - found->second.fetchedAt < std::chrono::milliseconds(ttlMs))
+    {
+      return found->second.microLamports;
+    }
+  }
+
+  // Concurrent misses for the same set may each fetch; the last one wins
+  uint64_t microLamports = fromFees(connection.getRecentPrioritizationFees(accounts));
+
+  std::lock_guard<std::mutex> lock(mutex);
+  Clock::time_point now = Clock::now();
+  if (cache.size() >= PRIORITY_FEE_CACHE_CAPACITY && cache.find(accounts) == cache.end())
+  {
+    // Drop the stalest estimate
+    auto oldest = std::min_element(cache.begin(), cache.end(), [](const auto &a, const auto &b)
+                                   { return a.second.fetchedAt < b.second.fetchedAt; });
+    cache.erase(oldest);
+  }
+  cache[accounts] = Entry{microLamports, now};
+  return microLamports;
+}
+
+uint64_t PriorityFeeEstimator::estimate(Message &message)
+{
+  return estimate(writableAccounts(message));
+}
+
+std::vector<PublicKey> PriorityFeeEstimator::writableAccounts(Message &message)
+{
+  std::vector<PublicKey> accounts;
+  for (size_t i = 0; i < message.accountKeys.size(); ++i)
+  {
+    if (message.isWritable(i))
+    {
+      accounts.push_back(message.accountKeys[i]);
+    }
+  }
+  return accounts;
+}
+
+std::vector<Instruction> PriorityFeeEstimator::withPriorityFee(const std::vector<Instruction> &instructions, std::optional<PublicKey> payer, uint32_t computeUnitLimit)
+{
+  // The compute budget instructions add no writable accounts, so the
+  // message without them locks the same set
+  Message message(instructions, payer);
+  std::vector<Instruction> result;
+  result.reserve(instructions.size() + 2);
+  result.push_back(ComputeBudgetProgram::setComputeUnitLimit(std::min(computeUnitLimit, MAX_COMPUTE_UNIT_LIMIT)));
+  result.push_back(ComputeBudgetProgram::setComputeUnitPrice(estimate(message)));
+  result.insert(result.end(), instructions.begin(), instructions.end());
+  return result;
+}
+
+void PriorityFeeEstimator::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  cache.clear();
+}
@@ -0,0 +1,74 @@
+#ifndef PRIORITY_FEE_ESTIMATOR_H
+#define PRIORITY_FEE_ESTIMATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+#include <chrono>
+#include <optional>
+#include <mutex>
+#include "connection.h"
+#include "message.h"
+#include "instruction.h"
+#include "public_key.h"
+
+// Share of recent slots whose fee the estimate matches or beats
+constexpr uint32_t PRIORITY_FEE_DEFAULT_PERCENTILE = 75;
+
+// How long an estimate is reused, about five slots
+constexpr uint32_t PRIORITY_FEE_DEFAULT_TTL_MS = 2000;
+
+// Account sets whose estimate is kept
+constexpr size_t PRIORITY_FEE_CACHE_CAPACITY = 32;
+
+// Compute unit price estimates from getRecentPrioritizationFees for the
+// accounts a transaction write-locks, since those are what it competes
+// for. Estimates are cached per account set for ttlMs.
+class PriorityFeeEstimator
+{
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Entry
+  {
+    uint64_t microLamports;
+    Clock::time_point fetchedAt;
+  };
+
+  Connection connection;
+  uint32_t percentile;
+  uint32_t ttlMs;
+  uint64_t minMicroLamports = 0;
+  uint64_t maxMicroLamports = UINT64_MAX;
+  // Keyed by the sorted account set
+  std::map<std::vector<PublicKey>, Entry> cache;
+  std::mutex mutex;
+
+  uint64_t fromFees(std::vector<PrioritizationFee> fees) const;
+
+public:
+  PriorityFeeEstimator(Connection connection, uint32_t percentile = PRIORITY_FEE_DEFAULT_PERCENTILE, uint32_t ttlMs = PRIORITY_FEE_DEFAULT_TTL_MS);
+
+  PriorityFeeEstimator(const PriorityFeeEstimator &) = delete;
+  PriorityFeeEstimator &operator=(const PriorityFeeEstimator &) = delete;
+
+  // Clamp every estimate, e.g. to cap what one transaction may spend
+  void setBounds(uint64_t minMicroLamports, uint64_t maxMicroLamports);
+
+  // Compute unit price in micro-lamports for a transaction write-locking
+  // accounts
+  uint64_t estimate(std::vector<PublicKey> accounts);
+  uint64_t estimate(Message &message);
+
+  // Accounts the message write-locks, in account key order
+  static std::vector<PublicKey> writableAccounts(Message &message);
+
+  // instructions with SetComputeUnitLimit(computeUnitLimit) and
+  // SetComputeUnitPrice(estimate) in front
+  std::vector<Instruction> withPriorityFee(const std::vector<Instruction> &instructions, std::optional<PublicKey> payer, uint32_t computeUnitLimit);
+
+  void clear();
+};
+
+#endif // PRIORITY_FEE_ESTIMATOR_H
@@ -0,0 +1,441 @@
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <optional>
+#include "program_accounts.h"
+#include "base64.h"
+
+// Nesting allowed while skipping values the parser does not know
+constexpr int PROGRAM_ACCOUNTS_MAX_DEPTH = 32;
+
+ProgramAccountsParser::ProgramAccountsParser(ResponseReader &reader) : reader(reader) {}
+
+int ProgramAccountsParser::peek()
+{
+  if (bufferPosition == bufferLength)
+  {
+    bufferPosition = 0;
+    bufferLength = reader.readBytes(buffer, sizeof(buffer));
+    if (bufferLength == 0)
+    {
+      return -1;
+    }
+  }
+  return static_cast<uint8_t>(buffer[bufferPosition]);
+}
+
+int ProgramAccountsParser::next()
+{
+  int c = peek();
+  if (c >= 0)
+  {
+    bufferPosition++;
+  }
+  return c;
+}
+
+void ProgramAccountsParser::skipWhitespace()
+{
+  int c = peek();
+  while (c == ' ' || c == '\n' || c == '\r' || c == '\t')
+  {
+    next();
+    c = peek();
+  }
+}
+
+bool ProgramAccountsParser::expect(char c)
+{
+  skipWhitespace();
+  return next() == c;
+}
+
+// Strings are kept up to PROGRAM_ACCOUNTS_MAX_STRING characters; escapes
+// are copied through without decoding since the fields read here never
+// contain any
+bool ProgramAccountsParser::readString(std::string &out)
+{
+  out.clear();
+  if (!expect('"'))
+  {
+    return false;
+  }
+  while (true)
+  {
+    int c = next();
+    if (c < 0)
+    {
+      return false;
+    }
+    if (c == '"')
+    {
+      return true;
+    }
+    if (c == '\\')
+    {
+      c = next();
+      if (c < 0)
+      {
+        return false;
+      }
+    }
+    if (out.size() < PROGRAM_ACCOUNTS_MAX_STRING)
+    {
+      out.push_back(static_cast<char>(c));
+    }
+  }
+}
+
+// Decode a base64 string as it is read, without holding the text
+bool ProgramAccountsParser::readBase64(std::vector<uint8_t> &out)
+{
+  out.clear();
+  if (!expect('"'))
+  {
+    return false;
+  }
+  uint32_t buffer = 0;
+  int bits = 0;
+  while (true)
+  {
+    int c = next();
+    if (c < 0)
+    {
+      return false;
+    }
+    if (c == '"')
+    {
+      return true;
+    }
+    int value = Base64::decodeChar(static_cast<char>(c));
+    if (value < 0)
+    {
+      // Padding
+      continue;
+    }
+    buffer = (buffer << 6) | static_cast<uint32_t>(value);
+    bits += 6;
+    if (bits >= 8)
+    {
+      bits -= 8;
+      out.push_back(static_cast<uint8_t>((buffer >> bits) & 0xFF));
+    }
+  }
+}
+
+// Unsigned integers only. A fraction, exponent or value past u64::MAX
+// cannot be held without losing it, so it fails the parse and is recorded
+// in invalid.
+bool ProgramAccountsParser::readNumber(uint64_t &out)
+{
+  skipWhitespace();
+  out = 0;
+  bool digits = false;
+  while (peek() >= '0' && peek() <= '9')
+  {
+    uint64_t digit = static_cast<uint64_t>(next() - '0');
+    if (out > (UINT64_MAX - digit) / 10)
+    {
+      invalid = "Number out of range";
+      return false;
+    }
+    out = out * 10 + digit;
+    digits = true;
+  }
+  if (digits && (peek() == '.' || peek() == 'e' || peek() == 'E'))
+  {
+    invalid = "Number is not an integer";
+    return false;
+  }
+  return digits;
+}
+
+bool ProgramAccountsParser::readBoolean(bool &out)
+{
+  skipWhitespace();
+  const char *literal = peek() == 't' ? "true" : "false";
+  out = literal[0] == 't';
+  for (const char *c = literal; *c != '\0'; ++c)
+  {
+    if (next() != *c)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ProgramAccountsParser::skipValue()
+{
+  skipWhitespace();
+  int depth = 0;
+  do
+  {
+    int c = peek();
+    if (c < 0)
+    {
+      return false;
+    }
+    if (c == '"')
+    {
+      std::string ignored;
+      if (!readString(ignored))
+      {
+        return false;
+      }
+    }
+    else
+    {
+      next();
+      if (c == '{' || c == '[')
+      {
+        if (++depth > PROGRAM_ACCOUNTS_MAX_DEPTH)
+        {
+          return false;
+        }
+      }
+      else if (c == '}' || c == ']')
+      {
+        depth--;
+      }
+      else if (depth == 0)
+      {
+        // Number or literal, runs until a delimiter
+        while (peek() >= 0 && peek() != ',' && peek() != '}' && peek() != ']')
+        {
+          next();
+        }
+      }
+    }
+    skipWhitespace();
+  } while (depth > 0);
+  return true;
+}
+
+bool ProgramAccountsParser::readPublicKey(PublicKey &out)
+{
+  if (!readString(text))
+  {
+    return false;
+  }
+  std::optional<PublicKey> key = PublicKey::fromString(text);
+  if (!key)
+  {
+    return false;
+  }
+  out = *key;
+  return true;
+}
+
+// Account data is returned as [data, encoding]
+bool ProgramAccountsParser::readAccountData()
+{
+  if (!expect('[') || !readBase64(data))
+  {
+    return false;
+  }
+  skipWhitespace();
+  while (peek() == ',')
+  {
+    next();
+    if (!skipValue())
+    {
+      return false;
+    }
+  }
+  return expect(']');
+}
+
+bool ProgramAccountsParser::readAccount(ProgramAccount &account)
+{
+  if (!expect('{'))
+  {
+    return false;
+  }
+  skipWhitespace();
+  if (peek() == '}')
+  {
+    next();
+    return true;
+  }
+  do
+  {
+    std::string key;
+    if (!readString(key) || !expect(':'))
+    {
+      return false;
+    }
+    bool ok;
+    if (key == "data")
+    {
+      ok = readAccountData();
+    }
+    else if (key == "lamports")
+    {
+      ok = readNumber(account.lamports);
+    }
+    else if (key == "owner")
+    {
+      ok = readPublicKey(account.owner);
+    }
+    else if (key == "executable")
+    {
+      ok = readBoolean(account.executable);
+    }
+    else if (key == "rentEpoch")
+    {
+      ok = readNumber(account.rentEpoch);
+    }
+    else
+    {
+      ok = skipValue();
+    }
+    if (!ok)
+    {
+      return false;
+    }
+    skipWhitespace();
+  } while (peek() == ',' && next() == ',');
+  return expect('}');
+}
+
+bool ProgramAccountsParser::readKeyedAccount(ProgramAccount &account)
+{
+  if (!expect('{'))
+  {
+    return false;
+  }
+  do
+  {
+    std::string key;
+    if (!readString(key) || !expect(':'))
+    {
+      return false;
+    }
+    bool ok;
+    if (key == "pubkey")
+    {
+      ok = readPublicKey(account.pubkey);
+    }
+    else if (key == "account")
+    {
+      ok = readAccount(account);
+    }
+    else
+    {
+      ok = skipValue();
+    }
+    if (!ok)
+    {
+      return false;
+    }
+    skipWhitespace();
+  } while (peek() == ',' && next() == ',');
+  return expect('}');
+}
+
+bool ProgramAccountsParser::readResult(const ProgramAccountHandler &handler)
+{
+  if (!expect('['))
+  {
+    return false;
+  }
+  skipWhitespace();
+  if (peek() == ']')
+  {
+    next();
+    return true;
+  }
+  do
+  {
+    ProgramAccount account{};
+    data.clear();
+    if (!readKeyedAccount(account))
+    {
+      return false;
+    }
+    account.data = ByteSpan(data);
+    count++;
+    if (!handler(account))
+    {
+      // The transport drains the rest of the body
+      stopped = true;
+      return true;
+    }
+    skipWhitespace();
+  } while (peek() == ',' && next() == ',');
+  return expect(']');
+}
+
+bool ProgramAccountsParser::readError()
+{
+  if (!expect('{'))
+  {
+    return false;
+  }
+  error = "RPC error";
+  do
+  {
+    std::string key;
+    if (!readString(key) || !expect(':'))
+    {
+      return false;
+    }
+    bool ok;
+    if (key == "message")
+    {
+      ok = readString(text);
+      error = text;
+    }
+    else
+    {
+      ok = skipValue();
+    }
+    if (!ok)
+    {
+      return false;
+    }
+    skipWhitespace();
+  } while (peek() == ',' && next() == ',');
+  return expect('}');
+}
+
+bool ProgramAccountsParser::parse(const ProgramAccountHandler &handler)
+{
+  if (!expect('{'))
+  {
+    return false;
+  }
+  do
+  {
+    std::string key;
+    if (!readString(key) || !expect(':'))
+    {
+      return false;
+    }
+    bool ok;
+    if (key == "result")
+    {
+      ok = readResult(handler);
+      if (stopped)
+      {
+        return ok;
+      }
+    }
+    else if (key == "error")
+    {
+      ok = readError();
+    }
+    else
+    {
+      ok = skipValue();
+    }
+    if (!ok)
+    {
+      return false;
+    }
+    skipWhitespace();
+  } while (peek() == ',' && next() == ',');
+  return expect('}');
+}
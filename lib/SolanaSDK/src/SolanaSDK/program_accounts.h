@@ -0,0 +1,99 @@
+#ifndef PROGRAM_ACCOUNTS_H
+#define PROGRAM_ACCOUNTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <optional>
+#include <functional>
+#include "byte_span.h"
+#include "public_key.h"
+#include "transport.h"
+#include "connection.h"
+
+// Longest string kept from the response, base58 addresses and error messages
+constexpr size_t PROGRAM_ACCOUNTS_MAX_STRING = 256;
+
+// Body bytes pulled from the reader at a time
+constexpr size_t PROGRAM_ACCOUNTS_READ_BUFFER = 256;
+
+// Matches accounts whose data holds bytes at offset
+struct MemcmpFilter
+{
+  size_t offset;
+  std::vector<uint8_t> bytes;
+};
+
+struct ProgramAccountsConfig
+{
+  // Every filter must match, they are applied by the node
+  std::vector<MemcmpFilter> memcmp;
+  std::optional<uint64_t> dataSize;
+  // Return only this range of each account's data
+  std::optional<DataSlice> dataSlice;
+};
+
+// One account of a getProgramAccounts response. data points into a buffer
+// that is reused for the next account, copy it to keep it.
+struct ProgramAccount
+{
+  PublicKey pubkey;
+  uint64_t lamports;
+  PublicKey owner;
+  ByteSpan data;
+  bool executable;
+  uint64_t rentEpoch;
+};
+
+// Return false to stop reading the response
+using ProgramAccountHandler = std::function<bool(const ProgramAccount &)>;
+
+// Pull parser for a getProgramAccounts response. Accounts are decoded
+// straight from the body one at a time, so memory use does not depend on
+// how many accounts the node returns.
+class ProgramAccountsParser
+{
+private:
+  ResponseReader &reader;
+  char buffer[PROGRAM_ACCOUNTS_READ_BUFFER];
+  size_t bufferPosition = 0;
+  size_t bufferLength = 0;
+  // Reused across accounts
+  std::string text;
+  std::vector<uint8_t> data;
+
+  int peek();
+  int next();
+  void skipWhitespace();
+  bool expect(char c);
+  bool readString(std::string &out);
+  bool readBase64(std::vector<uint8_t> &out);
+  bool readNumber(uint64_t &out);
+  bool readBoolean(bool &out);
+  bool skipValue();
+  bool readPublicKey(PublicKey &out);
+  bool readAccountData();
+  bool readAccount(ProgramAccount &account);
+  bool readKeyedAccount(ProgramAccount &account);
+  bool readResult(const ProgramAccountHandler &handler);
+  bool readError();
+
+public:
+  // Accounts passed to the handler
+  size_t count = 0;
+  // Set when the handler asked to stop
+  bool stopped = false;
+  // Message of an RPC error response
+  std::optional<std::string> error;
+  // Why a well formed response could not be read, such as a number that
+  // is not an integer or does not fit in 64 bits
+  std::optional<std::string> invalid;
+
+  ProgramAccountsParser(ResponseReader &reader);
+
+  // Parse the whole response. Returns false if it is malformed.
+  bool parse(const ProgramAccountHandler &handler);
+};
+
+#endif // PROGRAM_ACCOUNTS_H
@@ -0,0 +1,59 @@
+#ifndef COMPUTE_BUDGET_H
+#define COMPUTE_BUDGET_H
+
+#include <cstdint>
+#include <array>
+#include <vector>
+#include "../public_key.h"
+#include "../instruction.h"
+#include "../account_meta.h"
+
+// Most compute units a transaction may request
+constexpr uint32_t MAX_COMPUTE_UNIT_LIMIT = 1400000;
+
+// Instruction discriminants understood by the compute budget program
+enum class ComputeBudgetInstruction : uint8_t
+{
+  RequestHeapFrame = 1,
+  SetComputeUnitLimit = 2,
+  SetComputeUnitPrice = 3,
+  SetLoadedAccountsDataSizeLimit = 4,
+};
+
+class ComputeBudgetProgram
+{
+public:
+  // ComputeBudget111111111111111111111111111111
+  static PublicKey id()
+  {
+    static const std::array<uint8_t, PUBLIC_KEY_LEN> bytes = {
+        0x03, 0x06, 0x46, 0x6f, 0xe5, 0x21, 0x17, 0x32, 0xff, 0xec, 0xad, 0xba, 0x72, 0xc3, 0x9b, 0xe7,
+        0xbc, 0x8c, 0xe5, 0xbb, 0xc5, 0xf7, 0x12, 0x6b, 0x2c, 0x43, 0x9b, 0x3a, 0x40, 0x00, 0x00, 0x00};
+    return PublicKey(bytes);
+  }
+
+  // Cap the compute units the transaction may use; the priority fee is
+  // charged on this limit, not on the units actually used
+  static Instruction setComputeUnitLimit(uint32_t units)
+  {
+    std::vector<uint8_t> data = {static_cast<uint8_t>(ComputeBudgetInstruction::SetComputeUnitLimit)};
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+      data.push_back(static_cast<uint8_t>(units >> shift));
+    }
+    return Instruction::newWithBytes(id(), data, {});
+  }
+
+  // Priority fee in micro-lamports per compute unit
+  static Instruction setComputeUnitPrice(uint64_t microLamports)
+  {
+    std::vector<uint8_t> data = {static_cast<uint8_t>(ComputeBudgetInstruction::SetComputeUnitPrice)};
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+      data.push_back(static_cast<uint8_t>(microLamports >> shift));
+    }
+    return Instruction::newWithBytes(id(), data, {});
+  }
+};
+
+#endif // COMPUTE_BUDGET_H
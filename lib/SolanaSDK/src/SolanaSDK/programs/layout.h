@@ -0,0 +1,60 @@
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+
+// Little-endian writers for fixed-size instruction data, usable in
+// constant expressions. Each returns the offset just past what it wrote,
+// so fields can be chained:
+//   size_t offset = layout::putU32(data, 0, tag);
+//   offset = layout::putU64(data, offset, lamports);
+namespace layout
+{
+  template <size_t N>
+  constexpr size_t putU32(std::array<uint8_t, N> &out, size_t offset, uint32_t value)
+  {
+    for (size_t i = 0; i < 4; ++i)
+    {
+      out[offset + i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+    return offset + 4;
+  }
+
+  template <size_t N>
+  constexpr size_t putU64(std::array<uint8_t, N> &out, size_t offset, uint64_t value)
+  {
+    for (size_t i = 0; i < 8; ++i)
+    {
+      out[offset + i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+    return offset + 8;
+  }
+
+  template <size_t N>
+  constexpr size_t putBytes(std::array<uint8_t, N> &out, size_t offset, const uint8_t *bytes, size_t length)
+  {
+    for (size_t i = 0; i < length; ++i)
+    {
+      out[offset + i] = bytes[i];
+    }
+    return offset + length;
+  }
+
+  // std::array's operator== is only constexpr from C++20
+  template <size_t N>
+  constexpr bool equal(const std::array<uint8_t, N> &a, const std::array<uint8_t, N> &b)
+  {
+    for (size_t i = 0; i < N; ++i)
+    {
+      if (a[i] != b[i])
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+#endif // LAYOUT_H
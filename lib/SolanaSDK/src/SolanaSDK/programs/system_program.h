@@ -1,8 +1,46 @@
 #ifndef SYSTEM_PROGRAM_H
 #define SYSTEM_PROGRAM_H
 
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <string>
 #include <optional>
+#include <vector>
+#include <stdexcept>
 #include "../public_key.h"
+#include "../instruction.h"
+#include "../account_meta.h"
+#include "sysvar/recent_blockhashes.h"
+#include "layout.h"
+
+// Instruction discriminants understood by the system program
+enum class SystemInstruction : uint32_t
+{
+  CreateAccount = 0,
+  Assign = 1,
+  Transfer = 2,
+  CreateAccountWithSeed = 3,
+  AdvanceNonceAccount = 4,
+  WithdrawNonceAccount = 5,
+  InitializeNonceAccount = 6,
+  AuthorizeNonceAccount = 7,
+  Allocate = 8,
+  AllocateWithSeed = 9,
+  AssignWithSeed = 10,
+  TransferWithSeed = 11,
+  UpgradeNonceAccount = 12,
+};
+
+// Encoded sizes of the instruction data, all fields little-endian after a
+// u32 discriminant
+constexpr size_t SYSTEM_TRANSFER_DATA_LEN = 4 + 8;
+constexpr size_t SYSTEM_CREATE_ACCOUNT_DATA_LEN = 4 + 8 + 8 + PUBLIC_KEY_LEN;
+constexpr size_t SYSTEM_ASSIGN_DATA_LEN = 4 + PUBLIC_KEY_LEN;
+constexpr size_t SYSTEM_ALLOCATE_DATA_LEN = 4 + 8;
+constexpr size_t SYSTEM_ADVANCE_NONCE_DATA_LEN = 4;
+// The seed is a u64 length followed by up to MAX_SEED_LEN bytes
+constexpr size_t SYSTEM_CREATE_ACCOUNT_WITH_SEED_MAX_DATA_LEN = 4 + PUBLIC_KEY_LEN + 8 + MAX_SEED_LEN + 8 + 8 + PUBLIC_KEY_LEN;
 
 class SystemProgram
 {
@@ -20,6 +58,144 @@ public:
       return PublicKey();
     }
   }
+
+  // Instruction data, encoded without touching the heap so it can be
+  // built ahead of time or checked in a static_assert
+
+  static constexpr std::array<uint8_t, SYSTEM_TRANSFER_DATA_LEN> transferData(uint64_t lamports)
+  {
+    std::array<uint8_t, SYSTEM_TRANSFER_DATA_LEN> data{};
+    size_t offset = layout::putU32(data, 0, static_cast<uint32_t>(SystemInstruction::Transfer));
+    layout::putU64(data, offset, lamports);
+    return data;
+  }
+
+  static constexpr std::array<uint8_t, SYSTEM_CREATE_ACCOUNT_DATA_LEN> createAccountData(uint64_t lamports, uint64_t space, const PublicKey &owner)
+  {
+    std::array<uint8_t, SYSTEM_CREATE_ACCOUNT_DATA_LEN> data{};
+    size_t offset = layout::putU32(data, 0, static_cast<uint32_t>(SystemInstruction::CreateAccount));
+    offset = layout::putU64(data, offset, lamports);
+    offset = layout::putU64(data, offset, space);
+    layout::putBytes(data, offset, owner.key, PUBLIC_KEY_LEN);
+    return data;
+  }
+
+  static constexpr std::array<uint8_t, SYSTEM_ASSIGN_DATA_LEN> assignData(const PublicKey &owner)
+  {
+    std::array<uint8_t, SYSTEM_ASSIGN_DATA_LEN> data{};
+    size_t offset = layout::putU32(data, 0, static_cast<uint32_t>(SystemInstruction::Assign));
+    layout::putBytes(data, offset, owner.key, PUBLIC_KEY_LEN);
+    return data;
+  }
+
+  static constexpr std::array<uint8_t, SYSTEM_ALLOCATE_DATA_LEN> allocateData(uint64_t space)
+  {
+    std::array<uint8_t, SYSTEM_ALLOCATE_DATA_LEN> data{};
+    size_t offset = layout::putU32(data, 0, static_cast<uint32_t>(SystemInstruction::Allocate));
+    layout::putU64(data, offset, space);
+    return data;
+  }
+
+  static constexpr std::array<uint8_t, SYSTEM_ADVANCE_NONCE_DATA_LEN> advanceNonceData()
+  {
+    std::array<uint8_t, SYSTEM_ADVANCE_NONCE_DATA_LEN> data{};
+    layout::putU32(data, 0, static_cast<uint32_t>(SystemInstruction::AdvanceNonceAccount));
+    return data;
+  }
+
+  // Writes into a buffer sized for the longest seed and returns the length
+  // used
+  static size_t createAccountWithSeedData(std::array<uint8_t, SYSTEM_CREATE_ACCOUNT_WITH_SEED_MAX_DATA_LEN> &data,
+                                          const PublicKey &base, const std::string &seed,
+                                          uint64_t lamports, uint64_t space, const PublicKey &owner)
+  {
+    if (seed.size() > MAX_SEED_LEN)
+    {
+      throw std::invalid_argument("Seed is longer than MAX_SEED_LEN");
+    }
+    size_t offset = layout::putU32(data, 0, static_cast<uint32_t>(SystemInstruction::CreateAccountWithSeed));
+    offset = layout::putBytes(data, offset, base.key, PUBLIC_KEY_LEN);
+    offset = layout::putU64(data, offset, seed.size());
+    offset = layout::putBytes(data, offset, reinterpret_cast<const uint8_t *>(seed.data()), seed.size());
+    offset = layout::putU64(data, offset, lamports);
+    offset = layout::putU64(data, offset, space);
+    return layout::putBytes(data, offset, owner.key, PUBLIC_KEY_LEN);
+  }
+
+  // Move lamports between two system-owned accounts
+  static Instruction transfer(const PublicKey &fromPubkey, const PublicKey &toPubkey, uint64_t lamports)
+  {
+    return build(transferData(lamports), SYSTEM_TRANSFER_DATA_LEN,
+                 {AccountMeta::writable(fromPubkey, true),
+                  AccountMeta::writable(toPubkey, false)});
+  }
+
+  // Fund a new account, allocate its data and hand it to owner; both
+  // accounts sign
+  static Instruction createAccount(const PublicKey &fromPubkey, const PublicKey &newAccountPubkey,
+                                   uint64_t lamports, uint64_t space, const PublicKey &owner)
+  {
+    return build(createAccountData(lamports, space, owner), SYSTEM_CREATE_ACCOUNT_DATA_LEN,
+                 {AccountMeta::writable(fromPubkey, true),
+                  AccountMeta::writable(newAccountPubkey, true)});
+  }
+
+  // As createAccount, at the address derived from base, seed and owner;
+  // base signs instead of the new account
+  static Instruction createAccountWithSeed(const PublicKey &fromPubkey, const PublicKey &toPubkey,
+                                           const PublicKey &base, const std::string &seed,
+                                           uint64_t lamports, uint64_t space, const PublicKey &owner)
+  {
+    std::array<uint8_t, SYSTEM_CREATE_ACCOUNT_WITH_SEED_MAX_DATA_LEN> data{};
+    size_t length = createAccountWithSeedData(data, base, seed, lamports, space, owner);
+    return build(data, length,
+                 {AccountMeta::writable(fromPubkey, true),
+                  AccountMeta::writable(toPubkey, false),
+                  AccountMeta::readonly(base, true)});
+  }
+
+  // Allocate space for an account's data
+  static Instruction allocate(const PublicKey &accountPubkey, uint64_t space)
+  {
+    return build(allocateData(space), SYSTEM_ALLOCATE_DATA_LEN,
+                 {AccountMeta::writable(accountPubkey, true)});
+  }
+
+  // Hand an account to a new owner program
+  static Instruction assign(const PublicKey &accountPubkey, const PublicKey &owner)
+  {
+    return build(assignData(owner), SYSTEM_ASSIGN_DATA_LEN,
+                 {AccountMeta::writable(accountPubkey, true)});
+  }
+
+  // Consume a stored nonce, replacing it with a successor
+  static Instruction advanceNonceAccount(const PublicKey &noncePubkey, const PublicKey &authorizedPubkey)
+  {
+    return build(advanceNonceData(), SYSTEM_ADVANCE_NONCE_DATA_LEN,
+                 {AccountMeta::writable(noncePubkey, false),
+                  AccountMeta::readonly(RecentBlockhashes::id(), false),
+                  AccountMeta::readonly(authorizedPubkey, true)});
+  }
+
+private:
+  template <size_t N>
+  static Instruction build(const std::array<uint8_t, N> &data, size_t length, std::vector<AccountMeta> accounts)
+  {
+    std::vector<uint8_t> bytes(data.begin(), data.begin() + length);
+    return Instruction::newWithBytes(id(), bytes, accounts);
+  }
 };
 
-#endif // SYSTEM_PROGRAM_H
\ No newline at end of file
+// The encodings the builders send, pinned byte for byte against the system
+// program's bincode layout: a u32 discriminant, then little-endian fields
+static_assert(layout::equal(SystemProgram::transferData(0x0102030405060708ULL),
+                            std::array<uint8_t, SYSTEM_TRANSFER_DATA_LEN>{2, 0, 0, 0, 8, 7, 6, 5, 4, 3, 2, 1}),
+              "transfer data must be u32 2 then u64 lamports");
+static_assert(layout::equal(SystemProgram::allocateData(0x1122334455667788ULL),
+                            std::array<uint8_t, SYSTEM_ALLOCATE_DATA_LEN>{8, 0, 0, 0, 0x88, 0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11}),
+              "allocate data must be u32 8 then u64 space");
+static_assert(layout::equal(SystemProgram::advanceNonceData(),
+                            std::array<uint8_t, SYSTEM_ADVANCE_NONCE_DATA_LEN>{4, 0, 0, 0}),
+              "advanceNonceAccount data must be u32 4 alone");
+
+#endif // SYSTEM_PROGRAM_H
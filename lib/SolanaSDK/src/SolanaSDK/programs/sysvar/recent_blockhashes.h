@@ -9,16 +9,14 @@ class RecentBlockhashes
 public:
   static PublicKey id()
   {
-    // std::optional<PublicKey> pubkey = PublicKey::fromString("SysvarRecentB1ockHashes11111111111111111111");
-
-    // if (pubkey.has_value())
-    // {
-    //   return pubkey.value();
-    // }
-    // else
-    // {
-    // }
-    return PublicKey();
+    // SysvarRecentB1ockHashes11111111111111111111, kept as raw bytes so it
+    // is safe to use during static initialization
+    static const unsigned char ID[PUBLIC_KEY_LEN] = {
+        0x06, 0xa7, 0xd5, 0x17, 0x19, 0x2c, 0x56, 0x8e,
+        0xe0, 0x8a, 0x84, 0x5f, 0x73, 0xd2, 0x97, 0x88,
+        0xcf, 0x03, 0x5c, 0x31, 0x45, 0xb2, 0x1a, 0xb3,
+        0x44, 0xd8, 0x06, 0x2e, 0xa9, 0x40, 0x00, 0x00};
+    return PublicKey(ID);
   }
 };
 
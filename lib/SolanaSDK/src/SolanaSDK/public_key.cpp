@@ -5,7 +5,7 @@
 #include "public_key.h"
 #include "base58.h"
 #include "hash.h"
-#include "crypto.h"
+#include "sha256_lanes.h"
 
 bool bytesAreCurvePoint(const std::array<uint8_t, crypto_core_ed25519_BYTES> &bytes) {
     return crypto_core_ed25519_is_valid_point(bytes.data()) != 0;
@@ -31,7 +31,9 @@ std::string PublicKey::toBase58() {
     std::vector<uint8_t> keyVector(this->key, this->key + PUBLIC_KEY_LEN);
     // Ensure the vector has the correct size
     if (keyVector.size() != PUBLIC_KEY_LEN) {
+#if defined(ARDUINO)
         Serial.println("Error: Key vector size is incorrect.");
+#endif
         return "";
     }
     return Base58::trimEncode(keyVector);
@@ -120,18 +122,41 @@ std::optional<PublicKey> PublicKey::createProgramAddress(const std::vector<std::
 }
 
 // Find a valid [program derived address][pda] and its corresponding bump seed.
+// Candidate bumps are hashed a lane-width batch at a time.
 std::optional<std::pair<PublicKey, uint8_t>> PublicKey::tryFindProgramAddress(const std::vector<std::vector<uint8_t>> &seeds, const PublicKey &programId) {
-    std::vector<uint8_t> bump_seed(1, MAX_BUMP_SEED);
-
-    for (uint8_t i = MAX_BUMP_SEED; i > 0; --i) {
-        std::vector<std::vector<uint8_t>> seeds_with_bump = seeds;
-        seeds_with_bump.push_back(bump_seed);
-        std::optional<PublicKey> address = createProgramAddress(seeds_with_bump, programId);
-        if (address.has_value()) {
-            return std::make_pair(address.value(), bump_seed[0]);
-        } else {
-            bump_seed[0] -= 1;
+    if (seeds.size() + 1 > MAX_SEEDS) {
+        throw ParsePublickeyError("MaxSeedLengthExceeded");
+    }
+    for (const auto &seed : seeds) {
+        if (seed.size() > MAX_SEED_LEN) {
+            throw ParsePublickeyError("MaxSeedLengthExceeded");
+        }
+    }
+
+    size_t width = Sha256Lanes::width();
+    std::vector<uint8_t> bumpSeeds(width);
+    std::vector<std::vector<ByteSpan>> messages;
+
+    for (size_t bump = MAX_BUMP_SEED; bump > 0;) {
+        size_t batch = std::min(width, bump);
+        messages.assign(batch, {});
+        for (size_t i = 0; i < batch; ++i) {
+            bumpSeeds[i] = static_cast<uint8_t>(bump - i);
+            for (const auto &seed : seeds) {
+                messages[i].push_back(ByteSpan(seed));
+            }
+            messages[i].push_back(ByteSpan(&bumpSeeds[i], 1));
+            messages[i].push_back(ByteSpan(programId.key, PUBLIC_KEY_LEN));
+            messages[i].push_back(ByteSpan(PDA_MARKER, sizeof(PDA_MARKER) - 1));
+        }
+
+        std::vector<Hash> hashes = Hasher::hashMany(messages);
+        for (size_t i = 0; i < batch; ++i) {
+            if (!bytesAreCurvePoint(hashes[i].toBytes())) {
+                return std::make_pair(PublicKey(hashes[i].toBytes()), bumpSeeds[i]);
+            }
         }
+        bump -= batch;
     }
     return std::nullopt;
 }
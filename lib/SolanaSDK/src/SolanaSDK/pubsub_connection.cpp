@@ -0,0 +1,892 @@
+#include <sodium.h>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <optional>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <ArduinoJson.h>
+#include "pubsub_connection.h"
+#include "connection.h"
+#include "rpc_request_writer.h"
+#include "base58.h"
+#include "base64.h"
+
+// WebSocket opcodes (RFC 6455)
+constexpr uint8_t WS_CONTINUATION = 0x0;
+constexpr uint8_t WS_TEXT = 0x1;
+constexpr uint8_t WS_BINARY = 0x2;
+constexpr uint8_t WS_CLOSE = 0x8;
+constexpr uint8_t WS_PING = 0x9;
+constexpr uint8_t WS_PONG = 0xA;
+
+// Appended to the key before hashing it into Sec-WebSocket-Accept
+static const char WS_ACCEPT_GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+static inline uint32_t rotateLeft(uint32_t value, int bits)
+{
+  return (value << bits) | (value >> (32 - bits));
+}
+
+// SHA-1, only needed for the handshake (RFC 3174)
+static void sha1(const std::string &text, uint8_t digest[20])
+{
+  uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+  std::vector<uint8_t> message(text.begin(), text.end());
+  uint64_t bits = static_cast<uint64_t>(text.size()) * 8;
+  message.push_back(0x80);
+  while (message.size() % 64 != 56)
+  {
+    message.push_back(0);
+  }
+  for (int shift = 56; shift >= 0; shift -= 8)
+  {
+    message.push_back(static_cast<uint8_t>(bits >> shift));
+  }
+
+  for (size_t block = 0; block < message.size(); block += 64)
+  {
+    uint32_t w[80];
+    for (int i = 0; i < 16; ++i)
+    {
+      const uint8_t *p = &message[block + 4 * i];
+      w[i] = (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[2]) << 8) | p[3];
+    }
+    for (int i = 16; i < 80; ++i)
+    {
+      w[i] = rotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; ++i)
+    {
+      uint32_t f, k;
+      if (i < 20)
+      {
+        f = (b & c) | (~b & d);
+        k = 0x5A827999;
+      }
+      else if (i < 40)
+      {
+        f = b ^ c ^ d;
+        k = 0x6ED9EBA1;
+      }
+      else if (i < 60)
+      {
+        f = (b & c) | (b & d) | (c & d);
+        k = 0x8F1BBCDC;
+      }
+      else
+      {
+        f = b ^ c ^ d;
+        k = 0xCA62C1D6;
+      }
+      uint32_t temp = rotateLeft(a, 5) + f + e + k + w[i];
+      e = d;
+      d = c;
+      c = rotateLeft(b, 30);
+      b = a;
+      a = temp;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+  }
+
+  for (int i = 0; i < 5; ++i)
+  {
+    digest[4 * i] = static_cast<uint8_t>(h[i] >> 24);
+    digest[4 * i + 1] = static_cast<uint8_t>(h[i] >> 16);
+    digest[4 * i + 2] = static_cast<uint8_t>(h[i] >> 8);
+    digest[4 * i + 3] = static_cast<uint8_t>(h[i]);
+  }
+}
+
+// Value of the Sec-WebSocket-Accept header in an upgrade response, empty
+// if it has none
+static std::string acceptHeader(const std::string &response)
+{
+  static const char NAME[] = "sec-websocket-accept:";
+  size_t lineStart = response.find("\r\n");
+  while (lineStart != std::string::npos)
+  {
+    lineStart += 2;
+    size_t lineEnd = response.find("\r\n", lineStart);
+    if (lineEnd == std::string::npos)
+    {
+      break;
+    }
+    std::string line = response.substr(lineStart, lineEnd - lineStart);
+    std::transform(line.begin(), line.end(), line.begin(), [](unsigned char c)
+                   { return static_cast<char>(std::tolower(c)); });
+    if (line.rfind(NAME, 0) == 0)
+    {
+      std::string value = response.substr(lineStart + sizeof(NAME) - 1, lineEnd - lineStart - (sizeof(NAME) - 1));
+      size_t first = value.find_first_not_of(" \t");
+      size_t last = value.find_last_not_of(" \t");
+      return first == std::string::npos ? "" : value.substr(first, last - first + 1);
+    }
+    lineStart = lineEnd;
+  }
+  return "";
+}
+
+PubSubConnection::PubSubConnection(std::shared_ptr<PubSubSocket> socket, const std::string &endpoint, Commitment commitment)
+    : socket(socket), commitment(commitment)
+{
+  parseEndpoint(endpoint);
+}
+
+#if defined(ARDUINO)
+PubSubConnection::PubSubConnection(Client &client, const std::string &endpoint, Commitment commitment)
+    : PubSubConnection(std::make_shared<ClientPubSubSocket>(client), endpoint, commitment) {}
+#else
+PubSubConnection::PubSubConnection(const std::string &endpoint, Commitment commitment)
+    : PubSubConnection(std::make_shared<PosixPubSubSocket>(), endpoint, commitment)
+{
+  if (endpoint.rfind("ws://", 0) != 0)
+  {
+    throw std::invalid_argument("PubSubConnection needs a ws:// endpoint without a TLS socket");
+  }
+}
+#endif
+
+PubSubConnection::~PubSubConnection()
+{
+  close();
+}
+
+// Split ws[s]://host[:port]/path
+void PubSubConnection::parseEndpoint(const std::string &endpoint)
+{
+  bool secure = endpoint.rfind("wss://", 0) == 0;
+  size_t hostStart = endpoint.find("://");
+  hostStart = hostStart == std::string::npos ? 0 : hostStart + 3;
+  size_t pathStart = endpoint.find('/', hostStart);
+  std::string authority = endpoint.substr(hostStart, pathStart == std::string::npos ? std::string::npos : pathStart - hostStart);
+  path = pathStart == std::string::npos ? "/" : endpoint.substr(pathStart);
+
+  size_t colon = authority.find(':');
+  if (colon != std::string::npos)
+  {
+    host = authority.substr(0, colon);
+    port = static_cast<uint16_t>(std::stoi(authority.substr(colon + 1)));
+  }
+  else
+  {
+    host = authority;
+    port = secure ? 443 : 80;
+  }
+}
+
+std::string PubSubConnection::endpointFromHttp(const std::string &httpEndpoint)
+{
+  std::string endpoint = httpEndpoint;
+  if (endpoint.rfind("https://", 0) == 0)
+  {
+    endpoint.replace(0, 5, "wss");
+  }
+  else if (endpoint.rfind("http://", 0) == 0)
+  {
+    endpoint.replace(0, 4, "ws");
+  }
+
+  // An explicit port is bumped by one, the convention of solana-test-validator
+  size_t hostStart = endpoint.find("://");
+  hostStart = hostStart == std::string::npos ? 0 : hostStart + 3;
+  size_t pathStart = endpoint.find('/', hostStart);
+  size_t colon = endpoint.find(':', hostStart);
+  if (colon != std::string::npos && (pathStart == std::string::npos || colon < pathStart))
+  {
+    size_t portEnd = pathStart == std::string::npos ? endpoint.size() : pathStart;
+    int port = std::stoi(endpoint.substr(colon + 1, portEnd - colon - 1));
+    endpoint.replace(colon + 1, portEnd - colon - 1, std::to_string(port + 1));
+  }
+  return endpoint;
+}
+
+bool PubSubConnection::connect()
+{
+  dropSocket();
+  enabled = true;
+  if (!socket->connect(host, port))
+  {
+    return false;
+  }
+  if (!handshake())
+  {
+    socket->stop();
+    return false;
+  }
+
+  open = true;
+  lastActivity = Clock::now();
+  reconnectDelay = PUBSUB_RECONNECT_MIN_MS;
+
+  // Server side ids do not survive the socket, subscribe again
+  for (auto &subscription : subscriptions)
+  {
+    subscription.serverId.reset();
+    if (!subscribe(subscription))
+    {
+      dropSocket();
+      return false;
+    }
+  }
+  return true;
+}
+
+// Send the upgrade request and wait for "101 Switching Protocols" with the
+// Sec-WebSocket-Accept matching our key, so a proxy or server answering
+// something else is not mistaken for a WebSocket. The response is read
+// byte by byte so no frame data is consumed with it.
+bool PubSubConnection::handshake()
+{
+  uint8_t nonce[16];
+  randombytes_buf(nonce, sizeof(nonce));
+  std::string key = Base64::encode(std::vector<uint8_t>(nonce, nonce + sizeof(nonce)));
+
+  std::string request;
+  request.reserve(256);
+  request.append("GET ").append(path).append(" HTTP/1.1\r\n");
+  request.append("Host: ").append(host).append("\r\n");
+  request.append("Upgrade: websocket\r\n");
+  request.append("Connection: Upgrade\r\n");
+  request.append("Sec-WebSocket-Key: ").append(key).append("\r\n");
+  request.append("Sec-WebSocket-Version: 13\r\n\r\n");
+  if (socket->write(reinterpret_cast<const uint8_t *>(request.data()), request.size()) != request.size())
+  {
+    return false;
+  }
+
+  std::string response;
+  Clock::time_point until = Clock::now() + std::chrono::milliseconds(PUBSUB_HANDSHAKE_TIMEOUT_MS);
+  while (Clock::now() < until)
+  {
+    if (!socket->connected())
+    {
+      return false;
+    }
+    uint8_t c;
+    if (socket->available() <= 0 || socket->read(&c, 1) != 1)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      continue;
+    }
+    response.push_back(static_cast<char>(c));
+    if (response.size() >= 4 && response.compare(response.size() - 4, 4, "\r\n\r\n") == 0)
+    {
+      if (response.rfind("HTTP/1.1 101", 0) != 0)
+      {
+        return false;
+      }
+      uint8_t digest[20];
+      sha1(key + WS_ACCEPT_GUID, digest);
+      return acceptHeader(response) == Base64::encode(std::vector<uint8_t>(digest, digest + sizeof(digest)));
+    }
+    if (response.size() > 4096)
+    {
+      return false;
+    }
+  }
+  return false;
+}
+
+void PubSubConnection::close()
+{
+  if (open)
+  {
+    // Status 1000, normal closure
+    const uint8_t status[] = {0x03, 0xE8};
+    sendFrame(WS_CLOSE, status, sizeof(status));
+  }
+  enabled = false;
+  dropSocket();
+}
+
+void PubSubConnection::dropSocket()
+{
+  open = false;
+  rxLength = 0;
+  fragments.clear();
+  skipRemaining = 0;
+  skippingMessage = false;
+  // Server side ids die with the socket
+  abandoned.clear();
+  socketEpoch++;
+  socket->stop();
+}
+
+bool PubSubConnection::connected()
+{
+  return open && socket->connected();
+}
+
+// Client frames are always masked; the frame is assembled in tx and written
+// with a single call
+bool PubSubConnection::sendFrame(uint8_t opcode, const uint8_t *payload, size_t length)
+{
+  tx.clear();
+  tx.push_back(0x80 | opcode);
+  if (length < 126)
+  {
+    tx.push_back(0x80 | static_cast<uint8_t>(length));
+  }
+  else if (length <= 0xFFFF)
+  {
+    tx.push_back(0x80 | 126);
+    tx.push_back(static_cast<uint8_t>(length >> 8));
+    tx.push_back(static_cast<uint8_t>(length));
+  }
+  else
+  {
+    tx.push_back(0x80 | 127);
+    for (int shift = 56; shift >= 0; shift -= 8)
+    {
+      tx.push_back(static_cast<uint8_t>(static_cast<uint64_t>(length) >> shift));
+    }
+  }
+
+  uint8_t mask[4];
+  randombytes_buf(mask, sizeof(mask));
+  tx.insert(tx.end(), mask, mask + 4);
+
+  size_t start = tx.size();
+  tx.resize(start + length);
+  for (size_t i = 0; i < length; ++i)
+  {
+    tx[start + i] = payload[i] ^ mask[i & 3];
+  }
+
+  if (socket->write(tx.data(), tx.size()) != tx.size())
+  {
+    dropSocket();
+    return false;
+  }
+  lastActivity = Clock::now();
+  return true;
+}
+
+bool PubSubConnection::sendText(const std::string &payload)
+{
+  return sendFrame(WS_TEXT, reinterpret_cast<const uint8_t *>(payload.data()), payload.size());
+}
+
+const char *PubSubConnection::methodPrefix(Kind kind)
+{
+  switch (kind)
+  {
+  case Kind::signature:
+    return "signature";
+  case Kind::account:
+    return "account";
+  case Kind::slot:
+    return "slot";
+  case Kind::logs:
+    return "logs";
+  }
+  return "";
+}
+
+bool PubSubConnection::subscribe(Subscription &subscription)
+{
+  std::string method = std::string(methodPrefix(subscription.kind)) + "Subscribe";
+  subscription.requestId = nextRequestId++;
+
+  std::string payload;
+  RpcRequestWriter writer(payload, 192);
+  writer.beginRequest(subscription.requestId, method.c_str());
+  switch (subscription.kind)
+  {
+  case Kind::signature:
+    writer.string(subscription.target);
+    writer.beginObject().key("commitment").string(to_string(subscription.commitment)).endObject();
+    break;
+  case Kind::account:
+    writer.string(subscription.target);
+    writer.beginObject();
+    writer.key("commitment").string(to_string(subscription.commitment));
+    writer.key("encoding").string("base64");
+    writer.endObject();
+    break;
+  case Kind::slot:
+    break;
+  case Kind::logs:
+    writer.beginObject().key("mentions").beginArray().string(subscription.target).endArray().endObject();
+    writer.beginObject().key("commitment").string(to_string(subscription.commitment)).endObject();
+    break;
+  }
+  writer.endRequest();
+
+  return sendText(payload);
+}
+
+uint32_t PubSubConnection::add(Subscription subscription)
+{
+  subscription.handle = nextHandle++;
+  subscriptions.push_back(subscription);
+  if (open)
+  {
+    subscribe(subscriptions.back());
+  }
+  return subscription.handle;
+}
+
+uint32_t PubSubConnection::onSignature(const Signature &signature, std::function<void(const SignatureNotification &)> callback, Commitment commitment)
+{
+  Subscription subscription;
+  subscription.kind = Kind::signature;
+  subscription.target = signature.toString();
+  subscription.commitment = commitment;
+  subscription.onSignature = callback;
+  return add(subscription);
+}
+
+uint32_t PubSubConnection::onSignature(const Signature &signature, std::function<void(const SignatureNotification &)> callback)
+{
+  return onSignature(signature, callback, commitment);
+}
+
+uint32_t PubSubConnection::onAccountChange(PublicKey account, std::function<void(const AccountNotification &)> callback, Commitment commitment)
+{
+  Subscription subscription;
+  subscription.kind = Kind::account;
+  subscription.target = account.toBase58();
+  subscription.commitment = commitment;
+  subscription.onAccount = callback;
+  return add(subscription);
+}
+
+uint32_t PubSubConnection::onAccountChange(PublicKey account, std::function<void(const AccountNotification &)> callback)
+{
+  return onAccountChange(account, callback, commitment);
+}
+
+uint32_t PubSubConnection::onSlotChange(std::function<void(const SlotNotification &)> callback)
+{
+  Subscription subscription;
+  subscription.kind = Kind::slot;
+  subscription.commitment = commitment;
+  subscription.onSlot = callback;
+  return add(subscription);
+}
+
+uint32_t PubSubConnection::onLogs(PublicKey account, std::function<void(const LogsNotification &)> callback, Commitment commitment)
+{
+  Subscription subscription;
+  subscription.kind = Kind::logs;
+  subscription.target = account.toBase58();
+  subscription.commitment = commitment;
+  subscription.onLogs = callback;
+  return add(subscription);
+}
+
+uint32_t PubSubConnection::onLogs(PublicKey account, std::function<void(const LogsNotification &)> callback)
+{
+  return onLogs(account, callback, commitment);
+}
+
+bool PubSubConnection::removeSubscription(uint32_t handle)
+{
+  auto it = std::find_if(subscriptions.begin(), subscriptions.end(), [handle](const Subscription &subscription)
+                         { return subscription.handle == handle; });
+  if (it == subscriptions.end())
+  {
+    return false;
+  }
+
+  Kind kind = it->kind;
+  std::optional<uint64_t> serverId = it->serverId;
+  uint32_t requestId = it->requestId;
+  subscriptions.erase(it);
+  if (open && serverId)
+  {
+    unsubscribe(kind, *serverId);
+  }
+  else if (open && requestId != 0)
+  {
+    // The server subscribes anyway, drop it once we learn its id
+    abandoned.push_back({requestId, kind});
+  }
+  return true;
+}
+
+void PubSubConnection::unsubscribe(Kind kind, uint64_t serverId)
+{
+  std::string method = std::string(methodPrefix(kind)) + "Unsubscribe";
+  std::string payload;
+  RpcRequestWriter writer(payload, 96);
+  writer.beginRequest(nextRequestId++, method.c_str());
+  writer.number(serverId);
+  writer.endRequest();
+  sendText(payload);
+}
+
+size_t PubSubConnection::subscriptionCount() const
+{
+  return subscriptions.size();
+}
+
+void PubSubConnection::setMaxMessageSize(size_t bytes)
+{
+  maxMessageSize = bytes;
+}
+
+size_t PubSubConnection::skippedMessageCount() const
+{
+  return skipped;
+}
+
+void PubSubConnection::loop()
+{
+  Clock::time_point now = Clock::now();
+  if (!enabled)
+  {
+    return;
+  }
+  if (!connected())
+  {
+    if (open)
+    {
+      // The peer went away, schedule a reconnect
+      dropSocket();
+      nextReconnect = now;
+    }
+    if (now >= nextReconnect)
+    {
+      if (!connect())
+      {
+        nextReconnect = now + std::chrono::milliseconds(reconnectDelay);
+        reconnectDelay = std::min(reconnectDelay * 2, PUBSUB_RECONNECT_MAX_MS);
+      }
+    }
+    return;
+  }
+
+  if (!readFrames())
+  {
+    if (open)
+    {
+      dropSocket();
+      nextReconnect = now;
+    }
+    return;
+  }
+
+  if (open && now - lastActivity >= std::chrono::milliseconds(PUBSUB_PING_INTERVAL_MS))
+  {
+    sendFrame(WS_PING, nullptr, 0);
+  }
+}
+
+// Read whatever the socket has buffered and handle every complete frame.
+// Payloads are parsed where they sit in rx; only fragmented messages are
+// copied out to be reassembled. A callback run from here may drop or
+// replace the socket, which also resets rx, so the loop stops as soon as
+// the socket epoch moves.
+bool PubSubConnection::readFrames()
+{
+  uint32_t epoch = socketEpoch;
+  int available = socket->available();
+  if (available > 0)
+  {
+    if (rx.size() < rxLength + available)
+    {
+      rx.resize(std::min(rxLength + available, maxMessageSize + 14));
+    }
+    size_t room = rx.size() - rxLength;
+    if (room == 0)
+    {
+      // Frames over the limit are skipped once their header is in, so a
+      // full buffer means the stream is corrupt
+      return false;
+    }
+    int received = socket->read(rx.data() + rxLength, std::min<size_t>(room, available));
+    if (received > 0)
+    {
+      rxLength += received;
+      lastActivity = Clock::now();
+    }
+  }
+
+  // Throw away what is left of an oversized frame
+  size_t offset = static_cast<size_t>(std::min<uint64_t>(skipRemaining, rxLength));
+  skipRemaining -= offset;
+
+  while (rxLength - offset >= 2)
+  {
+    uint8_t *frame = rx.data() + offset;
+    bool fin = frame[0] & 0x80;
+    uint8_t opcode = frame[0] & 0x0F;
+    bool masked = frame[1] & 0x80;
+    uint64_t length = frame[1] & 0x7F;
+    size_t header = 2;
+
+    if (length == 126)
+    {
+      if (rxLength - offset < 4)
+      {
+        break;
+      }
+      length = (static_cast<uint64_t>(frame[2]) << 8) | frame[3];
+      header = 4;
+    }
+    else if (length == 127)
+    {
+      if (rxLength - offset < 10)
+      {
+        break;
+      }
+      length = 0;
+      for (int i = 0; i < 8; ++i)
+      {
+        length = (length << 8) | frame[2 + i];
+      }
+      header = 10;
+    }
+    // Servers must not mask frames (RFC 6455 5.1), the socket is failed
+    if (masked)
+    {
+      return false;
+    }
+
+    bool data = opcode == WS_TEXT || opcode == WS_BINARY || opcode == WS_CONTINUATION;
+    if (data && (length > maxMessageSize || (opcode == WS_CONTINUATION && skippingMessage)))
+    {
+      // Too big to hold: read past it instead of dropping the socket and
+      // every subscription with it
+      if (opcode != WS_CONTINUATION || !skippingMessage)
+      {
+        skipMessage(fin);
+      }
+      else
+      {
+        skippingMessage = !fin;
+      }
+      size_t buffered = rxLength - offset;
+      if (buffered < header + length)
+      {
+        skipRemaining = header + length - buffered;
+        offset = rxLength;
+        break;
+      }
+      offset += header + length;
+      continue;
+    }
+    if (!data && length > 125)
+    {
+      // Control frames are at most 125 bytes (RFC 6455 5.5)
+      return false;
+    }
+    if (rxLength - offset < header + length)
+    {
+      break;
+    }
+
+    uint8_t *payload = frame + header;
+
+    switch (opcode)
+    {
+    case WS_TEXT:
+    case WS_BINARY:
+      if (fin)
+      {
+        handleMessage(reinterpret_cast<char *>(payload), length);
+      }
+      else
+      {
+        fragments.assign(payload, payload + length);
+      }
+      break;
+    case WS_CONTINUATION:
+      if (fragments.size() + length > maxMessageSize)
+      {
+        skipMessage(fin);
+        break;
+      }
+      fragments.insert(fragments.end(), payload, payload + length);
+      if (fin)
+      {
+        handleMessage(fragments.data(), fragments.size());
+        fragments.clear();
+      }
+      break;
+    case WS_PING:
+      sendFrame(WS_PONG, payload, length);
+      break;
+    case WS_PONG:
+      break;
+    case WS_CLOSE:
+      return false;
+    default:
+      return false;
+    }
+
+    if (socketEpoch != epoch)
+    {
+      // rx belongs to the new socket now, or to none
+      return true;
+    }
+    offset += header + length;
+  }
+
+  // Keep the partial frame at the front of the buffer
+  if (offset > 0)
+  {
+    std::memmove(rx.data(), rx.data() + offset, rxLength - offset);
+    rxLength -= offset;
+  }
+  return true;
+}
+
+// Drop the message being received; unless fin, its later fragments are
+// thrown away as they come
+void PubSubConnection::skipMessage(bool fin)
+{
+  fragments.clear();
+  skippingMessage = !fin;
+  skipped++;
+}
+
+void PubSubConnection::handleMessage(char *data, size_t length)
+{
+  JsonDocument doc;
+  if (deserializeJson(doc, data, length))
+  {
+    return;
+  }
+
+  const char *method = doc["method"];
+  if (method != nullptr)
+  {
+    handleNotification(doc["params"], method);
+    return;
+  }
+
+  // Answer to a subscribe request: result is the server side id
+  uint32_t id = doc["id"] | 0u;
+  if (id == 0)
+  {
+    return;
+  }
+  for (auto it = subscriptions.begin(); it != subscriptions.end(); ++it)
+  {
+    if (it->requestId == id)
+    {
+      it->requestId = 0;
+      if (doc["result"].is<uint64_t>())
+      {
+        it->serverId = doc["result"].as<uint64_t>();
+      }
+      else
+      {
+        // Rejected by the server, nothing will ever be delivered
+        subscriptions.erase(it);
+      }
+      return;
+    }
+  }
+  for (auto it = abandoned.begin(); it != abandoned.end(); ++it)
+  {
+    if (it->requestId == id)
+    {
+      Kind kind = it->kind;
+      abandoned.erase(it);
+      if (doc["result"].is<uint64_t>())
+      {
+        unsubscribe(kind, doc["result"].as<uint64_t>());
+      }
+      return;
+    }
+  }
+}
+
+void PubSubConnection::handleNotification(JsonVariantConst params, const char *method)
+{
+  uint64_t serverId = params["subscription"] | 0ULL;
+  auto it = std::find_if(subscriptions.begin(), subscriptions.end(), [serverId](const Subscription &subscription)
+                         { return subscription.serverId && *subscription.serverId == serverId; });
+  if (it == subscriptions.end())
+  {
+    return;
+  }
+
+  JsonVariantConst result = params["result"];
+  uint64_t slot = result["context"]["slot"] | 0ULL;
+
+  if (it->kind == Kind::signature && strcmp(method, "signatureNotification") == 0)
+  {
+    SignatureNotification notification;
+    notification.slot = slot;
+    notification.failed = !result["value"]["err"].isNull();
+    // The server cancels signature subscriptions after the first notification
+    auto callback = it->onSignature;
+    subscriptions.erase(it);
+    if (callback)
+    {
+      callback(notification);
+    }
+  }
+  else if (it->kind == Kind::account && strcmp(method, "accountNotification") == 0)
+  {
+    JsonVariantConst value = result["value"];
+    AccountNotification notification;
+    notification.slot = slot;
+    notification.lamports = value["lamports"] | 0ULL;
+    notification.executable = value["executable"] | false;
+    notification.rentEpoch = value["rentEpoch"] | 0ULL;
+    const char *owner = value["owner"];
+    std::optional<PublicKey> ownerKey = owner != nullptr ? PublicKey::fromString(owner) : std::nullopt;
+    if (ownerKey)
+    {
+      notification.owner = *ownerKey;
+    }
+    const char *data = value["data"][0];
+    if (data != nullptr)
+    {
+      notification.data = Base64::decode(data);
+    }
+    // Copied first, the callback may add or remove subscriptions
+    auto callback = it->onAccount;
+    if (callback)
+    {
+      callback(notification);
+    }
+  }
+  else if (it->kind == Kind::slot && strcmp(method, "slotNotification") == 0)
+  {
+    SlotNotification notification;
+    notification.slot = result["slot"] | 0ULL;
+    notification.parent = result["parent"] | 0ULL;
+    notification.root = result["root"] | 0ULL;
+    auto callback = it->onSlot;
+    if (callback)
+    {
+      callback(notification);
+    }
+  }
+  else if (it->kind == Kind::logs && strcmp(method, "logsNotification") == 0)
+  {
+    JsonVariantConst value = result["value"];
+    LogsNotification notification;
+    notification.slot = slot;
+    notification.signature = value["signature"] | "";
+    notification.failed = !value["err"].isNull();
+    for (JsonVariantConst line : value["logs"].as<JsonArrayConst>())
+    {
+      notification.logs.push_back(line | "");
+    }
+    auto callback = it->onLogs;
+    if (callback)
+    {
+      callback(notification);
+    }
+  }
+}
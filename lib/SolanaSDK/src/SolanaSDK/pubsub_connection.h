@@ -0,0 +1,212 @@
+#ifndef PUBSUB_CONNECTION_H
+#define PUBSUB_CONNECTION_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <optional>
+#include <functional>
+#include <ArduinoJson.h>
+#include "pubsub_socket.h"
+#include "connection.h"
+#include "public_key.h"
+#include "signature.h"
+
+// Default for the largest message held in memory. Bigger ones are skipped
+// as they arrive and the socket stays open; see setMaxMessageSize().
+constexpr size_t PUBSUB_MAX_MESSAGE_SIZE = 16384;
+
+// Delay before the first reconnect attempt, doubled on every failure
+constexpr uint32_t PUBSUB_RECONNECT_MIN_MS = 1000;
+constexpr uint32_t PUBSUB_RECONNECT_MAX_MS = 30000;
+
+// Ping the server when the socket has been idle this long
+constexpr uint32_t PUBSUB_PING_INTERVAL_MS = 30000;
+
+constexpr uint32_t PUBSUB_HANDSHAKE_TIMEOUT_MS = 10000;
+
+struct SignatureNotification
+{
+  uint64_t slot;
+  // True if the transaction failed
+  bool failed;
+};
+
+struct AccountNotification
+{
+  uint64_t slot;
+  uint64_t lamports;
+  PublicKey owner;
+  std::vector<uint8_t> data;
+  bool executable;
+  uint64_t rentEpoch;
+};
+
+struct SlotNotification
+{
+  uint64_t slot;
+  uint64_t parent;
+  uint64_t root;
+};
+
+struct LogsNotification
+{
+  uint64_t slot;
+  std::string signature;
+  bool failed;
+  std::vector<std::string> logs;
+};
+
+// Client for the RPC PubSub WebSocket API. All subscriptions share one
+// socket; the connection is re-established and every subscription is sent
+// again whenever the socket drops. Not thread-safe: call loop() regularly
+// from the thread that owns it to read notifications and run callbacks.
+// Callbacks may add or remove subscriptions, or close and reconnect.
+//
+// On Arduino the socket is any Client (WiFiClient, WiFiClientSecure for
+// wss://). On Linux hosts a plain TCP socket is used for ws:// endpoints;
+// any other PubSubSocket can be passed in, e.g. one doing TLS.
+class PubSubConnection
+{
+private:
+  using Clock = std::chrono::steady_clock;
+
+  enum class Kind
+  {
+    signature,
+    account,
+    slot,
+    logs
+  };
+
+  struct Subscription
+  {
+    uint32_t handle;
+    Kind kind;
+    // Base58 signature or account, empty for slots
+    std::string target;
+    Commitment commitment;
+    // Id of the pending subscribe request, 0 once answered
+    uint32_t requestId = 0;
+    std::optional<uint64_t> serverId;
+    std::function<void(const SignatureNotification &)> onSignature;
+    std::function<void(const AccountNotification &)> onAccount;
+    std::function<void(const SlotNotification &)> onSlot;
+    std::function<void(const LogsNotification &)> onLogs;
+  };
+
+  // Subscribe request removed before its answer came, unsubscribed as soon
+  // as the server tells its id
+  struct Abandoned
+  {
+    uint32_t requestId;
+    Kind kind;
+  };
+
+  std::shared_ptr<PubSubSocket> socket;
+  std::string host;
+  uint16_t port;
+  std::string path;
+  Commitment commitment;
+  std::vector<Subscription> subscriptions;
+  std::vector<Abandoned> abandoned;
+  uint32_t nextHandle = 1;
+  uint32_t nextRequestId = 1;
+
+  // Bytes received but not yet consumed as complete frames
+  std::vector<uint8_t> rx;
+  size_t rxLength = 0;
+  // Payload of a fragmented message being reassembled
+  std::vector<char> fragments;
+  std::vector<uint8_t> tx;
+  size_t maxMessageSize = PUBSUB_MAX_MESSAGE_SIZE;
+  // Bytes of an oversized frame still to be read and thrown away
+  uint64_t skipRemaining = 0;
+  // Set while the later fragments of an oversized message are thrown away
+  bool skippingMessage = false;
+  size_t skipped = 0;
+
+  bool open = false;
+  // Set by connect(), cleared by close(); loop() only reconnects when set
+  bool enabled = false;
+  // Bumped whenever the socket is dropped, so readFrames() notices a
+  // callback that closed or reconnected under it
+  uint32_t socketEpoch = 0;
+  Clock::time_point lastActivity;
+  Clock::time_point nextReconnect;
+  uint32_t reconnectDelay = PUBSUB_RECONNECT_MIN_MS;
+
+  void parseEndpoint(const std::string &endpoint);
+  bool handshake();
+  bool sendFrame(uint8_t opcode, const uint8_t *payload, size_t length);
+  bool sendText(const std::string &payload);
+  bool subscribe(Subscription &subscription);
+  void unsubscribe(Kind kind, uint64_t serverId);
+  bool readFrames();
+  void skipMessage(bool fin);
+  void handleMessage(char *data, size_t length);
+  void handleNotification(JsonVariantConst params, const char *method);
+  void dropSocket();
+  uint32_t add(Subscription subscription);
+  static const char *methodPrefix(Kind kind);
+
+public:
+  // endpoint is a ws:// or wss:// URL, the socket must match the scheme
+  PubSubConnection(std::shared_ptr<PubSubSocket> socket, const std::string &endpoint, Commitment commitment = Commitment::confirmed);
+#if defined(ARDUINO)
+  // The client must outlive the connection
+  PubSubConnection(Client &client, const std::string &endpoint, Commitment commitment = Commitment::confirmed);
+#else
+  // Over a PosixPubSubSocket, so endpoint must be ws://
+  PubSubConnection(const std::string &endpoint, Commitment commitment = Commitment::confirmed);
+#endif
+  ~PubSubConnection();
+
+  PubSubConnection(const PubSubConnection &) = delete;
+  PubSubConnection &operator=(const PubSubConnection &) = delete;
+
+  // Open the socket and send every registered subscription. Even if this
+  // fails, loop() keeps retrying until close() is called.
+  bool connect();
+
+  void close();
+
+  bool connected();
+
+  // Read pending frames and dispatch notifications, reconnecting with
+  // backoff if the socket dropped. Call from loop().
+  void loop();
+
+  // Notified once when the transaction reaches the commitment level
+  uint32_t onSignature(const Signature &signature, std::function<void(const SignatureNotification &)> callback, Commitment commitment);
+  uint32_t onSignature(const Signature &signature, std::function<void(const SignatureNotification &)> callback);
+
+  uint32_t onAccountChange(PublicKey account, std::function<void(const AccountNotification &)> callback, Commitment commitment);
+  uint32_t onAccountChange(PublicKey account, std::function<void(const AccountNotification &)> callback);
+
+  uint32_t onSlotChange(std::function<void(const SlotNotification &)> callback);
+
+  // Logs of transactions mentioning account
+  uint32_t onLogs(PublicKey account, std::function<void(const LogsNotification &)> callback, Commitment commitment);
+  uint32_t onLogs(PublicKey account, std::function<void(const LogsNotification &)> callback);
+
+  // Stop a subscription by the handle returned when it was added
+  bool removeSubscription(uint32_t handle);
+
+  size_t subscriptionCount() const;
+
+  // Largest message held in memory, PUBSUB_MAX_MESSAGE_SIZE by default.
+  // Raise it for accounts whose base64 data exceeds it; bigger messages
+  // are read past and dropped without closing the socket.
+  void setMaxMessageSize(size_t bytes);
+
+  // Messages dropped so far for being larger than the limit
+  size_t skippedMessageCount() const;
+
+  // WebSocket URL matching an HTTP RPC endpoint, as web3.js derives it
+  static std::string endpointFromHttp(const std::string &httpEndpoint);
+};
+
+#endif // PUBSUB_CONNECTION_H
@@ -0,0 +1,198 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "pubsub_socket.h"
+
+#if defined(ARDUINO)
+
+ClientPubSubSocket::ClientPubSubSocket(Client &client) : client(client) {}
+
+bool ClientPubSubSocket::connect(const std::string &host, uint16_t port)
+{
+  return client.connect(host.c_str(), port);
+}
+
+size_t ClientPubSubSocket::write(const uint8_t *data, size_t length)
+{
+  return client.write(data, length);
+}
+
+int ClientPubSubSocket::available()
+{
+  return client.available();
+}
+
+int ClientPubSubSocket::read(uint8_t *buffer, size_t length)
+{
+  return client.read(buffer, length);
+}
+
+bool ClientPubSubSocket::connected()
+{
+  return client.connected();
+}
+
+void ClientPubSubSocket::stop()
+{
+  client.stop();
+}
+
+#else
+
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#if !defined(MSG_NOSIGNAL)
+#define MSG_NOSIGNAL 0
+#endif
+
+PosixPubSubSocket::~PosixPubSubSocket()
+{
+  stop();
+}
+
+bool PosixPubSubSocket::connect(const std::string &host, uint16_t port)
+{
+  stop();
+
+  addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo *addresses = nullptr;
+  if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0)
+  {
+    return false;
+  }
+
+  for (addrinfo *address = addresses; address != nullptr && fd < 0; address = address->ai_next)
+  {
+    int candidate = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (candidate < 0)
+    {
+      continue;
+    }
+    timeval timeout;
+    timeout.tv_sec = PUBSUB_SOCKET_TIMEOUT_MS / 1000;
+    timeout.tv_usec = (PUBSUB_SOCKET_TIMEOUT_MS % 1000) * 1000;
+    setsockopt(candidate, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    int one = 1;
+    setsockopt(candidate, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#if defined(SO_NOSIGPIPE)
+    setsockopt(candidate, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+
+    // Bound the connect like the HTTP transport does
+    int flags = fcntl(candidate, F_GETFL, 0);
+    fcntl(candidate, F_SETFL, flags | O_NONBLOCK);
+    bool ok = ::connect(candidate, address->ai_addr, address->ai_addrlen) == 0;
+    if (!ok && errno == EINPROGRESS)
+    {
+      pollfd entry{candidate, POLLOUT, 0};
+      int error = 0;
+      socklen_t length = sizeof(error);
+      ok = ::poll(&entry, 1, PUBSUB_SOCKET_TIMEOUT_MS) == 1 &&
+           getsockopt(candidate, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0;
+    }
+    if (ok)
+    {
+      fcntl(candidate, F_SETFL, flags);
+      fd = candidate;
+    }
+    else
+    {
+      ::close(candidate);
+    }
+  }
+
+  freeaddrinfo(addresses);
+  closed = false;
+  return fd >= 0;
+}
+
+size_t PosixPubSubSocket::write(const uint8_t *data, size_t length)
+{
+  size_t written = 0;
+  while (fd >= 0 && written < length)
+  {
+    ssize_t count = ::send(fd, data + written, length - written, MSG_NOSIGNAL);
+    if (count <= 0)
+    {
+      closed = true;
+      break;
+    }
+    written += static_cast<size_t>(count);
+  }
+  return written;
+}
+
+int PosixPubSubSocket::available()
+{
+  if (fd < 0 || closed)
+  {
+    return 0;
+  }
+  int count = 0;
+  if (ioctl(fd, FIONREAD, &count) != 0)
+  {
+    closed = true;
+    return 0;
+  }
+  if (count == 0)
+  {
+    // Readable with nothing to read means the peer closed
+    pollfd entry{fd, POLLIN, 0};
+    if (::poll(&entry, 1, 0) == 1)
+    {
+      char probe;
+      ssize_t peeked = ::recv(fd, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+      closed = peeked == 0 || (peeked < 0 && errno != EAGAIN && errno != EWOULDBLOCK);
+    }
+  }
+  return count;
+}
+
+int PosixPubSubSocket::read(uint8_t *buffer, size_t length)
+{
+  if (fd < 0)
+  {
+    return -1;
+  }
+  ssize_t count = ::recv(fd, buffer, length, MSG_DONTWAIT);
+  if (count == 0 || (count < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+  {
+    closed = true;
+  }
+  return static_cast<int>(count);
+}
+
+bool PosixPubSubSocket::connected()
+{
+  if (fd >= 0 && !closed)
+  {
+    available();
+  }
+  return fd >= 0 && !closed;
+}
+
+void PosixPubSubSocket::stop()
+{
+  if (fd >= 0)
+  {
+    ::close(fd);
+    fd = -1;
+  }
+  closed = false;
+}
+
+#endif // ARDUINO
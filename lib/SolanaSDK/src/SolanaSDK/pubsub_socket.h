@@ -0,0 +1,84 @@
+#ifndef PUBSUB_SOCKET_H
+#define PUBSUB_SOCKET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#if defined(ARDUINO)
+#include <Client.h>
+#endif
+
+// Time a PosixPubSubSocket waits for connect() and for each blocked write
+constexpr uint32_t PUBSUB_SOCKET_TIMEOUT_MS = 10000;
+
+// Byte stream a PubSubConnection runs over. Reads never block: read()
+// returns what is buffered and available() says how much that is.
+class PubSubSocket
+{
+public:
+  virtual ~PubSubSocket() = default;
+
+  virtual bool connect(const std::string &host, uint16_t port) = 0;
+
+  // Bytes written, less than length on failure
+  virtual size_t write(const uint8_t *data, size_t length) = 0;
+
+  // Bytes that can be read without blocking
+  virtual int available() = 0;
+
+  // Up to length bytes, 0 or less if none are buffered
+  virtual int read(uint8_t *buffer, size_t length) = 0;
+
+  virtual bool connected() = 0;
+
+  virtual void stop() = 0;
+};
+
+#if defined(ARDUINO)
+
+// Any Arduino Client: WiFiClient, WiFiClientSecure for wss://, or one
+// pointed at a local server
+class ClientPubSubSocket : public PubSubSocket
+{
+private:
+  Client &client;
+
+public:
+  ClientPubSubSocket(Client &client);
+
+  bool connect(const std::string &host, uint16_t port) override;
+  size_t write(const uint8_t *data, size_t length) override;
+  int available() override;
+  int read(uint8_t *buffer, size_t length) override;
+  bool connected() override;
+  void stop() override;
+};
+
+#else
+
+// Plain TCP socket for ws:// endpoints on Linux hosts
+class PosixPubSubSocket : public PubSubSocket
+{
+private:
+  int fd = -1;
+  // Set once the peer closed its end
+  bool closed = false;
+
+public:
+  PosixPubSubSocket() = default;
+  ~PosixPubSubSocket();
+
+  PosixPubSubSocket(const PosixPubSubSocket &) = delete;
+  PosixPubSubSocket &operator=(const PosixPubSubSocket &) = delete;
+
+  bool connect(const std::string &host, uint16_t port) override;
+  size_t write(const uint8_t *data, size_t length) override;
+  int available() override;
+  int read(uint8_t *buffer, size_t length) override;
+  bool connected() override;
+  void stop() override;
+};
+
+#endif // ARDUINO
+
+#endif // PUBSUB_SOCKET_H
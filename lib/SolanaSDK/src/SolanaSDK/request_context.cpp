@@ -0,0 +1,81 @@
+#include <cstdint>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <algorithm>
+#include "request_context.h"
+
+CancellationToken::CancellationToken() : flag(std::make_shared<std::atomic<bool>>(false)) {}
+
+void CancellationToken::cancel()
+{
+  flag->store(true);
+}
+
+bool CancellationToken::cancelled() const
+{
+  return flag->load();
+}
+
+Deadline Deadline::after(uint32_t timeoutMs)
+{
+  Deadline deadline;
+  deadline.at = Clock::now() + std::chrono::milliseconds(timeoutMs);
+  return deadline;
+}
+
+bool Deadline::expired() const
+{
+  return at && Clock::now() >= *at;
+}
+
+bool Deadline::bounded() const
+{
+  return at.has_value();
+}
+
+uint32_t Deadline::remainingMs(uint32_t limit) const
+{
+  if (!at)
+  {
+    return limit;
+  }
+  auto left = std::chrono::duration_cast<std::chrono::milliseconds>(*at - Clock::now()).count();
+  if (left <= 0)
+  {
+    return 0;
+  }
+  return static_cast<uint32_t>(std::min<int64_t>(left, limit));
+}
+
+Deadline Deadline::earliest(const Deadline &a, const Deadline &b)
+{
+  if (!a.at)
+  {
+    return b;
+  }
+  if (!b.at)
+  {
+    return a;
+  }
+  return *a.at <= *b.at ? a : b;
+}
+
+bool RequestContext::stopped() const
+{
+  return stopReason().has_value();
+}
+
+std::optional<RpcErrorCode> RequestContext::stopReason() const
+{
+  if (token && token->cancelled())
+  {
+    return RpcErrorCode::cancelled;
+  }
+  if (deadline.expired())
+  {
+    return RpcErrorCode::timeout;
+  }
+  return std::nullopt;
+}
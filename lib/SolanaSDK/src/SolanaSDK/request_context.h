@@ -0,0 +1,110 @@
+#ifndef REQUEST_CONTEXT_H
+#define REQUEST_CONTEXT_H
+
+#include <cstdint>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <stdexcept>
+
+// Longest a transport blocks between checks of a cancellation token
+constexpr uint32_t REQUEST_CONTEXT_POLL_MS = 50;
+
+// Shared flag that abandons every call carrying it once set. Copies share
+// the flag, so one token can be handed to several calls and cancelled from
+// another thread.
+class CancellationToken
+{
+private:
+  std::shared_ptr<std::atomic<bool>> flag;
+
+public:
+  CancellationToken();
+
+  void cancel();
+
+  bool cancelled() const;
+};
+
+// Point in time after which a call gives up, or none
+class Deadline
+{
+private:
+  using Clock = std::chrono::steady_clock;
+
+  std::optional<Clock::time_point> at;
+
+public:
+  // No deadline
+  Deadline() = default;
+
+  static Deadline after(uint32_t timeoutMs);
+
+  bool expired() const;
+
+  bool bounded() const;
+
+  // Milliseconds left, capped at limit; limit when there is no deadline
+  uint32_t remainingMs(uint32_t limit) const;
+
+  // Whichever of the two ends first
+  static Deadline earliest(const Deadline &a, const Deadline &b);
+};
+
+enum class RpcErrorCode
+{
+  // The deadline passed before the call finished
+  timeout,
+  // The call's cancellation token was cancelled
+  cancelled,
+  // No response from the node
+  transport,
+  // The node answered with a JSON-RPC error
+  rpc,
+  // The response could not be understood
+  invalidResponse
+};
+
+struct RpcError
+{
+  RpcErrorCode code;
+  std::string message;
+};
+
+// Thrown by Connection for failed calls; a std::runtime_error so existing
+// catch blocks keep working
+class RpcException : public std::runtime_error
+{
+public:
+  RpcErrorCode code;
+
+  RpcException(RpcErrorCode code, const std::string &message) : std::runtime_error(message), code(code) {}
+};
+
+// Deadline and cancellation token a call runs under
+struct RequestContext
+{
+  Deadline deadline;
+  std::optional<CancellationToken> token;
+
+  // True once the call should give up
+  bool stopped() const;
+
+  // Why the call gave up, empty while it may continue
+  std::optional<RpcErrorCode> stopReason() const;
+};
+
+// Value of a call or the error that ended it
+template <typename T>
+struct RpcResult
+{
+  std::optional<T> value;
+  std::optional<RpcError> error;
+
+  bool ok() const { return !error.has_value(); }
+  explicit operator bool() const { return ok(); }
+};
+
+#endif // REQUEST_CONTEXT_H
@@ -0,0 +1,541 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <mutex>
+#include <condition_variable>
+#include "router_transport.h"
+
+// Latency samples kept per endpoint for the p95 hedge delay
+constexpr size_t ROUTER_LATENCY_SAMPLES = 32;
+
+// Passes a response through while looking for a JSON-RPC "error" member
+// on the top-level object, or on any object of a batch
+class ScoredResponseReader : public ResponseReader
+{
+private:
+  ResponseReader &body;
+  int depth = 0;
+  // Depth of the objects whose members are looked at
+  int keyDepth = 0;
+  bool inString = false;
+  bool escaped = false;
+  bool expectKey = false;
+  bool inKey = false;
+  bool errorKey = false;
+  bool errorValue = false;
+  bool error = false;
+  std::string key;
+
+  void scan(char c)
+  {
+    if (inString)
+    {
+      if (escaped)
+      {
+        escaped = false;
+      }
+      else if (c == '\\')
+      {
+        escaped = true;
+      }
+      else if (c == '"')
+      {
+        inString = false;
+        errorKey = inKey && key == "error";
+        inKey = false;
+      }
+      else if (inKey && key.size() < 8)
+      {
+        key += c;
+      }
+      return;
+    }
+    if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+    {
+      return;
+    }
+    if (errorValue)
+    {
+      // "error": null is not an error
+      error = error || c != 'n';
+      errorValue = false;
+    }
+    switch (c)
+    {
+    case '"':
+      inString = true;
+      inKey = expectKey;
+      expectKey = false;
+      key.clear();
+      break;
+    case ':':
+      errorValue = errorKey;
+      errorKey = false;
+      break;
+    case '{':
+    case '[':
+      if (depth == 0)
+      {
+        keyDepth = c == '{' ? 1 : 2;
+      }
+      depth++;
+      expectKey = c == '{' && depth == keyDepth;
+      break;
+    case '}':
+    case ']':
+      depth--;
+      expectKey = false;
+      break;
+    case ',':
+      expectKey = depth == keyDepth;
+      break;
+    default:
+      break;
+    }
+  }
+
+public:
+  explicit ScoredResponseReader(ResponseReader &body) : body(body) {}
+
+  int read() override
+  {
+    int c = body.read();
+    if (c >= 0)
+    {
+      scan(static_cast<char>(c));
+    }
+    return c;
+  }
+
+  size_t readBytes(char *buffer, size_t length) override
+  {
+    size_t count = body.readBytes(buffer, length);
+    for (size_t i = 0; i < count; ++i)
+    {
+      scan(buffer[i]);
+    }
+    return count;
+  }
+
+  int status() const override
+  {
+    return body.status();
+  }
+
+  uint32_t retryAfterMs() const override
+  {
+    return body.retryAfterMs();
+  }
+
+  // 2xx without an error member, as far as the body was read
+  bool succeeded() const
+  {
+    return body.status() >= 200 && body.status() < 300 && !error;
+  }
+};
+
+// A response buffered by a racing attempt
+struct RouterReply
+{
+  std::string body;
+  int status = 200;
+  uint32_t retryAfterMs = 0;
+};
+
+// Outcome of a request sent to several endpoints at once. The first
+// successful reply wins; until one does, the first failed reply is kept so
+// the caller still sees the error if every attempt fails.
+struct RouterTransport::Race
+{
+  std::string request;
+  // The call's deadline with a token of the race's own, cancelled once
+  // the race is over so attempts still running give up
+  RequestContext context;
+  std::mutex mutex;
+  std::condition_variable finished;
+  size_t pending = 0;
+  bool won = false;
+  bool answered = false;
+  RouterReply reply;
+};
+
+RouterTransport::RouterTransport(std::vector<std::shared_ptr<Transport>> endpoints, RouterOptions options)
+    : state(std::make_shared<State>())
+{
+  if (endpoints.empty())
+  {
+    throw std::invalid_argument("RouterTransport needs at least one endpoint");
+  }
+  state->options = options;
+  for (auto &transport : endpoints)
+  {
+    Endpoint endpoint;
+    endpoint.transport = transport;
+    state->endpoints.push_back(endpoint);
+  }
+  executor.reset(new RpcExecutor(std::max<size_t>(maxConcurrency(), 2)));
+}
+
+std::shared_ptr<RouterTransport> RouterTransport::forEndpoints(const std::vector<std::string> &urls, size_t maxConnections, RouterOptions options)
+{
+  std::vector<std::shared_ptr<Transport>> endpoints;
+  for (const auto &url : urls)
+  {
+    endpoints.push_back(Transport::forEndpoint(url, maxConnections));
+  }
+  return std::make_shared<RouterTransport>(endpoints, options);
+}
+
+// Endpoints in order of preference: closed circuits by latency weighted
+// with error rate. A half-open circuit due for a probe goes first so the
+// probe is actually sent; when every circuit is open the least recently
+// failed ones are used.
+std::vector<size_t> RouterTransport::rank(State &state)
+{
+  std::lock_guard<std::mutex> lock(state.mutex);
+  Clock::time_point now = Clock::now();
+
+  auto score = [&state](size_t i)
+  {
+    const Endpoint &endpoint = state.endpoints[i];
+    return (endpoint.latencyMs + 1.0) * (1.0 + 10.0 * endpoint.errorRate);
+  };
+
+  std::vector<size_t> closed;
+  std::vector<size_t> open;
+  for (size_t i = 0; i < state.endpoints.size(); ++i)
+  {
+    Endpoint &endpoint = state.endpoints[i];
+    if (endpoint.consecutiveFailures < state.options.failureThreshold)
+    {
+      closed.push_back(i);
+    }
+    else
+    {
+      open.push_back(i);
+    }
+  }
+  std::sort(closed.begin(), closed.end(), [&score](size_t a, size_t b)
+            { return score(a) < score(b); });
+
+  for (size_t i : open)
+  {
+    Endpoint &endpoint = state.endpoints[i];
+    if (now >= endpoint.openUntil && !endpoint.probing)
+    {
+      endpoint.probing = true;
+      closed.insert(closed.begin(), i);
+      return closed;
+    }
+  }
+
+  if (closed.empty())
+  {
+    std::sort(open.begin(), open.end(), [&state](size_t a, size_t b)
+              { return state.endpoints[a].openUntil < state.endpoints[b].openUntil; });
+    return open;
+  }
+  return closed;
+}
+
+void RouterTransport::record(State &state, size_t index, bool ok, uint32_t latencyMs)
+{
+  std::lock_guard<std::mutex> lock(state.mutex);
+  Endpoint &endpoint = state.endpoints[index];
+  double alpha = state.options.ewmaAlpha;
+
+  endpoint.probing = false;
+  endpoint.errorRate = (1 - alpha) * endpoint.errorRate + alpha * (ok ? 0.0 : 1.0);
+  if (ok)
+  {
+    endpoint.latencyMs = endpoint.samples.empty() ? latencyMs : (1 - alpha) * endpoint.latencyMs + alpha * latencyMs;
+    if (endpoint.samples.size() < ROUTER_LATENCY_SAMPLES)
+    {
+      endpoint.samples.push_back(latencyMs);
+    }
+    else
+    {
+      endpoint.samples[endpoint.nextSample] = latencyMs;
+      endpoint.nextSample = (endpoint.nextSample + 1) % ROUTER_LATENCY_SAMPLES;
+    }
+    endpoint.consecutiveFailures = 0;
+  }
+  else
+  {
+    endpoint.consecutiveFailures++;
+    if (endpoint.consecutiveFailures >= state.options.failureThreshold)
+    {
+      endpoint.openUntil = Clock::now() + std::chrono::milliseconds(state.options.cooldownMs);
+    }
+  }
+}
+
+void RouterTransport::abandon(State &state, size_t index)
+{
+  std::lock_guard<std::mutex> lock(state.mutex);
+  // Let the next call probe a half-open circuit again
+  state.endpoints[index].probing = false;
+}
+
+uint32_t RouterTransport::hedgeDelay(State &state, size_t index)
+{
+  std::lock_guard<std::mutex> lock(state.mutex);
+  const Endpoint &endpoint = state.endpoints[index];
+  uint32_t delay;
+  if (endpoint.samples.size() < 8)
+  {
+    // Too few samples for a percentile, fall back to twice the average
+    delay = static_cast<uint32_t>(endpoint.latencyMs * 2);
+  }
+  else
+  {
+    std::vector<uint32_t> sorted = endpoint.samples;
+    size_t p95 = (sorted.size() * 95) / 100;
+    std::nth_element(sorted.begin(), sorted.begin() + p95, sorted.end());
+    delay = sorted[p95];
+  }
+  return std::max(delay, state.options.minHedgeDelayMs);
+}
+
+// Method name of a single request, empty for batches
+std::string RouterTransport::methodOf(ByteSpan request)
+{
+  if (request.size == 0 || request.data[0] != '{')
+  {
+    return "";
+  }
+  // The method comes right after the envelope's id
+  std::vector<std::string> methods = requestMethods(ByteSpan(request.data, std::min<size_t>(request.size, 256)));
+  return methods.empty() ? "" : methods.front();
+}
+
+// Run one attempt on the executor, buffering its reply into the race
+void RouterTransport::launch(std::shared_ptr<Race> race, size_t index)
+{
+  {
+    std::lock_guard<std::mutex> lock(race->mutex);
+    race->pending++;
+  }
+  std::shared_ptr<State> state = this->state;
+  std::shared_ptr<Transport> transport = state->endpoints[index].transport;
+  executor->submit([state, race, index, transport]
+                   {
+                     Clock::time_point start = Clock::now();
+                     RouterReply reply;
+                     bool succeeded = false;
+                     ByteSpan request(reinterpret_cast<const uint8_t *>(race->request.data()), race->request.size());
+                     bool ok = transport->post(request, [&reply, &succeeded](ResponseReader &reader)
+                                               {
+                                                 ScoredResponseReader scored(reader);
+                                                 char chunk[256];
+                                                 size_t count;
+                                                 while ((count = scored.readBytes(chunk, sizeof(chunk))) > 0)
+                                                 {
+                                                   reply.body.append(chunk, count);
+                                                 }
+                                                 reply.status = scored.status();
+                                                 reply.retryAfterMs = scored.retryAfterMs();
+                                                 succeeded = scored.succeeded();
+                                                 return true; }, race->context);
+                     auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+                     if (ok || !race->context.stopped())
+                     {
+                       record(*state, index, ok && succeeded, static_cast<uint32_t>(elapsed));
+                     }
+                     else
+                     {
+                       abandon(*state, index);
+                     }
+
+                     std::lock_guard<std::mutex> lock(race->mutex);
+                     race->pending--;
+                     if (ok && !race->won && (succeeded || !race->answered))
+                     {
+                       race->won = succeeded;
+                       race->answered = true;
+                       race->reply = std::move(reply);
+                     }
+                     race->finished.notify_all(); });
+}
+
+// Wait for the race to be decided or until passes, waking up regularly to
+// look at the call's cancellation token. Returns true once decided.
+bool RouterTransport::waitRace(std::unique_lock<std::mutex> &lock, Race &race, const RequestContext &context, Deadline until)
+{
+  auto decided = [&race]
+  { return race.won || race.pending == 0; };
+  while (!decided())
+  {
+    if (context.stopped() || until.expired())
+    {
+      return false;
+    }
+    uint32_t wait = until.remainingMs(context.token ? REQUEST_CONTEXT_POLL_MS : UINT32_MAX);
+    race.finished.wait_for(lock, std::chrono::milliseconds(wait), decided);
+  }
+  return true;
+}
+
+// Stream straight into the handler, failing over down the ranking only
+// while no response reached it. The handler may already have acted on a
+// body, e.g. passed streamed accounts on, so a second one is never fed to
+// it; a failed answer is returned for the caller to see its error.
+bool RouterTransport::postDirect(const std::vector<size_t> &order, ByteSpan request, const ResponseHandler &handler, const RequestContext &context)
+{
+  size_t attempts = std::min<size_t>(order.size(), 2);
+  bool ok = false;
+  for (size_t i = 0; i < attempts && !context.stopped(); ++i)
+  {
+    size_t index = order[i];
+    Clock::time_point start = Clock::now();
+    bool invoked = false;
+    bool succeeded = false;
+    ok = state->endpoints[index].transport->post(request, [&handler, &invoked, &succeeded](ResponseReader &body)
+                                                 {
+                                                   invoked = true;
+                                                   ScoredResponseReader scored(body);
+                                                   bool parsed = handler(scored);
+                                                   succeeded = scored.succeeded();
+                                                   return parsed; }, context);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+    if (!ok && context.stopped())
+    {
+      // Out of time, not the endpoint's fault
+      abandon(*state, index);
+      return false;
+    }
+    record(*state, index, ok && succeeded, static_cast<uint32_t>(elapsed));
+    if ((ok && succeeded) || invoked)
+    {
+      return ok;
+    }
+  }
+  return ok;
+}
+
+// Send to width endpoints at once, or with hedge set start with one and
+// add the next after its hedge delay, or sooner if the first one fails.
+// The first successful reply is handed on, else the first failed one.
+bool RouterTransport::postRace(const std::vector<size_t> &order, size_t width, bool hedge, ByteSpan request, const ResponseHandler &handler, const RequestContext &context)
+{
+  auto race = std::make_shared<Race>();
+  race->request.assign(reinterpret_cast<const char *>(request.data), request.size);
+  race->context.deadline = context.deadline;
+  race->context.token = CancellationToken();
+
+  std::unique_lock<std::mutex> lock(race->mutex);
+  size_t launched = 0;
+  if (hedge)
+  {
+    lock.unlock();
+    launch(race, order[launched++]);
+    lock.lock();
+    uint32_t delay = hedgeDelay(*state, order[0]);
+    waitRace(lock, *race, context, Deadline::earliest(Deadline::after(delay), context.deadline));
+    if (!race->won && launched < order.size() && !context.stopped())
+    {
+      lock.unlock();
+      launch(race, order[launched++]);
+      lock.lock();
+    }
+  }
+  else
+  {
+    lock.unlock();
+    while (launched < std::min(width, order.size()))
+    {
+      launch(race, order[launched++]);
+    }
+    lock.lock();
+  }
+
+  bool decided = waitRace(lock, *race, context, context.deadline);
+  // Losers and attempts outlived by the call give up and are not scored
+  race->context.token->cancel();
+  if (!decided || !race->answered)
+  {
+    return false;
+  }
+  RouterReply reply = std::move(race->reply);
+  lock.unlock();
+
+  StringResponseReader reader(reply.body, reply.status, reply.retryAfterMs);
+  return handler(reader);
+}
+
+bool RouterTransport::post(ByteSpan request, const ResponseHandler &handler)
+{
+  return post(request, handler, RequestContext());
+}
+
+bool RouterTransport::post(ByteSpan request, const ResponseHandler &handler, const RequestContext &context)
+{
+  if (context.stopped())
+  {
+    return false;
+  }
+  std::vector<size_t> order = rank(*state);
+  if (order.size() == 1)
+  {
+    return postDirect(order, request, handler, context);
+  }
+
+  const RouterOptions &options = state->options;
+  std::string method = methodOf(request);
+  if (method == "sendTransaction" && options.sendFanout > 1)
+  {
+    return postRace(order, options.sendFanout, false, request, handler, context);
+  }
+
+  bool hedged = options.hedgeReads && !method.empty() && method != "sendTransaction" &&
+                (options.hedgeMethods.empty() ||
+                 std::find(options.hedgeMethods.begin(), options.hedgeMethods.end(), method) != options.hedgeMethods.end());
+  if (hedged)
+  {
+    return postRace(order, 2, true, request, handler, context);
+  }
+  return postDirect(order, request, handler, context);
+}
+
+size_t RouterTransport::warmup()
+{
+  size_t ready = 0;
+  for (auto &endpoint : state->endpoints)
+  {
+    ready += endpoint.transport->warmup();
+  }
+  return ready;
+}
+
+size_t RouterTransport::maxConcurrency() const
+{
+  size_t total = 0;
+  for (const auto &endpoint : state->endpoints)
+  {
+    total += endpoint.transport->maxConcurrency();
+  }
+  return total;
+}
+
+std::vector<EndpointStats> RouterTransport::stats()
+{
+  std::lock_guard<std::mutex> lock(state->mutex);
+  std::vector<EndpointStats> result;
+  Clock::time_point now = Clock::now();
+  for (const auto &endpoint : state->endpoints)
+  {
+    EndpointStats stats;
+    stats.latencyMs = endpoint.latencyMs;
+    stats.errorRate = endpoint.errorRate;
+    stats.consecutiveFailures = endpoint.consecutiveFailures;
+    stats.circuitOpen = endpoint.consecutiveFailures >= state->options.failureThreshold && now < endpoint.openUntil;
+    result.push_back(stats);
+  }
+  return result;
+}
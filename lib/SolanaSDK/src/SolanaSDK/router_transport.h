@@ -0,0 +1,118 @@
+#ifndef ROUTER_TRANSPORT_H
+#define ROUTER_TRANSPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <mutex>
+#include "transport.h"
+#include "rpc_executor.h"
+
+struct RouterOptions
+{
+  // Weight of the newest sample in the latency and error averages
+  double ewmaAlpha = 0.2;
+  // Consecutive failures that open an endpoint's circuit
+  uint32_t failureThreshold = 3;
+  // How long an open circuit rejects calls before one probe is let through
+  uint32_t cooldownMs = 10000;
+  // Endpoints every sendTransaction is sent to at once
+  size_t sendFanout = 2;
+  // Send a duplicate read to the next best endpoint once the first one
+  // has taken longer than its p95 latency
+  bool hedgeReads = true;
+  uint32_t minHedgeDelayMs = 50;
+  // Methods that are hedged, empty hedges every method except sends
+  std::vector<std::string> hedgeMethods = {
+      "getLatestBlockhash",
+      "getBlockHeight",
+      "getBalance",
+      "getAccountInfo",
+      "getMultipleAccounts",
+      "getSignatureStatuses"};
+};
+
+// Latency and health of one endpoint as seen by the router
+struct EndpointStats
+{
+  double latencyMs;
+  double errorRate;
+  uint32_t consecutiveFailures;
+  bool circuitOpen;
+};
+
+// Transport over several RPC endpoints. Every call goes to the endpoint
+// with the best recent latency and error rate; failing endpoints are taken
+// out of rotation for a cooldown. Reads listed in hedgeMethods are raced
+// against a second endpoint when slow, and sendTransaction is fanned out.
+// An answer only counts as a success, and can only win a race, when its
+// status is 2xx and it carries no JSON-RPC "error" member.
+class RouterTransport : public Transport
+{
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Endpoint
+  {
+    std::shared_ptr<Transport> transport;
+    double latencyMs = 0;
+    double errorRate = 0;
+    uint32_t consecutiveFailures = 0;
+    Clock::time_point openUntil;
+    // True while the single probe of a half-open circuit is in flight
+    bool probing = false;
+    // Recent latencies for the hedge delay
+    std::vector<uint32_t> samples;
+    size_t nextSample = 0;
+  };
+
+  // Shared with racing requests that may outlive the call that started them
+  struct State
+  {
+    RouterOptions options;
+    std::vector<Endpoint> endpoints;
+    std::mutex mutex;
+  };
+
+  struct Race;
+
+  std::shared_ptr<State> state;
+  // Runs the attempts of hedged and fanned-out calls, one worker per
+  // connection the endpoints allow
+  std::unique_ptr<RpcExecutor> executor;
+
+  static std::vector<size_t> rank(State &state);
+  static void record(State &state, size_t index, bool ok, uint32_t latencyMs);
+  // Forget an attempt that was given up on, without scoring the endpoint
+  static void abandon(State &state, size_t index);
+  static uint32_t hedgeDelay(State &state, size_t index);
+  void launch(std::shared_ptr<Race> race, size_t index);
+  static bool waitRace(std::unique_lock<std::mutex> &lock, Race &race, const RequestContext &context, Deadline until);
+  static std::string methodOf(ByteSpan request);
+
+  bool postDirect(const std::vector<size_t> &order, ByteSpan request, const ResponseHandler &handler, const RequestContext &context);
+  bool postRace(const std::vector<size_t> &order, size_t width, bool hedge, ByteSpan request, const ResponseHandler &handler, const RequestContext &context);
+
+public:
+  RouterTransport(std::vector<std::shared_ptr<Transport>> endpoints, RouterOptions options = RouterOptions());
+
+  bool post(ByteSpan request, const ResponseHandler &handler) override;
+
+  // The context is passed to every endpoint tried; attempts it stops are
+  // not counted against the endpoint
+  bool post(ByteSpan request, const ResponseHandler &handler, const RequestContext &context) override;
+
+  size_t warmup() override;
+
+  size_t maxConcurrency() const override;
+
+  std::vector<EndpointStats> stats();
+
+  // Router over the platform default transport for each url
+  static std::shared_ptr<RouterTransport> forEndpoints(const std::vector<std::string> &urls, size_t maxConnections, RouterOptions options = RouterOptions());
+};
+
+#endif // ROUTER_TRANSPORT_H
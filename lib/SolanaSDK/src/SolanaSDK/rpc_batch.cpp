@@ -0,0 +1,209 @@
+#include <string>
+#include <vector>
+#include <optional>
+#include <functional>
+#include <exception>
+#include <stdexcept>
+#include <ArduinoJson.h>
+#include "rpc_batch.h"
+#include "connection.h"
+#include "base58.h"
+#include "rpc_request_writer.h"
+
+void RpcBatch::add(const std::string &method, RpcParamsWriter params, RpcResultHandler handler)
+{
+  calls.push_back(Call{0, method, params, handler});
+}
+
+void RpcBatch::dispatch(JsonArrayConst responses)
+{
+  std::vector<bool> answered(calls.size(), false);
+  // A throwing handler must not keep the others from their results, so the
+  // first exception is held until every call was answered
+  std::exception_ptr thrown;
+  auto deliver = [&thrown](Call &call, JsonVariantConst result, JsonVariantConst error)
+  {
+    try
+    {
+      call.handler(result, error);
+    }
+    catch (...)
+    {
+      if (!thrown)
+      {
+        thrown = std::current_exception();
+      }
+    }
+  };
+
+  for (JsonObjectConst response : responses)
+  {
+    uint32_t id = response["id"] | 0u;
+    for (size_t i = 0; i < calls.size(); ++i)
+    {
+      if (calls[i].id == id && !answered[i])
+      {
+        answered[i] = true;
+        deliver(calls[i], response["result"], response["error"]);
+        break;
+      }
+    }
+  }
+
+  // Calls the node did not answer are reported as failed
+  for (size_t i = 0; i < calls.size(); ++i)
+  {
+    if (!answered[i])
+    {
+      deliver(calls[i], JsonVariantConst(), JsonVariantConst());
+    }
+  }
+
+  if (thrown)
+  {
+    std::rethrow_exception(thrown);
+  }
+}
+
+void RpcBatch::fail()
+{
+  for (auto &call : calls)
+  {
+    call.handler(JsonVariantConst(), JsonVariantConst());
+  }
+}
+
+void RpcBatch::getLatestBlockhash(Commitment commitment, std::function<void(std::optional<BlockhashWithExpiryBlockHeight>)> callback)
+{
+  add(
+      "getLatestBlockhash",
+      [commitment](RpcRequestWriter &params)
+      {
+        params.beginObject().key("commitment").string(to_string(commitment)).endObject();
+      },
+      [callback](JsonVariantConst result, JsonVariantConst)
+      {
+        const char *blockhashString = result["value"]["blockhash"];
+        if (blockhashString == nullptr)
+        {
+          callback(std::nullopt);
+          return;
+        }
+        // A blockhash that does not decode to 32 bytes fails this call only
+        std::optional<BlockhashWithExpiryBlockHeight> blockhash;
+        try
+        {
+          blockhash = BlockhashWithExpiryBlockHeight{Hash::deserialize(Base58::decode(blockhashString)),
+                                                     result["value"]["lastValidBlockHeight"] | 0ULL};
+        }
+        catch (const std::invalid_argument &)
+        {
+        }
+        callback(blockhash);
+      });
+}
+
+void RpcBatch::getBlockHeight(Commitment commitment, std::function<void(std::optional<uint64_t>)> callback)
+{
+  add(
+      "getBlockHeight",
+      [commitment](RpcRequestWriter &params)
+      {
+        params.beginObject().key("commitment").string(to_string(commitment)).endObject();
+      },
+      [callback](JsonVariantConst result, JsonVariantConst)
+      {
+        if (!result.is<uint64_t>())
+        {
+          callback(std::nullopt);
+          return;
+        }
+        callback(result.as<uint64_t>());
+      });
+}
+
+void RpcBatch::getBalance(PublicKey publicKey, Commitment commitment, std::function<void(std::optional<uint64_t>)> callback)
+{
+  add(
+      "getBalance",
+      [publicKey, commitment](RpcRequestWriter &params) mutable
+      {
+        params.string(publicKey.toBase58());
+        params.beginObject().key("commitment").string(to_string(commitment)).endObject();
+      },
+      [callback](JsonVariantConst result, JsonVariantConst)
+      {
+        if (!result["value"].is<uint64_t>())
+        {
+          callback(std::nullopt);
+          return;
+        }
+        callback(result["value"].as<uint64_t>());
+      });
+}
+
+void RpcBatch::getSignatureStatuses(std::vector<Signature> signatures, std::function<void(std::vector<std::optional<SignatureStatus>>)> callback)
+{
+  getSignatureStatuses(signatures, false, callback);
+}
+
+void RpcBatch::getSignatureStatuses(std::vector<Signature> signatures, bool searchTransactionHistory, std::function<void(std::vector<std::optional<SignatureStatus>>)> callback)
+{
+  size_t count = signatures.size();
+  add(
+      "getSignatureStatuses",
+      [signatures, searchTransactionHistory](RpcRequestWriter &params)
+      {
+        params.beginArray();
+        for (const auto &signature : signatures)
+        {
+          params.string(signature.toString());
+        }
+        params.endArray();
+        if (searchTransactionHistory)
+        {
+          params.beginObject().key("searchTransactionHistory").boolean(true).endObject();
+        }
+      },
+      [callback, count](JsonVariantConst result, JsonVariantConst)
+      {
+        if (!result["value"].is<JsonArrayConst>())
+        {
+          callback({});
+          return;
+        }
+        std::vector<std::optional<SignatureStatus>> statuses(count);
+        size_t i = 0;
+        for (JsonVariantConst value : result["value"].as<JsonArrayConst>())
+        {
+          if (i >= count)
+          {
+            break;
+          }
+          if (!value.isNull())
+          {
+            SignatureStatus status;
+            status.slot = value["slot"] | 0ULL;
+            if (value["confirmations"].is<uint64_t>())
+            {
+              status.confirmations = value["confirmations"].as<uint64_t>();
+            }
+            status.failed = !value["err"].isNull();
+            status.confirmationStatus = commitmentFromString(value["confirmationStatus"]);
+            statuses[i] = status;
+          }
+          i++;
+        }
+        callback(statuses);
+      });
+}
+
+size_t RpcBatch::size() const
+{
+  return calls.size();
+}
+
+void RpcBatch::clear()
+{
+  calls.clear();
+}
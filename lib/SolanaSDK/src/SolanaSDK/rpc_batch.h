@@ -0,0 +1,64 @@
+#ifndef RPC_BATCH_H
+#define RPC_BATCH_H
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <functional>
+#include <ArduinoJson.h>
+#include "connection.h"
+#include "public_key.h"
+#include "signature.h"
+#include "rpc_request_writer.h"
+
+// Called with the "result" member of a response, or with a null result and
+// the "error" member when the call failed
+using RpcResultHandler = std::function<void(JsonVariantConst result, JsonVariantConst error)>;
+
+// Writes the elements of the "params" array of a request
+using RpcParamsWriter = std::function<void(RpcRequestWriter &params)>;
+
+// Several JSON-RPC calls sent together as one array by Connection::sendBatch.
+// Responses are matched back to their call by id, in any order.
+class RpcBatch
+{
+private:
+  friend class Connection;
+
+  struct Call
+  {
+    uint32_t id;
+    std::string method;
+    RpcParamsWriter params;
+    RpcResultHandler handler;
+  };
+
+  std::vector<Call> calls;
+
+  void dispatch(JsonArrayConst responses);
+  void fail();
+
+public:
+  // Queue any RPC method
+  void add(const std::string &method, RpcParamsWriter params, RpcResultHandler handler);
+
+  void getLatestBlockhash(Commitment commitment, std::function<void(std::optional<BlockhashWithExpiryBlockHeight>)> callback);
+
+  void getBlockHeight(Commitment commitment, std::function<void(std::optional<uint64_t>)> callback);
+
+  void getBalance(PublicKey publicKey, Commitment commitment, std::function<void(std::optional<uint64_t>)> callback);
+
+  // Statuses come back in the same order as signatures, empty if unknown.
+  // The callback gets an empty vector if the call itself failed.
+  void getSignatureStatuses(std::vector<Signature> signatures, std::function<void(std::vector<std::optional<SignatureStatus>>)> callback);
+
+  // With searchTransactionHistory set the node also looks past its recent
+  // status cache, so a transaction that landed long ago is still found
+  void getSignatureStatuses(std::vector<Signature> signatures, bool searchTransactionHistory, std::function<void(std::vector<std::optional<SignatureStatus>>)> callback);
+
+  size_t size() const;
+
+  void clear();
+};
+
+#endif // RPC_BATCH_H
@@ -0,0 +1,77 @@
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "rpc_executor.h"
+
+RpcExecutor::RpcExecutor(size_t workers) : workerCount(std::max<size_t>(workers, 1)) {}
+
+RpcExecutor::~RpcExecutor()
+{
+  stop();
+}
+
+void RpcExecutor::post(std::function<void()> task)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!running && workers.empty())
+    {
+      running = true;
+      for (size_t i = 0; i < workerCount; ++i)
+      {
+        workers.emplace_back(&RpcExecutor::run, this);
+      }
+    }
+    tasks.push_back(std::move(task));
+  }
+  wake.notify_one();
+}
+
+void RpcExecutor::run()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true)
+  {
+    wake.wait(lock, [this]
+              { return !running || !tasks.empty(); });
+    if (tasks.empty())
+    {
+      break;
+    }
+    std::function<void()> task = std::move(tasks.front());
+    tasks.pop_front();
+    lock.unlock();
+    task();
+    // Drop captured state before taking the lock again
+    task = nullptr;
+    lock.lock();
+  }
+}
+
+size_t RpcExecutor::pending()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return tasks.size();
+}
+
+void RpcExecutor::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    running = false;
+  }
+  wake.notify_all();
+  for (auto &worker : workers)
+  {
+    if (worker.joinable())
+    {
+      worker.join();
+    }
+  }
+  workers.clear();
+}
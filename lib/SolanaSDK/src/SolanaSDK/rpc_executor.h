@@ -0,0 +1,57 @@
+#ifndef RPC_EXECUTOR_H
+#define RPC_EXECUTOR_H
+
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <future>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+// Event loop behind the asynchronous Connection methods: a fixed set of
+// worker threads running queued RPC calls. Threads are only created once
+// the first task is submitted. Tasks must not own the executor, as it
+// cannot be destroyed from one of its own workers.
+class RpcExecutor
+{
+private:
+  size_t workerCount;
+  std::vector<std::thread> workers;
+  std::deque<std::function<void()>> tasks;
+  bool running = false;
+  std::mutex mutex;
+  std::condition_variable wake;
+
+  void run();
+  void post(std::function<void()> task);
+
+public:
+  RpcExecutor(size_t workers = 1);
+
+  // Finishes queued tasks, then joins the workers
+  ~RpcExecutor();
+
+  RpcExecutor(const RpcExecutor &) = delete;
+  RpcExecutor &operator=(const RpcExecutor &) = delete;
+
+  // Queue task and return a future for its result or exception
+  template <typename F>
+  auto submit(F task) -> std::future<decltype(task())>
+  {
+    using Result = decltype(task());
+    auto packaged = std::make_shared<std::packaged_task<Result()>>(std::move(task));
+    std::future<Result> future = packaged->get_future();
+    post([packaged]
+         { (*packaged)(); });
+    return future;
+  }
+
+  size_t pending();
+
+  void stop();
+};
+
+#endif // RPC_EXECUTOR_H
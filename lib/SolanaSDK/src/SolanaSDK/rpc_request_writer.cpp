@@ -0,0 +1,189 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <stdexcept>
+#include "rpc_request_writer.h"
+#include "base64.h"
+
+RpcRequestWriter::RpcRequestWriter(std::string &out, size_t reserve) : out(out)
+{
+  out.reserve(out.size() + reserve);
+}
+
+void RpcRequestWriter::separator()
+{
+  if (afterKey)
+  {
+    afterKey = false;
+    return;
+  }
+  if (depth == 0)
+  {
+    return;
+  }
+  uint32_t bit = 1u << (depth - 1);
+  if (hasItems & bit)
+  {
+    out.push_back(',');
+  }
+  hasItems |= bit;
+}
+
+void RpcRequestWriter::open(char bracket)
+{
+  if (depth >= 32)
+  {
+    throw std::runtime_error("JSON nesting too deep");
+  }
+  separator();
+  out.push_back(bracket);
+  depth++;
+  hasItems &= ~(1u << (depth - 1));
+}
+
+void RpcRequestWriter::close(char bracket)
+{
+  if (depth == 0)
+  {
+    throw std::runtime_error("Unbalanced JSON container");
+  }
+  depth--;
+  out.push_back(bracket);
+}
+
+void RpcRequestWriter::quoted(const char *value, size_t length)
+{
+  static const char HEX_DIGITS[] = "0123456789abcdef";
+  out.push_back('"');
+  for (size_t i = 0; i < length; ++i)
+  {
+    char c = value[i];
+    if (c == '"' || c == '\\')
+    {
+      out.push_back('\\');
+      out.push_back(c);
+    }
+    else if (static_cast<unsigned char>(c) < 0x20)
+    {
+      out.append("\\u00");
+      out.push_back(HEX_DIGITS[(c >> 4) & 0x0F]);
+      out.push_back(HEX_DIGITS[c & 0x0F]);
+    }
+    else
+    {
+      out.push_back(c);
+    }
+  }
+  out.push_back('"');
+}
+
+RpcRequestWriter &RpcRequestWriter::beginRequest(uint32_t id, const char *method)
+{
+  beginObject();
+  key("jsonrpc").string("2.0");
+  key("id").number(id);
+  key("method").string(method);
+  key("params").beginArray();
+  return *this;
+}
+
+RpcRequestWriter &RpcRequestWriter::endRequest()
+{
+  endArray();
+  return endObject();
+}
+
+RpcRequestWriter &RpcRequestWriter::beginArray()
+{
+  open('[');
+  return *this;
+}
+
+RpcRequestWriter &RpcRequestWriter::endArray()
+{
+  close(']');
+  return *this;
+}
+
+RpcRequestWriter &RpcRequestWriter::beginObject()
+{
+  open('{');
+  return *this;
+}
+
+RpcRequestWriter &RpcRequestWriter::endObject()
+{
+  close('}');
+  return *this;
+}
+
+RpcRequestWriter &RpcRequestWriter::key(const char *name)
+{
+  separator();
+  quoted(name, strlen(name));
+  out.push_back(':');
+  afterKey = true;
+  return *this;
+}
+
+RpcRequestWriter &RpcRequestWriter::string(const char *value)
+{
+  separator();
+  quoted(value, strlen(value));
+  return *this;
+}
+
+RpcRequestWriter &RpcRequestWriter::string(const std::string &value)
+{
+  separator();
+  quoted(value.data(), value.size());
+  return *this;
+}
+
+RpcRequestWriter &RpcRequestWriter::number(uint64_t value)
+{
+  separator();
+  char digits[20];
+  size_t length = 0;
+  do
+  {
+    digits[length++] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value > 0);
+  while (length > 0)
+  {
+    out.push_back(digits[--length]);
+  }
+  return *this;
+}
+
+RpcRequestWriter &RpcRequestWriter::boolean(bool value)
+{
+  separator();
+  out.append(value ? "true" : "false");
+  return *this;
+}
+
+RpcRequestWriter &RpcRequestWriter::null()
+{
+  separator();
+  out.append("null");
+  return *this;
+}
+
+RpcRequestWriter &RpcRequestWriter::base64(const uint8_t *data, size_t length)
+{
+  separator();
+  out.push_back('"');
+  size_t start = out.size();
+  out.resize(start + Base64::encodedLength(length));
+  Base64::encode(data, length, &out[start]);
+  out.push_back('"');
+  return *this;
+}
+
+RpcRequestWriter &RpcRequestWriter::base64(const std::vector<uint8_t> &data)
+{
+  return base64(data.data(), data.size());
+}
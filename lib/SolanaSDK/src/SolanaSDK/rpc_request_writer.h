@@ -0,0 +1,56 @@
+#ifndef RPC_REQUEST_WRITER_H
+#define RPC_REQUEST_WRITER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Writes JSON-RPC requests directly into a string buffer, without building
+// a JSON document first. Commas are inserted automatically, so values are
+// emitted in order:
+//
+//   writer.beginRequest(id, "getBalance");
+//   writer.string(publicKey.toBase58());
+//   writer.beginObject().key("commitment").string("finalized").endObject();
+//   writer.endRequest();
+class RpcRequestWriter
+{
+private:
+  std::string &out;
+  // Bit n is set once the container at depth n has an element
+  uint32_t hasItems = 0;
+  uint8_t depth = 0;
+  bool afterKey = false;
+
+  void separator();
+  void open(char bracket);
+  void close(char bracket);
+  void quoted(const char *value, size_t length);
+
+public:
+  // Appends to out, reserving room for reserve more bytes
+  explicit RpcRequestWriter(std::string &out, size_t reserve = 0);
+
+  // Open the request envelope, leaving the writer inside "params"
+  RpcRequestWriter &beginRequest(uint32_t id, const char *method);
+  RpcRequestWriter &endRequest();
+
+  RpcRequestWriter &beginArray();
+  RpcRequestWriter &endArray();
+  RpcRequestWriter &beginObject();
+  RpcRequestWriter &endObject();
+
+  RpcRequestWriter &key(const char *name);
+
+  RpcRequestWriter &string(const char *value);
+  RpcRequestWriter &string(const std::string &value);
+  RpcRequestWriter &number(uint64_t value);
+  RpcRequestWriter &boolean(bool value);
+  RpcRequestWriter &null();
+
+  // Encode bytes as a JSON string in place, with no intermediate copy
+  RpcRequestWriter &base64(const uint8_t *data, size_t length);
+  RpcRequestWriter &base64(const std::vector<uint8_t> &data);
+};
+
+#endif // RPC_REQUEST_WRITER_H
@@ -0,0 +1,274 @@
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <mutex>
+#include <condition_variable>
+#include "scheduler_transport.h"
+
+// Longest a queued call sleeps before looking at the buckets again; grants
+// and releases wake it sooner
+constexpr uint32_t SCHEDULER_MAX_WAIT_MS = 1000;
+
+SchedulerTransport::Bucket::Bucket(RateLimit limit) : limit(limit), refilled(Clock::now())
+{
+  if (this->limit.perSecond > 0)
+  {
+    this->limit.burst = std::max(this->limit.burst, 1.0);
+  }
+  tokens = this->limit.burst;
+}
+
+void SchedulerTransport::Bucket::refill(Clock::time_point now)
+{
+  if (limit.perSecond <= 0)
+  {
+    return;
+  }
+  double elapsed = std::chrono::duration<double>(now - refilled).count();
+  tokens = std::min(limit.burst, tokens + elapsed * limit.perSecond);
+  refilled = now;
+}
+
+// A batch larger than the burst goes through once the bucket is full and
+// leaves it in debt
+bool SchedulerTransport::Bucket::available(double cost) const
+{
+  return limit.perSecond <= 0 || tokens >= std::min(cost, limit.burst);
+}
+
+SchedulerTransport::Clock::duration SchedulerTransport::Bucket::wait(double cost) const
+{
+  double needed = std::min(cost, limit.burst) - tokens;
+  if (limit.perSecond <= 0 || needed <= 0)
+  {
+    return Clock::duration::zero();
+  }
+  return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(needed / limit.perSecond));
+}
+
+void SchedulerTransport::Bucket::take(double cost)
+{
+  if (limit.perSecond > 0)
+  {
+    tokens -= cost;
+  }
+}
+
+SchedulerTransport::SchedulerTransport(std::shared_ptr<Transport> inner, SchedulerOptions options)
+    : inner(inner), options(options), endpoint(options.endpointLimit)
+{
+  if (!inner)
+  {
+    throw std::invalid_argument("SchedulerTransport needs a transport");
+  }
+  maxInFlight = options.maxInFlight > 0 ? options.maxInFlight : inner->maxConcurrency();
+}
+
+SchedulerTransport::Bucket &SchedulerTransport::methodBucket(const std::string &method)
+{
+  auto found = methods.find(method);
+  if (found == methods.end())
+  {
+    auto limit = options.methodLimits.find(method);
+    found = methods.emplace(method, Bucket(limit != options.methodLimits.end() ? limit->second : options.methodLimit)).first;
+  }
+  return found->second;
+}
+
+RpcPriority SchedulerTransport::priorityOf(const std::vector<std::string> &names) const
+{
+  RpcPriority priority = RpcPriority::read;
+  for (const auto &name : names)
+  {
+    auto found = options.priorities.find(name);
+    if (found != options.priorities.end() && found->second < priority)
+    {
+      priority = found->second;
+    }
+  }
+  return priority;
+}
+
+// Calls are let through in queue order. One that is out of method tokens
+// is skipped so other methods can go ahead; one that is out of endpoint
+// tokens holds back everything behind it.
+SchedulerTransport::Clock::time_point SchedulerTransport::dispatch(Clock::time_point now)
+{
+  if (now < pausedUntil)
+  {
+    return pausedUntil;
+  }
+  Clock::time_point next = Clock::time_point::max();
+  endpoint.refill(now);
+  bool granted = false;
+  for (auto &entry : queue)
+  {
+    Waiter &waiter = *entry.second;
+    if (waiter.granted)
+    {
+      continue;
+    }
+    if (inFlight >= maxInFlight)
+    {
+      // release() dispatches again
+      break;
+    }
+    if (!endpoint.available(waiter.calls))
+    {
+      next = std::min(next, now + endpoint.wait(waiter.calls));
+      break;
+    }
+    bool ready = true;
+    for (const auto &method : waiter.methods)
+    {
+      Bucket &bucket = methodBucket(method.first);
+      bucket.refill(now);
+      if (!bucket.available(method.second))
+      {
+        next = std::min(next, now + bucket.wait(method.second));
+        ready = false;
+      }
+    }
+    if (!ready)
+    {
+      continue;
+    }
+    endpoint.take(waiter.calls);
+    for (const auto &method : waiter.methods)
+    {
+      methodBucket(method.first).take(method.second);
+    }
+    waiter.granted = true;
+    inFlight++;
+    granted = true;
+  }
+  if (granted)
+  {
+    changed.notify_all();
+  }
+  return next;
+}
+
+bool SchedulerTransport::acquire(std::pair<int, uint64_t> ticket, Waiter &waiter, const RequestContext &context)
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  queue[ticket] = &waiter;
+  while (true)
+  {
+    Clock::time_point now = Clock::now();
+    Clock::time_point next = dispatch(now);
+    if (waiter.granted)
+    {
+      queue.erase(ticket);
+      return true;
+    }
+    if (context.stopped())
+    {
+      queue.erase(ticket);
+      // It may have been holding back the calls behind it
+      changed.notify_all();
+      return false;
+    }
+    uint32_t limitMs = context.deadline.remainingMs(context.token ? REQUEST_CONTEXT_POLL_MS : SCHEDULER_MAX_WAIT_MS);
+    Clock::duration wait = std::min<Clock::duration>(next - now, std::chrono::milliseconds(limitMs));
+    changed.wait_for(lock, wait);
+  }
+}
+
+void SchedulerTransport::release()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  inFlight--;
+  dispatch(Clock::now());
+}
+
+bool SchedulerTransport::post(ByteSpan request, const ResponseHandler &handler)
+{
+  return post(request, handler, RequestContext());
+}
+
+bool SchedulerTransport::post(ByteSpan request, const ResponseHandler &handler, const RequestContext &context)
+{
+  if (context.stopped())
+  {
+    return false;
+  }
+  std::vector<std::string> names = requestMethods(request);
+  Waiter waiter;
+  for (const auto &name : names)
+  {
+    waiter.methods[name]++;
+  }
+  waiter.calls = std::max<size_t>(names.size(), 1);
+
+  std::pair<int, uint64_t> ticket;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    ticket = std::make_pair(static_cast<int>(priorityOf(names)), nextTicket++);
+  }
+
+  for (uint32_t attempt = 0;; ++attempt)
+  {
+    waiter.granted = false;
+    if (!acquire(ticket, waiter, context))
+    {
+      return false;
+    }
+
+    bool limited = false;
+    uint32_t retryAfterMs = 0;
+    bool ok = inner->post(request, [&handler, &limited, &retryAfterMs](ResponseReader &body)
+                          {
+                            if (body.status() == 429)
+                            {
+                              limited = true;
+                              retryAfterMs = body.retryAfterMs();
+                              return false;
+                            }
+                            return handler(body); }, context);
+    if (limited)
+    {
+      // Pause before the slot is released so nothing else goes out first
+      std::lock_guard<std::mutex> lock(mutex);
+      throttled++;
+      uint32_t pauseMs = retryAfterMs > 0 ? retryAfterMs : options.throttleBackoffMs;
+      pausedUntil = std::max(pausedUntil, Clock::now() + std::chrono::milliseconds(pauseMs));
+    }
+    release();
+    if (!limited)
+    {
+      return ok;
+    }
+    if (attempt >= options.maxThrottleRetries)
+    {
+      return false;
+    }
+    // Queued again with the original ticket, ahead of later calls
+  }
+}
+
+size_t SchedulerTransport::warmup()
+{
+  return inner->warmup();
+}
+
+size_t SchedulerTransport::maxConcurrency() const
+{
+  return maxInFlight;
+}
+
+SchedulerStats SchedulerTransport::stats()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  SchedulerStats stats;
+  stats.queued = queue.size();
+  stats.inFlight = inFlight;
+  stats.throttled = throttled;
+  return stats;
+}
@@ -0,0 +1,138 @@
+#ifndef SCHEDULER_TRANSPORT_H
+#define SCHEDULER_TRANSPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include "transport.h"
+
+// Token bucket refilled at perSecond up to burst tokens; perSecond 0 means
+// no limit
+struct RateLimit
+{
+  double perSecond = 0;
+  double burst = 0;
+};
+
+// Order in which queued calls are let through, most urgent first
+enum class RpcPriority
+{
+  send = 0,
+  confirmation = 1,
+  read = 2
+};
+
+// Defaults follow the published limits of the public mainnet-beta
+// endpoint: 100 requests per 10 s per IP, 40 per 10 s for a single method
+struct SchedulerOptions
+{
+  RateLimit endpointLimit = {10, 100};
+  // Applied to every method not listed in methodLimits
+  RateLimit methodLimit = {4, 40};
+  std::map<std::string, RateLimit> methodLimits;
+  // Methods not listed are background reads. A batch takes the priority
+  // of its most urgent call.
+  std::map<std::string, RpcPriority> priorities = {
+      {"sendTransaction", RpcPriority::send},
+      {"getSignatureStatuses", RpcPriority::confirmation},
+      {"getBlockHeight", RpcPriority::confirmation}};
+  // Calls passed to the inner transport at once, 0 for its maxConcurrency
+  size_t maxInFlight = 0;
+  // Pause after a 429 without a usable Retry-After
+  uint32_t throttleBackoffMs = 1000;
+  // Times a throttled call is queued again before it fails
+  uint32_t maxThrottleRetries = 2;
+};
+
+struct SchedulerStats
+{
+  size_t queued;
+  size_t inFlight;
+  // 429 responses seen so far
+  uint64_t throttled;
+};
+
+// Transport in front of a single endpoint that keeps calls within the
+// provider's quotas. Each call takes one token per JSON-RPC request from
+// the endpoint bucket and from its method's bucket; calls wait in a queue
+// ordered by RpcPriority, so sends go out ahead of confirmation polling
+// and background reads when tokens or sockets are short. An HTTP 429
+// pauses the endpoint for its Retry-After and the call is queued again.
+//
+// With several endpoints give each its own scheduler under a
+// RouterTransport, so a throttled endpoint fails over:
+//   RouterTransport router({std::make_shared<SchedulerTransport>(Transport::forEndpoint(url, 2)), ...});
+class SchedulerTransport : public Transport
+{
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Bucket
+  {
+    RateLimit limit;
+    double tokens;
+    Clock::time_point refilled;
+
+    Bucket(RateLimit limit);
+    void refill(Clock::time_point now);
+    bool available(double cost) const;
+    // Time until cost tokens are available
+    Clock::duration wait(double cost) const;
+    void take(double cost);
+  };
+
+  struct Waiter
+  {
+    // Calls per method in the request
+    std::map<std::string, size_t> methods;
+    size_t calls;
+    bool granted = false;
+  };
+
+  std::shared_ptr<Transport> inner;
+  SchedulerOptions options;
+  size_t maxInFlight;
+  std::mutex mutex;
+  std::condition_variable changed;
+  Bucket endpoint;
+  std::map<std::string, Bucket> methods;
+  // Ordered by priority, then arrival
+  std::map<std::pair<int, uint64_t>, Waiter *> queue;
+  uint64_t nextTicket = 0;
+  size_t inFlight = 0;
+  Clock::time_point pausedUntil;
+  uint64_t throttled = 0;
+
+  Bucket &methodBucket(const std::string &method);
+  RpcPriority priorityOf(const std::vector<std::string> &methods) const;
+  // Grant tokens to queued calls in order, returns when to look again
+  Clock::time_point dispatch(Clock::time_point now);
+  // Wait for the call's turn, false if the context stopped first
+  bool acquire(std::pair<int, uint64_t> ticket, Waiter &waiter, const RequestContext &context);
+  void release();
+
+public:
+  SchedulerTransport(std::shared_ptr<Transport> inner, SchedulerOptions options = SchedulerOptions());
+
+  SchedulerTransport(const SchedulerTransport &) = delete;
+  SchedulerTransport &operator=(const SchedulerTransport &) = delete;
+
+  bool post(ByteSpan request, const ResponseHandler &handler) override;
+
+  // Time spent queued counts against the context's deadline
+  bool post(ByteSpan request, const ResponseHandler &handler, const RequestContext &context) override;
+
+  size_t warmup() override;
+
+  size_t maxConcurrency() const override;
+
+  SchedulerStats stats();
+};
+
+#endif // SCHEDULER_TRANSPORT_H
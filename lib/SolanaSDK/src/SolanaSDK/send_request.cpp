@@ -1,11 +1,16 @@
+#if defined(ARDUINO)
+
 #include <WiFi.h>
 #include <HTTPClient.h>
+#include "send_request.h"
 
-bool sendHttpRequest(const char *url, const String &requestData, String &response)
+bool sendHttpRequest(const char *url, const String &requestData, String &response, uint32_t timeoutMs)
 {
   if (WiFi.status() == WL_CONNECTED)
   {
     HTTPClient http;
+    http.setConnectTimeout(static_cast<int32_t>(timeoutMs));
+    http.setTimeout(static_cast<uint16_t>(timeoutMs > UINT16_MAX ? UINT16_MAX : timeoutMs));
     http.begin(url);
 
     int httpResponseCode = http.POST(requestData);
@@ -14,7 +19,6 @@ bool sendHttpRequest(const char *url, const String &requestData, String &respons
     {
       response = http.getString();
       http.end();
-      Serial.println(response);
       return true;
     }
     else
@@ -31,3 +35,5 @@ bool sendHttpRequest(const char *url, const String &requestData, String &respons
     return false;
   }
 }
+
+#endif // ARDUINO
@@ -1,9 +1,16 @@
 #ifndef SEND_REQUEST_H
 #define SEND_REQUEST_H
 
+#if defined(ARDUINO)
+
 #include <WiFi.h>
 #include <HTTPClient.h>
 
-bool sendHttpRequest(const char *url, const String &requestData, String &response);
+// Connect and read timeout of sendHttpRequest
+constexpr uint32_t SEND_REQUEST_DEFAULT_TIMEOUT_MS = 5000;
+
+bool sendHttpRequest(const char *url, const String &requestData, String &response, uint32_t timeoutMs = SEND_REQUEST_DEFAULT_TIMEOUT_MS);
+
+#endif // ARDUINO
 
 #endif // SEND_REQUEST_H
\ No newline at end of file
@@ -0,0 +1,392 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include "sha256.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SHA256_X86_SHANI 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__linux__) && (defined(__GNUC__) || defined(__clang__))
+#define SHA256_ARMV8_CE 1
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+const uint32_t SHA256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+const uint32_t SHA256_IV[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+void Sha256Backend::init(Sha256State &state) const
+{
+    std::memcpy(state.h, SHA256_IV, sizeof(state.h));
+    state.bufferLen = 0;
+    state.totalLen = 0;
+}
+
+void Sha256Backend::update(Sha256State &state, const uint8_t *data, size_t len) const
+{
+    state.totalLen += len;
+
+    if (state.bufferLen > 0)
+    {
+        size_t take = std::min(len, SHA256_BLOCK_BYTES - state.bufferLen);
+        std::memcpy(state.buffer + state.bufferLen, data, take);
+        state.bufferLen += take;
+        data += take;
+        len -= take;
+        if (state.bufferLen < SHA256_BLOCK_BYTES)
+        {
+            return;
+        }
+        compress(state.h, state.buffer, 1);
+        state.bufferLen = 0;
+    }
+
+    // Feed whole blocks straight from the caller's buffer
+    size_t blocks = len / SHA256_BLOCK_BYTES;
+    if (blocks > 0)
+    {
+        compress(state.h, data, blocks);
+        data += blocks * SHA256_BLOCK_BYTES;
+        len -= blocks * SHA256_BLOCK_BYTES;
+    }
+
+    std::memcpy(state.buffer, data, len);
+    state.bufferLen = len;
+}
+
+void Sha256Backend::finish(Sha256State &state, uint8_t out[SHA256_DIGEST_BYTES]) const
+{
+    uint64_t bitLen = state.totalLen * 8;
+
+    state.buffer[state.bufferLen++] = 0x80;
+    if (state.bufferLen > SHA256_BLOCK_BYTES - 8)
+    {
+        std::memset(state.buffer + state.bufferLen, 0, SHA256_BLOCK_BYTES - state.bufferLen);
+        compress(state.h, state.buffer, 1);
+        state.bufferLen = 0;
+    }
+    std::memset(state.buffer + state.bufferLen, 0, SHA256_BLOCK_BYTES - 8 - state.bufferLen);
+    for (size_t i = 0; i < 8; ++i)
+    {
+        state.buffer[SHA256_BLOCK_BYTES - 1 - i] = static_cast<uint8_t>(bitLen >> (8 * i));
+    }
+    compress(state.h, state.buffer, 1);
+
+    for (size_t i = 0; i < 8; ++i)
+    {
+        out[4 * i] = static_cast<uint8_t>(state.h[i] >> 24);
+        out[4 * i + 1] = static_cast<uint8_t>(state.h[i] >> 16);
+        out[4 * i + 2] = static_cast<uint8_t>(state.h[i] >> 8);
+        out[4 * i + 3] = static_cast<uint8_t>(state.h[i]);
+    }
+}
+
+bool Sha256Backend::selfTest() const
+{
+    // FIPS 180-2 "abc" and the two block message
+    static const uint8_t ABC_DIGEST[SHA256_DIGEST_BYTES] = {
+        0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+        0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad};
+    static const uint8_t LONG_DIGEST[SHA256_DIGEST_BYTES] = {
+        0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8, 0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39,
+        0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67, 0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1};
+    static const char LONG_MESSAGE[] = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+
+    uint8_t digest[SHA256_DIGEST_BYTES];
+    Sha256State state;
+
+    init(state);
+    update(state, reinterpret_cast<const uint8_t *>("abc"), 3);
+    finish(state, digest);
+    if (std::memcmp(digest, ABC_DIGEST, SHA256_DIGEST_BYTES) != 0)
+    {
+        return false;
+    }
+
+    init(state);
+    update(state, reinterpret_cast<const uint8_t *>(LONG_MESSAGE), sizeof(LONG_MESSAGE) - 1);
+    finish(state, digest);
+    return std::memcmp(digest, LONG_DIGEST, SHA256_DIGEST_BYTES) == 0;
+}
+
+static inline uint32_t rotr(uint32_t x, int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+// Portable FIPS 180-4 compression function
+class SoftwareSha256 : public Sha256Backend
+{
+public:
+    const char *name() const override { return "software"; }
+
+    void compress(uint32_t state[8], const uint8_t *blocks, size_t numBlocks) const override
+    {
+        uint32_t w[64];
+        for (size_t block = 0; block < numBlocks; ++block, blocks += SHA256_BLOCK_BYTES)
+        {
+            for (size_t i = 0; i < 16; ++i)
+            {
+                w[i] = (static_cast<uint32_t>(blocks[4 * i]) << 24) | (static_cast<uint32_t>(blocks[4 * i + 1]) << 16) |
+                       (static_cast<uint32_t>(blocks[4 * i + 2]) << 8) | static_cast<uint32_t>(blocks[4 * i + 3]);
+            }
+            for (size_t i = 16; i < 64; ++i)
+            {
+                uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+
+            uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+            uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+            for (size_t i = 0; i < 64; ++i)
+            {
+                uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+                uint32_t ch = (e & f) ^ (~e & g);
+                uint32_t t1 = h + s1 + ch + SHA256_K[i] + w[i];
+                uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+                uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+                uint32_t t2 = s0 + maj;
+                h = g;
+                g = f;
+                f = e;
+                e = d + t1;
+                d = c;
+                c = b;
+                b = a;
+                a = t1 + t2;
+            }
+            state[0] += a;
+            state[1] += b;
+            state[2] += c;
+            state[3] += d;
+            state[4] += e;
+            state[5] += f;
+            state[6] += g;
+            state[7] += h;
+        }
+    }
+};
+
+#if defined(SHA256_X86_SHANI)
+// Intel SHA extensions
+class ShaNiSha256 : public Sha256Backend
+{
+public:
+    const char *name() const override { return "sha-ni"; }
+
+    static bool supported()
+    {
+        unsigned int eax, ebx, ecx, edx;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_SSE4_1) || !(ecx & bit_SSSE3))
+        {
+            return false;
+        }
+        if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+        {
+            return false;
+        }
+        return (ebx & (1u << 29)) != 0;
+    }
+
+    __attribute__((target("sha,sse4.1,ssse3"))) void compress(uint32_t state[8], const uint8_t *blocks, size_t numBlocks) const override
+    {
+        const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+        // Rearrange ABCD EFGH into the ABEF CDGH layout used by sha256rnds2
+        __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(&state[0])), 0xB1);
+        __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(&state[4])), 0x1B);
+        __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+        state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+        for (size_t block = 0; block < numBlocks; ++block, blocks += SHA256_BLOCK_BYTES)
+        {
+            __m128i abefSave = state0;
+            __m128i cdghSave = state1;
+            __m128i msg[4];
+
+            for (size_t i = 0; i < 16; ++i)
+            {
+                if (i < 4)
+                {
+                    msg[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(blocks + 16 * i)), byteSwap);
+                }
+                else
+                {
+                    // W[i..i+3] from the four previous schedule vectors
+                    __m128i m = _mm_sha256msg1_epu32(msg[i % 4], msg[(i + 1) % 4]);
+                    m = _mm_add_epi32(m, _mm_alignr_epi8(msg[(i + 3) % 4], msg[(i + 2) % 4], 4));
+                    msg[i % 4] = _mm_sha256msg2_epu32(m, msg[(i + 3) % 4]);
+                }
+
+                __m128i wk = _mm_add_epi32(msg[i % 4], _mm_loadu_si128(reinterpret_cast<const __m128i *>(&SHA256_K[4 * i])));
+                state1 = _mm_sha256rnds2_epu32(state1, state0, wk);
+                state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(wk, 0x0E));
+            }
+
+            state0 = _mm_add_epi32(state0, abefSave);
+            state1 = _mm_add_epi32(state1, cdghSave);
+        }
+
+        tmp = _mm_shuffle_epi32(state0, 0x1B);
+        state1 = _mm_shuffle_epi32(state1, 0xB1);
+        state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+        state1 = _mm_alignr_epi8(state1, tmp, 8);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&state[0]), state0);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&state[4]), state1);
+    }
+};
+#endif
+
+#if defined(SHA256_ARMV8_CE)
+// ARMv8 cryptography extensions
+class ArmV8Sha256 : public Sha256Backend
+{
+public:
+    const char *name() const override { return "armv8-ce"; }
+
+    static bool supported()
+    {
+        return (getauxval(AT_HWCAP) & HWCAP_SHA2) != 0;
+    }
+
+    __attribute__((target("+crypto"))) void compress(uint32_t state[8], const uint8_t *blocks, size_t numBlocks) const override
+    {
+        uint32x4_t state0 = vld1q_u32(&state[0]);
+        uint32x4_t state1 = vld1q_u32(&state[4]);
+
+        for (size_t block = 0; block < numBlocks; ++block, blocks += SHA256_BLOCK_BYTES)
+        {
+            uint32x4_t abcdSave = state0;
+            uint32x4_t efghSave = state1;
+            uint32x4_t msg[4];
+            for (size_t i = 0; i < 4; ++i)
+            {
+                msg[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks + 16 * i)));
+            }
+
+            for (size_t i = 0; i < 16; ++i)
+            {
+                uint32x4_t wk = vaddq_u32(msg[i % 4], vld1q_u32(&SHA256_K[4 * i]));
+                if (i < 12)
+                {
+                    // Schedule W[i+16..i+19] into the slot just consumed
+                    msg[i % 4] = vsha256su1q_u32(vsha256su0q_u32(msg[i % 4], msg[(i + 1) % 4]), msg[(i + 2) % 4], msg[(i + 3) % 4]);
+                }
+                uint32x4_t abcd = state0;
+                state0 = vsha256hq_u32(state0, state1, wk);
+                state1 = vsha256h2q_u32(state1, abcd, wk);
+            }
+
+            state0 = vaddq_u32(state0, abcdSave);
+            state1 = vaddq_u32(state1, efghSave);
+        }
+
+        vst1q_u32(&state[0], state0);
+        vst1q_u32(&state[4], state1);
+    }
+};
+#endif
+
+#if defined(ESP_PLATFORM)
+// ESP32 SHA peripheral, driven through the hardware accelerated mbedtls port
+class Esp32Sha256 : public Sha256Backend
+{
+public:
+    const char *name() const override { return "esp32-hw"; }
+
+    // The peripheral only runs whole messages, block compression is unused
+    void compress(uint32_t state[8], const uint8_t *blocks, size_t numBlocks) const override
+    {
+        Sha256Backend::software().compress(state, blocks, numBlocks);
+    }
+
+    void init(Sha256State &state) const override
+    {
+        mbedtls_sha256_init(&state.hw);
+        mbedtls_sha256_starts(&state.hw, 0);
+        state.totalLen = 0;
+    }
+
+    void update(Sha256State &state, const uint8_t *data, size_t len) const override
+    {
+        mbedtls_sha256_update(&state.hw, data, len);
+        state.totalLen += len;
+    }
+
+    void finish(Sha256State &state, uint8_t out[SHA256_DIGEST_BYTES]) const override
+    {
+        mbedtls_sha256_finish(&state.hw, out);
+        mbedtls_sha256_free(&state.hw);
+    }
+
+    void release(Sha256State &state) const override
+    {
+        mbedtls_sha256_free(&state.hw);
+    }
+};
+#endif
+
+const Sha256Backend &Sha256Backend::software()
+{
+    static SoftwareSha256 backend;
+    return backend;
+}
+
+std::vector<const Sha256Backend *> Sha256Backend::available()
+{
+    std::vector<const Sha256Backend *> backends;
+#if defined(SHA256_X86_SHANI)
+    static ShaNiSha256 shaNi;
+    if (ShaNiSha256::supported())
+    {
+        backends.push_back(&shaNi);
+    }
+#endif
+#if defined(SHA256_ARMV8_CE)
+    static ArmV8Sha256 armV8;
+    if (ArmV8Sha256::supported())
+    {
+        backends.push_back(&armV8);
+    }
+#endif
+#if defined(ESP_PLATFORM)
+    static Esp32Sha256 esp32;
+    backends.push_back(&esp32);
+#endif
+    backends.push_back(&software());
+    return backends;
+}
+
+const Sha256Backend &Sha256Backend::best()
+{
+    // Pick the first backend that reproduces the reference digests
+    static const Sha256Backend *selected = []
+    {
+        for (const Sha256Backend *backend : available())
+        {
+            if (backend->selfTest())
+            {
+                return backend;
+            }
+        }
+        return &software();
+    }();
+    return *selected;
+}
@@ -0,0 +1,67 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(ESP_PLATFORM)
+#include <mbedtls/sha256.h>
+#endif
+
+// Size of a SHA-256 digest in bytes
+constexpr size_t SHA256_DIGEST_BYTES = 32;
+// Size of a SHA-256 input block in bytes
+constexpr size_t SHA256_BLOCK_BYTES = 64;
+
+// Streaming state shared by every backend
+struct Sha256State
+{
+    uint32_t h[8];
+    uint8_t buffer[SHA256_BLOCK_BYTES];
+    size_t bufferLen;
+    uint64_t totalLen;
+#if defined(ESP_PLATFORM)
+    mbedtls_sha256_context hw;
+#endif
+};
+
+// A SHA-256 implementation. Block based backends only provide compress()
+// and inherit buffering and padding; backends driving a whole-message
+// engine override init/update/finish instead.
+class Sha256Backend
+{
+public:
+    virtual ~Sha256Backend() = default;
+
+    virtual const char *name() const = 0;
+
+    // Process numBlocks consecutive 64 byte blocks into state
+    virtual void compress(uint32_t state[8], const uint8_t *blocks, size_t numBlocks) const = 0;
+
+    virtual void init(Sha256State &state) const;
+    virtual void update(Sha256State &state, const uint8_t *data, size_t len) const;
+    virtual void finish(Sha256State &state, uint8_t out[SHA256_DIGEST_BYTES]) const;
+
+    // Release any resources held by an unfinished state
+    virtual void release(Sha256State &) const {}
+
+    // Check the backend against known digests
+    bool selfTest() const;
+
+    // Portable implementation, always available
+    static const Sha256Backend &software();
+
+    // Fastest backend supported by the running CPU, chosen once
+    static const Sha256Backend &best();
+
+    // All backends usable on the running CPU, fastest first
+    static std::vector<const Sha256Backend *> available();
+};
+
+// Round constants, shared with the lane-parallel implementation
+extern const uint32_t SHA256_K[64];
+// Initial hash value
+extern const uint32_t SHA256_IV[8];
+
+#endif // SHA256_H
@@ -0,0 +1,280 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include "sha256.h"
+#include "sha256_lanes.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SHA256_LANES_VECTOR 1
+#endif
+
+// Append the concatenated spans and FIPS 180-4 padding to dst
+static size_t padMessage(const std::vector<ByteSpan> &parts, std::vector<uint8_t> &dst)
+{
+    uint64_t len = 0;
+    for (const ByteSpan &part : parts)
+    {
+        dst.insert(dst.end(), part.begin(), part.end());
+        len += part.size;
+    }
+    size_t numBlocks = (len + 8) / SHA256_BLOCK_BYTES + 1;
+    dst.push_back(0x80);
+    dst.resize(dst.size() + numBlocks * SHA256_BLOCK_BYTES - len - 9, 0);
+    for (int i = 7; i >= 0; --i)
+    {
+        dst.push_back(static_cast<uint8_t>((len * 8) >> (8 * i)));
+    }
+    return numBlocks;
+}
+
+// Hash lanes one at a time with the best single stream backend
+static void hashScalar(const uint8_t *const *buffers, const size_t *numBlocks, size_t count, uint8_t (*out)[SHA256_DIGEST_BYTES])
+{
+    const Sha256Backend &backend = Sha256Backend::best();
+    for (size_t lane = 0; lane < count; ++lane)
+    {
+        uint32_t state[8];
+        std::memcpy(state, SHA256_IV, sizeof(state));
+        backend.compress(state, buffers[lane], numBlocks[lane]);
+        for (size_t i = 0; i < 8; ++i)
+        {
+            out[lane][4 * i] = static_cast<uint8_t>(state[i] >> 24);
+            out[lane][4 * i + 1] = static_cast<uint8_t>(state[i] >> 16);
+            out[lane][4 * i + 2] = static_cast<uint8_t>(state[i] >> 8);
+            out[lane][4 * i + 3] = static_cast<uint8_t>(state[i]);
+        }
+    }
+}
+
+#if defined(SHA256_LANES_VECTOR)
+template <size_t N>
+struct LaneVector
+{
+    typedef uint32_t type __attribute__((vector_size(4 * N)));
+};
+
+// Compress N pre-padded messages in parallel, word i of every lane held in
+// one vector. Always inlined so each caller's target ISA applies.
+template <size_t N>
+static inline __attribute__((always_inline)) void hashLanes(const uint8_t *const *buffers, const size_t *numBlocks, size_t count, uint8_t (*out)[SHA256_DIGEST_BYTES])
+{
+    typedef typename LaneVector<N>::type V;
+
+    V state[8];
+    for (size_t i = 0; i < 8; ++i)
+    {
+        state[i] = V{} + SHA256_IV[i];
+    }
+
+    size_t maxBlocks = 0;
+    for (size_t lane = 0; lane < count; ++lane)
+    {
+        maxBlocks = std::max(maxBlocks, numBlocks[lane]);
+    }
+
+    for (size_t block = 0; block < maxBlocks; ++block)
+    {
+        V active = V{};
+        V w[16];
+        for (size_t i = 0; i < 16; ++i)
+        {
+            w[i] = V{};
+        }
+        for (size_t lane = 0; lane < count; ++lane)
+        {
+            if (block >= numBlocks[lane])
+            {
+                continue;
+            }
+            active[lane] = 0xFFFFFFFF;
+            const uint8_t *p = buffers[lane] + block * SHA256_BLOCK_BYTES;
+            for (size_t i = 0; i < 16; ++i)
+            {
+                w[i][lane] = (static_cast<uint32_t>(p[4 * i]) << 24) | (static_cast<uint32_t>(p[4 * i + 1]) << 16) |
+                             (static_cast<uint32_t>(p[4 * i + 2]) << 8) | static_cast<uint32_t>(p[4 * i + 3]);
+            }
+        }
+
+        V a = state[0], b = state[1], c = state[2], d = state[3];
+        V e = state[4], f = state[5], g = state[6], h = state[7];
+        for (size_t t = 0; t < 64; ++t)
+        {
+            if (t >= 16)
+            {
+                // Rolling 16 word message schedule
+                V w15 = w[(t - 15) & 15];
+                V w2 = w[(t - 2) & 15];
+                V s0 = ((w15 >> 7) | (w15 << 25)) ^ ((w15 >> 18) | (w15 << 14)) ^ (w15 >> 3);
+                V s1 = ((w2 >> 17) | (w2 << 15)) ^ ((w2 >> 19) | (w2 << 13)) ^ (w2 >> 10);
+                w[t & 15] = w[t & 15] + s0 + w[(t - 7) & 15] + s1;
+            }
+            V s1 = ((e >> 6) | (e << 26)) ^ ((e >> 11) | (e << 21)) ^ ((e >> 25) | (e << 7));
+            V ch = (e & f) ^ (~e & g);
+            V t1 = h + s1 + ch + SHA256_K[t] + w[t & 15];
+            V s0 = ((a >> 2) | (a << 30)) ^ ((a >> 13) | (a << 19)) ^ ((a >> 22) | (a << 10));
+            V maj = (a & b) ^ (a & c) ^ (b & c);
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + s0 + maj;
+        }
+
+        // Lanes that already finished keep their state
+        V next[8] = {a, b, c, d, e, f, g, h};
+        for (size_t i = 0; i < 8; ++i)
+        {
+            state[i] = (state[i] & ~active) | ((state[i] + next[i]) & active);
+        }
+    }
+
+    for (size_t lane = 0; lane < count; ++lane)
+    {
+        for (size_t i = 0; i < 8; ++i)
+        {
+            uint32_t word = state[i][lane];
+            out[lane][4 * i] = static_cast<uint8_t>(word >> 24);
+            out[lane][4 * i + 1] = static_cast<uint8_t>(word >> 16);
+            out[lane][4 * i + 2] = static_cast<uint8_t>(word >> 8);
+            out[lane][4 * i + 3] = static_cast<uint8_t>(word);
+        }
+    }
+}
+#endif
+
+#if defined(SHA256_LANES_VECTOR) && defined(__x86_64__)
+__attribute__((target("avx512f"))) static void hashAvx512(const uint8_t *const *buffers, const size_t *numBlocks, size_t count, uint8_t (*out)[SHA256_DIGEST_BYTES])
+{
+    hashLanes<16>(buffers, numBlocks, count, out);
+}
+
+__attribute__((target("avx2"))) static void hashAvx2(const uint8_t *const *buffers, const size_t *numBlocks, size_t count, uint8_t (*out)[SHA256_DIGEST_BYTES])
+{
+    hashLanes<8>(buffers, numBlocks, count, out);
+}
+
+__attribute__((target("sse4.1"))) static void hashSse4(const uint8_t *const *buffers, const size_t *numBlocks, size_t count, uint8_t (*out)[SHA256_DIGEST_BYTES])
+{
+    hashLanes<4>(buffers, numBlocks, count, out);
+}
+#elif defined(SHA256_LANES_VECTOR) && defined(__aarch64__)
+static void hashNeon(const uint8_t *const *buffers, const size_t *numBlocks, size_t count, uint8_t (*out)[SHA256_DIGEST_BYTES])
+{
+    hashLanes<4>(buffers, numBlocks, count, out);
+}
+#endif
+
+typedef void (*LaneFunction)(const uint8_t *const *, const size_t *, size_t, uint8_t (*)[SHA256_DIGEST_BYTES]);
+
+struct LaneImplementation
+{
+    const char *name;
+    size_t width;
+    LaneFunction run;
+};
+
+// Check a lane implementation against the scalar path on uneven inputs
+static bool selfTest(const LaneImplementation &implementation)
+{
+    std::vector<std::vector<uint8_t>> inputs(implementation.width);
+    std::vector<std::vector<ByteSpan>> messages(implementation.width);
+    for (size_t lane = 0; lane < implementation.width; ++lane)
+    {
+        inputs[lane].resize(lane * 29);
+        for (size_t i = 0; i < inputs[lane].size(); ++i)
+        {
+            inputs[lane][i] = static_cast<uint8_t>(i * 7 + lane);
+        }
+        messages[lane].push_back(ByteSpan(inputs[lane]));
+    }
+
+    std::vector<std::vector<uint8_t>> padded(implementation.width);
+    std::vector<const uint8_t *> buffers(implementation.width);
+    std::vector<size_t> numBlocks(implementation.width);
+    for (size_t lane = 0; lane < implementation.width; ++lane)
+    {
+        numBlocks[lane] = padMessage(messages[lane], padded[lane]);
+        buffers[lane] = padded[lane].data();
+    }
+
+    std::vector<uint8_t> expected(implementation.width * SHA256_DIGEST_BYTES);
+    std::vector<uint8_t> actual(implementation.width * SHA256_DIGEST_BYTES);
+    hashScalar(buffers.data(), numBlocks.data(), implementation.width, reinterpret_cast<uint8_t(*)[SHA256_DIGEST_BYTES]>(expected.data()));
+    implementation.run(buffers.data(), numBlocks.data(), implementation.width, reinterpret_cast<uint8_t(*)[SHA256_DIGEST_BYTES]>(actual.data()));
+    return expected == actual;
+}
+
+static const LaneImplementation &selectImplementation()
+{
+    static const LaneImplementation selected = []
+    {
+        std::vector<LaneImplementation> candidates;
+#if defined(SHA256_LANES_VECTOR) && defined(__x86_64__)
+        if (__builtin_cpu_supports("avx512f"))
+        {
+            candidates.push_back({"avx512", 16, hashAvx512});
+        }
+        if (__builtin_cpu_supports("avx2"))
+        {
+            candidates.push_back({"avx2", 8, hashAvx2});
+        }
+        if (__builtin_cpu_supports("sse4.1"))
+        {
+            candidates.push_back({"sse4.1", 4, hashSse4});
+        }
+#elif defined(SHA256_LANES_VECTOR) && defined(__aarch64__)
+        candidates.push_back({"neon", 4, hashNeon});
+#endif
+        for (const LaneImplementation &candidate : candidates)
+        {
+            if (selfTest(candidate))
+            {
+                return candidate;
+            }
+        }
+        return LaneImplementation{"scalar", 1, hashScalar};
+    }();
+    return selected;
+}
+
+const char *Sha256Lanes::name()
+{
+    return selectImplementation().name;
+}
+
+size_t Sha256Lanes::width()
+{
+    return selectImplementation().width;
+}
+
+void Sha256Lanes::hashMany(const std::vector<std::vector<ByteSpan>> &messages, uint8_t (*out)[SHA256_DIGEST_BYTES])
+{
+    const LaneImplementation &implementation = selectImplementation();
+
+    // Pad every message once into a shared arena
+    std::vector<uint8_t> arena;
+    std::vector<size_t> offsets(messages.size());
+    std::vector<size_t> numBlocks(messages.size());
+    for (size_t i = 0; i < messages.size(); ++i)
+    {
+        offsets[i] = arena.size();
+        numBlocks[i] = padMessage(messages[i], arena);
+    }
+
+    std::vector<const uint8_t *> buffers(messages.size());
+    for (size_t i = 0; i < messages.size(); ++i)
+    {
+        buffers[i] = arena.data() + offsets[i];
+    }
+
+    for (size_t first = 0; first < messages.size(); first += implementation.width)
+    {
+        size_t count = std::min(implementation.width, messages.size() - first);
+        implementation.run(buffers.data() + first, numBlocks.data() + first, count, out + first);
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef SHA256_LANES_H
+#define SHA256_LANES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "sha256.h"
+#include "byte_span.h"
+
+// Maximum number of messages hashed side by side
+constexpr size_t SHA256_MAX_LANES = 16;
+
+// Hashes many independent messages at once, one message per SIMD lane.
+// Each message is the concatenation of its spans. Inputs of different
+// lengths are allowed, lanes that run out of blocks are masked off.
+class Sha256Lanes
+{
+public:
+    // Name of the lane implementation picked for this CPU
+    static const char *name();
+
+    // Number of messages processed per pass
+    static size_t width();
+
+    // Hash messages[i] into out[i]
+    static void hashMany(const std::vector<std::vector<ByteSpan>> &messages, uint8_t (*out)[SHA256_DIGEST_BYTES]);
+};
+
+#endif // SHA256_LANES_H
@@ -5,7 +5,9 @@
 #include <string>
 #include <sstream>
 #include <iomanip>
+#if defined(ARDUINO)
 #include <Arduino.h>
+#endif
 #include <sodium/crypto_sign_ed25519.h>
 #include "keypair.h"
 #include "public_key.h"
@@ -2,6 +2,7 @@
 #define SIGNATURE_H
 
 #include <cstdint>
+#include <cstring>
 #include <vector>
 #include <array>
 #include <stdexcept>
@@ -35,6 +36,11 @@ public:
         return value[0];
     }
 
+    bool operator==(const Signature &other) const
+    {
+        return value == other.value;
+    }
+
     bool operator!=(const Signature &other) const
     {
         return value != other.value;
@@ -65,6 +71,18 @@ private:
 
 std::ostream &operator<<(std::ostream &os, const Signature &signature);
 
+// Hash for unordered containers keyed by Signature. Signatures are
+// uniformly distributed, so their first bytes are already a good hash.
+struct SignatureHash
+{
+    size_t operator()(const Signature &signature) const
+    {
+        size_t hash;
+        std::memcpy(&hash, signature.value.data(), sizeof(hash));
+        return hash;
+    }
+};
+
 class Signable
 {
 public:
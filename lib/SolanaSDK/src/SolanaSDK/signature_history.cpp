@@ -0,0 +1,233 @@
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <future>
+#include <optional>
+#include <algorithm>
+#include <stdexcept>
+#include "signature_history.h"
+
+SignatureHistory::SignatureHistory(size_t capacity) : maxRecords(capacity)
+{
+  if (capacity == 0)
+  {
+    throw std::invalid_argument("SignatureHistory capacity must be at least 1");
+  }
+  ring.reserve(capacity);
+  index.reserve(capacity);
+}
+
+bool SignatureHistory::insert(const PublicKey &address, const ConfirmedSignatureInfo &info)
+{
+  if (index.count(info.signature) > 0)
+  {
+    return false;
+  }
+
+  if (ring.size() < maxRecords)
+  {
+    ring.push_back(SignatureRecord{address, info});
+  }
+  else
+  {
+    index.erase(ring[head].info.signature);
+    ring[head] = SignatureRecord{address, info};
+  }
+  index[info.signature] = head;
+  head = (head + 1) % maxRecords;
+  count = ring.size();
+  return true;
+}
+
+bool SignatureHistory::contains(const Signature &signature) const
+{
+  return index.count(signature) > 0;
+}
+
+std::optional<SignatureRecord> SignatureHistory::find(const Signature &signature) const
+{
+  auto it = index.find(signature);
+  if (it == index.end())
+  {
+    return std::nullopt;
+  }
+  return ring[it->second];
+}
+
+std::vector<SignatureRecord> SignatureHistory::records() const
+{
+  std::vector<SignatureRecord> result;
+  result.reserve(count);
+  // Until the ring wraps, head is one past the newest record at the end
+  size_t start = count < maxRecords ? 0 : head;
+  for (size_t i = 0; i < count; ++i)
+  {
+    result.push_back(ring[(start + i) % count]);
+  }
+  return result;
+}
+
+size_t SignatureHistory::size() const
+{
+  return count;
+}
+
+size_t SignatureHistory::capacity() const
+{
+  return maxRecords;
+}
+
+void SignatureHistory::clear()
+{
+  ring.clear();
+  index.clear();
+  head = 0;
+  count = 0;
+}
+
+SignatureSync::SignatureSync(Connection connection, size_t historyCapacity, Commitment commitment, size_t maxConcurrency, size_t initialDepth)
+    : connection(connection), commitment(commitment), maxConcurrency(maxConcurrency), initialDepth(initialDepth), history(historyCapacity),
+      executor(new RpcExecutor(std::max<size_t>(1, maxConcurrency))) {}
+
+SignatureSync::SignatureSync(std::string endpoint, size_t historyCapacity, Commitment commitment, size_t maxConcurrency, size_t initialDepth)
+    : SignatureSync(Connection(endpoint, commitment, std::max<size_t>(1, maxConcurrency)), historyCapacity, commitment, maxConcurrency, initialDepth) {}
+
+void SignatureSync::addAddress(const PublicKey &address, std::optional<Signature> cursor)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  cursors[address] = cursor;
+}
+
+bool SignatureSync::removeAddress(const PublicKey &address)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return cursors.erase(address) > 0;
+}
+
+std::optional<Signature> SignatureSync::cursor(const PublicKey &address)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = cursors.find(address);
+  return it == cursors.end() ? std::nullopt : it->second;
+}
+
+size_t SignatureSync::addressCount()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return cursors.size();
+}
+
+// Page backwards from the newest signature until the cursor is reached, or
+// until initialDepth signatures for an address seen for the first time
+std::vector<ConfirmedSignatureInfo> SignatureSync::fetchNew(PublicKey address, const std::optional<Signature> &cursor)
+{
+  std::vector<ConfirmedSignatureInfo> result;
+  SignaturesForAddressOptions options;
+  options.until = cursor;
+  size_t wanted = cursor ? SIZE_MAX : initialDepth;
+
+  while (result.size() < wanted)
+  {
+    options.limit = std::min(GET_SIGNATURES_FOR_ADDRESS_LIMIT, wanted - result.size());
+    std::vector<ConfirmedSignatureInfo> page = connection.getSignaturesForAddress(address, options, commitment);
+    result.insert(result.end(), page.begin(), page.end());
+    if (page.size() < options.limit)
+    {
+      break;
+    }
+    options.before = page.back().signature;
+  }
+  return result;
+}
+
+SyncReport SignatureSync::sync(std::function<void(const PublicKey &, const ConfirmedSignatureInfo &)> onSignature)
+{
+  SyncReport report;
+  std::vector<std::pair<PublicKey, std::optional<Signature>>> targets;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    targets.assign(cursors.begin(), cursors.end());
+  }
+  if (targets.empty())
+  {
+    return report;
+  }
+
+  // One task per address; the executor keeps at most maxConcurrency of
+  // them running
+  std::vector<std::future<void>> fetches;
+  fetches.reserve(targets.size());
+  for (const auto &target : targets)
+  {
+    fetches.push_back(executor->submit([this, &report, &onSignature, target]()
+                                       {
+      const PublicKey &address = target.first;
+      std::vector<ConfirmedSignatureInfo> fetched;
+      try
+      {
+        fetched = fetchNew(address, target.second);
+      }
+      catch (const std::exception &e)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        report.failedAddresses++;
+        return;
+      }
+
+      // Record oldest first so the ring keeps chronological order
+      std::vector<ConfirmedSignatureInfo> added;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = fetched.rbegin(); it != fetched.rend(); ++it)
+        {
+          if (history.insert(address, *it))
+          {
+            added.push_back(*it);
+          }
+        }
+        report.newSignatures += added.size();
+        auto cursor = cursors.find(address);
+        if (!fetched.empty() && cursor != cursors.end())
+        {
+          cursor->second = fetched.front().signature;
+        }
+      }
+
+      if (onSignature)
+      {
+        for (const auto &info : added)
+        {
+          onSignature(address, info);
+        }
+      } }));
+  }
+  // Every task refers to report, so wait for all of them before passing
+  // on an exception thrown by onSignature
+  for (auto &fetch : fetches)
+  {
+    fetch.wait();
+  }
+  for (auto &fetch : fetches)
+  {
+    fetch.get();
+  }
+  return report;
+}
+
+bool SignatureSync::contains(const Signature &signature)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return history.contains(signature);
+}
+
+std::optional<SignatureRecord> SignatureSync::find(const Signature &signature)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return history.find(signature);
+}
+
+std::vector<SignatureRecord> SignatureSync::records()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return history.records();
+}
@@ -0,0 +1,127 @@
+#ifndef SIGNATURE_HISTORY_H
+#define SIGNATURE_HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include <optional>
+#include <functional>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include "connection.h"
+#include "rpc_executor.h"
+#include "public_key.h"
+#include "signature.h"
+
+constexpr size_t SIGNATURE_SYNC_DEFAULT_CONCURRENCY = 4;
+
+// Signatures fetched for an address that has no cursor yet; older history
+// is not downloaded
+constexpr size_t SIGNATURE_SYNC_DEFAULT_INITIAL_DEPTH = GET_SIGNATURES_FOR_ADDRESS_LIMIT;
+
+// A signature seen while syncing address
+struct SignatureRecord
+{
+  PublicKey address;
+  ConfirmedSignatureInfo info;
+};
+
+// Fixed-size ring of signature records with a lookup by signature. Once
+// full, every insert overwrites the oldest record. Not thread-safe.
+class SignatureHistory
+{
+private:
+  std::vector<SignatureRecord> ring;
+  size_t maxRecords;
+  // Slot the next record is written to
+  size_t head = 0;
+  size_t count = 0;
+  std::unordered_map<Signature, size_t, SignatureHash> index;
+
+public:
+  SignatureHistory(size_t capacity);
+
+  // Returns false if the signature is already held
+  bool insert(const PublicKey &address, const ConfirmedSignatureInfo &info);
+
+  bool contains(const Signature &signature) const;
+
+  std::optional<SignatureRecord> find(const Signature &signature) const;
+
+  // Oldest first
+  std::vector<SignatureRecord> records() const;
+
+  size_t size() const;
+
+  size_t capacity() const;
+
+  void clear();
+};
+
+struct SyncReport
+{
+  // Signatures not seen before
+  size_t newSignatures = 0;
+  // Addresses whose fetch failed; their cursors are left as they were
+  size_t failedAddresses = 0;
+};
+
+// Incremental getSignaturesForAddress sync over many addresses. Each
+// address remembers the newest signature seen, and a sync only pages
+// through history newer than it. Addresses are synced in parallel with at
+// most maxConcurrency requests in flight, further capped by the
+// connection's transport: a Connection made with the default of
+// TRANSPORT_DEFAULT_MAX_CONNECTIONS runs one request at a time. The
+// endpoint constructor sizes its connection pool to maxConcurrency.
+class SignatureSync
+{
+private:
+  Connection connection;
+  Commitment commitment;
+  size_t maxConcurrency;
+  size_t initialDepth;
+  // Newest signature seen per address, empty until the first sync
+  std::map<PublicKey, std::optional<Signature>> cursors;
+  SignatureHistory history;
+  std::mutex mutex;
+  // Runs the per-address fetches; declared last so its workers are
+  // joined before the state they touch is destroyed
+  std::unique_ptr<RpcExecutor> executor;
+
+  // Signatures newer than cursor, newest first
+  std::vector<ConfirmedSignatureInfo> fetchNew(PublicKey address, const std::optional<Signature> &cursor);
+
+public:
+  SignatureSync(Connection connection, size_t historyCapacity, Commitment commitment = Commitment::confirmed, size_t maxConcurrency = SIGNATURE_SYNC_DEFAULT_CONCURRENCY, size_t initialDepth = SIGNATURE_SYNC_DEFAULT_INITIAL_DEPTH);
+  // Sync over a connection to endpoint with maxConcurrency sockets
+  SignatureSync(std::string endpoint, size_t historyCapacity, Commitment commitment = Commitment::confirmed, size_t maxConcurrency = SIGNATURE_SYNC_DEFAULT_CONCURRENCY, size_t initialDepth = SIGNATURE_SYNC_DEFAULT_INITIAL_DEPTH);
+
+  SignatureSync(const SignatureSync &) = delete;
+  SignatureSync &operator=(const SignatureSync &) = delete;
+
+  // Start syncing address, optionally from a cursor persisted earlier
+  void addAddress(const PublicKey &address, std::optional<Signature> cursor = std::nullopt);
+
+  bool removeAddress(const PublicKey &address);
+
+  // Newest signature seen for address, to persist across restarts
+  std::optional<Signature> cursor(const PublicKey &address);
+
+  size_t addressCount();
+
+  // Fetch new history for every address. onSignature is called for each
+  // new signature, oldest first per address, from the executor's workers.
+  SyncReport sync(std::function<void(const PublicKey &, const ConfirmedSignatureInfo &)> onSignature = nullptr);
+
+  bool contains(const Signature &signature);
+
+  std::optional<SignatureRecord> find(const Signature &signature);
+
+  // Every record held, oldest first
+  std::vector<SignatureRecord> records();
+};
+
+#endif // SIGNATURE_HISTORY_H
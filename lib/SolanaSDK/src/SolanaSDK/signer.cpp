@@ -1,7 +1,9 @@
 #include <sodium/crypto_sign_ed25519.h>
 #include <string>
 #include <vector>
+#if defined(ARDUINO)
 #include <Arduino.h>
+#endif
 #include "signer.h"
 #include "keypair.h"
 #include "base58.h"
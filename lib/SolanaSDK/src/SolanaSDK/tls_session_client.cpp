@@ -0,0 +1,271 @@
+#if defined(ARDUINO)
+
+#include <sdkconfig.h>
+
+#if defined(CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS)
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <memory>
+#include <algorithm>
+#include <mutex>
+#include <lwip/sockets.h>
+#include <esp_tls.h>
+#include <esp_crt_bundle.h>
+#include "tls_session_client.h"
+
+void TlsSessionCache::store(esp_tls_t *tls)
+{
+  // A fresh copy each time, so connects still using the old one are safe
+  esp_tls_client_session_t *latest = esp_tls_get_client_session(tls);
+  if (latest == nullptr)
+  {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  session.reset(latest, esp_tls_free_client_session);
+}
+
+std::shared_ptr<esp_tls_client_session_t> TlsSessionCache::get()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return session;
+}
+
+TlsSessionClient::TlsSessionClient(const char *caCert, std::shared_ptr<TlsSessionCache> sessions)
+    : caCert(caCert), sessions(sessions) {}
+
+TlsSessionClient::~TlsSessionClient()
+{
+  stop();
+}
+
+int TlsSessionClient::connect(IPAddress ip, uint16_t port)
+{
+  return connect(ip, port, TLS_SESSION_DEFAULT_TIMEOUT_MS);
+}
+
+int TlsSessionClient::connect(IPAddress ip, uint16_t port, int32_t timeoutMs)
+{
+  return connect(ip.toString().c_str(), port, timeoutMs);
+}
+
+int TlsSessionClient::connect(const char *host, uint16_t port)
+{
+  return connect(host, port, TLS_SESSION_DEFAULT_TIMEOUT_MS);
+}
+
+int TlsSessionClient::connect(const char *host, uint16_t port, int32_t timeoutMs)
+{
+  stop();
+
+  esp_tls_cfg_t config;
+  std::memset(&config, 0, sizeof(config));
+  if (caCert != nullptr)
+  {
+    config.cacert_buf = reinterpret_cast<const unsigned char *>(caCert);
+    config.cacert_bytes = std::strlen(caCert) + 1;
+  }
+  else
+  {
+    config.crt_bundle_attach = esp_crt_bundle_attach;
+  }
+  // Also becomes the socket's send and receive timeout
+  config.timeout_ms = timeoutMs;
+  std::shared_ptr<esp_tls_client_session_t> session = sessions->get();
+  config.client_session = session.get();
+
+  tls = esp_tls_init();
+  if (tls == nullptr)
+  {
+    return 0;
+  }
+  if (esp_tls_conn_new_sync(host, std::strlen(host), port, &config, tls) != 1 ||
+      esp_tls_get_conn_sockfd(tls, &socket) != ESP_OK)
+  {
+    esp_tls_conn_destroy(tls);
+    tls = nullptr;
+    socket = -1;
+    return 0;
+  }
+  // Under TLS 1.2 the ticket is known once the handshake is done
+  sessions->store(tls);
+  return 1;
+}
+
+size_t TlsSessionClient::pending()
+{
+  if (tls == nullptr)
+  {
+    return 0;
+  }
+  ssize_t count = esp_tls_get_bytes_avail(tls);
+  return count > 0 ? static_cast<size_t>(count) : 0;
+}
+
+int TlsSessionClient::readTls(uint8_t *buffer, size_t length)
+{
+  ssize_t count = esp_tls_conn_read(tls, buffer, length);
+  if (count > 0)
+  {
+    return static_cast<int>(count);
+  }
+  if (count != ESP_TLS_ERR_SSL_WANT_READ && count != ESP_TLS_ERR_SSL_WANT_WRITE)
+  {
+    closed = true;
+  }
+  return 0;
+}
+
+// Whether a record, or the close of the socket, is waiting to be read
+bool TlsSessionClient::socketReadable()
+{
+  fd_set readable;
+  FD_ZERO(&readable);
+  FD_SET(socket, &readable);
+  timeval now = {0, 0};
+  return select(socket + 1, &readable, nullptr, nullptr, &now) > 0;
+}
+
+size_t TlsSessionClient::write(uint8_t data)
+{
+  return write(&data, 1);
+}
+
+size_t TlsSessionClient::write(const uint8_t *buffer, size_t size)
+{
+  if (tls == nullptr || closed)
+  {
+    return 0;
+  }
+  size_t written = 0;
+  while (written < size)
+  {
+    ssize_t count = esp_tls_conn_write(tls, buffer + written, size - written);
+    if (count > 0)
+    {
+      written += static_cast<size_t>(count);
+    }
+    else if (count != ESP_TLS_ERR_SSL_WANT_READ && count != ESP_TLS_ERR_SSL_WANT_WRITE)
+    {
+      closed = true;
+      break;
+    }
+  }
+  return written;
+}
+
+// Never blocks: a record is only read once the socket has one waiting
+int TlsSessionClient::available()
+{
+  if (tls == nullptr || closed)
+  {
+    return peeked >= 0 ? 1 : 0;
+  }
+  if (peeked < 0 && pending() == 0 && socketReadable())
+  {
+    uint8_t c;
+    if (readTls(&c, 1) == 1)
+    {
+      peeked = c;
+    }
+  }
+  return static_cast<int>(pending()) + (peeked >= 0 ? 1 : 0);
+}
+
+int TlsSessionClient::read()
+{
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+int TlsSessionClient::read(uint8_t *buffer, size_t size)
+{
+  if (size == 0 || available() == 0)
+  {
+    return -1;
+  }
+  size_t count = 0;
+  if (peeked >= 0)
+  {
+    buffer[count++] = static_cast<uint8_t>(peeked);
+    peeked = -1;
+  }
+  size_t decrypted = std::min(pending(), size - count);
+  if (decrypted > 0)
+  {
+    count += static_cast<size_t>(readTls(buffer + count, decrypted));
+  }
+  return static_cast<int>(count);
+}
+
+int TlsSessionClient::peek()
+{
+  if (peeked >= 0)
+  {
+    return peeked;
+  }
+  // available() reads a byte ahead only when nothing was decrypted yet
+  if (available() > 0 && peeked < 0)
+  {
+    uint8_t c;
+    if (readTls(&c, 1) == 1)
+    {
+      peeked = c;
+    }
+  }
+  return peeked;
+}
+
+void TlsSessionClient::flush() {}
+
+void TlsSessionClient::stop()
+{
+  if (tls != nullptr)
+  {
+    // Under TLS 1.3 the ticket arrives with the first response, so the
+    // session is only complete now
+    sessions->store(tls);
+    esp_tls_conn_destroy(tls);
+    tls = nullptr;
+  }
+  socket = -1;
+  closed = false;
+  peeked = -1;
+}
+
+uint8_t TlsSessionClient::connected()
+{
+  if (tls == nullptr)
+  {
+    return 0;
+  }
+  if (peeked >= 0 || pending() > 0)
+  {
+    return 1;
+  }
+  if (closed)
+  {
+    return 0;
+  }
+  // A socket that reads as closed without blocking was dropped by the server
+  uint8_t probe;
+  ssize_t count = recv(socket, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+  if (count == 0 || (count < 0 && errno != EWOULDBLOCK && errno != EAGAIN))
+  {
+    closed = true;
+    return 0;
+  }
+  return 1;
+}
+
+TlsSessionClient::operator bool()
+{
+  return connected();
+}
+
+#endif // CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+
+#endif // ARDUINO
@@ -0,0 +1,83 @@
+#ifndef TLS_SESSION_CLIENT_H
+#define TLS_SESSION_CLIENT_H
+
+#if defined(ARDUINO)
+
+#include <sdkconfig.h>
+
+#if defined(CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS)
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <WiFi.h>
+#include <esp_tls.h>
+
+// Handshake and socket timeout when connect() is not given one
+constexpr int32_t TLS_SESSION_DEFAULT_TIMEOUT_MS = 5000;
+
+// Newest TLS session negotiated with an endpoint. A session pool shares one
+// so every socket it opens can resume the handshake of another.
+class TlsSessionCache
+{
+private:
+  std::mutex mutex;
+  std::shared_ptr<esp_tls_client_session_t> session;
+
+public:
+  // Keep the session tls negotiated in place of the one held
+  void store(esp_tls_t *tls);
+
+  // Session to offer on the next connect, null before the first handshake.
+  // Shared so it stays valid while a connect uses it.
+  std::shared_ptr<esp_tls_client_session_t> get();
+};
+
+// WiFiClient over esp-tls that offers the cached session ticket when it
+// connects, so a new or dropped socket costs an abbreviated handshake
+// rather than a full one. The server is verified against caCert (PEM), or
+// against the certificate bundle when there is none. Needs
+// CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS.
+class TlsSessionClient : public WiFiClient
+{
+private:
+  const char *caCert;
+  std::shared_ptr<TlsSessionCache> sessions;
+  esp_tls_t *tls = nullptr;
+  int socket = -1;
+  bool closed = false;
+  // Byte read ahead by available() to find out if a record arrived
+  int peeked = -1;
+
+  // Bytes already decrypted by esp-tls and not read yet
+  size_t pending();
+  // Blocking read of up to length bytes, marks the client closed on error
+  int readTls(uint8_t *buffer, size_t length);
+  bool socketReadable();
+
+public:
+  TlsSessionClient(const char *caCert, std::shared_ptr<TlsSessionCache> sessions);
+  ~TlsSessionClient();
+
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(IPAddress ip, uint16_t port, int32_t timeoutMs) override;
+  int connect(const char *host, uint16_t port) override;
+  int connect(const char *host, uint16_t port, int32_t timeoutMs) override;
+  size_t write(uint8_t data) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  int available() override;
+  int read() override;
+  int read(uint8_t *buffer, size_t size) override;
+  int peek() override;
+  void flush() override;
+  void stop() override;
+  uint8_t connected() override;
+  operator bool() override;
+};
+
+#endif // CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+
+#endif // ARDUINO
+
+#endif // TLS_SESSION_CLIENT_H
@@ -10,6 +10,10 @@
 #include "instruction.h"
 #include "compiled_keys.h"
 #include "signer.h"
+#include "programs/system_program.h"
+
+// Index of the instruction that advances the nonce in a durable nonce transaction
+constexpr size_t NONCED_TX_MARKER_IX_INDEX = 0;
 
 // Create an unsigned transaction from a Message.
 Transaction::Transaction(Message message)
@@ -37,8 +41,9 @@ Transaction Transaction::newUnsigned(Message message)
 // Create a fully-signed transaction from a Message
 Transaction Transaction::create(std::vector<Signer> &fromKeypairs, Message message, Hash recent_blockhash)
 {
-  Transaction tx = this->newUnsigned(message);
-  // TODO: add sign
+  Transaction tx = Transaction::newUnsigned(message);
+  Signers signers(fromKeypairs);
+  tx.sign(signers, recent_blockhash);
   return tx;
 }
 
@@ -46,14 +51,22 @@ Transaction Transaction::create(std::vector<Signer> &fromKeypairs, Message messa
 Transaction Transaction::newWithPayer(std::vector<Instruction> &instructions, std::optional<PublicKey> &payer)
 {
   Message message = Message(instructions, payer);
-  return this->newUnsigned(message);
+  return Transaction::newUnsigned(message);
 }
 
 // Create a fully-signed transaction from a list of Instructions
 Transaction Transaction::createSignedWithPayer(std::vector<Instruction> &instructions, std::optional<PublicKey> &payer, std::vector<Signer> &signingKeypairs, Hash recentBlockhash)
 {
   Message message = Message(instructions, payer);
-  return this->create(signingKeypairs, message, recentBlockhash);
+  return Transaction::create(signingKeypairs, message, recentBlockhash);
+}
+
+// Create a fully-signed durable nonce transaction. The stored nonce value is
+// used in place of a recent blockhash, so no RPC round trip is needed.
+Transaction Transaction::createWithNonce(std::vector<Instruction> &instructions, std::optional<PublicKey> &payer, const PublicKey &nonceAccountPublicKey, const PublicKey &nonceAuthorityPublicKey, std::vector<Signer> &signingKeypairs, Hash durableNonce)
+{
+  Message message = Message::newWithNonce(instructions, payer, nonceAccountPublicKey, nonceAuthorityPublicKey);
+  return Transaction::create(signingKeypairs, message, durableNonce);
 }
 
 // Create a fully-signed transaction from pre-compiled instructions.
@@ -361,3 +374,41 @@ Transaction Transaction::deserialize(const std::vector<uint8_t> &data)
 
   return Transaction(message);
 }
+
+// Returns the advance nonce instruction if this is a durable nonce transaction.
+std::optional<CompiledInstruction> Transaction::usesDurableNonce()
+{
+  if (this->message.instructions.size() <= NONCED_TX_MARKER_IX_INDEX)
+  {
+    return std::nullopt;
+  }
+
+  const CompiledInstruction &instruction = this->message.instructions[NONCED_TX_MARKER_IX_INDEX];
+  if (instruction.programIdIndex >= this->message.accountKeys.size() || !(this->message.accountKeys[instruction.programIdIndex] == SystemProgram::id()))
+  {
+    return std::nullopt;
+  }
+
+  const std::vector<uint8_t> &data = instruction.data;
+  if (data.size() < 4 || data[0] != static_cast<uint8_t>(SystemInstruction::AdvanceNonceAccount) || data[1] != 0 || data[2] != 0 || data[3] != 0)
+  {
+    return std::nullopt;
+  }
+
+  if (instruction.accounts.empty() || !this->message.isWritable(instruction.accounts.front()))
+  {
+    return std::nullopt;
+  }
+
+  return instruction;
+}
+
+// Get the nonce account referenced by an advance nonce instruction.
+std::optional<PublicKey> Transaction::getNoncePubkeyFromInstruction(const CompiledInstruction &instruction)
+{
+  if (instruction.accounts.empty() || instruction.accounts.front() >= this->message.accountKeys.size())
+  {
+    return std::nullopt;
+  }
+  return this->message.accountKeys[instruction.accounts.front()];
+}
@@ -29,13 +29,15 @@ public:
 
   static Transaction newUnsigned(Message message);
 
-  Transaction create(std::vector<Signer> &fromKeypairs, Message message, Hash recent_blockhash);
+  static Transaction create(std::vector<Signer> &fromKeypairs, Message message, Hash recent_blockhash);
 
-  Transaction newWithPayer(std::vector<Instruction> &instructions, std::optional<PublicKey> &payer);
+  static Transaction newWithPayer(std::vector<Instruction> &instructions, std::optional<PublicKey> &payer);
 
-  Transaction createSignedWithPayer(std::vector<Instruction> &instructions, std::optional<PublicKey> &payer, std::vector<Signer> &signingKeypairs, Hash recentBlockhash);
+  static Transaction createSignedWithPayer(std::vector<Instruction> &instructions, std::optional<PublicKey> &payer, std::vector<Signer> &signingKeypairs, Hash recentBlockhash);
 
-  Transaction createWithCompiledInstructions(std::vector<Signer> &fromKeypairs, std::vector<PublicKey> &keys, Hash recentBlockhash, std::vector<PublicKey> programIds, std::vector<CompiledInstruction> instructions);
+  static Transaction createWithNonce(std::vector<Instruction> &instructions, std::optional<PublicKey> &payer, const PublicKey &nonceAccountPublicKey, const PublicKey &nonceAuthorityPublicKey, std::vector<Signer> &signingKeypairs, Hash durableNonce);
+
+  static Transaction createWithCompiledInstructions(std::vector<Signer> &fromKeypairs, std::vector<PublicKey> &keys, Hash recentBlockhash, std::vector<PublicKey> programIds, std::vector<CompiledInstruction> instructions);
 
   std::vector<uint8_t> data(size_t instructionIndex);
 
@@ -75,11 +77,14 @@ public:
 
   static Transaction deserialize(const std::vector<uint8_t> &data);
 
+  std::optional<CompiledInstruction> usesDurableNonce();
+
+  std::optional<PublicKey> getNoncePubkeyFromInstruction(const CompiledInstruction &instruction);
+
 private:
   std::vector<bool> _verifyWithResults(const std::vector<uint8_t> &messageBytes);
 
-  // TODO: get_nonce_pubkey_from_instruction, uses_durable_nonce,
-  // replace_signatures, verify_precompiles,
+  // TODO: replace_signatures, verify_precompiles,
 };
 
 #endif // TRANSACTION_H
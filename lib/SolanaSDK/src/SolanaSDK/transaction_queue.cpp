@@ -0,0 +1,293 @@
+#include <cstdint>
+#include <atomic>
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <optional>
+#include <vector>
+#include "transaction_queue.h"
+#include "connection.h"
+#include "transaction.h"
+#include "signature.h"
+#include "signer.h"
+#include "rpc_batch.h"
+
+TransactionQueue::TransactionQueue(size_t capacity, size_t maxAttempts) : capacity(capacity), maxAttempts(maxAttempts) {}
+
+bool TransactionQueue::push(Transaction transaction, std::vector<Signer> signers, uint64_t lastValidBlockHeight)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (entries.size() + draining >= capacity)
+  {
+    return false;
+  }
+
+  std::optional<PublicKey> nonceAccount;
+  std::optional<CompiledInstruction> nonceInstruction = transaction.usesDurableNonce();
+  if (nonceInstruction.has_value())
+  {
+    nonceAccount = transaction.getNoncePubkeyFromInstruction(nonceInstruction.value());
+  }
+
+  std::vector<uint8_t> serialized = transaction.serialize();
+  entries.push_back(QueuedTransaction{transaction, serialized, signers, lastValidBlockHeight, nonceAccount});
+  return true;
+}
+
+bool TransactionQueue::push(Transaction transaction, std::vector<Signer> signers)
+{
+  if (!transaction.usesDurableNonce().has_value())
+  {
+    throw std::invalid_argument("Transaction does not use a durable nonce");
+  }
+  return push(transaction, signers, 0);
+}
+
+size_t TransactionQueue::size()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return entries.size();
+}
+
+bool TransactionQueue::full()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return entries.size() + draining >= capacity;
+}
+
+bool TransactionQueue::expired(QueuedTransaction &entry, Connection &connection, uint64_t blockHeight, std::optional<BlockhashWithExpiryBlockHeight> &latestBlockhash, Hash &anchor)
+{
+  if (entry.nonceAccount.has_value())
+  {
+    NonceAccount nonce = connection.getNonceAccount(entry.nonceAccount.value());
+    if (!(nonce.durableNonce != entry.transaction.message.recentBlockhash))
+    {
+      return false;
+    }
+    anchor = nonce.durableNonce;
+    return true;
+  }
+
+  if (blockHeight <= entry.lastValidBlockHeight)
+  {
+    return false;
+  }
+  // Fetch at most one fresh blockhash per drain
+  if (!latestBlockhash.has_value())
+  {
+    latestBlockhash = connection.getLatestBlockhash();
+  }
+  anchor = latestBlockhash->blockhash;
+  return true;
+}
+
+std::vector<std::optional<SignatureStatus>> TransactionQueue::statuses(Connection &connection, const std::vector<QueuedTransaction *> &entries)
+{
+  std::vector<std::optional<SignatureStatus>> result(entries.size());
+  if (entries.empty())
+  {
+    return result;
+  }
+
+  // Responses can come back in any order, so each call fills its own range
+  RpcBatch batch;
+  bool answered = true;
+  for (size_t start = 0; start < entries.size(); start += GET_SIGNATURE_STATUSES_LIMIT)
+  {
+    size_t end = std::min(start + GET_SIGNATURE_STATUSES_LIMIT, entries.size());
+    std::vector<Signature> signatures;
+    for (size_t i = start; i < end; ++i)
+    {
+      signatures.push_back(entries[i]->transaction.signatures.front());
+    }
+    batch.getSignatureStatuses(signatures, true, [&result, &answered, start, end](std::vector<std::optional<SignatureStatus>> values)
+                               {
+                                 if (values.size() != end - start)
+                                 {
+                                   answered = false;
+                                   return;
+                                 }
+                                 std::copy(values.begin(), values.end(), result.begin() + start); });
+  }
+  if (!connection.sendBatch(batch) || !answered)
+  {
+    throw std::runtime_error("Signature statuses unavailable");
+  }
+  return result;
+}
+
+DrainResult TransactionQueue::drain(Connection &connection, size_t maxInFlight, SendOptions sendOptions)
+{
+  DrainResult result;
+
+  // Take the current batch out of the queue so producers are not blocked
+  std::vector<QueuedTransaction> batch;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    batch.assign(entries.begin(), entries.end());
+    entries.clear();
+    draining += batch.size();
+  }
+  if (batch.empty())
+  {
+    return result;
+  }
+
+  // Only one transaction per nonce account can land before the nonce
+  // advances, so later ones are held back until the next drain.
+  std::vector<QueuedTransaction> ready;
+  std::vector<QueuedTransaction> deferred;
+  try
+  {
+    uint64_t blockHeight = connection.getBlockHeight();
+    std::optional<BlockhashWithExpiryBlockHeight> latestBlockhash;
+    std::map<PublicKey, bool> usedNonces;
+    std::vector<bool> held(batch.size(), false);
+    std::vector<std::optional<Hash>> anchors(batch.size());
+
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+      QueuedTransaction &entry = batch[i];
+      if (entry.nonceAccount.has_value())
+      {
+        if (usedNonces[entry.nonceAccount.value()])
+        {
+          held[i] = true;
+          continue;
+        }
+        usedNonces[entry.nonceAccount.value()] = true;
+      }
+
+      Hash anchor;
+      if (expired(entry, connection, blockHeight, latestBlockhash, anchor))
+      {
+        anchors[i] = anchor;
+      }
+    }
+
+    // An expired entry whose last send may have reached the node is only
+    // re-signed if the node has never seen its signature. Otherwise it has
+    // landed and signing it again would submit it twice.
+    std::vector<QueuedTransaction *> unsure;
+    std::vector<size_t> unsureIndexes;
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+      if (anchors[i].has_value() && batch[i].sent)
+      {
+        unsure.push_back(&batch[i]);
+        unsureIndexes.push_back(i);
+      }
+    }
+    std::vector<std::optional<SignatureStatus>> landed(batch.size());
+    std::vector<std::optional<SignatureStatus>> found = statuses(connection, unsure);
+    for (size_t i = 0; i < unsure.size(); ++i)
+    {
+      landed[unsureIndexes[i]] = found[i];
+    }
+
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+      QueuedTransaction &entry = batch[i];
+      if (held[i])
+      {
+        deferred.push_back(entry);
+        continue;
+      }
+      if (landed[i].has_value())
+      {
+        Signature signature = entry.transaction.signatures.front();
+        (landed[i]->failed ? result.dropped : result.submitted).push_back(signature);
+        continue;
+      }
+      if (anchors[i].has_value())
+      {
+        Signers signers(entry.signers);
+        entry.transaction.sign(signers, anchors[i].value());
+        entry.serialized = entry.transaction.serialize();
+        if (!entry.nonceAccount.has_value())
+        {
+          entry.lastValidBlockHeight = latestBlockhash->lastValidBlockHeight;
+        }
+        entry.sent = false;
+        result.resigned++;
+      }
+      ready.push_back(entry);
+    }
+  }
+  catch (const std::exception &e)
+  {
+    // Still offline, put the whole batch back in its original order
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.insert(entries.begin(), batch.begin(), batch.end());
+    draining -= batch.size();
+    result = DrainResult();
+    result.failed = batch.size();
+    return result;
+  }
+
+  // Submit with a bounded number of concurrent senders. The signature is
+  // taken from the transaction, so a reply that cannot be parsed does not
+  // lose track of a send that went through.
+  std::mutex resultMutex;
+  std::atomic<size_t> nextIndex{0};
+  std::vector<QueuedTransaction> retry;
+  size_t workerCount = std::max<size_t>(1, std::min(maxInFlight, ready.size()));
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < workerCount; ++i)
+  {
+    workers.emplace_back([&]()
+                         {
+      for (size_t index = nextIndex++; index < ready.size(); index = nextIndex++)
+      {
+        QueuedTransaction &entry = ready[index];
+        bool rejected = false;
+        try
+        {
+          connection.sendRawTransaction(entry.serialized, sendOptions);
+          std::lock_guard<std::mutex> lock(resultMutex);
+          result.submitted.push_back(entry.transaction.signatures.front());
+          continue;
+        }
+        catch (const RpcException &e)
+        {
+          // Only an error answer from the node means it was not accepted
+          rejected = e.code == RpcErrorCode::rpc;
+        }
+        catch (const std::exception &)
+        {
+        }
+
+        std::lock_guard<std::mutex> lock(resultMutex);
+        entry.sent = entry.sent || !rejected;
+        if (++entry.attempts >= maxAttempts)
+        {
+          result.dropped.push_back(entry.transaction.signatures.front());
+        }
+        else
+        {
+          retry.push_back(entry);
+        }
+      } });
+  }
+  for (auto &worker : workers)
+  {
+    worker.join();
+  }
+
+  // Requeued entries were counted by draining, so the queue stays within
+  // capacity however many were pushed meanwhile
+  std::lock_guard<std::mutex> lock(mutex);
+  result.failed = retry.size();
+  entries.insert(entries.begin(), deferred.begin(), deferred.end());
+  entries.insert(entries.begin(), retry.begin(), retry.end());
+  draining -= batch.size();
+  return result;
+}
+
+DrainResult TransactionQueue::drain(Connection &connection, size_t maxInFlight)
+{
+  SendOptions defaultSendOptions;
+  return drain(connection, maxInFlight, defaultSendOptions);
+}
@@ -0,0 +1,104 @@
+#ifndef TRANSACTION_QUEUE_H
+#define TRANSACTION_QUEUE_H
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include "connection.h"
+#include "transaction.h"
+#include "signature.h"
+#include "signer.h"
+
+// A fully signed transaction waiting to be submitted
+struct QueuedTransaction
+{
+  Transaction transaction;
+
+  // Wire bytes produced by Transaction::serialize
+  std::vector<uint8_t> serialized;
+
+  // Keys used to re-sign the transaction once its blockhash or nonce is stale
+  std::vector<Signer> signers;
+
+  // Last block height at which the blockhash is valid, unused for nonce transactions
+  uint64_t lastValidBlockHeight;
+
+  // Set when the transaction is anchored to a durable nonce account
+  std::optional<PublicKey> nonceAccount;
+
+  // Failed sends so far
+  size_t attempts = 0;
+
+  // A send failed in a way that may still have reached the node, so the
+  // current signature could land
+  bool sent = false;
+};
+
+// Sends an entry gets before it is dropped from the queue
+constexpr size_t TRANSACTION_QUEUE_MAX_ATTEMPTS = 8;
+
+struct DrainResult
+{
+  // Signatures accepted by the RPC node, or found to have landed after an
+  // earlier send whose outcome was unknown
+  std::vector<Signature> submitted;
+
+  // Entries that had to be re-signed before submission
+  size_t resigned = 0;
+
+  // Entries returned to the queue because the send failed
+  size_t failed = 0;
+
+  // Signatures removed from the queue without being accepted: out of
+  // attempts, or landed but failed
+  std::vector<Signature> dropped;
+};
+
+// Bounded queue of pre-signed transactions produced while offline and
+// submitted in bursts once the link comes back.
+//
+// A send that times out or loses its reply may still have been accepted,
+// so such an entry is sent again with the same bytes. It is re-signed only
+// once its blockhash has expired or its nonce has moved on and the node
+// has no status for its signature, which means it can never land.
+class TransactionQueue
+{
+private:
+  size_t capacity;
+  size_t maxAttempts;
+  std::deque<QueuedTransaction> entries;
+  // Entries taken out by a drain in progress, still counted against capacity
+  size_t draining = 0;
+  std::mutex mutex;
+
+  // True if the blockhash or nonce the entry was signed with can no longer
+  // be used, with the value to re-sign it with in anchor
+  bool expired(QueuedTransaction &entry, Connection &connection, uint64_t blockHeight, std::optional<BlockhashWithExpiryBlockHeight> &latestBlockhash, Hash &anchor);
+
+  // Statuses of the entries' signatures, throws if the node did not answer
+  static std::vector<std::optional<SignatureStatus>> statuses(Connection &connection, const std::vector<QueuedTransaction *> &entries);
+
+public:
+  TransactionQueue(size_t capacity, size_t maxAttempts = TRANSACTION_QUEUE_MAX_ATTEMPTS);
+
+  // Queue a signed transaction. Returns false when the queue is full.
+  bool push(Transaction transaction, std::vector<Signer> signers, uint64_t lastValidBlockHeight);
+
+  // Queue a signed durable nonce transaction. Returns false when the queue is full.
+  bool push(Transaction transaction, std::vector<Signer> signers);
+
+  size_t size();
+
+  bool full();
+
+  // Re-sign stale entries and submit the queue with at most maxInFlight
+  // concurrent sends. Entries that fail to send stay queued until they
+  // have had maxAttempts sends.
+  DrainResult drain(Connection &connection, size_t maxInFlight, SendOptions sendOptions);
+
+  DrainResult drain(Connection &connection, size_t maxInFlight = 4);
+};
+
+#endif // TRANSACTION_QUEUE_H
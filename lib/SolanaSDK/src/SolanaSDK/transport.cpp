@@ -0,0 +1,159 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <algorithm>
+#include "transport.h"
+#if defined(ARDUINO)
+#include "http_session.h"
+#else
+#include "posix_http_transport.h"
+#endif
+
+size_t ResponseReader::readBytes(char *buffer, size_t length)
+{
+  size_t count = 0;
+  while (count < length)
+  {
+    int c = read();
+    if (c < 0)
+    {
+      break;
+    }
+    buffer[count++] = static_cast<char>(c);
+  }
+  return count;
+}
+
+int ResponseReader::status() const
+{
+  return 200;
+}
+
+uint32_t ResponseReader::retryAfterMs() const
+{
+  return 0;
+}
+
+uint32_t parseRetryAfter(const std::string &value)
+{
+  size_t start = value.find_first_not_of(" \t");
+  if (start == std::string::npos || value[start] < '0' || value[start] > '9')
+  {
+    return 0;
+  }
+  uint64_t seconds = std::strtoull(value.c_str() + start, nullptr, 10);
+  return static_cast<uint32_t>(std::min<uint64_t>(seconds * 1000, UINT32_MAX));
+}
+
+std::vector<std::string> requestMethods(ByteSpan request)
+{
+  static const char KEY[] = "\"method\":\"";
+  std::vector<std::string> methods;
+  const char *data = reinterpret_cast<const char *>(request.data);
+  const char *end = data + request.size;
+  const char *at = data;
+  while ((at = std::search(at, end, KEY, KEY + sizeof(KEY) - 1)) != end)
+  {
+    at += sizeof(KEY) - 1;
+    const char *close = std::find(at, end, '"');
+    if (close == end)
+    {
+      break;
+    }
+    methods.emplace_back(at, close);
+    at = close;
+  }
+  return methods;
+}
+
+StringResponseReader::StringResponseReader(const std::string &body, int statusCode, uint32_t retryAfter)
+    : body(body), statusCode(statusCode), retryAfter(retryAfter) {}
+
+int StringResponseReader::read()
+{
+  return position < body.size() ? static_cast<uint8_t>(body[position++]) : -1;
+}
+
+size_t StringResponseReader::readBytes(char *buffer, size_t length)
+{
+  size_t count = std::min(length, body.size() - position);
+  std::memcpy(buffer, body.data() + position, count);
+  position += count;
+  return count;
+}
+
+int StringResponseReader::status() const
+{
+  return statusCode;
+}
+
+uint32_t StringResponseReader::retryAfterMs() const
+{
+  return retryAfter;
+}
+
+ContextResponseReader::ContextResponseReader(ResponseReader &body, const RequestContext &context) : body(body), context(context) {}
+
+int ContextResponseReader::read()
+{
+  if (++reads % CONTEXT_READER_CHECK_INTERVAL == 0)
+  {
+    stopped = context.stopped();
+  }
+  return stopped ? -1 : body.read();
+}
+
+size_t ContextResponseReader::readBytes(char *buffer, size_t length)
+{
+  stopped = stopped || context.stopped();
+  return stopped ? 0 : body.readBytes(buffer, length);
+}
+
+int ContextResponseReader::status() const
+{
+  return body.status();
+}
+
+uint32_t ContextResponseReader::retryAfterMs() const
+{
+  return body.retryAfterMs();
+}
+
+bool Transport::post(ByteSpan request, const ResponseHandler &handler, const RequestContext &context)
+{
+  if (context.stopped())
+  {
+    return false;
+  }
+  if (!context.deadline.bounded() && !context.token)
+  {
+    return post(request, handler);
+  }
+  return post(request, [&handler, &context](ResponseReader &body)
+              {
+                ContextResponseReader reader(body, context);
+                return handler(reader) && !context.stopped(); });
+}
+
+size_t Transport::warmup()
+{
+  return 0;
+}
+
+size_t Transport::maxConcurrency() const
+{
+  return 1;
+}
+
+std::shared_ptr<Transport> Transport::forEndpoint(const std::string &url, size_t maxConnections)
+{
+#if defined(ARDUINO)
+  return std::make_shared<HttpTransport>(url, maxConnections);
+#else
+  return std::make_shared<PosixHttpTransport>(url, maxConnections);
+#endif
+}
@@ -0,0 +1,121 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include "byte_span.h"
+#include "request_context.h"
+
+// Bytes read one at a time between context checks of ContextResponseReader
+constexpr uint32_t CONTEXT_READER_CHECK_INTERVAL = 256;
+
+// Connections kept per endpoint when none is given
+constexpr size_t TRANSPORT_DEFAULT_MAX_CONNECTIONS = 1;
+
+// Most body bytes read past the point a handler stopped at to keep the
+// socket open. A longer rest is dropped with the socket, reconnecting costs
+// less than reading it.
+constexpr size_t TRANSPORT_DRAIN_LIMIT = 4096;
+
+// Response body handed to a Transport's response handler. Has the read()
+// and readBytes() pair ArduinoJson needs to parse it without buffering.
+class ResponseReader
+{
+public:
+  virtual ~ResponseReader() = default;
+
+  // Next byte of the body, -1 at the end
+  virtual int read() = 0;
+
+  // Up to length bytes, fewer only at the end of the body
+  virtual size_t readBytes(char *buffer, size_t length);
+
+  // HTTP status of the response, 200 for transports without one
+  virtual int status() const;
+
+  // Delay the server asked for with Retry-After, 0 if none
+  virtual uint32_t retryAfterMs() const;
+};
+
+// Retry-After header value in milliseconds. Only the delta-seconds form is
+// understood, an HTTP date gives 0.
+uint32_t parseRetryAfter(const std::string &value);
+
+// Method names of a request or batch written by RpcRequestWriter, in order
+std::vector<std::string> requestMethods(ByteSpan request);
+
+// Reads a response body held in memory, answering status() and
+// retryAfterMs() with what the original response carried
+class StringResponseReader : public ResponseReader
+{
+private:
+  const std::string &body;
+  size_t position = 0;
+  int statusCode;
+  uint32_t retryAfter;
+
+public:
+  StringResponseReader(const std::string &body, int statusCode = 200, uint32_t retryAfter = 0);
+
+  int read() override;
+  size_t readBytes(char *buffer, size_t length) override;
+  int status() const override;
+  uint32_t retryAfterMs() const override;
+};
+
+// Ends a body early once the context stops, so a parser reading it fails
+// instead of waiting on a slow server. Single-byte reads only look at the
+// clock every CONTEXT_READER_CHECK_INTERVAL bytes.
+class ContextResponseReader : public ResponseReader
+{
+private:
+  ResponseReader &body;
+  const RequestContext &context;
+  uint32_t reads = 0;
+  bool stopped = false;
+
+public:
+  ContextResponseReader(ResponseReader &body, const RequestContext &context);
+
+  int read() override;
+  size_t readBytes(char *buffer, size_t length) override;
+  int status() const override;
+  uint32_t retryAfterMs() const override;
+};
+
+// Called once the server answered. Returns false if the body could not be
+// parsed.
+using ResponseHandler = std::function<bool(ResponseReader &body)>;
+
+// Carries JSON-RPC requests to a node. Implementations are safe to call
+// from several threads at once, up to maxConcurrency() requests in flight.
+class Transport
+{
+public:
+  virtual ~Transport() = default;
+
+  // POST request and stream the response body into handler. Returns false
+  // if no response was received or the handler rejected it.
+  virtual bool post(ByteSpan request, const ResponseHandler &handler) = 0;
+
+  // As above, giving up once the context's deadline passes or its token is
+  // cancelled. The default checks the context before sending and while the
+  // body is read; transports that can also bound connect and write
+  // override it.
+  virtual bool post(ByteSpan request, const ResponseHandler &handler, const RequestContext &context);
+
+  // Open connections ahead of the first request, returns how many are ready
+  virtual size_t warmup();
+
+  virtual size_t maxConcurrency() const;
+
+  // Default transport for the platform: HTTPClient on Arduino, POSIX
+  // sockets elsewhere
+  static std::shared_ptr<Transport> forEndpoint(const std::string &url, size_t maxConnections);
+};
+
+#endif // TRANSPORT_H
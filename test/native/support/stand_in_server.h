@@ -0,0 +1,754 @@
+#ifndef STAND_IN_SERVER_H
+#define STAND_IN_SERVER_H
+
+// Local servers standing in for an RPC node in host tests. Each listens on
+// an ephemeral port of 127.0.0.1 and serves every accepted connection on
+// its own thread until the peer closes or the server is destroyed.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <csignal>
+#include <openssl/sha.h>
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/pem.h>
+#include <openssl/x509v3.h>
+
+// One accepted connection
+class StandInPeer
+{
+private:
+  int fd;
+
+public:
+  explicit StandInPeer(int fd) : fd(fd) {}
+  virtual ~StandInPeer() = default;
+
+  int socket() const { return fd; }
+
+  // Up to length bytes, 0 once the peer closed
+  virtual size_t read(char *buffer, size_t length)
+  {
+    ssize_t count = ::recv(fd, buffer, length, 0);
+    return count > 0 ? static_cast<size_t>(count) : 0;
+  }
+
+  virtual bool write(const char *data, size_t length)
+  {
+    while (length > 0)
+    {
+      ssize_t count = ::send(fd, data, length, MSG_NOSIGNAL);
+      if (count <= 0)
+      {
+        return false;
+      }
+      data += count;
+      length -= static_cast<size_t>(count);
+    }
+    return true;
+  }
+
+  bool write(const std::string &data) { return write(data.data(), data.size()); }
+
+  // Exactly length bytes, false if the peer closed first
+  bool readExactly(char *buffer, size_t length)
+  {
+    while (length > 0)
+    {
+      size_t count = read(buffer, length);
+      if (count == 0)
+      {
+        return false;
+      }
+      buffer += count;
+      length -= count;
+    }
+    return true;
+  }
+
+  // A CRLF-terminated line without its terminator
+  bool readLine(std::string &line)
+  {
+    line.clear();
+    char c;
+    while (readExactly(&c, 1))
+    {
+      if (c == '\n')
+      {
+        if (!line.empty() && line.back() == '\r')
+        {
+          line.pop_back();
+        }
+        return true;
+      }
+      line += c;
+    }
+    return false;
+  }
+};
+
+class StandInServer
+{
+public:
+  using PeerHandler = std::function<void(StandInPeer &peer)>;
+
+private:
+  int listener = -1;
+  uint16_t boundPort = 0;
+  PeerHandler handler;
+  std::atomic<bool> stopping{false};
+  std::atomic<size_t> accepted{0};
+  std::thread acceptor;
+  std::mutex mutex;
+  std::vector<int> peers;
+  std::vector<std::thread> workers;
+
+  void acceptLoop()
+  {
+    while (!stopping)
+    {
+      pollfd entry{listener, POLLIN, 0};
+      if (::poll(&entry, 1, 20) <= 0)
+      {
+        continue;
+      }
+      int fd = ::accept(listener, nullptr, nullptr);
+      if (fd < 0)
+      {
+        continue;
+      }
+      accepted++;
+      std::lock_guard<std::mutex> lock(mutex);
+      peers.push_back(fd);
+      workers.emplace_back([this, fd]
+                           {
+                             std::unique_ptr<StandInPeer> peer = makePeer(fd);
+                             if (peer)
+                             {
+                               handler(*peer);
+                             }
+                             ::shutdown(fd, SHUT_RDWR); });
+    }
+  }
+
+protected:
+  // Wraps an accepted socket, nullptr to drop it
+  virtual std::unique_ptr<StandInPeer> makePeer(int fd) { return std::unique_ptr<StandInPeer>(new StandInPeer(fd)); }
+
+  void start(PeerHandler peerHandler)
+  {
+    handler = std::move(peerHandler);
+    listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    socklen_t length = sizeof(address);
+    if (listener < 0 ||
+        ::bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        ::listen(listener, 64) != 0 ||
+        ::getsockname(listener, reinterpret_cast<sockaddr *>(&address), &length) != 0)
+    {
+      throw std::runtime_error("Stand-in server could not listen");
+    }
+    boundPort = ntohs(address.sin_port);
+    acceptor = std::thread([this]
+                           { acceptLoop(); });
+  }
+
+  // Subclasses call this from their destructor so no worker runs a handler
+  // that touches destroyed members
+  void stop()
+  {
+    if (stopping.exchange(true))
+    {
+      return;
+    }
+    acceptor.join();
+    std::vector<std::thread> running;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (int fd : peers)
+      {
+        ::shutdown(fd, SHUT_RDWR);
+      }
+      running.swap(workers);
+    }
+    for (auto &worker : running)
+    {
+      worker.join();
+    }
+    for (int fd : peers)
+    {
+      ::close(fd);
+    }
+    ::close(listener);
+  }
+
+  StandInServer() = default;
+
+public:
+  explicit StandInServer(PeerHandler peerHandler) { start(std::move(peerHandler)); }
+  virtual ~StandInServer() { stop(); }
+
+  StandInServer(const StandInServer &) = delete;
+  StandInServer &operator=(const StandInServer &) = delete;
+
+  uint16_t port() const { return boundPort; }
+
+  // Connections accepted so far
+  size_t connections() const { return accepted; }
+
+  // A client's connect() returns before the accept thread gets to it, so
+  // counts taken right after a call wait for the accepts to catch up
+  size_t connections(size_t expected, uint32_t timeoutMs = 1000) const
+  {
+    auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (accepted < expected && std::chrono::steady_clock::now() < until)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return accepted;
+  }
+};
+
+struct StandInRequest
+{
+  std::string method;
+  std::string path;
+  // Header names in lower case
+  std::map<std::string, std::string> headers;
+  std::string body;
+};
+
+struct StandInResponse
+{
+  int status = 200;
+  std::vector<std::pair<std::string, std::string>> headers;
+  std::string body;
+  // Sent verbatim instead of status, headers and body when set
+  std::string raw;
+  // Held back this long before answering
+  uint32_t delayMs = 0;
+  // Close the connection after answering
+  bool close = false;
+
+  static StandInResponse json(const std::string &body, int status = 200)
+  {
+    StandInResponse response;
+    response.status = status;
+    response.headers.emplace_back("Content-Type", "application/json");
+    response.body = body;
+    return response;
+  }
+};
+
+// Keep-alive HTTP/1.1 server answering each request with handler
+class StandInHttpServer : public StandInServer
+{
+public:
+  using Handler = std::function<StandInResponse(const StandInRequest &request)>;
+
+private:
+  Handler handler;
+  std::atomic<size_t> served{0};
+
+  static const char *reason(int status)
+  {
+    switch (status)
+    {
+    case 200:
+      return "OK";
+    case 429:
+      return "Too Many Requests";
+    case 500:
+      return "Internal Server Error";
+    case 503:
+      return "Service Unavailable";
+    default:
+      return "Status";
+    }
+  }
+
+  void serve(StandInPeer &peer)
+  {
+    std::string line;
+    while (peer.readLine(line) && !line.empty())
+    {
+      StandInRequest request;
+      size_t space = line.find(' ');
+      request.method = line.substr(0, space);
+      request.path = line.substr(space + 1, line.find(' ', space + 1) - space - 1);
+      while (peer.readLine(line) && !line.empty())
+      {
+        size_t colon = line.find(':');
+        if (colon == std::string::npos)
+        {
+          continue;
+        }
+        std::string name = line.substr(0, colon);
+        for (char &c : name)
+        {
+          c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        size_t value = line.find_first_not_of(' ', colon + 1);
+        request.headers[name] = value == std::string::npos ? "" : line.substr(value);
+      }
+      auto length = request.headers.find("content-length");
+      if (length != request.headers.end())
+      {
+        request.body.resize(std::strtoull(length->second.c_str(), nullptr, 10));
+        if (!peer.readExactly(&request.body[0], request.body.size()))
+        {
+          return;
+        }
+      }
+
+      served++;
+      StandInResponse response = handler(request);
+      if (response.delayMs > 0)
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(response.delayMs));
+      }
+      std::string out = response.raw;
+      if (out.empty())
+      {
+        out = "HTTP/1.1 " + std::to_string(response.status) + " " + reason(response.status) + "\r\n";
+        for (const auto &header : response.headers)
+        {
+          out += header.first + ": " + header.second + "\r\n";
+        }
+        out += "Content-Length: " + std::to_string(response.body.size()) + "\r\n";
+        if (response.close)
+        {
+          out += "Connection: close\r\n";
+        }
+        out += "\r\n" + response.body;
+      }
+      if (!peer.write(out) || response.close)
+      {
+        return;
+      }
+    }
+  }
+
+protected:
+  StandInHttpServer() = default;
+
+  void start(Handler requestHandler)
+  {
+    handler = std::move(requestHandler);
+    StandInServer::start([this](StandInPeer &peer)
+                         { serve(peer); });
+  }
+
+public:
+  explicit StandInHttpServer(Handler requestHandler) { start(std::move(requestHandler)); }
+  ~StandInHttpServer() override { stop(); }
+
+  std::string url() const { return "http://127.0.0.1:" + std::to_string(port()) + "/"; }
+
+  // Requests answered so far
+  size_t requests() const { return served; }
+
+  // Count once expected requests came in or timeoutMs passed
+  size_t requests(size_t expected, uint32_t timeoutMs = 1000) const
+  {
+    auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (served < expected && std::chrono::steady_clock::now() < until)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return served;
+  }
+};
+
+// StandInHttpServer behind TLS, with a self-signed certificate for
+// 127.0.0.1 made at startup. Clients trust it through caCert(). TLS 1.3
+// session tickets are on, so a client can resume its first session.
+class StandInHttpsServer : public StandInHttpServer
+{
+private:
+  class TlsPeer : public StandInPeer
+  {
+  private:
+    SSL *ssl;
+
+  public:
+    TlsPeer(int fd, SSL *ssl) : StandInPeer(fd), ssl(ssl) {}
+    ~TlsPeer() override { SSL_free(ssl); }
+
+    size_t read(char *buffer, size_t length) override
+    {
+      int count = SSL_read(ssl, buffer, static_cast<int>(length));
+      return count > 0 ? static_cast<size_t>(count) : 0;
+    }
+
+    bool write(const char *data, size_t length) override
+    {
+      return length == 0 || SSL_write(ssl, data, static_cast<int>(length)) == static_cast<int>(length);
+    }
+  };
+
+  SSL_CTX *context = nullptr;
+  std::string certificatePem;
+  std::atomic<size_t> handshakes{0};
+  std::atomic<size_t> resumed{0};
+
+  void makeContext()
+  {
+    EVP_PKEY *key = EVP_EC_gen("P-256");
+    X509 *certificate = X509_new();
+    ASN1_INTEGER_set(X509_get_serialNumber(certificate), 1);
+    X509_gmtime_adj(X509_getm_notBefore(certificate), -60);
+    X509_gmtime_adj(X509_getm_notAfter(certificate), 3600);
+    X509_set_pubkey(certificate, key);
+    X509_NAME *name = X509_get_subject_name(certificate);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char *>("127.0.0.1"), -1, -1, 0);
+    X509_set_issuer_name(certificate, name);
+    X509V3_CTX extensions;
+    X509V3_set_ctx_nodb(&extensions);
+    X509V3_set_ctx(&extensions, certificate, certificate, nullptr, nullptr, 0);
+    const char *entries[][2] = {{"subjectAltName", "IP:127.0.0.1"}, {"basicConstraints", "critical,CA:TRUE"}};
+    for (const auto &entry : entries)
+    {
+      X509_EXTENSION *extension = X509V3_EXT_conf(nullptr, &extensions, entry[0], entry[1]);
+      X509_add_ext(certificate, extension, -1);
+      X509_EXTENSION_free(extension);
+    }
+    X509_sign(certificate, key, EVP_sha256());
+
+    BIO *pem = BIO_new(BIO_s_mem());
+    PEM_write_bio_X509(pem, certificate);
+    char *data = nullptr;
+    long length = BIO_get_mem_data(pem, &data);
+    certificatePem.assign(data, static_cast<size_t>(length));
+    BIO_free(pem);
+
+    context = SSL_CTX_new(TLS_server_method());
+    if (context == nullptr || SSL_CTX_use_certificate(context, certificate) != 1 || SSL_CTX_use_PrivateKey(context, key) != 1)
+    {
+      throw std::runtime_error("Stand-in TLS context could not be set up");
+    }
+    X509_free(certificate);
+    EVP_PKEY_free(key);
+  }
+
+protected:
+  std::unique_ptr<StandInPeer> makePeer(int fd) override
+  {
+    SSL *ssl = SSL_new(context);
+    SSL_set_fd(ssl, fd);
+    if (SSL_accept(ssl) != 1)
+    {
+      SSL_free(ssl);
+      return nullptr;
+    }
+    handshakes++;
+    if (SSL_session_reused(ssl) == 1)
+    {
+      resumed++;
+    }
+    return std::unique_ptr<StandInPeer>(new TlsPeer(fd, ssl));
+  }
+
+public:
+  explicit StandInHttpsServer(Handler requestHandler)
+  {
+    // OpenSSL writes with write(), a client that hung up must not end the
+    // test with SIGPIPE
+    std::signal(SIGPIPE, SIG_IGN);
+    makeContext();
+    start(std::move(requestHandler));
+  }
+  ~StandInHttpsServer() override
+  {
+    stop();
+    SSL_CTX_free(context);
+  }
+
+  std::string url() const { return "https://127.0.0.1:" + std::to_string(port()) + "/"; }
+
+  // PEM of the certificate the server presents
+  const char *caCert() const { return certificatePem.c_str(); }
+
+  // Handshakes completed so far, and how many of them resumed a session
+  size_t tlsHandshakes() const { return handshakes; }
+  size_t tlsResumed() const { return resumed; }
+};
+
+// WebSocket server speaking just enough of RFC 6455 for PubSub tests. The
+// handler runs once per connection after the upgrade.
+class StandInWebSocketServer : public StandInServer
+{
+public:
+  class Session
+  {
+  private:
+    StandInPeer &peer;
+
+  public:
+    explicit Session(StandInPeer &peer) : peer(peer) {}
+
+    // Next text message from the client, answering pings on the way;
+    // false once the client closed
+    bool receive(std::string &message)
+    {
+      while (true)
+      {
+        unsigned char head[2];
+        if (!peer.readExactly(reinterpret_cast<char *>(head), 2))
+        {
+          return false;
+        }
+        uint8_t opcode = head[0] & 0x0F;
+        uint64_t length = head[1] & 0x7F;
+        if (length >= 126)
+        {
+          unsigned char extended[8];
+          size_t size = length == 126 ? 2 : 8;
+          if (!peer.readExactly(reinterpret_cast<char *>(extended), size))
+          {
+            return false;
+          }
+          length = 0;
+          for (size_t i = 0; i < size; ++i)
+          {
+            length = (length << 8) | extended[i];
+          }
+        }
+        unsigned char mask[4] = {0, 0, 0, 0};
+        if ((head[1] & 0x80) && !peer.readExactly(reinterpret_cast<char *>(mask), 4))
+        {
+          return false;
+        }
+        std::string payload(length, '\0');
+        if (length > 0 && !peer.readExactly(&payload[0], length))
+        {
+          return false;
+        }
+        for (size_t i = 0; i < payload.size(); ++i)
+        {
+          payload[i] = static_cast<char>(payload[i] ^ mask[i & 3]);
+        }
+        if (opcode == 0x8)
+        {
+          return false;
+        }
+        if (opcode == 0x9)
+        {
+          peer.write(frame(0xA, payload));
+          continue;
+        }
+        if (opcode == 0x1 || opcode == 0x2)
+        {
+          message = payload;
+          return true;
+        }
+      }
+    }
+
+    bool send(const std::string &text) { return peer.write(frame(0x1, text)); }
+
+    // Frames written with a single call, so the client reads them together
+    bool sendAll(const std::vector<std::string> &texts)
+    {
+      std::string out;
+      for (const auto &text : texts)
+      {
+        out += frame(0x1, text);
+      }
+      return peer.write(out);
+    }
+
+    // A text frame with the mask bit set, which servers must never send
+    bool sendMasked(const std::string &text) { return peer.write(frame(0x1, text, true)); }
+  };
+
+  using Handler = std::function<void(Session &session)>;
+
+  // One server frame, unmasked unless asked for
+  static std::string frame(uint8_t opcode, const std::string &payload, bool masked = false)
+  {
+    std::string out;
+    out += static_cast<char>(0x80 | opcode);
+    uint8_t maskBit = masked ? 0x80 : 0;
+    if (payload.size() < 126)
+    {
+      out += static_cast<char>(maskBit | payload.size());
+    }
+    else if (payload.size() <= 0xFFFF)
+    {
+      out += static_cast<char>(maskBit | 126);
+      out += static_cast<char>(payload.size() >> 8);
+      out += static_cast<char>(payload.size());
+    }
+    else
+    {
+      out += static_cast<char>(maskBit | 127);
+      for (int shift = 56; shift >= 0; shift -= 8)
+      {
+        out += static_cast<char>(static_cast<uint64_t>(payload.size()) >> shift);
+      }
+    }
+    if (!masked)
+    {
+      return out + payload;
+    }
+    const char mask[4] = {0x11, 0x22, 0x33, 0x44};
+    out.append(mask, 4);
+    for (size_t i = 0; i < payload.size(); ++i)
+    {
+      out += static_cast<char>(payload[i] ^ mask[i & 3]);
+    }
+    return out;
+  }
+
+  // Answer the upgrade with a Sec-WebSocket-Accept not derived from the
+  // client's key, as something other than a WebSocket server might
+  bool wrongAccept = false;
+
+private:
+  Handler handler;
+
+  static std::string acceptKey(const std::string &key)
+  {
+    std::string text = key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    unsigned char digest[SHA_DIGEST_LENGTH];
+    SHA1(reinterpret_cast<const unsigned char *>(text.data()), text.size(), digest);
+    unsigned char encoded[4 * ((SHA_DIGEST_LENGTH + 2) / 3) + 1];
+    int length = EVP_EncodeBlock(encoded, digest, SHA_DIGEST_LENGTH);
+    return std::string(reinterpret_cast<char *>(encoded), length);
+  }
+
+  void serve(StandInPeer &peer)
+  {
+    std::string line;
+    std::string key;
+    if (!peer.readLine(line) || line.rfind("GET ", 0) != 0)
+    {
+      return;
+    }
+    while (peer.readLine(line) && !line.empty())
+    {
+      std::string lower = line;
+      for (char &c : lower)
+      {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+      }
+      if (lower.rfind("sec-websocket-key:", 0) == 0)
+      {
+        key = line.substr(line.find_first_not_of(' ', 18));
+      }
+    }
+    std::string response = "HTTP/1.1 101 Switching Protocols\r\n"
+                           "Upgrade: websocket\r\n"
+                           "Connection: Upgrade\r\n"
+                           "Sec-WebSocket-Accept: " +
+                           acceptKey(wrongAccept ? key + "x" : key) + "\r\n\r\n";
+    if (!peer.write(response))
+    {
+      return;
+    }
+    Session session(peer);
+    handler(session);
+  }
+
+public:
+  explicit StandInWebSocketServer(Handler sessionHandler) : handler(std::move(sessionHandler))
+  {
+    start([this](StandInPeer &peer)
+          { serve(peer); });
+  }
+  ~StandInWebSocketServer() override { stop(); }
+
+  std::string url() const { return "ws://127.0.0.1:" + std::to_string(port()) + "/"; }
+};
+
+// Value of "method" in a JSON-RPC request body, empty if there is none
+inline std::string standInMethod(const std::string &body)
+{
+  size_t key = body.find("\"method\"");
+  if (key == std::string::npos)
+  {
+    return "";
+  }
+  size_t open = body.find('"', body.find(':', key) + 1);
+  size_t close = body.find('"', open + 1);
+  return body.substr(open + 1, close - open - 1);
+}
+
+// Value of "id" in a JSON-RPC request body, 0 if there is none
+inline uint32_t standInId(const std::string &body)
+{
+  size_t key = body.find("\"id\"");
+  if (key == std::string::npos)
+  {
+    return 0;
+  }
+  return static_cast<uint32_t>(std::strtoul(body.c_str() + body.find(':', key) + 1, nullptr, 10));
+}
+
+// JSON-RPC response envelope around result, which is raw JSON
+inline std::string standInResult(const std::string &request, const std::string &result)
+{
+  return "{\"jsonrpc\":\"2.0\",\"result\":" + result + ",\"id\":" + std::to_string(standInId(request)) + "}";
+}
+
+inline std::string standInError(const std::string &request, int code, const std::string &message)
+{
+  return "{\"jsonrpc\":\"2.0\",\"error\":{\"code\":" + std::to_string(code) + ",\"message\":\"" + message + "\"},\"id\":" + std::to_string(standInId(request)) + "}";
+}
+
+// body wrapped in a gzip member made of a single stored deflate block, with
+// the CRC-32 and length trailer. Bodies are kept under 64 KiB.
+inline std::string standInGzip(const std::string &body)
+{
+  uint32_t crc = 0xFFFFFFFF;
+  for (unsigned char c : body)
+  {
+    crc ^= c;
+    for (int bit = 0; bit < 8; ++bit)
+    {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+  crc = ~crc;
+  uint16_t length = static_cast<uint16_t>(body.size());
+  std::string gzip("\x1f\x8b\x08\x00\x00\x00\x00\x00\x00\xff", 10);
+  // Final stored block: LEN and its complement, then the bytes as they are
+  gzip.push_back('\x01');
+  gzip.push_back(static_cast<char>(length & 0xFF));
+  gzip.push_back(static_cast<char>(length >> 8));
+  gzip.push_back(static_cast<char>(~length & 0xFF));
+  gzip.push_back(static_cast<char>((~length >> 8) & 0xFF));
+  gzip += body;
+  for (uint32_t value : {crc, static_cast<uint32_t>(body.size())})
+  {
+    for (int i = 0; i < 4; ++i)
+    {
+      gzip.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+  }
+  return gzip;
+}
+
+#endif // STAND_IN_SERVER_H
@@ -0,0 +1,174 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <optional>
+#include <unity.h>
+#include <ArduinoJson.h>
+#include "SolanaSDK/account_cache.h"
+#include "SolanaSDK/loopback_transport.h"
+
+static PublicKey keyFilledWith(uint8_t value)
+{
+  return PublicKey(std::vector<uint8_t>(PUBLIC_KEY_LEN, value));
+}
+
+// Stand-in node holding lamports per account at its current slot; an
+// account without an entry does not exist
+struct AccountNode
+{
+  uint64_t slot = 10;
+  std::map<std::string, uint64_t> lamports;
+  // Accounts asked for, per getMultipleAccounts call
+  std::vector<size_t> calls;
+  std::mutex mutex;
+
+  std::string answer(const std::string &request)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    JsonDocument requestDoc;
+    deserializeJson(requestDoc, request);
+    JsonArrayConst accounts = requestDoc["params"][0];
+    calls.push_back(accounts.size());
+    std::string values;
+    for (JsonVariantConst account : accounts)
+    {
+      values += values.empty() ? "" : ",";
+      auto it = lamports.find(account.as<std::string>());
+      if (it == lamports.end())
+      {
+        values += "null";
+        continue;
+      }
+      values += "{\"lamports\":" + std::to_string(it->second) + ",\"owner\":\"11111111111111111111111111111111\","
+                "\"data\":[\"AQID\",\"base64\"],\"executable\":false,\"rentEpoch\":0}";
+    }
+    return "{\"jsonrpc\":\"2.0\",\"result\":{\"context\":{\"slot\":" + std::to_string(slot) + "},\"value\":[" + values +
+           "]},\"id\":" + std::to_string(requestDoc["id"] | 0u) + "}";
+  }
+};
+
+static Connection connectionTo(AccountNode &node)
+{
+  auto transport = std::make_shared<LoopbackTransport>([&node](const std::string &request)
+                                                       { return node.answer(request); },
+                                                       4);
+  return Connection(transport, Commitment::confirmed);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_closed_account_replaces_an_older_read()
+{
+  AccountNode node;
+  PublicKey account = keyFilledWith(1);
+  node.lamports[account.toBase58()] = 500;
+  // Every get goes to the node
+  AccountCache cache(connectionTo(node), 8, 0, 0);
+  TEST_ASSERT_EQUAL_UINT64(500, cache.get(account, Commitment::confirmed)->lamports);
+
+  // Closed at slot 12
+  node.lamports.clear();
+  node.slot = 12;
+  TEST_ASSERT_FALSE(cache.get(account, Commitment::confirmed).has_value());
+  TEST_ASSERT_FALSE(cache.peek(account).has_value());
+
+  // A node lagging behind the closure does not bring the account back
+  node.lamports[account.toBase58()] = 500;
+  node.slot = 11;
+  cache.get(account, Commitment::confirmed);
+  TEST_ASSERT_FALSE(cache.peek(account).has_value());
+}
+
+void test_update_without_lamports_closes_the_account()
+{
+  AccountNode node;
+  PublicKey account = keyFilledWith(2);
+  node.lamports[account.toBase58()] = 700;
+  AccountCache cache(connectionTo(node), 8, 60000, 0);
+  cache.get(account, Commitment::confirmed);
+
+  AccountInfo closed = *cache.peek(account);
+  closed.lamports = 0;
+  closed.slot = 9;
+  cache.update(account, closed, Commitment::confirmed);
+  TEST_ASSERT_TRUE(cache.peek(account).has_value());
+
+  closed.slot = 11;
+  cache.update(account, closed, Commitment::confirmed);
+  TEST_ASSERT_FALSE(cache.peek(account).has_value());
+  TEST_ASSERT_FALSE(cache.get(account, Commitment::confirmed).has_value());
+  TEST_ASSERT_EQUAL(1, node.calls.size());
+}
+
+void test_concurrent_misses_share_one_request()
+{
+  AccountNode node;
+  std::vector<PublicKey> accounts;
+  for (uint8_t i = 1; i <= 4; ++i)
+  {
+    accounts.push_back(keyFilledWith(i));
+    node.lamports[accounts.back().toBase58()] = 100 * i;
+  }
+  AccountCache cache(connectionTo(node), 8, 60000, 100);
+
+  std::vector<std::optional<AccountInfo>> results(accounts.size());
+  std::vector<std::thread> readers;
+  for (size_t i = 0; i < accounts.size(); ++i)
+  {
+    readers.emplace_back([&, i]
+                         { results[i] = cache.get(accounts[i], Commitment::confirmed); });
+  }
+  for (auto &reader : readers)
+  {
+    reader.join();
+  }
+
+  TEST_ASSERT_EQUAL(1, node.calls.size());
+  TEST_ASSERT_EQUAL(4, node.calls[0]);
+  for (size_t i = 0; i < accounts.size(); ++i)
+  {
+    TEST_ASSERT_TRUE(results[i].has_value());
+    TEST_ASSERT_EQUAL_UINT64(100 * (i + 1), results[i]->lamports);
+  }
+}
+
+void test_least_recently_used_entry_is_evicted()
+{
+  AccountNode node;
+  PublicKey first = keyFilledWith(1);
+  PublicKey second = keyFilledWith(2);
+  PublicKey third = keyFilledWith(3);
+  for (PublicKey account : {first, second, third})
+  {
+    node.lamports[account.toBase58()] = 1;
+  }
+  AccountCache cache(connectionTo(node), 2, 60000, 0);
+
+  cache.get(first, Commitment::confirmed);
+  cache.get(second, Commitment::confirmed);
+  // A hit makes first the most recently used
+  cache.get(first, Commitment::confirmed);
+  TEST_ASSERT_EQUAL(2, node.calls.size());
+  cache.get(third, Commitment::confirmed);
+
+  TEST_ASSERT_EQUAL(2, cache.size());
+  TEST_ASSERT_TRUE(cache.peek(first).has_value());
+  TEST_ASSERT_FALSE(cache.peek(second).has_value());
+  TEST_ASSERT_TRUE(cache.peek(third).has_value());
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_closed_account_replaces_an_older_read);
+  RUN_TEST(test_update_without_lamports_closes_the_account);
+  RUN_TEST(test_concurrent_misses_share_one_request);
+  RUN_TEST(test_least_recently_used_entry_is_evicted);
+  return UNITY_END();
+}
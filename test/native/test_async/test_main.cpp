@@ -0,0 +1,153 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <chrono>
+#include <optional>
+#include <algorithm>
+#include <unity.h>
+#include "SolanaSDK/connection.h"
+#include "SolanaSDK/rpc_batch.h"
+#include "SolanaSDK/loopback_transport.h"
+#include "../support/stand_in_server.h"
+
+// Requests the handler is working on at once, and the most seen so far
+struct InFlight
+{
+  std::atomic<int> now{0};
+  std::atomic<int> most{0};
+
+  void enter()
+  {
+    int current = ++now;
+    int seen = most;
+    while (current > seen && !most.compare_exchange_weak(seen, current))
+    {
+    }
+  }
+
+  void leave() { now--; }
+};
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_calls_run_in_parallel_over_pooled_sockets()
+{
+  InFlight inFlight;
+  StandInHttpServer server([&inFlight](const StandInRequest &request)
+                           {
+                             inFlight.enter();
+                             std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                             inFlight.leave();
+                             return StandInResponse::json(standInResult(request.body, "4242")); });
+  Connection connection(server.url(), Commitment::confirmed, 4);
+
+  std::vector<std::future<uint64_t>> heights;
+  for (int i = 0; i < 8; ++i)
+  {
+    heights.push_back(connection.getBlockHeightAsync());
+  }
+  for (auto &height : heights)
+  {
+    TEST_ASSERT_EQUAL_UINT64(4242, height.get());
+  }
+  TEST_ASSERT_EQUAL(4, inFlight.most.load());
+  TEST_ASSERT_EQUAL(8, server.requests());
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(4, server.connections());
+}
+
+void test_errors_are_rethrown_by_get()
+{
+  auto transport = std::make_shared<LoopbackTransport>([](const std::string &request)
+                                                       { return standInError(request, -32005, "Node is behind"); });
+  Connection connection(transport, Commitment::confirmed);
+  std::future<uint64_t> height = connection.getBlockHeightAsync();
+
+  bool thrown = false;
+  try
+  {
+    height.get();
+  }
+  catch (const RpcException &e)
+  {
+    thrown = true;
+    TEST_ASSERT_TRUE(e.code == RpcErrorCode::rpc);
+  }
+  TEST_ASSERT_TRUE(thrown);
+
+  // A lost reply is a transport error
+  auto silent = std::make_shared<LoopbackTransport>([](const std::string &)
+                                                    { return std::string(); });
+  Connection lost(silent, Commitment::confirmed);
+  thrown = false;
+  try
+  {
+    lost.getLatestBlockhashAsync().get();
+  }
+  catch (const RpcException &e)
+  {
+    thrown = true;
+    TEST_ASSERT_TRUE(e.code == RpcErrorCode::transport);
+  }
+  TEST_ASSERT_TRUE(thrown);
+}
+
+void test_queued_calls_finish_after_the_connection_is_gone()
+{
+  auto transport = std::make_shared<LoopbackTransport>([](const std::string &request)
+                                                       {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return standInResult(request, "77"); });
+  std::vector<std::future<uint64_t>> heights;
+  {
+    Connection connection(transport, Commitment::confirmed);
+    for (int i = 0; i < 3; ++i)
+    {
+      heights.push_back(connection.getBlockHeightAsync());
+    }
+  }
+  for (auto &height : heights)
+  {
+    TEST_ASSERT_EQUAL_UINT64(77, height.get());
+  }
+  TEST_ASSERT_EQUAL(3, transport->requestCount());
+}
+
+void test_blocking_calls_and_batches_share_the_connection()
+{
+  auto transport = std::make_shared<LoopbackTransport>([](const std::string &request)
+                                                       {
+    if (request[0] != '[')
+    {
+      return standInResult(request, "5");
+    }
+    return "[" + standInResult(request, "6") + "]"; });
+  Connection connection(transport, Commitment::confirmed);
+  std::future<uint64_t> pending = connection.getBlockHeightAsync();
+  TEST_ASSERT_EQUAL_UINT64(5, connection.getBlockHeight());
+  TEST_ASSERT_EQUAL_UINT64(5, pending.get());
+
+  std::optional<uint64_t> batched;
+  RpcBatch batch;
+  batch.getBlockHeight(Commitment::confirmed, [&batched](std::optional<uint64_t> value)
+                       { batched = value; });
+  TEST_ASSERT_TRUE(connection.sendBatchAsync(batch).get());
+  // The batch was copied into the task, its callback still reports here
+  TEST_ASSERT_TRUE(batched.has_value());
+  TEST_ASSERT_EQUAL_UINT64(6, *batched);
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_calls_run_in_parallel_over_pooled_sockets);
+  RUN_TEST(test_errors_are_rethrown_by_get);
+  RUN_TEST(test_queued_calls_finish_after_the_connection_is_gone);
+  RUN_TEST(test_blocking_calls_and_batches_share_the_connection);
+  return UNITY_END();
+}
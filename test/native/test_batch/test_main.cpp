@@ -0,0 +1,171 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <algorithm>
+#include <unity.h>
+#include <ArduinoJson.h>
+#include "SolanaSDK/connection.h"
+#include "SolanaSDK/rpc_batch.h"
+#include "SolanaSDK/loopback_transport.h"
+
+// A blockhash whose first byte is 0, so its base58 form starts with '1'
+static Hash leadingZeroBlockhash()
+{
+  std::vector<uint8_t> bytes(HASH_BYTES, 0x5A);
+  bytes[0] = 0;
+  return Hash::deserialize(bytes);
+}
+
+// Answers each call of a batch with result(method), in reverse order so
+// responses have to be matched by id
+static std::shared_ptr<LoopbackTransport> batchNode(std::function<std::string(const std::string &method)> result)
+{
+  return std::make_shared<LoopbackTransport>([result](const std::string &request)
+                                             {
+    JsonDocument requestDoc;
+    deserializeJson(requestDoc, request);
+    std::vector<std::string> responses;
+    for (JsonVariantConst call : requestDoc.as<JsonArrayConst>())
+    {
+      std::string answer = result(call["method"] | "");
+      if (!answer.empty())
+      {
+        responses.push_back("{\"jsonrpc\":\"2.0\",\"result\":" + answer + ",\"id\":" + std::to_string(call["id"] | 0u) + "}");
+      }
+    }
+    std::reverse(responses.begin(), responses.end());
+    std::string body = "[";
+    for (const std::string &response : responses)
+    {
+      body += (body.size() > 1 ? "," : "") + response;
+    }
+    return body + "]"; });
+}
+
+static std::string blockhashResult(const std::string &blockhash)
+{
+  return "{\"context\":{\"slot\":1},\"value\":{\"blockhash\":\"" + blockhash + "\",\"lastValidBlockHeight\":900}}";
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_results_reach_their_callbacks()
+{
+  Hash expected = leadingZeroBlockhash();
+  std::string blockhash = expected.toStr();
+  TEST_ASSERT_TRUE(blockhash[0] == '1');
+  Connection connection(batchNode([&blockhash](const std::string &method) -> std::string
+                                  {
+                                    if (method == "getLatestBlockhash")
+                                    {
+                                      return blockhashResult(blockhash);
+                                    }
+                                    if (method == "getBlockHeight")
+                                    {
+                                      return "812";
+                                    }
+                                    if (method == "getBalance")
+                                    {
+                                      return "{\"context\":{\"slot\":1},\"value\":5000}";
+                                    }
+                                    return ""; }),
+                        Commitment::confirmed);
+
+  std::optional<BlockhashWithExpiryBlockHeight> latest;
+  std::optional<uint64_t> height;
+  std::optional<uint64_t> balance;
+  RpcBatch batch;
+  batch.getLatestBlockhash(Commitment::confirmed, [&latest](std::optional<BlockhashWithExpiryBlockHeight> value)
+                           { latest = value; });
+  batch.getBlockHeight(Commitment::confirmed, [&height](std::optional<uint64_t> value)
+                       { height = value; });
+  batch.getBalance(PublicKey(std::vector<uint8_t>(PUBLIC_KEY_LEN, 1)), Commitment::confirmed, [&balance](std::optional<uint64_t> value)
+                   { balance = value; });
+
+  TEST_ASSERT_TRUE(connection.sendBatch(batch));
+  TEST_ASSERT_TRUE(latest.has_value());
+  TEST_ASSERT_TRUE(latest->blockhash.data == expected.data);
+  TEST_ASSERT_EQUAL_UINT64(900, latest->lastValidBlockHeight);
+  TEST_ASSERT_TRUE(height.has_value());
+  TEST_ASSERT_EQUAL_UINT64(812, *height);
+  TEST_ASSERT_TRUE(balance.has_value());
+  TEST_ASSERT_EQUAL_UINT64(5000, *balance);
+}
+
+void test_malformed_and_missing_results_fail_only_their_call()
+{
+  Connection connection(batchNode([](const std::string &method) -> std::string
+                                  {
+                                    if (method == "getLatestBlockhash")
+                                    {
+                                      return blockhashResult("3xyz");
+                                    }
+                                    if (method == "getBlockHeight")
+                                    {
+                                      return "812";
+                                    }
+                                    return ""; }),
+                        Commitment::confirmed);
+
+  bool blockhashCalled = false;
+  std::optional<BlockhashWithExpiryBlockHeight> latest;
+  std::optional<uint64_t> height;
+  bool balanceCalled = false;
+  std::optional<uint64_t> balance;
+  RpcBatch batch;
+  batch.getLatestBlockhash(Commitment::confirmed, [&](std::optional<BlockhashWithExpiryBlockHeight> value)
+                           { blockhashCalled = true; latest = value; });
+  batch.getBlockHeight(Commitment::confirmed, [&height](std::optional<uint64_t> value)
+                       { height = value; });
+  batch.getBalance(PublicKey(std::vector<uint8_t>(PUBLIC_KEY_LEN, 1)), Commitment::confirmed, [&](std::optional<uint64_t> value)
+                   { balanceCalled = true; balance = value; });
+
+  TEST_ASSERT_TRUE(connection.sendBatch(batch));
+  TEST_ASSERT_TRUE(blockhashCalled);
+  TEST_ASSERT_FALSE(latest.has_value());
+  TEST_ASSERT_TRUE(height.has_value());
+  TEST_ASSERT_EQUAL_UINT64(812, *height);
+  TEST_ASSERT_TRUE(balanceCalled);
+  TEST_ASSERT_FALSE(balance.has_value());
+}
+
+void test_throwing_callback_does_not_drop_the_others()
+{
+  Connection connection(batchNode([](const std::string &method) -> std::string
+                                  { return method == "getBlockHeight" ? "812" : "null"; }),
+                        Commitment::confirmed);
+
+  std::optional<uint64_t> height;
+  RpcBatch batch;
+  batch.add("getHealth", nullptr, [](JsonVariantConst, JsonVariantConst)
+            { throw std::runtime_error("handler failed"); });
+  batch.getBlockHeight(Commitment::confirmed, [&height](std::optional<uint64_t> value)
+                       { height = value; });
+
+  bool thrown = false;
+  try
+  {
+    connection.sendBatch(batch);
+  }
+  catch (const std::runtime_error &)
+  {
+    thrown = true;
+  }
+  TEST_ASSERT_TRUE(thrown);
+  TEST_ASSERT_TRUE(height.has_value());
+  TEST_ASSERT_EQUAL_UINT64(812, *height);
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_results_reach_their_callbacks);
+  RUN_TEST(test_malformed_and_missing_results_fail_only_their_call);
+  RUN_TEST(test_throwing_callback_does_not_drop_the_others);
+  return UNITY_END();
+}
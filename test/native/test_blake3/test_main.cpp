@@ -0,0 +1,111 @@
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <unity.h>
+#include "SolanaSDK/blake3.h"
+#include "SolanaSDK/message.h"
+
+// Official BLAKE3 test vectors: input byte i is i % 251
+struct Blake3Vector
+{
+  size_t length;
+  const char *hex;
+};
+
+static const Blake3Vector VECTORS[] = {
+    {0, "af1349b9f5f9a1a6a0404dea36dcc9499bcb25c9adc112b7cc9a93cae41f3262"},
+    {1, "2d3adedff11b61f14c886e35afa036736dcd87a74d27b5c1510225d0f592e213"},
+    {63, "e9bc37a594daad83be9470df7f7b3798297c3d834ce80ba85d6e207627b7db7b"},
+    {64, "4eed7141ea4a5cd4b788606bd23f46e212af9cacebacdc7d1f4c6dc7f2511b98"},
+    {65, "de1e5fa0be70df6d2be8fffd0e99ceaa8eb6e8c93a63f2d8d1c30ecb6b263dee"},
+    {1023, "10108970eeda3eb932baac1428c7a2163b0e924c9a9e25b35bba72b28f70bd11"},
+    {1024, "42214739f095a406f3fc83deb889744ac00df831c10daa55189b5d121c855af7"},
+    {1025, "d00278ae47eb27b34faecf67b4fe263f82d5412916c1ffd97c8cb7fb814b8444"},
+    {2048, "e776b6028c7cd22a4d0ba182a8bf62205d2ef576467e838ed6f2529b85fba24a"},
+    {2049, "5f4d72f40d7a5f82b15ca2b2e44b1de3c2ef86c426c95c1af0b6879522563030"},
+    {3072, "b98cb0ff3623be03326b373de6b9095218513e64f1ee2edd2525c7ad1e5cffd2"},
+    {3073, "7124b49501012f81cc7f11ca069ec9226cecb8a2c850cfe644e327d22d3e1cd3"},
+    {4096, "015094013f57a5277b59d8475c0501042c0b642e531b0a1c8f58d2163229e969"},
+    {4097, "9b4052b38f1c5fc8b1f9ff7ac7b27cd242487b3d890d15c96a1c25b8aa0fb995"},
+    {8192, "aae792484c8efe4f19e2ca7d371d8c467ffb10748d8a5a1ae579948f718a2a63"},
+    {8193, "bab6c09cb8ce8cf459261398d2e7aef35700bf488116ceb94a36d0f5f1b7bc3b"},
+    {16384, "f875d6646de28985646f34ee13be9a576fd515f76b5b0a26bb324735041ddde4"},
+    {31744, "62b6960e1a44bcc1eb1a611a8d6235b6b4b78f32e7abc4fb4c6cdcce94895c47"},
+    {102400, "bc3e3d41a1146b069abffad3c0d44860cf664390afce4d9661f7902e7943e085"},
+};
+
+static std::vector<uint8_t> vectorInput(size_t length)
+{
+  std::vector<uint8_t> input(length);
+  for (size_t i = 0; i < length; ++i)
+  {
+    input[i] = static_cast<uint8_t>(i % 251);
+  }
+  return input;
+}
+
+static std::string toHex(const Hash &hash)
+{
+  std::string hex;
+  char digits[3];
+  for (uint8_t byte : hash.data)
+  {
+    std::snprintf(digits, sizeof(digits), "%02x", byte);
+    hex += digits;
+  }
+  return hex;
+}
+
+// Digest of input fed to the hasher in pieces of step bytes
+static std::string blake3Hex(const std::vector<uint8_t> &input, size_t step)
+{
+  Blake3Hasher hasher;
+  for (size_t offset = 0; offset < input.size(); offset += step)
+  {
+    hasher.hash(input.data() + offset, std::min(step, input.size() - offset));
+  }
+  Hash hash;
+  hasher.result(&hash);
+  return toHex(hash);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_official_vectors()
+{
+  for (const Blake3Vector &vector : VECTORS)
+  {
+    std::vector<uint8_t> input = vectorInput(vector.length);
+    TEST_ASSERT_EQUAL_STRING(vector.hex, blake3Hex(input, input.size() + 1).c_str());
+  }
+}
+
+void test_vectors_fed_in_pieces()
+{
+  for (const Blake3Vector &vector : VECTORS)
+  {
+    std::vector<uint8_t> input = vectorInput(vector.length);
+    for (size_t step : {size_t(1), size_t(63), size_t(1000), size_t(BLAKE3_CHUNK_LEN), size_t(3 * BLAKE3_CHUNK_LEN + 5)})
+    {
+      TEST_ASSERT_EQUAL_STRING(vector.hex, blake3Hex(input, step).c_str());
+    }
+  }
+}
+
+void test_message_hash_is_domain_separated()
+{
+  std::vector<uint8_t> messageBytes = vectorInput(300);
+  TEST_ASSERT_EQUAL_STRING("b33ef3d5a488f46347d1b78f35afa04c1e534cb41148fdaee222d1bbd55dbad5", toHex(Message::hashRawMessage(messageBytes)).c_str());
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_official_vectors);
+  RUN_TEST(test_vectors_fed_in_pieces);
+  RUN_TEST(test_message_hash_is_domain_separated);
+  return UNITY_END();
+}
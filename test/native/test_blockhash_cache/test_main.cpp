@@ -0,0 +1,129 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <optional>
+#include <stdexcept>
+#include <unity.h>
+#include <ArduinoJson.h>
+#include "SolanaSDK/blockhash_cache.h"
+#include "SolanaSDK/loopback_transport.h"
+
+// Stand-in node answering the cache's batches. The blockhash starts with a
+// zero byte, so its base58 form starts with '1'.
+struct CacheNode
+{
+  Hash blockhash;
+  std::atomic<size_t> throwing{0};
+  std::atomic<size_t> batches{0};
+
+  CacheNode()
+  {
+    std::vector<uint8_t> bytes(HASH_BYTES, 0x3C);
+    bytes[0] = 0;
+    blockhash = Hash::deserialize(bytes);
+  }
+
+  std::string answer(const std::string &request)
+  {
+    batches++;
+    if (throwing > 0)
+    {
+      throwing--;
+      throw std::runtime_error("node went away");
+    }
+    JsonDocument requestDoc;
+    deserializeJson(requestDoc, request);
+    std::string response = "[";
+    for (JsonVariantConst call : requestDoc.as<JsonArrayConst>())
+    {
+      std::string method = call["method"] | "";
+      std::string result = method == "getBlockHeight" ? "1000" : "{\"context\":{\"slot\":1},\"value\":{\"blockhash\":\"" + blockhash.toStr() + "\",\"lastValidBlockHeight\":1150}}";
+      response += (response.size() > 1 ? "," : "") + std::string("{\"jsonrpc\":\"2.0\",\"result\":") + result + ",\"id\":" + std::to_string(call["id"] | 0u) + "}";
+    }
+    return response + "]";
+  }
+};
+
+static Connection connectionTo(CacheNode &node)
+{
+  auto transport = std::make_shared<LoopbackTransport>([&node](const std::string &request)
+                                                       { return node.answer(request); });
+  return Connection(transport, Commitment::confirmed);
+}
+
+// Wait up to timeoutMs for the cache to hold a usable blockhash
+static std::optional<BlockhashWithExpiryBlockHeight> waitForBlockhash(BlockhashCache &cache, uint32_t timeoutMs = 2000)
+{
+  auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+  std::optional<BlockhashWithExpiryBlockHeight> blockhash = cache.get(Commitment::confirmed);
+  while (!blockhash && std::chrono::steady_clock::now() < until)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    blockhash = cache.get(Commitment::confirmed);
+  }
+  return blockhash;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_refresher_keeps_a_leading_zero_blockhash()
+{
+  CacheNode node;
+  BlockhashCache cache(connectionTo(node), 200);
+  cache.start();
+  TEST_ASSERT_FALSE(cache.get(Commitment::confirmed).has_value());
+
+  std::optional<BlockhashWithExpiryBlockHeight> blockhash = waitForBlockhash(cache);
+  cache.stop();
+  TEST_ASSERT_TRUE(blockhash.has_value());
+  TEST_ASSERT_TRUE(blockhash->blockhash.data == node.blockhash.data);
+  TEST_ASSERT_EQUAL_UINT64(1150, blockhash->lastValidBlockHeight);
+  TEST_ASSERT_GREATER_THAN_UINT32(100, cache.remainingBlocks(Commitment::confirmed));
+}
+
+void test_refresh_that_throws_is_retried()
+{
+  CacheNode node;
+  node.throwing = 2;
+  BlockhashCache cache(connectionTo(node), 200);
+  cache.track(Commitment::confirmed);
+  cache.start();
+
+  // The refresher outlives the failures and picks the blockhash up later
+  std::optional<BlockhashWithExpiryBlockHeight> blockhash = waitForBlockhash(cache);
+  cache.stop();
+  TEST_ASSERT_TRUE(blockhash.has_value());
+  TEST_ASSERT_TRUE(blockhash->blockhash.data == node.blockhash.data);
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(3, node.batches.load());
+}
+
+void test_get_or_fetch_and_invalidate()
+{
+  CacheNode node;
+  BlockhashCache cache(connectionTo(node), 60000);
+  BlockhashWithExpiryBlockHeight fetched = cache.getOrFetch(Commitment::confirmed);
+  TEST_ASSERT_TRUE(fetched.blockhash.data == node.blockhash.data);
+  TEST_ASSERT_EQUAL(1, node.batches.load());
+
+  // Served from the cache until invalidated
+  TEST_ASSERT_TRUE(cache.get(Commitment::confirmed).has_value());
+  cache.invalidate(Commitment::confirmed);
+  TEST_ASSERT_FALSE(cache.get(Commitment::confirmed).has_value());
+  cache.getOrFetch(Commitment::confirmed);
+  TEST_ASSERT_EQUAL(2, node.batches.load());
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_refresher_keeps_a_leading_zero_blockhash);
+  RUN_TEST(test_refresh_that_throws_is_retried);
+  RUN_TEST(test_get_or_fetch_and_invalidate);
+  return UNITY_END();
+}
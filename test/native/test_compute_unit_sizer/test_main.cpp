@@ -0,0 +1,66 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <unity.h>
+#include "SolanaSDK/compute_unit_sizer.h"
+#include "SolanaSDK/loopback_transport.h"
+#include "../support/stand_in_server.h"
+
+static PublicKey keyNumber(uint8_t n)
+{
+  PublicKey key;
+  std::fill(std::begin(key.key), std::end(key.key), 0);
+  key.key[0] = n;
+  return key;
+}
+
+// Instruction of a stand-in program whose data starts with discriminator
+static Instruction call(uint8_t discriminator, uint8_t argument)
+{
+  std::vector<uint8_t> data(16, 0);
+  data[0] = discriminator;
+  data[12] = argument;
+  return Instruction::newWithBytes(keyNumber(7), data, {AccountMeta::writable(keyNumber(1), true)});
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_arguments_past_the_discriminator_share_a_limit()
+{
+  auto transport = std::make_shared<LoopbackTransport>([](const std::string &request)
+                                                       { return standInResult(request, "{\"context\":{\"slot\":1},\"value\":{\"err\":null,\"logs\":[],\"unitsConsumed\":20000}}"); });
+  ComputeUnitSizer sizer(Connection(transport, Commitment::confirmed));
+
+  uint32_t first = sizer.computeUnitLimit({call(1, 10)}, keyNumber(1));
+  uint32_t second = sizer.computeUnitLimit({call(1, 99)}, keyNumber(1));
+  TEST_ASSERT_EQUAL(first, second);
+  TEST_ASSERT_EQUAL(1, transport->requestCount());
+}
+
+void test_each_discriminator_is_simulated()
+{
+  uint32_t units = 20000;
+  auto transport = std::make_shared<LoopbackTransport>([&units](const std::string &request)
+                                                       {
+    std::string result = "{\"context\":{\"slot\":1},\"value\":{\"err\":null,\"logs\":[],\"unitsConsumed\":" + std::to_string(units) + "}}";
+    units *= 4;
+    return standInResult(request, result); });
+  ComputeUnitSizer sizer(Connection(transport, Commitment::confirmed));
+
+  uint32_t cheap = sizer.computeUnitLimit({call(1, 10)}, keyNumber(1));
+  uint32_t costly = sizer.computeUnitLimit({call(2, 10)}, keyNumber(1));
+  TEST_ASSERT_EQUAL(2, transport->requestCount());
+  TEST_ASSERT_TRUE(costly > cheap);
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_arguments_past_the_discriminator_share_a_limit);
+  RUN_TEST(test_each_discriminator_is_simulated);
+  return UNITY_END();
+}
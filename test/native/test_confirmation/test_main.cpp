@@ -0,0 +1,206 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <set>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <stdexcept>
+#include <algorithm>
+#include <unity.h>
+#include <ArduinoJson.h>
+#include "SolanaSDK/confirmation_engine.h"
+#include "SolanaSDK/loopback_transport.h"
+#include "SolanaSDK/programs/system_program.h"
+
+// Stand-in node answering batches; remembers how many calls of each kind
+// every batch carried
+struct BatchNode
+{
+  uint64_t blockHeight = 100;
+  std::vector<size_t> statusCalls;
+  std::vector<size_t> sends;
+  // Signatures reported as finalized
+  std::set<std::string> landed;
+  // Requests that throw before being answered
+  std::atomic<size_t> throwing{0};
+
+  std::string answer(const std::string &request)
+  {
+    if (throwing > 0)
+    {
+      throwing--;
+      throw std::runtime_error("node went away");
+    }
+    JsonDocument requestDoc;
+    deserializeJson(requestDoc, request);
+    if (!requestDoc.is<JsonArrayConst>())
+    {
+      // A single sendTransaction, answered with a signature of its own
+      std::string signature = Signature::deserialize(std::vector<uint8_t>(SIGNATURE_BYTES, 0x33)).toString();
+      return "{\"jsonrpc\":\"2.0\",\"result\":\"" + signature + "\",\"id\":" + std::to_string(requestDoc["id"] | 0u) + "}";
+    }
+    size_t statusCount = 0;
+    size_t sendCount = 0;
+    std::string response = "[";
+    for (JsonVariantConst call : requestDoc.as<JsonArrayConst>())
+    {
+      std::string method = call["method"] | "";
+      std::string result = "null";
+      if (method == "getBlockHeight")
+      {
+        result = std::to_string(blockHeight);
+      }
+      else if (method == "getSignatureStatuses")
+      {
+        statusCount++;
+        result = "{\"context\":{\"slot\":1},\"value\":[";
+        for (size_t i = 0; i < call["params"][0].size(); ++i)
+        {
+          bool found = landed.count(call["params"][0][i].as<std::string>()) > 0;
+          result += i == 0 ? "" : ",";
+          result += found ? "{\"slot\":5,\"confirmations\":null,\"err\":null,\"confirmationStatus\":\"finalized\"}" : "null";
+        }
+        result += "]}";
+      }
+      else if (method == "sendTransaction")
+      {
+        sendCount++;
+        result = "\"sig\"";
+      }
+      if (response.size() > 1)
+      {
+        response += ",";
+      }
+      response += "{\"jsonrpc\":\"2.0\",\"result\":" + result + ",\"id\":" + std::to_string(call["id"] | 0u) + "}";
+    }
+    if (statusCount > 0)
+    {
+      statusCalls.push_back(statusCount);
+    }
+    if (sendCount > 0)
+    {
+      sends.push_back(sendCount);
+    }
+    return response + "]";
+  }
+};
+
+static Signature signatureNumber(uint32_t n)
+{
+  std::vector<uint8_t> bytes(SIGNATURE_BYTES, 0);
+  bytes[0] = 0xAA;
+  bytes[1] = static_cast<uint8_t>(n);
+  bytes[2] = static_cast<uint8_t>(n >> 8);
+  return Signature(bytes);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_statuses_are_split_across_batches()
+{
+  BatchNode node;
+  auto transport = std::make_shared<LoopbackTransport>([&node](const std::string &request)
+                                                       { return node.answer(request); });
+  ConfirmationEngine engine(Connection(transport, Commitment::confirmed));
+  size_t tracked = CONFIRMATION_STATUSES_PER_CALL * (CONFIRMATION_STATUS_CALLS_PER_BATCH + 1);
+  std::vector<std::future<ConfirmationResult>> futures;
+  for (uint32_t i = 0; i < tracked; ++i)
+  {
+    futures.push_back(engine.track(signatureNumber(i), std::vector<uint8_t>(8, 1), 1000));
+  }
+
+  TEST_ASSERT_TRUE(engine.tick());
+  TEST_ASSERT_EQUAL(2, node.statusCalls.size());
+  TEST_ASSERT_EQUAL(CONFIRMATION_STATUS_CALLS_PER_BATCH, node.statusCalls[0]);
+  TEST_ASSERT_EQUAL(1, node.statusCalls[1]);
+  TEST_ASSERT_EQUAL(tracked, engine.inFlight());
+}
+
+void test_rebroadcasts_are_split_across_batches()
+{
+  BatchNode node;
+  auto transport = std::make_shared<LoopbackTransport>([&node](const std::string &request)
+                                                       { return node.answer(request); });
+  ConfirmationOptions options;
+  options.rebroadcastBlocks = 1;
+  ConfirmationEngine engine(Connection(transport, Commitment::confirmed), options);
+  size_t tracked = CONFIRMATION_SENDS_PER_BATCH * 2 + 3;
+  std::vector<std::future<ConfirmationResult>> futures;
+  for (uint32_t i = 0; i < tracked; ++i)
+  {
+    futures.push_back(engine.track(signatureNumber(i), std::vector<uint8_t>(8, 1), 1000));
+  }
+
+  // Learn the block height, then mark when each was sent
+  TEST_ASSERT_TRUE(engine.tick());
+  TEST_ASSERT_TRUE(engine.tick());
+  TEST_ASSERT_EQUAL(0, node.sends.size());
+  node.blockHeight++;
+  TEST_ASSERT_TRUE(engine.tick());
+  node.blockHeight++;
+  TEST_ASSERT_TRUE(engine.tick());
+
+  TEST_ASSERT_EQUAL(3, node.sends.size());
+  TEST_ASSERT_EQUAL(CONFIRMATION_SENDS_PER_BATCH, node.sends[0]);
+  TEST_ASSERT_EQUAL(CONFIRMATION_SENDS_PER_BATCH, node.sends[1]);
+  TEST_ASSERT_EQUAL(3, node.sends[2]);
+}
+
+void test_send_tracks_the_transaction_signature()
+{
+  BatchNode node;
+  auto transport = std::make_shared<LoopbackTransport>([&node](const std::string &request)
+                                                       { return node.answer(request); });
+  ConfirmationEngine engine(Connection(transport, Commitment::confirmed));
+
+  Keypair payer = Keypair::generate();
+  PublicKey payerKey = payer.publicKey;
+  std::vector<Instruction> instructions = {SystemProgram::transfer(payerKey, PublicKey(std::vector<uint8_t>(PUBLIC_KEY_LEN, 4)), 1000)};
+  std::optional<PublicKey> payerOption = payerKey;
+  std::vector<Signer> signers = {Signer(payer)};
+  Transaction transaction = Transaction::createSignedWithPayer(instructions, payerOption, signers, Hash(std::vector<uint8_t>(HASH_BYTES, 1)));
+  Signature signature = transaction.signatures.front();
+
+  // The node echoes some other signature, the engine goes by its own
+  std::future<ConfirmationResult> future = engine.send(transaction, 1000);
+  node.landed.insert(signature.toString());
+  TEST_ASSERT_TRUE(engine.tick());
+  TEST_ASSERT_EQUAL(0, engine.inFlight());
+  ConfirmationResult result = future.get();
+  TEST_ASSERT_TRUE(result.signature == signature);
+  TEST_ASSERT_TRUE(result.status == ConfirmationStatus::confirmed);
+  TEST_ASSERT_EQUAL_UINT64(5, result.slot);
+}
+
+void test_background_ticks_survive_exceptions()
+{
+  BatchNode node;
+  node.throwing = 3;
+  auto transport = std::make_shared<LoopbackTransport>([&node](const std::string &request)
+                                                       { return node.answer(request); });
+  ConfirmationOptions options;
+  options.pollIntervalMs = 5;
+  ConfirmationEngine engine(Connection(transport, Commitment::confirmed), options);
+  node.landed.insert(signatureNumber(1).toString());
+  std::future<ConfirmationResult> future = engine.track(signatureNumber(1), std::vector<uint8_t>(8, 1), 1000);
+
+  engine.start();
+  TEST_ASSERT_TRUE(future.wait_for(std::chrono::seconds(2)) == std::future_status::ready);
+  engine.stop();
+  TEST_ASSERT_TRUE(future.get().status == ConfirmationStatus::confirmed);
+  TEST_ASSERT_EQUAL(3, engine.failedTicks());
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_statuses_are_split_across_batches);
+  RUN_TEST(test_rebroadcasts_are_split_across_batches);
+  RUN_TEST(test_send_tracks_the_transaction_signature);
+  RUN_TEST(test_background_ticks_survive_exceptions);
+  return UNITY_END();
+}
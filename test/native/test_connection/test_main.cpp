@@ -0,0 +1,95 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include <unity.h>
+#include "SolanaSDK/connection.h"
+#include "SolanaSDK/loopback_transport.h"
+
+// Bytes whose first one is zero, so their base58 form starts with '1'
+static std::vector<uint8_t> leadingZeroBytes(size_t length, uint8_t fill)
+{
+  std::vector<uint8_t> bytes(length, fill);
+  bytes[0] = 0;
+  return bytes;
+}
+
+static Connection connectionAnswering(const std::string &result)
+{
+  auto transport = std::make_shared<LoopbackTransport>([result](const std::string &)
+                                                       { return "{\"jsonrpc\":\"2.0\",\"result\":" + result + ",\"id\":1}"; });
+  return Connection(transport, Commitment::confirmed);
+}
+
+static std::string blockhashResult(const std::string &blockhash, const std::string &extra = "")
+{
+  return "{\"context\":{\"slot\":1},\"value\":{" + extra + "\"blockhash\":\"" + blockhash + "\",\"lastValidBlockHeight\":321}}";
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_blockhash_keeps_its_leading_zero_bytes()
+{
+  Hash expected = Hash::deserialize(leadingZeroBytes(HASH_BYTES, 0x41));
+  Connection connection = connectionAnswering(blockhashResult(expected.toStr()));
+  BlockhashWithExpiryBlockHeight latest = connection.getLatestBlockhash();
+  TEST_ASSERT_TRUE(latest.blockhash.data == expected.data);
+  TEST_ASSERT_EQUAL_UINT64(321, latest.lastValidBlockHeight);
+}
+
+void test_fields_outside_the_filter_are_skipped()
+{
+  // Far more than the parsed document ever holds
+  std::string padding = "\"padding\":\"" + std::string(64 * 1024, 'x') + "\",\"nested\":{\"list\":[1,2,3,{\"a\":\"b\"}]},";
+  Hash expected = Hash::deserialize(std::vector<uint8_t>(HASH_BYTES, 0x17));
+  Connection connection = connectionAnswering(blockhashResult(expected.toStr(), padding));
+  BlockhashWithExpiryBlockHeight latest = connection.getLatestBlockhash();
+  TEST_ASSERT_TRUE(latest.blockhash.data == expected.data);
+  TEST_ASSERT_EQUAL_UINT64(321, latest.lastValidBlockHeight);
+}
+
+void test_blockhash_of_the_wrong_length_is_an_invalid_response()
+{
+  Connection connection = connectionAnswering(blockhashResult("3xyz"));
+  bool thrown = false;
+  try
+  {
+    connection.getLatestBlockhash();
+  }
+  catch (const std::runtime_error &)
+  {
+    thrown = true;
+  }
+  TEST_ASSERT_TRUE(thrown);
+
+  RpcResult<BlockhashWithExpiryBlockHeight> result = connection.tryGetLatestBlockhash();
+  TEST_ASSERT_FALSE(result.value.has_value());
+  TEST_ASSERT_TRUE(result.error.has_value());
+  TEST_ASSERT_TRUE(result.error->code == RpcErrorCode::invalidResponse);
+}
+
+void test_sent_signature_keeps_its_leading_zero_bytes()
+{
+  Signature expected = Signature::deserialize(leadingZeroBytes(SIGNATURE_BYTES, 0x6B));
+  std::string encoded = expected.toString();
+  TEST_ASSERT_TRUE(encoded[0] == '1');
+  Connection connection = connectionAnswering("\"" + encoded + "\"");
+  Signature signature = connection.sendRawTransaction(std::vector<uint8_t>(200, 1));
+  TEST_ASSERT_TRUE(signature == expected);
+
+  Connection truncated = connectionAnswering("\"" + encoded.substr(0, 20) + "\"");
+  TEST_ASSERT_TRUE(truncated.trySendRawTransaction(std::vector<uint8_t>(200, 1)).error.has_value());
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_blockhash_keeps_its_leading_zero_bytes);
+  RUN_TEST(test_fields_outside_the_filter_are_skipped);
+  RUN_TEST(test_blockhash_of_the_wrong_length_is_an_invalid_response);
+  RUN_TEST(test_sent_signature_keeps_its_leading_zero_bytes);
+  return UNITY_END();
+}
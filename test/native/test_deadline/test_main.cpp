@@ -0,0 +1,109 @@
+#include <cstdint>
+#include <string>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <unity.h>
+#include "SolanaSDK/connection.h"
+#include "SolanaSDK/posix_http_transport.h"
+#include "../support/stand_in_server.h"
+
+using Clock = std::chrono::steady_clock;
+
+static uint32_t elapsedMs(Clock::time_point since)
+{
+  return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - since).count();
+}
+
+// Answers getBlockHeight after delayMs
+static StandInHttpServer::Handler slowNode(uint32_t delayMs)
+{
+  return [delayMs](const StandInRequest &request)
+  {
+    StandInResponse response = StandInResponse::json(standInResult(request.body, "4242"));
+    response.delayMs = delayMs;
+    return response;
+  };
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_deadline_is_a_typed_error()
+{
+  StandInHttpServer server(slowNode(1000));
+  Connection connection(server.url(), Commitment::confirmed);
+
+  auto started = Clock::now();
+  RpcResult<uint64_t> height = connection.withDeadline(100).tryGetBlockHeight();
+  TEST_ASSERT_FALSE(height.ok());
+  TEST_ASSERT_TRUE(height.error->code == RpcErrorCode::timeout);
+  TEST_ASSERT_LESS_THAN_UINT32(500, elapsedMs(started));
+}
+
+void test_cancellation_is_a_typed_error()
+{
+  StandInHttpServer server(slowNode(1000));
+  Connection connection(server.url(), Commitment::confirmed);
+  CancellationToken token;
+  std::thread canceller([token]() mutable
+                        {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    token.cancel(); });
+
+  auto started = Clock::now();
+  RpcResult<BlockhashWithExpiryBlockHeight> blockhash = connection.withCancellation(token).tryGetLatestBlockhash();
+  canceller.join();
+  TEST_ASSERT_FALSE(blockhash.ok());
+  TEST_ASSERT_TRUE(blockhash.error->code == RpcErrorCode::cancelled);
+  TEST_ASSERT_LESS_THAN_UINT32(500, elapsedMs(started));
+}
+
+void test_rpc_error_and_value_come_back_typed()
+{
+  StandInHttpServer server([](const StandInRequest &request)
+                           {
+    if (standInMethod(request.body) == "getAccountInfo")
+    {
+      return StandInResponse::json(standInError(request.body, -32602, "Invalid param"));
+    }
+    return StandInResponse::json(standInResult(request.body, "4242")); });
+  Connection connection(server.url(), Commitment::confirmed);
+
+  RpcResult<uint64_t> height = connection.tryGetBlockHeight();
+  TEST_ASSERT_TRUE(height.ok());
+  TEST_ASSERT_EQUAL(4242, *height.value);
+
+  RpcResult<std::optional<AccountInfo>> account = connection.tryGetAccountInfo(PublicKey());
+  TEST_ASSERT_FALSE(account.ok());
+  TEST_ASSERT_TRUE(account.error->code == RpcErrorCode::rpc);
+}
+
+void test_waiting_for_a_busy_socket_honours_the_deadline()
+{
+  StandInHttpServer server(slowNode(1000));
+  auto transport = std::make_shared<PosixHttpTransport>(server.url(), 1);
+  Connection connection(transport, Commitment::confirmed);
+  std::thread holder([connection]() mutable
+                     { connection.tryGetBlockHeight(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  auto started = Clock::now();
+  RpcResult<uint64_t> height = connection.withDeadline(100).tryGetBlockHeight();
+  uint32_t waited = elapsedMs(started);
+  holder.join();
+  TEST_ASSERT_FALSE(height.ok());
+  TEST_ASSERT_TRUE(height.error->code == RpcErrorCode::timeout);
+  TEST_ASSERT_LESS_THAN_UINT32(500, waited);
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_deadline_is_a_typed_error);
+  RUN_TEST(test_cancellation_is_a_typed_error);
+  RUN_TEST(test_rpc_error_and_value_come_back_typed);
+  RUN_TEST(test_waiting_for_a_busy_socket_honours_the_deadline);
+  return UNITY_END();
+}
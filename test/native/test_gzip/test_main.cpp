@@ -0,0 +1,74 @@
+#include <cstdint>
+#include <string>
+#include <unity.h>
+#include "SolanaSDK/connection.h"
+#include "../support/stand_in_server.h"
+
+// Answers getBlockHeight with a gzip body, passed through damage first
+static StandInHttpServer::Handler gzipNode(std::string (*damage)(std::string))
+{
+  return [damage](const StandInRequest &request)
+  {
+    StandInResponse response = StandInResponse::json(damage(standInGzip(standInResult(request.body, "4242"))));
+    response.headers.emplace_back("Content-Encoding", "gzip");
+    return response;
+  };
+}
+
+static std::string intact(std::string gzip)
+{
+  return gzip;
+}
+
+static std::string flipCrc(std::string gzip)
+{
+  gzip[gzip.size() - 8] ^= 0x01;
+  return gzip;
+}
+
+// Stream cut after the deflate data, the trailer never arrives
+static std::string dropTrailer(std::string gzip)
+{
+  return gzip.substr(0, gzip.size() - 8);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_gzip_body_is_inflated()
+{
+  StandInHttpServer server(gzipNode(intact));
+  Connection connection(server.url(), Commitment::confirmed);
+
+  RpcResult<uint64_t> height = connection.tryGetBlockHeight();
+  TEST_ASSERT_TRUE(height.ok());
+  TEST_ASSERT_EQUAL(4242, *height.value);
+}
+
+void test_gzip_crc_mismatch_fails()
+{
+  StandInHttpServer server(gzipNode(flipCrc));
+  Connection connection(server.url(), Commitment::confirmed);
+
+  RpcResult<uint64_t> height = connection.tryGetBlockHeight();
+  TEST_ASSERT_FALSE(height.ok());
+}
+
+void test_gzip_without_trailer_fails()
+{
+  StandInHttpServer server(gzipNode(dropTrailer));
+  Connection connection(server.url(), Commitment::confirmed);
+
+  RpcResult<uint64_t> height = connection.tryGetBlockHeight();
+  TEST_ASSERT_FALSE(height.ok());
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_gzip_body_is_inflated);
+  RUN_TEST(test_gzip_crc_mismatch_fails);
+  RUN_TEST(test_gzip_without_trailer_fails);
+  return UNITY_END();
+}
@@ -0,0 +1,116 @@
+#include <cstdint>
+#include <vector>
+#include <set>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+#include <unity.h>
+#include "SolanaSDK/keypair.h"
+#include "SolanaSDK/keypair_pool.h"
+#include "SolanaSDK/signer.h"
+
+// Wait up to timeoutMs for the pool to hold count keypairs
+static bool waitForAvailable(KeypairPool &pool, size_t count, uint32_t timeoutMs = 2000)
+{
+  auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+  while (pool.available() < count)
+  {
+    if (std::chrono::steady_clock::now() > until)
+    {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_seed_size_is_checked()
+{
+  std::vector<unsigned char> seed(SECRET_KEY_LEN, 5);
+  Keypair fromVector(seed);
+  Keypair fromArray(seed.data());
+  TEST_ASSERT_TRUE(fromVector.publicKey == fromArray.publicKey);
+
+  bool thrown = false;
+  try
+  {
+    Keypair tooShort(std::vector<unsigned char>(8, 5));
+  }
+  catch (const std::invalid_argument &)
+  {
+    thrown = true;
+  }
+  TEST_ASSERT_TRUE(thrown);
+}
+
+void test_pool_fills_in_the_background()
+{
+  KeypairPool pool(6);
+  TEST_ASSERT_EQUAL(0, pool.available());
+  pool.start();
+  TEST_ASSERT_TRUE(waitForAvailable(pool, 6));
+
+  // A taken slot is refilled
+  pool.take();
+  TEST_ASSERT_TRUE(waitForAvailable(pool, 6));
+  pool.stop();
+}
+
+void test_pooled_keypairs_are_distinct_and_sign()
+{
+  KeypairPool pool(4);
+  pool.start();
+  TEST_ASSERT_TRUE(waitForAvailable(pool, 4));
+  pool.stop();
+
+  std::set<std::string> publicKeys;
+  std::vector<uint8_t> message = {1, 2, 3};
+  for (size_t i = 0; i < 4; ++i)
+  {
+    Keypair keypair = pool.take();
+    publicKeys.insert(keypair.publicKey.toBase58());
+
+    // The public key belongs to the secret key it was rebuilt from
+    Keypair rebuilt(std::vector<unsigned char>(keypair.getSecretKey(), keypair.getSecretKey() + SECRET_KEY_LEN));
+    TEST_ASSERT_TRUE(rebuilt.publicKey == keypair.publicKey);
+    PublicKey publicKey = keypair.publicKey;
+    Signer signer(keypair);
+    signer.signMessage(message).verify(publicKey.serialize(), message);
+  }
+  TEST_ASSERT_EQUAL(4, publicKeys.size());
+  TEST_ASSERT_EQUAL(0, pool.available());
+}
+
+void test_empty_pool_generates_inline()
+{
+  KeypairPool pool(2);
+  Keypair first = pool.take();
+  Keypair second = pool.take();
+  TEST_ASSERT_FALSE(first.publicKey == second.publicKey);
+  TEST_ASSERT_EQUAL(0, pool.available());
+}
+
+void test_drain_empties_the_pool()
+{
+  KeypairPool pool(3);
+  pool.start();
+  TEST_ASSERT_TRUE(waitForAvailable(pool, 3));
+  pool.stop();
+  pool.drain();
+  TEST_ASSERT_EQUAL(0, pool.available());
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_seed_size_is_checked);
+  RUN_TEST(test_pool_fills_in_the_background);
+  RUN_TEST(test_pooled_keypairs_are_distinct_and_sign);
+  RUN_TEST(test_empty_pool_generates_inline);
+  RUN_TEST(test_drain_empties_the_pool);
+  return UNITY_END();
+}
@@ -0,0 +1,139 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <unity.h>
+#include "SolanaSDK/connection.h"
+#include "SolanaSDK/loopback_transport.h"
+#include "SolanaSDK/nonce_account.h"
+#include "SolanaSDK/transaction.h"
+#include "SolanaSDK/base64.h"
+#include "SolanaSDK/programs/system_program.h"
+#include "../support/stand_in_server.h"
+
+static PublicKey keyFilledWith(uint8_t value)
+{
+  return PublicKey(std::vector<uint8_t>(PUBLIC_KEY_LEN, value));
+}
+
+// Bincode of an initialized current-version nonce account
+static std::vector<uint8_t> nonceAccountData(const PublicKey &authority, uint8_t nonceByte, uint64_t lamportsPerSignature)
+{
+  std::vector<uint8_t> data = {1, 0, 0, 0, 1, 0, 0, 0};
+  PublicKey key = authority;
+  std::vector<uint8_t> authorityBytes = key.serialize();
+  data.insert(data.end(), authorityBytes.begin(), authorityBytes.end());
+  data.insert(data.end(), HASH_BYTES, nonceByte);
+  for (size_t i = 0; i < 8; ++i)
+  {
+    data.push_back(static_cast<uint8_t>(lamportsPerSignature >> (8 * i)));
+  }
+  return data;
+}
+
+static bool rejected(const std::vector<uint8_t> &data)
+{
+  try
+  {
+    NonceAccount::deserialize(data);
+  }
+  catch (const std::invalid_argument &)
+  {
+    return true;
+  }
+  return false;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_nonce_account_is_decoded()
+{
+  PublicKey authority = keyFilledWith(7);
+  NonceAccount account = NonceAccount::deserialize(nonceAccountData(authority, 9, 5000));
+
+  TEST_ASSERT_EQUAL_UINT32(1, account.version);
+  TEST_ASSERT_TRUE(account.initialized);
+  TEST_ASSERT_TRUE(account.authority == authority);
+  TEST_ASSERT_TRUE(account.durableNonce.data == Hash(std::vector<uint8_t>(HASH_BYTES, 9)).data);
+  TEST_ASSERT_EQUAL_UINT64(5000, account.lamportsPerSignature);
+}
+
+void test_uninitialized_and_invalid_nonce_accounts()
+{
+  std::vector<uint8_t> uninitialized(NONCE_ACCOUNT_LEN, 0);
+  uninitialized[0] = 1;
+  TEST_ASSERT_FALSE(NonceAccount::deserialize(uninitialized).initialized);
+
+  std::vector<uint8_t> unknownVersion = nonceAccountData(keyFilledWith(7), 9, 5000);
+  unknownVersion[0] = 2;
+  TEST_ASSERT_TRUE(rejected(unknownVersion));
+
+  std::vector<uint8_t> truncated = nonceAccountData(keyFilledWith(7), 9, 5000);
+  truncated.resize(NONCE_ACCOUNT_LEN - 1);
+  TEST_ASSERT_TRUE(rejected(truncated));
+}
+
+void test_nonce_transaction_advances_first()
+{
+  Keypair payer = Keypair::generate();
+  PublicKey payerKey = payer.publicKey;
+  PublicKey nonceKey = keyFilledWith(3);
+  Hash durableNonce(std::vector<uint8_t>(HASH_BYTES, 9));
+  std::vector<Instruction> instructions = {SystemProgram::transfer(payerKey, keyFilledWith(4), 1000)};
+  std::optional<PublicKey> payerOption = payerKey;
+  std::vector<Signer> signers = {Signer(payer)};
+
+  Transaction transaction = Transaction::createWithNonce(instructions, payerOption, nonceKey, payerKey, signers, durableNonce);
+
+  TEST_ASSERT_TRUE(transaction.message.recentBlockhash.data == durableNonce.data);
+  std::optional<CompiledInstruction> advance = transaction.usesDurableNonce();
+  TEST_ASSERT_TRUE(advance.has_value());
+  std::optional<PublicKey> noncePubkey = transaction.getNoncePubkeyFromInstruction(*advance);
+  TEST_ASSERT_TRUE(noncePubkey.has_value());
+  TEST_ASSERT_TRUE(*noncePubkey == nonceKey);
+  TEST_ASSERT_TRUE(transaction.isSigned());
+}
+
+void test_blockhash_transaction_has_no_nonce()
+{
+  Keypair payer = Keypair::generate();
+  PublicKey payerKey = payer.publicKey;
+  std::vector<Instruction> instructions = {SystemProgram::transfer(payerKey, keyFilledWith(4), 1000)};
+  std::optional<PublicKey> payerOption = payerKey;
+  std::vector<Signer> signers = {Signer(payer)};
+
+  Transaction transaction = Transaction::createSignedWithPayer(instructions, payerOption, signers, Hash(std::vector<uint8_t>(HASH_BYTES, 9)));
+  TEST_ASSERT_FALSE(transaction.usesDurableNonce().has_value());
+}
+
+void test_connection_fetches_nonce_account()
+{
+  PublicKey authority = keyFilledWith(7);
+  std::string data = Base64::encode(nonceAccountData(authority, 9, 5000));
+  auto transport = std::make_shared<LoopbackTransport>([&data](const std::string &request)
+                                                       {
+    TEST_ASSERT_EQUAL_STRING("getAccountInfo", standInMethod(request).c_str());
+    return standInResult(request, "{\"context\":{\"slot\":12},\"value\":{\"lamports\":1447680,\"owner\":\"11111111111111111111111111111111\","
+                                  "\"data\":[\"" + data + "\",\"base64\"],\"executable\":false,\"rentEpoch\":0}}"); });
+  Connection connection(transport, Commitment::confirmed);
+
+  NonceAccount account = connection.getNonceAccount(keyFilledWith(3));
+  TEST_ASSERT_TRUE(account.initialized);
+  TEST_ASSERT_TRUE(account.authority == authority);
+  TEST_ASSERT_EQUAL_UINT64(5000, account.lamportsPerSignature);
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_nonce_account_is_decoded);
+  RUN_TEST(test_uninitialized_and_invalid_nonce_accounts);
+  RUN_TEST(test_nonce_transaction_advances_first);
+  RUN_TEST(test_blockhash_transaction_has_no_nonce);
+  RUN_TEST(test_connection_fetches_nonce_account);
+  return UNITY_END();
+}
@@ -0,0 +1,150 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <optional>
+#include <unity.h>
+#include <ArduinoJson.h>
+#include "SolanaSDK/connection.h"
+#include "SolanaSDK/program_accounts.h"
+#include "SolanaSDK/base64.h"
+#include "../support/stand_in_server.h"
+
+static PublicKey keyFilledWith(uint8_t value)
+{
+  return PublicKey(std::vector<uint8_t>(PUBLIC_KEY_LEN, value));
+}
+
+static std::string keyedAccount(uint8_t fill, uint64_t lamports, const std::vector<uint8_t> &data, const std::string &rentEpoch = "18446744073709551615")
+{
+  PublicKey pubkey = keyFilledWith(fill);
+  PublicKey owner = keyFilledWith(0x77);
+  return "{\"pubkey\":\"" + pubkey.toBase58() + "\",\"account\":{\"lamports\":" + std::to_string(lamports) +
+         ",\"owner\":\"" + owner.toBase58() + "\",\"data\":[\"" + Base64::encode(data) + "\",\"base64\"]," +
+         "\"executable\":false,\"rentEpoch\":" + rentEpoch + ",\"space\":" + std::to_string(data.size()) + "}}";
+}
+
+static std::string accountList(size_t count)
+{
+  std::string list;
+  for (size_t i = 0; i < count; ++i)
+  {
+    list += (list.empty() ? "" : ",") + keyedAccount(static_cast<uint8_t>(i + 1), 1000 + i, std::vector<uint8_t>(40, static_cast<uint8_t>(i)));
+  }
+  return "[" + list + "]";
+}
+
+// Code of the RpcException thrown by getProgramAccounts, nullopt if none
+static std::optional<RpcErrorCode> failureOf(Connection &connection)
+{
+  try
+  {
+    connection.getProgramAccounts(keyFilledWith(0x77), ProgramAccountsConfig(), [](const ProgramAccount &)
+                                  { return true; });
+  }
+  catch (const RpcException &e)
+  {
+    return e.code;
+  }
+  return std::nullopt;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_filters_are_sent_and_accounts_streamed()
+{
+  std::string request;
+  StandInHttpServer server([&request](const StandInRequest &incoming)
+                           {
+                             request = incoming.body;
+                             return StandInResponse::json(standInResult(incoming.body, accountList(30))); });
+  Connection connection(server.url(), Commitment::confirmed);
+
+  ProgramAccountsConfig config;
+  config.dataSize = 40;
+  config.memcmp.push_back({8, {1, 2, 3}});
+  config.dataSlice = DataSlice{0, 40};
+  std::vector<uint64_t> lamports;
+  std::vector<std::vector<uint8_t>> data;
+  uint64_t rentEpoch = 0;
+  size_t count = connection.getProgramAccounts(keyFilledWith(0x77), config, [&](const ProgramAccount &account)
+                                               {
+    lamports.push_back(account.lamports);
+    data.emplace_back(account.data.begin(), account.data.end());
+    rentEpoch = account.rentEpoch;
+    return true; });
+
+  // The body spans many reads, accounts cross their boundaries
+  TEST_ASSERT_EQUAL(30, count);
+  TEST_ASSERT_EQUAL(30, lamports.size());
+  for (size_t i = 0; i < lamports.size(); ++i)
+  {
+    TEST_ASSERT_EQUAL_UINT64(1000 + i, lamports[i]);
+    TEST_ASSERT_TRUE(data[i] == std::vector<uint8_t>(40, static_cast<uint8_t>(i)));
+  }
+  TEST_ASSERT_EQUAL_UINT64(UINT64_MAX, rentEpoch);
+
+  JsonDocument doc;
+  TEST_ASSERT_TRUE(deserializeJson(doc, request) == DeserializationError::Ok);
+  JsonObjectConst options = doc["params"][1];
+  TEST_ASSERT_EQUAL_UINT64(40, options["filters"][0]["dataSize"].as<uint64_t>());
+  TEST_ASSERT_EQUAL_UINT64(8, options["filters"][1]["memcmp"]["offset"].as<uint64_t>());
+  std::string bytes = options["filters"][1]["memcmp"]["bytes"] | "";
+  TEST_ASSERT_EQUAL_STRING("AQID", bytes.c_str());
+  TEST_ASSERT_EQUAL_UINT64(40, options["dataSlice"]["length"].as<uint64_t>());
+}
+
+void test_handler_stops_early()
+{
+  StandInHttpServer server([](const StandInRequest &request)
+                           { return StandInResponse::json(standInResult(request.body, accountList(200))); });
+  Connection connection(server.url(), Commitment::confirmed);
+
+  size_t seen = 0;
+  size_t count = connection.getProgramAccounts(keyFilledWith(0x77), ProgramAccountsConfig(), [&seen](const ProgramAccount &)
+                                               { return ++seen < 3; });
+  TEST_ASSERT_EQUAL(3, count);
+  TEST_ASSERT_EQUAL(3, seen);
+
+  // The rest of the body does not leak into the next call
+  count = connection.getProgramAccounts(keyFilledWith(0x77), ProgramAccountsConfig(), [](const ProgramAccount &)
+                                        { return true; });
+  TEST_ASSERT_EQUAL(200, count);
+  TEST_ASSERT_EQUAL(2, server.requests());
+}
+
+void test_malformed_stream_fails()
+{
+  std::string body;
+  StandInHttpServer server([&body](const StandInRequest &)
+                           { return StandInResponse::json(body); });
+  Connection connection(server.url(), Commitment::confirmed);
+
+  // Cut off in the middle of an account
+  std::string complete = standInResult("", accountList(5));
+  body = complete.substr(0, complete.size() / 2);
+  TEST_ASSERT_TRUE(failureOf(connection) == RpcErrorCode::transport);
+
+  // Numbers that cannot be held without losing them
+  body = standInResult("", "[" + keyedAccount(1, 5, {1}, "1.8446744073709552e19") + "]");
+  TEST_ASSERT_TRUE(failureOf(connection) == RpcErrorCode::invalidResponse);
+  body = standInResult("", "[" + keyedAccount(1, 5, {1}, "18446744073709551616") + "]");
+  TEST_ASSERT_TRUE(failureOf(connection) == RpcErrorCode::invalidResponse);
+
+  // An error response carries the node's message
+  body = standInError("", -32010, "excluded from account secondary indexes");
+  TEST_ASSERT_TRUE(failureOf(connection) == RpcErrorCode::rpc);
+
+  body = complete;
+  TEST_ASSERT_FALSE(failureOf(connection).has_value());
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_filters_are_sent_and_accounts_streamed);
+  RUN_TEST(test_handler_stops_early);
+  RUN_TEST(test_malformed_stream_fails);
+  return UNITY_END();
+}
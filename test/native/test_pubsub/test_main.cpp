@@ -0,0 +1,386 @@
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <unity.h>
+#include "SolanaSDK/pubsub_connection.h"
+#include "../support/stand_in_server.h"
+
+using Session = StandInWebSocketServer::Session;
+
+static PublicKey keyEndingIn(uint8_t last)
+{
+  std::array<uint8_t, PUBLIC_KEY_LEN> bytes{};
+  bytes[PUBLIC_KEY_LEN - 1] = last;
+  return PublicKey(bytes);
+}
+
+static std::string subscribed(const std::string &request, uint64_t serverId)
+{
+  return "{\"jsonrpc\":\"2.0\",\"result\":" + std::to_string(serverId) + ",\"id\":" + std::to_string(standInId(request)) + "}";
+}
+
+static std::string accountNotification(uint64_t serverId, const std::string &owner, const std::string &data = "AQID")
+{
+  return "{\"jsonrpc\":\"2.0\",\"method\":\"accountNotification\",\"params\":{\"result\":{\"context\":{\"slot\":99},"
+         "\"value\":{\"lamports\":5,\"owner\":\"" +
+         owner + "\",\"data\":[\"" + data + "\",\"base64\"],\"executable\":false,\"rentEpoch\":0}},\"subscription\":" +
+         std::to_string(serverId) + "}}";
+}
+
+static std::string slotNotification(uint64_t serverId, uint64_t slot)
+{
+  return "{\"jsonrpc\":\"2.0\",\"method\":\"slotNotification\",\"params\":{\"result\":{\"slot\":" + std::to_string(slot) +
+         ",\"parent\":" + std::to_string(slot - 1) + ",\"root\":" + std::to_string(slot - 32) + "},\"subscription\":" +
+         std::to_string(serverId) + "}}";
+}
+
+// Run loop() until done() holds or timeoutMs passed
+static bool pump(PubSubConnection &connection, std::function<bool()> done, uint32_t timeoutMs = 2000)
+{
+  auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+  while (!done() && std::chrono::steady_clock::now() < until)
+  {
+    connection.loop();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return done();
+}
+
+// Answer every subscribe until the client goes away
+static void acknowledge(Session &session, std::atomic<uint64_t> &nextId)
+{
+  std::string message;
+  while (session.receive(message))
+  {
+    if (standInMethod(message).find("Subscribe") != std::string::npos)
+    {
+      session.send(subscribed(message, nextId++));
+    }
+  }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_account_notification_keeps_leading_zero_owner()
+{
+  PublicKey owner = keyEndingIn(7);
+  std::string ownerText = owner.toBase58();
+  std::string method;
+  StandInWebSocketServer server([&](Session &session)
+                                {
+                                  std::string message;
+                                  if (!session.receive(message))
+                                  {
+                                    return;
+                                  }
+                                  method = standInMethod(message);
+                                  session.send(subscribed(message, 23));
+                                  session.send(accountNotification(23, ownerText));
+                                  while (session.receive(message))
+                                  {
+                                  } });
+
+  PubSubConnection connection(server.url());
+  std::vector<AccountNotification> received;
+  connection.onAccountChange(keyEndingIn(1), [&](const AccountNotification &notification)
+                             { received.push_back(notification); });
+  TEST_ASSERT_TRUE(connection.connect());
+  TEST_ASSERT_TRUE(pump(connection, [&]
+                        { return !received.empty(); }));
+
+  TEST_ASSERT_EQUAL_STRING("accountSubscribe", method.c_str());
+  TEST_ASSERT_EQUAL_UINT64(99, received[0].slot);
+  TEST_ASSERT_EQUAL_UINT64(5, received[0].lamports);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(owner.key, received[0].owner.key, PUBLIC_KEY_LEN);
+  TEST_ASSERT_EQUAL(3, received[0].data.size());
+  TEST_ASSERT_EQUAL_UINT8(3, received[0].data[2]);
+  connection.close();
+}
+
+void test_callback_may_change_subscriptions()
+{
+  std::atomic<uint64_t> nextId{40};
+  StandInWebSocketServer server([&](Session &session)
+                                {
+                                  std::string message;
+                                  if (!session.receive(message))
+                                  {
+                                    return;
+                                  }
+                                  uint64_t id = nextId++;
+                                  session.send(subscribed(message, id));
+                                  // Both frames arrive in one read, the second is handled
+                                  // after the first callback changed the subscriptions
+                                  session.sendAll({slotNotification(id, 100), slotNotification(id, 101)});
+                                  acknowledge(session, nextId); });
+
+  PubSubConnection connection(server.url());
+  std::vector<uint64_t> slots;
+  uint32_t handle = 0;
+  handle = connection.onSlotChange([&](const SlotNotification &notification)
+                                   {
+                                     if (slots.empty())
+                                     {
+                                       // Enough new entries to move the subscription list
+                                       for (int i = 0; i < 16; ++i)
+                                       {
+                                         connection.onSlotChange([](const SlotNotification &) {});
+                                       }
+                                     }
+                                     else
+                                     {
+                                       // Still uses its captures once its own entry is gone
+                                       connection.removeSubscription(handle);
+                                     }
+                                     slots.push_back(notification.slot); });
+  TEST_ASSERT_TRUE(connection.connect());
+  TEST_ASSERT_TRUE(pump(connection, [&]
+                        { return slots.size() == 2; }));
+  TEST_ASSERT_EQUAL_UINT64(100, slots[0]);
+  TEST_ASSERT_EQUAL_UINT64(101, slots[1]);
+  TEST_ASSERT_EQUAL(16, connection.subscriptionCount());
+  connection.close();
+}
+
+void test_callback_may_reconnect()
+{
+  std::atomic<int> sessions{0};
+  std::atomic<uint64_t> nextId{1};
+  StandInWebSocketServer server([&](Session &session)
+                                {
+                                  std::string message;
+                                  if (!session.receive(message))
+                                  {
+                                    return;
+                                  }
+                                  uint64_t id = nextId++;
+                                  session.send(subscribed(message, id));
+                                  if (sessions++ == 0)
+                                  {
+                                    session.sendAll({slotNotification(id, 200), slotNotification(id, 201)});
+                                  }
+                                  acknowledge(session, nextId); });
+
+  PubSubConnection connection(server.url());
+  std::vector<uint64_t> slots;
+  connection.onSlotChange([&](const SlotNotification &notification)
+                          {
+                            slots.push_back(notification.slot);
+                            connection.connect(); });
+  TEST_ASSERT_TRUE(connection.connect());
+  TEST_ASSERT_TRUE(pump(connection, [&]
+                        { return sessions == 2; }));
+  // The second frame belonged to the dropped socket
+  pump(connection, []
+       { return false; }, 100);
+  TEST_ASSERT_EQUAL(1, slots.size());
+  TEST_ASSERT_EQUAL_UINT64(200, slots[0]);
+  TEST_ASSERT_TRUE(connection.connected());
+  connection.close();
+}
+
+void test_masked_server_frame_drops_socket()
+{
+  std::atomic<int> sessions{0};
+  std::atomic<uint64_t> nextId{1};
+  StandInWebSocketServer server([&](Session &session)
+                                {
+                                  std::string message;
+                                  if (!session.receive(message))
+                                  {
+                                    return;
+                                  }
+                                  uint64_t id = nextId++;
+                                  session.send(subscribed(message, id));
+                                  if (sessions++ == 0)
+                                  {
+                                    session.sendMasked(slotNotification(id, 300));
+                                  }
+                                  acknowledge(session, nextId); });
+
+  PubSubConnection connection(server.url());
+  std::vector<uint64_t> slots;
+  connection.onSlotChange([&](const SlotNotification &notification)
+                          { slots.push_back(notification.slot); });
+  TEST_ASSERT_TRUE(connection.connect());
+  TEST_ASSERT_TRUE(pump(connection, [&]
+                        { return sessions == 2 && connection.connected(); }));
+  TEST_ASSERT_EQUAL(0, slots.size());
+  connection.close();
+}
+
+void test_resubscribes_after_drop()
+{
+  std::atomic<int> sessions{0};
+  std::vector<std::string> methods;
+  std::mutex mutex;
+  StandInWebSocketServer server([&](Session &session)
+                                {
+                                  std::string message;
+                                  if (!session.receive(message))
+                                  {
+                                    return;
+                                  }
+                                  {
+                                    std::lock_guard<std::mutex> lock(mutex);
+                                    methods.push_back(standInMethod(message));
+                                  }
+                                  session.send(subscribed(message, 7));
+                                  if (sessions++ == 0)
+                                  {
+                                    // Hang up, the client has to come back
+                                    return;
+                                  }
+                                  session.send(accountNotification(7, keyEndingIn(2).toBase58()));
+                                  while (session.receive(message))
+                                  {
+                                  } });
+
+  PubSubConnection connection(server.url());
+  std::vector<AccountNotification> received;
+  connection.onAccountChange(keyEndingIn(1), [&](const AccountNotification &notification)
+                             { received.push_back(notification); });
+  TEST_ASSERT_TRUE(connection.connect());
+  TEST_ASSERT_TRUE(pump(connection, [&]
+                        { return !received.empty(); }));
+  TEST_ASSERT_EQUAL(2, sessions.load());
+  std::lock_guard<std::mutex> lock(mutex);
+  TEST_ASSERT_EQUAL_STRING("accountSubscribe", methods[1].c_str());
+  connection.close();
+}
+
+// Sends a notification for an account with 18000 bytes of data, past the
+// default limit once base64 encoded, then a small one
+static void sendLargeThenSmall(Session &session, std::atomic<int> &sessions)
+{
+  std::string message;
+  if (!session.receive(message))
+  {
+    return;
+  }
+  sessions++;
+  session.send(subscribed(message, 31));
+  session.send(accountNotification(31, keyEndingIn(2).toBase58(), std::string(24000, 'A')));
+  session.send(accountNotification(31, keyEndingIn(2).toBase58()));
+  while (session.receive(message))
+  {
+  }
+}
+
+void test_oversized_message_is_skipped_without_reconnect()
+{
+  std::atomic<int> sessions{0};
+  StandInWebSocketServer server([&](Session &session)
+                                { sendLargeThenSmall(session, sessions); });
+
+  PubSubConnection connection(server.url());
+  std::vector<AccountNotification> received;
+  connection.onAccountChange(keyEndingIn(1), [&](const AccountNotification &notification)
+                             { received.push_back(notification); });
+  TEST_ASSERT_TRUE(connection.connect());
+  TEST_ASSERT_TRUE(pump(connection, [&]
+                        { return !received.empty(); }));
+  pump(connection, []
+       { return false; }, 100);
+  TEST_ASSERT_EQUAL(1, received.size());
+  TEST_ASSERT_EQUAL(3, received[0].data.size());
+  TEST_ASSERT_EQUAL(1, connection.skippedMessageCount());
+  TEST_ASSERT_EQUAL(1, sessions.load());
+  TEST_ASSERT_TRUE(connection.connected());
+  connection.close();
+}
+
+void test_raised_limit_delivers_large_accounts()
+{
+  std::atomic<int> sessions{0};
+  StandInWebSocketServer server([&](Session &session)
+                                { sendLargeThenSmall(session, sessions); });
+
+  PubSubConnection connection(server.url());
+  connection.setMaxMessageSize(32 * 1024);
+  std::vector<AccountNotification> received;
+  connection.onAccountChange(keyEndingIn(1), [&](const AccountNotification &notification)
+                             { received.push_back(notification); });
+  TEST_ASSERT_TRUE(connection.connect());
+  TEST_ASSERT_TRUE(pump(connection, [&]
+                        { return received.size() == 2; }));
+  TEST_ASSERT_EQUAL(18000, received[0].data.size());
+  TEST_ASSERT_EQUAL(3, received[1].data.size());
+  TEST_ASSERT_EQUAL(0, connection.skippedMessageCount());
+  connection.close();
+}
+
+void test_handshake_checks_the_accept_key()
+{
+  StandInWebSocketServer server([](Session &session)
+                                {
+                                  std::string message;
+                                  while (session.receive(message))
+                                  {
+                                  } });
+  server.wrongAccept = true;
+  PubSubConnection connection(server.url());
+  TEST_ASSERT_FALSE(connection.connect());
+  TEST_ASSERT_FALSE(connection.connected());
+  connection.close();
+}
+
+void test_removed_pending_subscription_is_unsubscribed()
+{
+  std::vector<std::string> messages;
+  std::mutex mutex;
+  StandInWebSocketServer server([&](Session &session)
+                                {
+                                  std::string message;
+                                  while (session.receive(message))
+                                  {
+                                    {
+                                      std::lock_guard<std::mutex> lock(mutex);
+                                      messages.push_back(message);
+                                    }
+                                    if (standInMethod(message) == "slotSubscribe")
+                                    {
+                                      session.send(subscribed(message, 77));
+                                    }
+                                  } });
+
+  PubSubConnection connection(server.url());
+  TEST_ASSERT_TRUE(connection.connect());
+  // Removed before the server answered the subscribe
+  uint32_t handle = connection.onSlotChange([](const SlotNotification &) {});
+  TEST_ASSERT_TRUE(connection.removeSubscription(handle));
+  TEST_ASSERT_EQUAL(0, connection.subscriptionCount());
+
+  TEST_ASSERT_TRUE(pump(connection, [&]
+                        {
+                          std::lock_guard<std::mutex> lock(mutex);
+                          return messages.size() == 2; }));
+  std::lock_guard<std::mutex> lock(mutex);
+  TEST_ASSERT_EQUAL_STRING("slotUnsubscribe", standInMethod(messages[1]).c_str());
+  TEST_ASSERT_TRUE(messages[1].find("\"params\":[77]") != std::string::npos);
+  connection.close();
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_account_notification_keeps_leading_zero_owner);
+  RUN_TEST(test_callback_may_change_subscriptions);
+  RUN_TEST(test_callback_may_reconnect);
+  RUN_TEST(test_masked_server_frame_drops_socket);
+  RUN_TEST(test_resubscribes_after_drop);
+  RUN_TEST(test_oversized_message_is_skipped_without_reconnect);
+  RUN_TEST(test_raised_limit_delivers_large_accounts);
+  RUN_TEST(test_handshake_checks_the_accept_key);
+  RUN_TEST(test_removed_pending_subscription_is_unsubscribed);
+  return UNITY_END();
+}
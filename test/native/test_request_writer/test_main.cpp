@@ -0,0 +1,142 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include <unity.h>
+#include <ArduinoJson.h>
+#include "SolanaSDK/rpc_request_writer.h"
+#include "SolanaSDK/connection.h"
+#include "SolanaSDK/loopback_transport.h"
+#include "SolanaSDK/base64.h"
+
+static std::vector<uint8_t> patternBytes(size_t length)
+{
+  std::vector<uint8_t> data(length);
+  for (size_t i = 0; i < length; ++i)
+  {
+    data[i] = static_cast<uint8_t>(i * 31 + 7);
+  }
+  return data;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_request_envelope()
+{
+  std::string out;
+  RpcRequestWriter writer(out);
+  writer.beginRequest(7, "getBalance");
+  writer.string("Abc");
+  writer.beginObject().key("commitment").string("finalized").key("minContextSlot").number(18446744073709551615ULL).endObject();
+  writer.endRequest();
+  TEST_ASSERT_EQUAL_STRING("{\"jsonrpc\":\"2.0\",\"id\":7,\"method\":\"getBalance\",\"params\":[\"Abc\",{\"commitment\":\"finalized\",\"minContextSlot\":18446744073709551615}]}", out.c_str());
+}
+
+void test_nested_containers_and_scalars()
+{
+  std::string out;
+  RpcRequestWriter writer(out);
+  writer.beginArray();
+  writer.beginArray().endArray();
+  writer.beginObject().key("a").beginArray().number(0).boolean(true).boolean(false).null().endArray().key("b").beginObject().endObject().endObject();
+  writer.number(1);
+  writer.endArray();
+  TEST_ASSERT_EQUAL_STRING("[[],{\"a\":[0,true,false,null],\"b\":{}},1]", out.c_str());
+}
+
+void test_strings_are_escaped()
+{
+  std::string out;
+  RpcRequestWriter writer(out);
+  writer.beginObject().key("q\"k").string(std::string("a\"b\\c\n\x01", 7)).endObject();
+  TEST_ASSERT_EQUAL_STRING("{\"q\\\"k\":\"a\\\"b\\\\c\\u000a\\u0001\"}", out.c_str());
+
+  // And read back by a JSON parser
+  JsonDocument doc;
+  TEST_ASSERT_TRUE(deserializeJson(doc, out) == DeserializationError::Ok);
+  std::string value = doc["q\"k"] | "";
+  TEST_ASSERT_TRUE(value == std::string("a\"b\\c\n\x01", 7));
+}
+
+void test_base64_is_written_in_place()
+{
+  for (size_t length : {size_t(0), size_t(1), size_t(2), size_t(3), size_t(1232), size_t(5000)})
+  {
+    std::vector<uint8_t> data = patternBytes(length);
+    std::string out;
+    RpcRequestWriter writer(out);
+    writer.beginArray().base64(data).number(1).endArray();
+    TEST_ASSERT_EQUAL_STRING(("[\"" + Base64::encode(data) + "\",1]").c_str(), out.c_str());
+  }
+}
+
+void test_unbalanced_containers_throw()
+{
+  std::string out;
+  RpcRequestWriter writer(out);
+  bool thrown = false;
+  try
+  {
+    writer.endObject();
+  }
+  catch (const std::runtime_error &)
+  {
+    thrown = true;
+  }
+  TEST_ASSERT_TRUE(thrown);
+
+  thrown = false;
+  try
+  {
+    for (size_t i = 0; i < 33; ++i)
+    {
+      writer.beginArray();
+    }
+  }
+  catch (const std::runtime_error &)
+  {
+    thrown = true;
+  }
+  TEST_ASSERT_TRUE(thrown);
+}
+
+void test_send_transaction_request_carries_the_whole_transaction()
+{
+  // Larger than a packet, which the DOM based request could not hold
+  std::vector<uint8_t> rawTransaction = patternBytes(1232);
+  std::string request;
+  auto transport = std::make_shared<LoopbackTransport>([&request](const std::string &body)
+                                                       {
+    request = body;
+    return std::string("{\"jsonrpc\":\"2.0\",\"result\":\"") + Signature::deserialize(std::vector<uint8_t>(SIGNATURE_BYTES, 9)).toString() + "\",\"id\":1}"; });
+  Connection connection(transport, Commitment::confirmed);
+  SendOptions options;
+  options.skipPreflight = true;
+  connection.sendRawTransaction(rawTransaction, options);
+
+  JsonDocument doc;
+  TEST_ASSERT_TRUE(deserializeJson(doc, request) == DeserializationError::Ok);
+  std::string method = doc["method"] | "";
+  TEST_ASSERT_EQUAL_STRING("sendTransaction", method.c_str());
+  std::vector<uint8_t> sent = Base64::decode(doc["params"][0].as<std::string>());
+  TEST_ASSERT_EQUAL(rawTransaction.size(), sent.size());
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(rawTransaction.data(), sent.data(), rawTransaction.size());
+  std::string encoding = doc["params"][1]["encoding"] | "";
+  TEST_ASSERT_EQUAL_STRING("base64", encoding.c_str());
+  TEST_ASSERT_TRUE(doc["params"][1]["skipPreflight"].as<bool>());
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_request_envelope);
+  RUN_TEST(test_nested_containers_and_scalars);
+  RUN_TEST(test_strings_are_escaped);
+  RUN_TEST(test_base64_is_written_in_place);
+  RUN_TEST(test_unbalanced_containers_throw);
+  RUN_TEST(test_send_transaction_request_carries_the_whole_transaction);
+  return UNITY_END();
+}
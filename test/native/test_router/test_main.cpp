@@ -0,0 +1,202 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <unity.h>
+#include "SolanaSDK/connection.h"
+#include "SolanaSDK/router_transport.h"
+#include "../support/stand_in_server.h"
+
+using Clock = std::chrono::steady_clock;
+
+static const char *SEND_REQUEST = "{\"jsonrpc\":\"2.0\",\"id\":7,\"method\":\"sendTransaction\",\"params\":[\"AQ==\"]}";
+
+static StandInHttpServer::Handler answer(int status, const std::string &result, uint32_t delayMs = 0)
+{
+  return [status, result, delayMs](const StandInRequest &request)
+  {
+    StandInResponse response = StandInResponse::json(standInResult(request.body, result), status);
+    response.delayMs = delayMs;
+    return response;
+  };
+}
+
+static StandInHttpServer::Handler rateLimited(uint32_t delayMs = 0)
+{
+  return [delayMs](const StandInRequest &request)
+  {
+    StandInResponse response = StandInResponse::json(standInError(request.body, 429, "Too many requests"), 429);
+    response.headers.emplace_back("Retry-After", "2");
+    response.delayMs = delayMs;
+    return response;
+  };
+}
+
+static std::shared_ptr<RouterTransport> routerFor(const std::vector<const StandInHttpServer *> &servers, RouterOptions options = RouterOptions())
+{
+  std::vector<std::string> urls;
+  for (const auto *server : servers)
+  {
+    urls.push_back(server->url());
+  }
+  return RouterTransport::forEndpoints(urls, 2, options);
+}
+
+static ByteSpan span(const std::string &text)
+{
+  return ByteSpan(reinterpret_cast<const uint8_t *>(text.data()), text.size());
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_hedged_read_skips_rate_limited_endpoint()
+{
+  StandInHttpServer limited(rateLimited());
+  StandInHttpServer healthy(answer(200, "4242", 20));
+  auto router = routerFor({&limited, &healthy});
+  Connection connection(router, Commitment::confirmed);
+
+  TEST_ASSERT_EQUAL_UINT64(4242, connection.getBlockHeight());
+  std::vector<EndpointStats> stats = router->stats();
+  TEST_ASSERT_EQUAL(1, stats[0].consecutiveFailures);
+  TEST_ASSERT_EQUAL(0, stats[1].consecutiveFailures);
+}
+
+void test_hedged_read_skips_rpc_error()
+{
+  StandInHttpServer behind([](const StandInRequest &request)
+                           { return StandInResponse::json(standInError(request.body, -32005, "Node is behind")); });
+  StandInHttpServer healthy(answer(200, "4242", 20));
+  auto router = routerFor({&behind, &healthy});
+  Connection connection(router, Commitment::confirmed);
+
+  TEST_ASSERT_EQUAL_UINT64(4242, connection.getBlockHeight());
+  TEST_ASSERT_TRUE(router->stats()[0].errorRate > 0);
+  TEST_ASSERT_EQUAL(0, router->stats()[1].consecutiveFailures);
+}
+
+void test_failed_race_forwards_status()
+{
+  StandInHttpServer first(rateLimited());
+  StandInHttpServer second(rateLimited(10));
+  auto router = routerFor({&first, &second});
+
+  int status = 0;
+  uint32_t retryAfter = 0;
+  std::string body;
+  std::string request = "{\"jsonrpc\":\"2.0\",\"id\":3,\"method\":\"getBlockHeight\",\"params\":[]}";
+  bool answered = router->post(span(request), [&](ResponseReader &reader)
+                               {
+                                 status = reader.status();
+                                 retryAfter = reader.retryAfterMs();
+                                 int c;
+                                 while ((c = reader.read()) >= 0)
+                                 {
+                                   body += static_cast<char>(c);
+                                 }
+                                 return true; });
+  TEST_ASSERT_TRUE(answered);
+  TEST_ASSERT_EQUAL(429, status);
+  TEST_ASSERT_EQUAL_UINT32(2000, retryAfter);
+  TEST_ASSERT_TRUE(body.find("Too many requests") != std::string::npos);
+}
+
+void test_error_bodies_open_the_circuit()
+{
+  StandInHttpServer unavailable([](const StandInRequest &request)
+                                { return StandInResponse::json(standInError(request.body, -32000, "Unavailable"), 503); });
+  RouterOptions options;
+  options.failureThreshold = 3;
+  auto router = routerFor({&unavailable}, options);
+  Connection connection(router, Commitment::confirmed);
+
+  for (int i = 0; i < 3; ++i)
+  {
+    auto result = connection.tryCall([](Connection &c)
+                                     { return c.getBlockHeight(); });
+    TEST_ASSERT_FALSE(result.ok());
+    TEST_ASSERT_TRUE(result.error->code == RpcErrorCode::rpc);
+  }
+  TEST_ASSERT_TRUE(router->stats()[0].circuitOpen);
+}
+
+void test_send_is_fanned_out()
+{
+  StandInHttpServer first(answer(200, "\"sig\""));
+  StandInHttpServer second(answer(200, "\"sig\""));
+  auto router = routerFor({&first, &second});
+
+  bool answered = router->post(span(SEND_REQUEST), [](ResponseReader &reader)
+                               { return reader.read() == '{'; });
+  TEST_ASSERT_TRUE(answered);
+  TEST_ASSERT_EQUAL(1, first.requests(1));
+  TEST_ASSERT_EQUAL(1, second.requests(1));
+}
+
+void test_losing_attempt_is_cancelled()
+{
+  StandInHttpServer slow(answer(200, "1", 2000));
+  StandInHttpServer fast(answer(200, "4242", 100));
+  RouterOptions options;
+  options.minHedgeDelayMs = 10;
+  Clock::time_point start = Clock::now();
+  {
+    auto router = routerFor({&slow, &fast}, options);
+    Connection connection(router, Commitment::confirmed);
+    TEST_ASSERT_EQUAL_UINT64(4242, connection.getBlockHeight());
+  }
+  // The router joined its workers without waiting out the slow endpoint
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+  TEST_ASSERT_LESS_THAN_UINT32(1000, elapsed);
+}
+
+void test_direct_post_fails_over_only_before_the_handler_ran()
+{
+  RouterOptions options;
+  options.hedgeReads = false;
+  std::string request = "{\"jsonrpc\":\"2.0\",\"id\":3,\"method\":\"getBlockHeight\",\"params\":[]}";
+
+  // Nothing listens on the first endpoint, the second one answers
+  StandInHttpServer healthy(answer(200, "4242"));
+  auto router = RouterTransport::forEndpoints({"http://127.0.0.1:1/", healthy.url()}, 1, options);
+  std::vector<int> statuses;
+  auto handler = [&statuses](ResponseReader &reader)
+  {
+    statuses.push_back(reader.status());
+    char chunk[64];
+    while (reader.readBytes(chunk, sizeof(chunk)) > 0)
+    {
+    }
+    return true;
+  };
+  TEST_ASSERT_TRUE(router->post(span(request), handler));
+  TEST_ASSERT_EQUAL(1, statuses.size());
+  TEST_ASSERT_EQUAL(200, statuses[0]);
+
+  // An error body reached the handler, it must not see a second response
+  StandInHttpServer unavailable([](const StandInRequest &request)
+                                { return StandInResponse::json(standInError(request.body, -32000, "Unavailable"), 503); });
+  StandInHttpServer spare(answer(200, "4242"));
+  auto ranked = routerFor({&unavailable, &spare}, options);
+  statuses.clear();
+  TEST_ASSERT_TRUE(ranked->post(span(request), handler));
+  TEST_ASSERT_EQUAL(1, statuses.size());
+  TEST_ASSERT_EQUAL(503, statuses[0]);
+  TEST_ASSERT_EQUAL(0, spare.requests());
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_hedged_read_skips_rate_limited_endpoint);
+  RUN_TEST(test_hedged_read_skips_rpc_error);
+  RUN_TEST(test_failed_race_forwards_status);
+  RUN_TEST(test_error_bodies_open_the_circuit);
+  RUN_TEST(test_send_is_fanned_out);
+  RUN_TEST(test_losing_attempt_is_cancelled);
+  RUN_TEST(test_direct_post_fails_over_only_before_the_handler_ran);
+  return UNITY_END();
+}
@@ -0,0 +1,174 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <unity.h>
+#include "SolanaSDK/scheduler_transport.h"
+#include "../support/stand_in_server.h"
+
+using Clock = std::chrono::steady_clock;
+
+// Methods in the order the stand-in server received them, with when
+struct Arrivals
+{
+  std::mutex mutex;
+  std::vector<std::string> methods;
+  std::vector<Clock::time_point> times;
+
+  // Returns how many have arrived so far
+  size_t record(const std::string &body)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    methods.push_back(standInMethod(body));
+    times.push_back(Clock::now());
+    return methods.size();
+  }
+
+  uint32_t gapMs(size_t from, size_t to)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(times[to] - times[from]).count());
+  }
+};
+
+static bool postCall(Transport &transport, const std::string &method)
+{
+  std::string request = "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"" + method + "\",\"params\":[]}";
+  ByteSpan span(reinterpret_cast<const uint8_t *>(request.data()), request.size());
+  return transport.post(span, [](ResponseReader &body)
+                        {
+                          char scratch[256];
+                          while (body.readBytes(scratch, sizeof(scratch)) > 0)
+                          {
+                          }
+                          return body.status() == 200; });
+}
+
+static SchedulerOptions unlimited()
+{
+  SchedulerOptions options;
+  options.endpointLimit = {0, 0};
+  options.methodLimit = {0, 0};
+  return options;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_token_bucket_spaces_calls_after_the_burst()
+{
+  Arrivals arrivals;
+  StandInHttpServer server([&arrivals](const StandInRequest &request)
+                           {
+                             arrivals.record(request.body);
+                             return StandInResponse::json(standInResult(request.body, "1")); });
+  SchedulerOptions options = unlimited();
+  // Two at once, then one every 50 ms
+  options.endpointLimit = {20, 2};
+  SchedulerTransport scheduler(Transport::forEndpoint(server.url(), 2), options);
+
+  for (int i = 0; i < 6; ++i)
+  {
+    TEST_ASSERT_TRUE(postCall(scheduler, "getSlot"));
+  }
+  TEST_ASSERT_EQUAL(6, server.requests());
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(40, arrivals.gapMs(0, 1));
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(40, arrivals.gapMs(1, 2));
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(180, arrivals.gapMs(0, 5));
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(600, arrivals.gapMs(0, 5));
+}
+
+void test_method_bucket_holds_back_only_its_method()
+{
+  Arrivals arrivals;
+  StandInHttpServer server([&arrivals](const StandInRequest &request)
+                           {
+                             arrivals.record(request.body);
+                             return StandInResponse::json(standInResult(request.body, "1")); });
+  SchedulerOptions options = unlimited();
+  options.methodLimits["getBalance"] = {5, 1};
+  SchedulerTransport scheduler(Transport::forEndpoint(server.url(), 2), options);
+
+  TEST_ASSERT_TRUE(postCall(scheduler, "getBalance"));
+  TEST_ASSERT_TRUE(postCall(scheduler, "getSlot"));
+  TEST_ASSERT_TRUE(postCall(scheduler, "getBalance"));
+  // getSlot went straight through, the second getBalance waited ~200 ms
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(100, arrivals.gapMs(0, 1));
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(170, arrivals.gapMs(0, 2));
+}
+
+void test_queued_calls_go_out_by_priority()
+{
+  Arrivals arrivals;
+  StandInHttpServer server([&arrivals](const StandInRequest &request)
+                           {
+                             arrivals.record(request.body);
+                             StandInResponse response = StandInResponse::json(standInResult(request.body, "1"));
+                             // Keeps the only slot busy while the others queue up
+                             if (standInMethod(request.body) == "getAccountInfo")
+                             {
+                               response.delayMs = 150;
+                             }
+                             return response; });
+  SchedulerOptions options = unlimited();
+  options.maxInFlight = 1;
+  SchedulerTransport scheduler(Transport::forEndpoint(server.url(), 2), options);
+
+  std::vector<std::thread> callers;
+  callers.emplace_back([&scheduler]
+                       { postCall(scheduler, "getAccountInfo"); });
+  // Queued in the reverse of their priority
+  for (const char *method : {"getBalance", "getBlockHeight", "sendTransaction"})
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    callers.emplace_back([&scheduler, method]
+                         { postCall(scheduler, method); });
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  TEST_ASSERT_EQUAL(3, scheduler.stats().queued);
+  for (auto &caller : callers)
+  {
+    caller.join();
+  }
+
+  TEST_ASSERT_EQUAL(4, arrivals.methods.size());
+  TEST_ASSERT_EQUAL_STRING("getAccountInfo", arrivals.methods[0].c_str());
+  TEST_ASSERT_EQUAL_STRING("sendTransaction", arrivals.methods[1].c_str());
+  TEST_ASSERT_EQUAL_STRING("getBlockHeight", arrivals.methods[2].c_str());
+  TEST_ASSERT_EQUAL_STRING("getBalance", arrivals.methods[3].c_str());
+}
+
+void test_throttled_call_waits_for_retry_after()
+{
+  Arrivals arrivals;
+  StandInHttpServer server([&arrivals](const StandInRequest &request)
+                           {
+                             if (arrivals.record(request.body) == 1)
+                             {
+                               StandInResponse response = StandInResponse::json("{\"error\":\"Too many requests\"}", 429);
+                               response.headers.push_back({"Retry-After", "1"});
+                               return response;
+                             }
+                             return StandInResponse::json(standInResult(request.body, "1")); });
+  SchedulerTransport scheduler(Transport::forEndpoint(server.url(), 2), unlimited());
+
+  TEST_ASSERT_TRUE(postCall(scheduler, "getSlot"));
+  TEST_ASSERT_EQUAL(2, server.requests());
+  TEST_ASSERT_EQUAL_UINT64(1, scheduler.stats().throttled);
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(950, arrivals.gapMs(0, 1));
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(1500, arrivals.gapMs(0, 1));
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_token_bucket_spaces_calls_after_the_burst);
+  RUN_TEST(test_method_bucket_holds_back_only_its_method);
+  RUN_TEST(test_queued_calls_go_out_by_priority);
+  RUN_TEST(test_throttled_call_waits_for_retry_after);
+  return UNITY_END();
+}
@@ -0,0 +1,92 @@
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unity.h>
+#include <openssl/sha.h>
+#include "SolanaSDK/sha256.h"
+#include "SolanaSDK/hash.h"
+
+// Lengths around the block and padding boundaries
+static const size_t LENGTHS[] = {0, 1, 3, 55, 56, 63, 64, 65, 119, 120, 127, 128, 129, 1000, 4096, 65537};
+
+static std::vector<uint8_t> patternBytes(size_t length)
+{
+  std::vector<uint8_t> data(length);
+  for (size_t i = 0; i < length; ++i)
+  {
+    data[i] = static_cast<uint8_t>(i * 31 + 7);
+  }
+  return data;
+}
+
+static std::vector<uint8_t> referenceDigest(const std::vector<uint8_t> &data)
+{
+  std::vector<uint8_t> digest(SHA256_DIGEST_BYTES);
+  SHA256(data.data(), data.size(), digest.data());
+  return digest;
+}
+
+// Digest of data fed to backend in pieces of step bytes
+static std::vector<uint8_t> backendDigest(const Sha256Backend &backend, const std::vector<uint8_t> &data, size_t step)
+{
+  Sha256State state;
+  backend.init(state);
+  for (size_t offset = 0; offset < data.size(); offset += step)
+  {
+    backend.update(state, data.data() + offset, std::min(step, data.size() - offset));
+  }
+  std::vector<uint8_t> digest(SHA256_DIGEST_BYTES);
+  backend.finish(state, digest.data());
+  return digest;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_every_backend_passes_its_self_test()
+{
+  std::vector<const Sha256Backend *> backends = Sha256Backend::available();
+  TEST_ASSERT_FALSE(backends.empty());
+  for (const Sha256Backend *backend : backends)
+  {
+    TEST_ASSERT_TRUE_MESSAGE(backend->selfTest(), backend->name());
+  }
+  TEST_ASSERT_TRUE(Sha256Backend::best().selfTest());
+}
+
+void test_every_backend_matches_the_reference()
+{
+  for (const Sha256Backend *backend : Sha256Backend::available())
+  {
+    for (size_t length : LENGTHS)
+    {
+      std::vector<uint8_t> data = patternBytes(length);
+      std::vector<uint8_t> expected = referenceDigest(data);
+      for (size_t step : {size_t(1), size_t(13), size_t(64), size_t(1) << 20})
+      {
+        TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(expected.data(), backendDigest(*backend, data, step).data(), SHA256_DIGEST_BYTES, backend->name());
+      }
+    }
+  }
+}
+
+void test_hasher_uses_the_best_backend()
+{
+  std::vector<uint8_t> data = patternBytes(300);
+  Hasher hasher;
+  hasher.hashv({ByteSpan(data.data(), 100), ByteSpan(data.data() + 100, 200)});
+  Hash hash;
+  hasher.result(&hash);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(referenceDigest(data).data(), hash.data.data(), SHA256_DIGEST_BYTES);
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_every_backend_passes_its_self_test);
+  RUN_TEST(test_every_backend_matches_the_reference);
+  RUN_TEST(test_hasher_uses_the_best_backend);
+  return UNITY_END();
+}
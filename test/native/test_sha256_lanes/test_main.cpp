@@ -0,0 +1,100 @@
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unity.h>
+#include <openssl/evp.h>
+#include "SolanaSDK/sha256_lanes.h"
+#include "SolanaSDK/hash.h"
+
+static std::vector<uint8_t> patternBytes(size_t length, uint8_t seed)
+{
+  std::vector<uint8_t> data(length);
+  for (size_t i = 0; i < length; ++i)
+  {
+    data[i] = static_cast<uint8_t>(i * 31 + seed);
+  }
+  return data;
+}
+
+// Digest of the concatenation of spans
+static std::vector<uint8_t> referenceDigest(const std::vector<ByteSpan> &spans)
+{
+  EVP_MD_CTX *context = EVP_MD_CTX_new();
+  EVP_DigestInit_ex(context, EVP_sha256(), nullptr);
+  for (const ByteSpan &span : spans)
+  {
+    EVP_DigestUpdate(context, span.data, span.size);
+  }
+  std::vector<uint8_t> digest(SHA256_DIGEST_BYTES);
+  EVP_DigestFinal_ex(context, digest.data(), nullptr);
+  EVP_MD_CTX_free(context);
+  return digest;
+}
+
+// Hash count messages of varied lengths side by side and check each one
+static void checkMany(size_t count)
+{
+  std::vector<std::vector<uint8_t>> inputs;
+  for (size_t i = 0; i < count; ++i)
+  {
+    // Lengths cross block and padding boundaries, so lanes finish at
+    // different passes
+    inputs.push_back(patternBytes((i * 37) % 300, static_cast<uint8_t>(i)));
+  }
+  std::vector<std::vector<ByteSpan>> messages;
+  for (const auto &input : inputs)
+  {
+    size_t half = input.size() / 2;
+    messages.push_back({ByteSpan(input.data(), half), ByteSpan(input.data() + half, input.size() - half)});
+  }
+
+  std::vector<uint8_t> out(count * SHA256_DIGEST_BYTES);
+  Sha256Lanes::hashMany(messages, reinterpret_cast<uint8_t(*)[SHA256_DIGEST_BYTES]>(out.data()));
+  for (size_t i = 0; i < count; ++i)
+  {
+    TEST_ASSERT_EQUAL_HEX8_ARRAY_MESSAGE(referenceDigest(messages[i]).data(), out.data() + i * SHA256_DIGEST_BYTES, SHA256_DIGEST_BYTES, Sha256Lanes::name());
+  }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_lane_width_is_bounded()
+{
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(1, Sha256Lanes::width());
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(SHA256_MAX_LANES, Sha256Lanes::width());
+}
+
+void test_partial_and_full_passes_match_the_reference()
+{
+  size_t width = Sha256Lanes::width();
+  for (size_t count : {size_t(1), width - 1, width, width + 1, 2 * width + 3})
+  {
+    if (count > 0)
+    {
+      checkMany(count);
+    }
+  }
+}
+
+void test_hasher_hash_many_matches_single_hashes()
+{
+  std::vector<uint8_t> first = patternBytes(64, 1);
+  std::vector<uint8_t> second = patternBytes(1000, 2);
+  std::vector<Hash> hashes = Hasher::hashMany({{ByteSpan(first)}, {ByteSpan(second)}, {}});
+  TEST_ASSERT_EQUAL(3, hashes.size());
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(referenceDigest({ByteSpan(first)}).data(), hashes[0].data.data(), SHA256_DIGEST_BYTES);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(referenceDigest({ByteSpan(second)}).data(), hashes[1].data.data(), SHA256_DIGEST_BYTES);
+  TEST_ASSERT_EQUAL_HEX8_ARRAY(referenceDigest({}).data(), hashes[2].data.data(), SHA256_DIGEST_BYTES);
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_lane_width_is_bounded);
+  RUN_TEST(test_partial_and_full_passes_match_the_reference);
+  RUN_TEST(test_hasher_hash_many_matches_single_hashes);
+  return UNITY_END();
+}
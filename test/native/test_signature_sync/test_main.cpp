@@ -0,0 +1,126 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <unity.h>
+#include "SolanaSDK/signature_history.h"
+#include "SolanaSDK/loopback_transport.h"
+#include "../support/stand_in_server.h"
+
+static Signature signatureNumber(uint32_t n)
+{
+  std::vector<uint8_t> bytes(SIGNATURE_BYTES, 0);
+  bytes[0] = 0xAA;
+  bytes[1] = static_cast<uint8_t>(n);
+  bytes[2] = static_cast<uint8_t>(n >> 8);
+  return Signature(bytes);
+}
+
+static PublicKey addressNumber(uint8_t n)
+{
+  PublicKey address;
+  std::fill(std::begin(address.key), std::end(address.key), 0);
+  address.key[0] = n;
+  return address;
+}
+
+// One new signature per request, numbered in the order they were asked for
+static std::string answerSignatures(const std::string &request, uint32_t n)
+{
+  return standInResult(request, "[{\"signature\":\"" + signatureNumber(n).toString() + "\",\"slot\":1,\"err\":null,\"blockTime\":null,\"confirmationStatus\":\"confirmed\"}]");
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_sync_runs_max_concurrency_fetches_at_once()
+{
+  std::atomic<uint32_t> served{0};
+  std::atomic<size_t> inFlight{0};
+  std::atomic<size_t> peak{0};
+  auto transport = std::make_shared<LoopbackTransport>([&](const std::string &request)
+                                                       {
+    size_t now = ++inFlight;
+    size_t seen = peak;
+    while (now > seen && !peak.compare_exchange_weak(seen, now))
+    {
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    inFlight--;
+    return answerSignatures(request, served++); },
+                                                       8);
+  SignatureSync sync(Connection(transport, Commitment::confirmed), 64, Commitment::confirmed, 3);
+  for (uint8_t i = 1; i <= 9; ++i)
+  {
+    sync.addAddress(addressNumber(i));
+  }
+
+  SyncReport report = sync.sync();
+  TEST_ASSERT_EQUAL(9, report.newSignatures);
+  TEST_ASSERT_EQUAL(0, report.failedAddresses);
+  TEST_ASSERT_EQUAL(3, peak.load());
+  TEST_ASSERT_TRUE(sync.cursor(addressNumber(1)).has_value());
+}
+
+void test_endpoint_sync_opens_a_socket_per_fetcher()
+{
+  std::atomic<uint32_t> served{0};
+  StandInHttpServer server([&](const StandInRequest &request)
+                           {
+    StandInResponse response = StandInResponse::json(answerSignatures(request.body, served++));
+    response.delayMs = 100;
+    return response; });
+  SignatureSync sync(server.url(), 64, Commitment::confirmed, 3);
+  for (uint8_t i = 1; i <= 6; ++i)
+  {
+    sync.addAddress(addressNumber(i));
+  }
+
+  auto started = std::chrono::steady_clock::now();
+  SyncReport report = sync.sync();
+  auto elapsed = std::chrono::steady_clock::now() - started;
+  TEST_ASSERT_EQUAL(6, report.newSignatures);
+  TEST_ASSERT_EQUAL(3, server.connections());
+  // Two rounds of three, not six one after the other
+  TEST_ASSERT_TRUE(elapsed < std::chrono::milliseconds(450));
+}
+
+void test_callback_exception_is_passed_on()
+{
+  std::atomic<uint32_t> served{0};
+  auto transport = std::make_shared<LoopbackTransport>([&](const std::string &request)
+                                                       { return answerSignatures(request, served++); },
+                                                       4);
+  SignatureSync sync(Connection(transport, Commitment::confirmed), 64, Commitment::confirmed, 4);
+  for (uint8_t i = 1; i <= 4; ++i)
+  {
+    sync.addAddress(addressNumber(i));
+  }
+
+  bool thrown = false;
+  try
+  {
+    sync.sync([](const PublicKey &, const ConfirmedSignatureInfo &)
+              { throw std::runtime_error("handler failed"); });
+  }
+  catch (const std::runtime_error &)
+  {
+    thrown = true;
+  }
+  TEST_ASSERT_TRUE(thrown);
+  TEST_ASSERT_EQUAL(4, sync.records().size());
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_sync_runs_max_concurrency_fetches_at_once);
+  RUN_TEST(test_endpoint_sync_opens_a_socket_per_fetcher);
+  RUN_TEST(test_callback_exception_is_passed_on);
+  return UNITY_END();
+}
@@ -0,0 +1,89 @@
+#include <cstdint>
+#include <string>
+#include <memory>
+#include <unity.h>
+#include "SolanaSDK/connection.h"
+#include "SolanaSDK/posix_http_transport.h"
+#include "../support/stand_in_server.h"
+
+// Answers getBlockHeight, hanging up after each answer when closing is set
+static StandInHttpServer::Handler blockHeightNode(bool closing)
+{
+  return [closing](const StandInRequest &request)
+  {
+    StandInResponse response = StandInResponse::json(standInResult(request.body, "4242"));
+    response.close = closing;
+    return response;
+  };
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_https_request_is_answered()
+{
+  StandInHttpsServer server(blockHeightNode(false));
+  auto transport = std::make_shared<PosixHttpTransport>(server.url(), 1, POSIX_HTTP_DEFAULT_TIMEOUT_MS, server.caCert());
+  Connection connection(transport, Commitment::confirmed);
+
+  TEST_ASSERT_EQUAL(4242, connection.getBlockHeight());
+  TEST_ASSERT_EQUAL(4242, connection.getBlockHeight());
+  // Both calls rode the one keep-alive connection
+  TEST_ASSERT_EQUAL(1, server.tlsHandshakes());
+  TEST_ASSERT_EQUAL(1, transport->tlsStats().handshakes);
+}
+
+void test_reconnect_resumes_the_session()
+{
+  StandInHttpsServer server(blockHeightNode(true));
+  auto transport = std::make_shared<PosixHttpTransport>(server.url(), 1, POSIX_HTTP_DEFAULT_TIMEOUT_MS, server.caCert());
+  Connection connection(transport, Commitment::confirmed);
+
+  for (int i = 0; i < 3; ++i)
+  {
+    TEST_ASSERT_EQUAL(4242, connection.getBlockHeight());
+  }
+  PosixHttpTransport::TlsStats stats = transport->tlsStats();
+  TEST_ASSERT_EQUAL(3, stats.handshakes);
+  TEST_ASSERT_EQUAL(2, stats.resumed);
+  TEST_ASSERT_EQUAL(2, server.tlsResumed());
+}
+
+void test_untrusted_certificate_is_rejected()
+{
+  StandInHttpsServer server(blockHeightNode(false));
+  StandInHttpsServer other(blockHeightNode(false));
+  auto transport = std::make_shared<PosixHttpTransport>(server.url(), 1, POSIX_HTTP_DEFAULT_TIMEOUT_MS, other.caCert());
+  Connection connection(transport, Commitment::confirmed);
+
+  RpcResult<uint64_t> height = connection.tryGetBlockHeight();
+  TEST_ASSERT_FALSE(height.ok());
+  TEST_ASSERT_TRUE(height.error->code == RpcErrorCode::transport);
+  TEST_ASSERT_EQUAL(0, server.requests());
+}
+
+void test_gzip_over_tls_checks_the_trailer()
+{
+  StandInHttpsServer server([](const StandInRequest &request)
+                            {
+    std::string gzip = standInGzip(standInResult(request.body, "4242"));
+    gzip[gzip.size() - 8] ^= 0x01;
+    StandInResponse response = StandInResponse::json(gzip);
+    response.headers.emplace_back("Content-Encoding", "gzip");
+    return response; });
+  auto transport = std::make_shared<PosixHttpTransport>(server.url(), 1, POSIX_HTTP_DEFAULT_TIMEOUT_MS, server.caCert());
+  Connection connection(transport, Commitment::confirmed);
+
+  TEST_ASSERT_FALSE(connection.tryGetBlockHeight().ok());
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_https_request_is_answered);
+  RUN_TEST(test_reconnect_resumes_the_session);
+  RUN_TEST(test_untrusted_certificate_is_rejected);
+  RUN_TEST(test_gzip_over_tls_checks_the_trailer);
+  return UNITY_END();
+}
@@ -0,0 +1,233 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <set>
+#include <memory>
+#include <optional>
+#include <functional>
+#include <unity.h>
+#include <ArduinoJson.h>
+#include "SolanaSDK/transaction_queue.h"
+#include "SolanaSDK/loopback_transport.h"
+#include "SolanaSDK/base64.h"
+#include "SolanaSDK/programs/system_program.h"
+
+enum class SendOutcome
+{
+  accept,
+  // Accepted, but the reply never arrives
+  lose,
+  reject
+};
+
+// Stand-in node keeping the block height, the signatures it was sent and
+// the ones it reports as landed
+struct QueueNode
+{
+  uint64_t blockHeight = 50;
+  std::string blockhash = Hash(std::vector<uint8_t>(HASH_BYTES, 2)).toStr();
+  SendOutcome outcome = SendOutcome::accept;
+  std::vector<std::string> sent;
+  std::set<std::string> landed;
+  std::function<void()> onSend;
+
+  std::string answerCall(JsonVariantConst call)
+  {
+    std::string method = call["method"] | "";
+    std::string result = "null";
+    if (method == "getBlockHeight")
+    {
+      result = std::to_string(blockHeight);
+    }
+    else if (method == "getLatestBlockhash")
+    {
+      result = "{\"context\":{\"slot\":1},\"value\":{\"blockhash\":\"" + blockhash + "\",\"lastValidBlockHeight\":" + std::to_string(blockHeight + 150) + "}}";
+    }
+    else if (method == "getSignatureStatuses")
+    {
+      result = "{\"context\":{\"slot\":1},\"value\":[";
+      for (size_t i = 0; i < call["params"][0].size(); ++i)
+      {
+        bool found = landed.count(call["params"][0][i].as<std::string>()) > 0;
+        result += i == 0 ? "" : ",";
+        result += found ? "{\"slot\":1,\"confirmations\":null,\"err\":null,\"confirmationStatus\":\"finalized\"}" : "null";
+      }
+      result += "]}";
+    }
+    else if (method == "sendTransaction")
+    {
+      // One signature, after its one byte count
+      std::vector<uint8_t> wire = Base64::decode(call["params"][0].as<std::string>());
+      std::string signature = Signature(std::vector<uint8_t>(wire.begin() + 1, wire.begin() + 1 + SIGNATURE_BYTES)).toString();
+      sent.push_back(signature);
+      if (onSend)
+      {
+        onSend();
+      }
+      if (outcome == SendOutcome::reject)
+      {
+        return "{\"jsonrpc\":\"2.0\",\"error\":{\"code\":-32002,\"message\":\"Transaction simulation failed\"},\"id\":" + std::to_string(call["id"] | 0u) + "}";
+      }
+      result = "\"" + signature + "\"";
+    }
+    return "{\"jsonrpc\":\"2.0\",\"result\":" + result + ",\"id\":" + std::to_string(call["id"] | 0u) + "}";
+  }
+
+  std::string answer(const std::string &request)
+  {
+    JsonDocument requestDoc;
+    deserializeJson(requestDoc, request);
+    std::string method = requestDoc["method"] | "";
+    if (method == "sendTransaction" && outcome == SendOutcome::lose)
+    {
+      answerCall(requestDoc.as<JsonVariantConst>());
+      return "";
+    }
+    if (!requestDoc.is<JsonArrayConst>())
+    {
+      return answerCall(requestDoc.as<JsonVariantConst>());
+    }
+    std::string response = "[";
+    for (JsonVariantConst call : requestDoc.as<JsonArrayConst>())
+    {
+      response += (response.size() > 1 ? "," : "") + answerCall(call);
+    }
+    return response + "]";
+  }
+};
+
+static PublicKey keyFilledWith(uint8_t value)
+{
+  return PublicKey(std::vector<uint8_t>(PUBLIC_KEY_LEN, value));
+}
+
+// Queue a transfer signed with a blockhash that is valid up to block 100
+static Signature pushTransfer(TransactionQueue &queue)
+{
+  Keypair payer = Keypair::generate();
+  PublicKey payerKey = payer.publicKey;
+  std::vector<Instruction> instructions = {SystemProgram::transfer(payerKey, keyFilledWith(4), 1000)};
+  std::optional<PublicKey> payerOption = payerKey;
+  std::vector<Signer> signers = {Signer(payer)};
+  Transaction transaction = Transaction::createSignedWithPayer(instructions, payerOption, signers, Hash(std::vector<uint8_t>(HASH_BYTES, 1)));
+  TEST_ASSERT_TRUE(queue.push(transaction, signers, 100));
+  return transaction.signatures.front();
+}
+
+static Connection connectionTo(QueueNode &node)
+{
+  auto transport = std::make_shared<LoopbackTransport>([&node](const std::string &request)
+                                                       { return node.answer(request); });
+  return Connection(transport, Commitment::confirmed);
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_lost_reply_that_landed_is_not_signed_again()
+{
+  QueueNode node;
+  Connection connection = connectionTo(node);
+  TransactionQueue queue(4);
+  Signature signature = pushTransfer(queue);
+
+  node.outcome = SendOutcome::lose;
+  DrainResult first = queue.drain(connection, 1);
+  TEST_ASSERT_EQUAL(1, first.failed);
+  TEST_ASSERT_EQUAL(1, queue.size());
+
+  // The blockhash expires, but the node did accept the first send
+  node.blockHeight = 150;
+  node.outcome = SendOutcome::accept;
+  node.landed.insert(signature.toString());
+  DrainResult second = queue.drain(connection, 1);
+  TEST_ASSERT_EQUAL(0, second.resigned);
+  TEST_ASSERT_EQUAL(1, second.submitted.size());
+  TEST_ASSERT_EQUAL_STRING(signature.toString().c_str(), second.submitted[0].toString().c_str());
+  TEST_ASSERT_EQUAL(1, node.sent.size());
+  TEST_ASSERT_EQUAL(0, queue.size());
+}
+
+void test_lost_reply_is_signed_again_once_dead()
+{
+  QueueNode node;
+  Connection connection = connectionTo(node);
+  TransactionQueue queue(4);
+  Signature signature = pushTransfer(queue);
+
+  node.outcome = SendOutcome::lose;
+  queue.drain(connection, 1);
+
+  // Still valid: the same bytes are sent again
+  DrainResult retried = queue.drain(connection, 1);
+  TEST_ASSERT_EQUAL(0, retried.resigned);
+  TEST_ASSERT_EQUAL(2, node.sent.size());
+  TEST_ASSERT_EQUAL_STRING(signature.toString().c_str(), node.sent[1].c_str());
+
+  // Expired and never seen by the node: safe to sign with a new blockhash
+  node.blockHeight = 150;
+  node.outcome = SendOutcome::accept;
+  DrainResult resigned = queue.drain(connection, 1);
+  TEST_ASSERT_EQUAL(1, resigned.resigned);
+  TEST_ASSERT_EQUAL(1, resigned.submitted.size());
+  TEST_ASSERT_EQUAL(3, node.sent.size());
+  TEST_ASSERT_TRUE(node.sent[2] != signature.toString());
+  TEST_ASSERT_EQUAL_STRING(node.sent[2].c_str(), resigned.submitted[0].toString().c_str());
+}
+
+void test_rejected_entry_is_dropped_after_max_attempts()
+{
+  QueueNode node;
+  Connection connection = connectionTo(node);
+  TransactionQueue queue(4, 3);
+  Signature signature = pushTransfer(queue);
+
+  node.outcome = SendOutcome::reject;
+  TEST_ASSERT_EQUAL(1, queue.drain(connection, 1).failed);
+  TEST_ASSERT_EQUAL(1, queue.drain(connection, 1).failed);
+  DrainResult last = queue.drain(connection, 1);
+  TEST_ASSERT_EQUAL(0, last.failed);
+  TEST_ASSERT_EQUAL(1, last.dropped.size());
+  TEST_ASSERT_EQUAL_STRING(signature.toString().c_str(), last.dropped[0].toString().c_str());
+  TEST_ASSERT_EQUAL(0, queue.size());
+  TEST_ASSERT_EQUAL(3, node.sent.size());
+}
+
+void test_capacity_counts_entries_being_drained()
+{
+  QueueNode node;
+  Connection connection = connectionTo(node);
+  TransactionQueue queue(2);
+  pushTransfer(queue);
+  pushTransfer(queue);
+
+  // Entries pushed while the batch is out would not fit once it is requeued
+  size_t refused = 0;
+  node.onSend = [&queue, &refused]()
+  {
+    TEST_ASSERT_TRUE(queue.full());
+    Keypair payer = Keypair::generate();
+    PublicKey payerKey = payer.publicKey;
+    std::vector<Instruction> instructions = {SystemProgram::transfer(payerKey, keyFilledWith(4), 1)};
+    std::optional<PublicKey> payerOption = payerKey;
+    std::vector<Signer> signers = {Signer(payer)};
+    Transaction transaction = Transaction::createSignedWithPayer(instructions, payerOption, signers, Hash(std::vector<uint8_t>(HASH_BYTES, 1)));
+    refused += queue.push(transaction, signers, 100) ? 0 : 1;
+  };
+  node.outcome = SendOutcome::lose;
+  DrainResult result = queue.drain(connection, 1);
+  TEST_ASSERT_EQUAL(2, result.failed);
+  TEST_ASSERT_EQUAL(2, refused);
+  TEST_ASSERT_EQUAL(2, queue.size());
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_lost_reply_that_landed_is_not_signed_again);
+  RUN_TEST(test_lost_reply_is_signed_again_once_dead);
+  RUN_TEST(test_rejected_entry_is_dropped_after_max_attempts);
+  RUN_TEST(test_capacity_counts_entries_being_drained);
+  return UNITY_END();
+}
@@ -0,0 +1,161 @@
+#include <cstdint>
+#include <string>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <unity.h>
+#include "SolanaSDK/connection.h"
+#include "SolanaSDK/loopback_transport.h"
+#include "SolanaSDK/posix_http_transport.h"
+#include "../support/stand_in_server.h"
+
+static const char *BLOCKHASH = "EkSnNWid2cvwEVnVx9aBqawnmiCNiDgp3gUdkDPTKN1N";
+
+static std::string answerBlockHeight(const std::string &request)
+{
+  return standInResult(request, "4242");
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_warmup_opens_every_connection()
+{
+  StandInHttpServer server([](const StandInRequest &request)
+                           { return StandInResponse::json(answerBlockHeight(request.body)); });
+  PosixHttpTransport transport(server.url(), 3);
+
+  TEST_ASSERT_EQUAL(3, transport.warmup());
+  TEST_ASSERT_EQUAL(3, server.connections(3));
+  // Already open sockets are counted again without reconnecting
+  TEST_ASSERT_EQUAL(3, transport.warmup());
+  TEST_ASSERT_EQUAL(3, server.connections(4, 50));
+}
+
+void test_posix_transport_keeps_connection_alive()
+{
+  StandInHttpServer server([](const StandInRequest &request)
+                           { return StandInResponse::json(answerBlockHeight(request.body)); });
+  Connection connection(server.url(), Commitment::confirmed, 1);
+
+  TEST_ASSERT_EQUAL_UINT64(4242, connection.getBlockHeight());
+  TEST_ASSERT_EQUAL_UINT64(4242, connection.getBlockHeight());
+  TEST_ASSERT_EQUAL(2, server.requests());
+  TEST_ASSERT_EQUAL(1, server.connections());
+}
+
+// Body the stand-in server answers with: its request body names the size,
+// "chunked" sends a short body in chunks
+static StandInResponse sizedBody(const StandInRequest &request)
+{
+  if (request.body == "chunked")
+  {
+    StandInResponse response;
+    response.raw = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                   "200\r\n" +
+                   std::string(0x200, 'c') + "\r\n200\r\n" + std::string(0x200, 'd') + "\r\n0\r\n\r\n";
+    return response;
+  }
+  return StandInResponse::json(std::string(std::stoul(request.body), 'x'));
+}
+
+// Post through transport, reading only the first bytes of the response
+static bool postAndStopEarly(PosixHttpTransport &transport, const std::string &body)
+{
+  return transport.post(ByteSpan(reinterpret_cast<const uint8_t *>(body.data()), body.size()), [](ResponseReader &response)
+                        {
+                          char head[16];
+                          return response.readBytes(head, sizeof(head)) == sizeof(head); });
+}
+
+void test_posix_transport_drains_a_short_rest()
+{
+  StandInHttpServer server(sizedBody);
+  PosixHttpTransport transport(server.url(), 1);
+
+  TEST_ASSERT_TRUE(postAndStopEarly(transport, "1000"));
+  TEST_ASSERT_TRUE(postAndStopEarly(transport, "chunked"));
+  TEST_ASSERT_TRUE(postAndStopEarly(transport, "1000"));
+  TEST_ASSERT_EQUAL(3, server.requests());
+  TEST_ASSERT_EQUAL(1, server.connections());
+}
+
+void test_posix_transport_drops_the_socket_on_a_long_rest()
+{
+  StandInHttpServer server(sizedBody);
+  PosixHttpTransport transport(server.url(), 1);
+
+  // Reconnecting is cheaper than reading the other megabyte
+  TEST_ASSERT_TRUE(postAndStopEarly(transport, "1048576"));
+  TEST_ASSERT_TRUE(postAndStopEarly(transport, "1000"));
+  TEST_ASSERT_EQUAL(2, server.connections(2));
+  TEST_ASSERT_EQUAL(2, server.requests());
+}
+
+void test_loopback_answers_block_height()
+{
+  auto transport = std::make_shared<LoopbackTransport>(answerBlockHeight);
+  Connection connection(transport, Commitment::finalized);
+
+  TEST_ASSERT_EQUAL_UINT64(4242, connection.getBlockHeight());
+  TEST_ASSERT_EQUAL(1, transport->requestCount());
+}
+
+void test_loopback_answers_latest_blockhash()
+{
+  auto transport = std::make_shared<LoopbackTransport>([](const std::string &request)
+                                                       {
+                                                         TEST_ASSERT_EQUAL_STRING("getLatestBlockhash", standInMethod(request).c_str());
+                                                         return standInResult(request, std::string("{\"context\":{\"slot\":1},\"value\":{\"blockhash\":\"") + BLOCKHASH + "\",\"lastValidBlockHeight\":777}}"); });
+  Connection connection(transport, Commitment::confirmed);
+
+  BlockhashWithExpiryBlockHeight latest = connection.getLatestBlockhash();
+  TEST_ASSERT_EQUAL_STRING(BLOCKHASH, latest.blockhash.toStr().c_str());
+  TEST_ASSERT_EQUAL_UINT64(777, latest.lastValidBlockHeight);
+}
+
+void test_loopback_rpc_error_is_typed()
+{
+  auto transport = std::make_shared<LoopbackTransport>([](const std::string &request)
+                                                       { return standInError(request, -32005, "Node is behind"); });
+  Connection connection(transport, Commitment::confirmed);
+
+  try
+  {
+    connection.getBlockHeight();
+    TEST_FAIL_MESSAGE("expected an RpcException");
+  }
+  catch (const RpcException &e)
+  {
+    TEST_ASSERT_TRUE(e.code == RpcErrorCode::rpc);
+  }
+}
+
+void test_loopback_deadline_is_typed()
+{
+  auto transport = std::make_shared<LoopbackTransport>([](const std::string &request)
+                                                       {
+                                                         std::this_thread::sleep_for(std::chrono::milliseconds(60));
+                                                         return answerBlockHeight(request); });
+  Connection connection(transport, Commitment::confirmed);
+
+  auto result = connection.withDeadline(10).tryCall([](Connection &c)
+                                                    { return c.getBlockHeight(); });
+  TEST_ASSERT_FALSE(result.ok());
+  TEST_ASSERT_TRUE(result.error->code == RpcErrorCode::timeout);
+}
+
+int main(int, char **)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_warmup_opens_every_connection);
+  RUN_TEST(test_posix_transport_keeps_connection_alive);
+  RUN_TEST(test_posix_transport_drains_a_short_rest);
+  RUN_TEST(test_posix_transport_drops_the_socket_on_a_long_rest);
+  RUN_TEST(test_loopback_answers_block_height);
+  RUN_TEST(test_loopback_answers_latest_blockhash);
+  RUN_TEST(test_loopback_rpc_error_is_typed);
+  RUN_TEST(test_loopback_deadline_is_typed);
+  return UNITY_END();
+}